@@ -39,8 +39,14 @@
  * BSD Licensed as described in the file LICENSE
  */
 
+#include <inttypes.h>
+#include <string.h>
 #include <esp_log.h>
 #include <esp_idf_lib_helpers.h>
+#include <esp_attr.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
 #include "ADS111x.h"
 
 #define I2C_FREQ_HZ 1000000 // Max 1MHz for esp32
@@ -69,11 +75,29 @@
 #define OS_OFFSET        15
 #define OS_MASK          0x01
 
+#define RDY_POLL_INTERVAL_US   100  // Sleep between two reads of the OS bit
+
 #define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
 static const char *TAG = "ads111x";
 
+/*
+ * Cached copy of REG_CONFIG (without the OS bit) of every device, by port and address:
+ * i2c_dev_t is the shared i2cdev descriptor, so the cache lives in the driver.
+ * Setters write the new value without reading the register first, getters of
+ * configuration fields do not touch the bus. Only the OS bit is always read from the
+ * device. Use ads111x_sync_config()/ads111x_verify_config() after a device reset.
+ */
+typedef struct
+{
+    uint16_t config;
+    bool valid;
+} conf_shadow_t;
+
+static conf_shadow_t conf_shadows[I2C_NUM_MAX][4];
+static uint32_t transactions;
+
 const float ads111x_gain_values[] = {
     [ADS111X_GAIN_6V144]   = 6.144,
     [ADS111X_GAIN_4V096]   = 4.096,
@@ -89,6 +113,7 @@ static esp_err_t read_reg(i2c_dev_t *dev, uint8_t reg, uint16_t *val)
 {
     uint8_t buf[2];
     esp_err_t res;
+    transactions++;
     if ((res = i2c_dev_read_reg(dev, reg, buf, 2)) != ESP_OK)
     {
         ESP_LOGE(TAG, "Could not read from register 0x%02x", reg);
@@ -103,6 +128,7 @@ static esp_err_t write_reg(i2c_dev_t *dev, uint8_t reg, uint16_t val)
 {
     uint8_t buf[2] = { val >> 8, val };
     esp_err_t res;
+    transactions++;
     if ((res = i2c_dev_write_reg(dev, reg, buf, 2)) != ESP_OK)
     {
         ESP_LOGE(TAG, "Could not write 0x%04x to register 0x%02x", val, reg);
@@ -112,6 +138,53 @@ static esp_err_t write_reg(i2c_dev_t *dev, uint8_t reg, uint16_t val)
     return ESP_OK;
 }
 
+static conf_shadow_t *get_shadow(const i2c_dev_t *dev)
+{
+    if (dev->port >= I2C_NUM_MAX || dev->addr < ADS111X_ADDR_GND || dev->addr > ADS111X_ADDR_SCL)
+        return NULL;
+    return &conf_shadows[dev->port][dev->addr - ADS111X_ADDR_GND];
+}
+
+// Device mutex must be held
+static esp_err_t sync_config(i2c_dev_t *dev, uint16_t *val)
+{
+    conf_shadow_t *shadow = get_shadow(dev);
+    CHECK(read_reg(dev, REG_CONFIG, val));
+    if (shadow)
+    {
+        shadow->config = *val & ~(OS_MASK << OS_OFFSET);
+        shadow->valid = true;
+    }
+    return ESP_OK;
+}
+
+// Device mutex must be held. Returns the config without the OS bit
+static esp_err_t load_config(i2c_dev_t *dev, uint16_t *val)
+{
+    conf_shadow_t *shadow = get_shadow(dev);
+    if (shadow && shadow->valid)
+    {
+        *val = shadow->config;
+        return ESP_OK;
+    }
+    CHECK(sync_config(dev, val));
+    *val &= ~(OS_MASK << OS_OFFSET);
+    return ESP_OK;
+}
+
+// Device mutex must be held. On error the device state is unknown: the cache is dropped
+static esp_err_t store_config(i2c_dev_t *dev, uint16_t val)
+{
+    conf_shadow_t *shadow = get_shadow(dev);
+    esp_err_t res = write_reg(dev, REG_CONFIG, val);
+    if (shadow)
+    {
+        shadow->config = val & ~(OS_MASK << OS_OFFSET);
+        shadow->valid = (res == ESP_OK);
+    }
+    return res;
+}
+
 static esp_err_t read_conf_bits(i2c_dev_t *dev, uint8_t offs, uint16_t mask,
         uint16_t *bits)
 {
@@ -120,7 +193,11 @@ static esp_err_t read_conf_bits(i2c_dev_t *dev, uint8_t offs, uint16_t mask,
     uint16_t val;
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, read_reg(dev, REG_CONFIG, &val));
+    // OS is a status bit (conversion in progress): always from the device
+    if (offs == OS_OFFSET)
+        I2C_DEV_CHECK(dev, read_reg(dev, REG_CONFIG, &val));
+    else
+        I2C_DEV_CHECK(dev, load_config(dev, &val));
     I2C_DEV_GIVE_MUTEX(dev);
 
     ESP_LOGD(TAG, "Got config value: 0x%04x", val);
@@ -138,11 +215,12 @@ static esp_err_t write_conf_bits(i2c_dev_t *dev, uint16_t val, uint8_t offs,
     uint16_t old;
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, read_reg(dev, REG_CONFIG, &old));
-    // Issue #593
-    if (offs != OS_OFFSET || mask != OS_MASK)
-        old &= ~(OS_MASK << OS_OFFSET);
-    I2C_DEV_CHECK(dev, write_reg(dev, REG_CONFIG, (old & ~(mask << offs)) | (val << offs)));
+    // Issue #593: OS reads back as 1 when idle, it is never written back (load_config drops it)
+    I2C_DEV_CHECK(dev, load_config(dev, &old));
+    uint16_t config = (old & ~(mask << offs)) | ((val & mask) << offs);
+    // Unchanged field: nothing to write
+    if (config != old || offs == OS_OFFSET)
+        I2C_DEV_CHECK(dev, store_config(dev, config));
     I2C_DEV_GIVE_MUTEX(dev);
 
     return ESP_OK;
@@ -178,6 +256,9 @@ esp_err_t ads111x_init_desc(i2c_dev_t *dev, uint8_t addr, i2c_port_t port,
 #if HELPER_TARGET_IS_ESP32
     dev->cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
+    conf_shadow_t *shadow = get_shadow(dev);
+    if (shadow)
+        shadow->valid = false;  // First access reads the register
     return i2c_dev_create_mutex(dev);
 }
 
@@ -232,6 +313,66 @@ esp_err_t ads101x_get_value(i2c_dev_t *dev, int16_t *value)
     return ESP_OK;
 }
 
+esp_err_t ads111x_sync_config(i2c_dev_t *dev)
+{
+    CHECK_ARG(dev);
+
+    uint16_t val;
+
+    I2C_DEV_TAKE_MUTEX(dev);
+    I2C_DEV_CHECK(dev, sync_config(dev, &val));
+    I2C_DEV_GIVE_MUTEX(dev);
+
+    return ESP_OK;
+}
+
+esp_err_t ads111x_verify_config(i2c_dev_t *dev)
+{
+    CHECK_ARG(dev);
+
+    conf_shadow_t *shadow = get_shadow(dev);
+    uint16_t val;
+    bool was_valid;
+    uint16_t expected = 0;
+
+    I2C_DEV_TAKE_MUTEX(dev);
+    was_valid = shadow && shadow->valid;
+    if (was_valid)
+        expected = shadow->config;
+    I2C_DEV_CHECK(dev, sync_config(dev, &val));
+    I2C_DEV_GIVE_MUTEX(dev);
+
+    val &= ~(OS_MASK << OS_OFFSET);
+    if (was_valid && val != expected)
+    {
+        ESP_LOGW(TAG, "Config register of 0x%02x is 0x%04x, expected 0x%04x (device reset?)", dev->addr, val, expected);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ads111x_convert_next(i2c_dev_t *dev, ads111x_mux_t mux, int16_t *previous)
+{
+    CHECK_ARG(dev && previous);
+
+    uint16_t config;
+
+    I2C_DEV_TAKE_MUTEX(dev);
+    I2C_DEV_CHECK(dev, load_config(dev, &config));
+    config = (config & ~(MUX_MASK << MUX_OFFSET)) | ((mux & MUX_MASK) << MUX_OFFSET) | (1 << OS_OFFSET);
+    I2C_DEV_CHECK(dev, store_config(dev, config));
+    // The conversion register keeps the previous result until the new conversion ends
+    I2C_DEV_CHECK(dev, read_reg(dev, REG_CONVERSION, (uint16_t *)previous));
+    I2C_DEV_GIVE_MUTEX(dev);
+
+    return ESP_OK;
+}
+
+uint32_t ads111x_get_transaction_count(void)
+{
+    return transactions;
+}
+
 esp_err_t ads111x_get_gain(i2c_dev_t *dev, ads111x_gain_t *gain)
 {
     READ_CONFIG(PGA_OFFSET, PGA_MASK, gain);
@@ -354,4 +495,413 @@ esp_err_t ads111x_set_comp_high_thresh(i2c_dev_t *dev, int16_t th)
     I2C_DEV_GIVE_MUTEX(dev);
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+///////////////////////////////////////////////////////////////////////////////
+// Conversion-ready acquisition
+
+// Nominal conversion times, us (datasheet: actual rate may be up to 10% slower)
+static const uint32_t conversion_time_us[] = {
+    [ADS111X_DATA_RATE_8]   = 125000,
+    [ADS111X_DATA_RATE_16]  = 62500,
+    [ADS111X_DATA_RATE_32]  = 31250,
+    [ADS111X_DATA_RATE_64]  = 15625,
+    [ADS111X_DATA_RATE_128] = 7813,
+    [ADS111X_DATA_RATE_250] = 4000,
+    [ADS111X_DATA_RATE_475] = 2106,
+    [ADS111X_DATA_RATE_860] = 1163,
+};
+
+uint32_t ads111x_conversion_time_us(ads111x_data_rate_t rate)
+{
+    return conversion_time_us[rate & DR_MASK];
+}
+
+static void IRAM_ATTR rdy_isr_handler(void *arg)
+{
+    ads111x_rdy_t *ctx = (ads111x_rdy_t *)arg;
+    BaseType_t woken = pdFALSE;
+
+    if (ctx->task)
+        vTaskNotifyGiveFromISR(ctx->task, &woken);
+    if (woken == pdTRUE)
+        portYIELD_FROM_ISR();
+}
+
+static void rdy_sleep_timer_cb(void *arg)
+{
+    xSemaphoreGive(((ads111x_rdy_t *)arg)->sleep_done);
+}
+
+// Sleep @p us microseconds without spinning: a one-shot esp_timer wakes the task,
+// so waits shorter than a FreeRTOS tick do not cost a whole tick
+static void rdy_sleep_us(ads111x_rdy_t *ctx, uint32_t us)
+{
+    if (ctx->sleep_timer == NULL || esp_timer_start_once(ctx->sleep_timer, us) != ESP_OK)
+    {
+        esp_rom_delay_us(us);
+        return;
+    }
+    if (xSemaphoreTake(ctx->sleep_done, pdMS_TO_TICKS(us / 1000) + 2) != pdTRUE)
+    {
+        // Not expected: stop the timer and drop a give racing with the stop
+        esp_timer_stop(ctx->sleep_timer);
+        xSemaphoreTake(ctx->sleep_done, 0);
+    }
+}
+
+static void rdy_sleep_delete(ads111x_rdy_t *ctx)
+{
+    if (ctx->sleep_timer)
+    {
+        esp_timer_stop(ctx->sleep_timer);
+        esp_timer_delete(ctx->sleep_timer);
+        ctx->sleep_timer = NULL;
+    }
+    if (ctx->sleep_done)
+    {
+        vSemaphoreDelete(ctx->sleep_done);
+        ctx->sleep_done = NULL;
+    }
+}
+
+static esp_err_t rdy_sleep_create(ads111x_rdy_t *ctx)
+{
+    ctx->sleep_done = xSemaphoreCreateBinary();
+    if (!ctx->sleep_done)
+        return ESP_ERR_NO_MEM;
+
+    const esp_timer_create_args_t args = {
+        .callback = rdy_sleep_timer_cb,
+        .arg = ctx,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ads111x_rdy",
+    };
+    esp_err_t res = esp_timer_create(&args, &ctx->sleep_timer);
+    if (res != ESP_OK)
+    {
+        ctx->sleep_timer = NULL;
+        rdy_sleep_delete(ctx);
+    }
+    return res;
+}
+
+esp_err_t ads111x_rdy_init(ads111x_rdy_t *ctx, i2c_dev_t *dev, gpio_num_t alert_gpio,
+        ads111x_gain_t gain, ads111x_data_rate_t rate)
+{
+    CHECK_ARG(ctx && dev);
+
+    ctx->dev = dev;
+    ctx->alert_gpio = alert_gpio;
+    ctx->gain = gain;
+    ctx->rate = rate;
+    ctx->task = xTaskGetCurrentTaskHandle();
+    ctx->conversions = 0;
+    ctx->timeouts = 0;
+    ctx->errors = 0;
+    ctx->started = 0;
+    ctx->sleep_timer = NULL;
+    ctx->sleep_done = NULL;
+    ctx->config = ((gain & PGA_MASK) << PGA_OFFSET)
+            | (ADS111X_MODE_SINGLE_SHOT << MODE_OFFSET)
+            | ((rate & DR_MASK) << DR_OFFSET)
+            | (ADS111X_COMP_MODE_NORMAL << COMP_MODE_OFFSET)
+            | (ADS111X_COMP_POLARITY_LOW << COMP_POL_OFFSET)
+            | (ADS111X_COMP_LATCH_DISABLED << COMP_LAT_OFFSET)
+            | (ADS111X_COMP_QUEUE_1 << COMP_QUE_OFFSET);
+
+    // Hi_thresh MSB = 1, Lo_thresh MSB = 0: ALERT/RDY becomes conversion-ready
+    CHECK(ads111x_set_comp_high_thresh(dev, (int16_t)0x8000));
+    CHECK(ads111x_set_comp_low_thresh(dev, 0x0000));
+
+    I2C_DEV_TAKE_MUTEX(dev);
+    I2C_DEV_CHECK(dev, store_config(dev, ctx->config));
+    I2C_DEV_GIVE_MUTEX(dev);
+
+    if (alert_gpio == GPIO_NUM_NC)
+    {
+        ESP_LOGW(TAG, "ALERT/RDY not connected, polling OS bit");
+        return rdy_sleep_create(ctx);
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << alert_gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE, // ALERT/RDY is open drain
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    CHECK(gpio_config(&io_conf));
+
+    // The ISR service may already be installed by another component
+    esp_err_t res = gpio_install_isr_service(0);
+    if (res != ESP_OK && res != ESP_ERR_INVALID_STATE)
+        return res;
+    CHECK(gpio_isr_handler_add(alert_gpio, rdy_isr_handler, ctx));
+
+    ESP_LOGI(TAG, "Conversion-ready acquisition on GPIO%d, %" PRIu32 " us/conversion",
+            alert_gpio, ads111x_conversion_time_us(rate));
+    return ESP_OK;
+}
+
+esp_err_t ads111x_rdy_free(ads111x_rdy_t *ctx)
+{
+    CHECK_ARG(ctx);
+
+    rdy_sleep_delete(ctx);
+    if (ctx->alert_gpio != GPIO_NUM_NC)
+        CHECK(gpio_isr_handler_remove(ctx->alert_gpio));
+    ctx->task = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t rdy_wait(ads111x_rdy_t *ctx)
+{
+    uint32_t timeout_us = ads111x_conversion_time_us(ctx->rate) * 2 + 2000;
+
+    if (ctx->alert_gpio != GPIO_NUM_NC)
+    {
+        TickType_t ticks = pdMS_TO_TICKS(timeout_us / 1000) + 2;
+        return ulTaskNotifyTake(pdTRUE, ticks) ? ESP_OK : ESP_ERR_TIMEOUT;
+    }
+
+    // No ALERT/RDY: sleep most of the conversion on the one-shot timer (no tick
+    // rounding: 860 SPS does not become 100 SPS, no busy-wait), then poll the OS bit.
+    // Counted from the start of the conversion: devices of an array are waited one after another
+    int64_t ready_at = ctx->started + ads111x_conversion_time_us(ctx->rate) * 9 / 10;
+    int64_t remaining = ready_at - esp_timer_get_time();
+    if (remaining > 0)
+        rdy_sleep_us(ctx, (uint32_t)remaining);
+    int64_t deadline = esp_timer_get_time() + timeout_us;
+    for (;;)
+    {
+        bool busy;
+        CHECK(ads111x_is_busy(ctx->dev, &busy));
+        if (!busy)
+            return ESP_OK;
+        if (esp_timer_get_time() >= deadline)
+            return ESP_ERR_TIMEOUT;
+        rdy_sleep_us(ctx, RDY_POLL_INTERVAL_US);
+    }
+}
+
+// Config register starting a conversion of @p mux with @p gain
+static uint16_t rdy_config(const ads111x_rdy_t *ctx, ads111x_mux_t mux, ads111x_gain_t gain)
+{
+    return (ctx->config & ~(PGA_MASK << PGA_OFFSET)) | ((gain & PGA_MASK) << PGA_OFFSET)
+            | ((mux & MUX_MASK) << MUX_OFFSET) | (1 << OS_OFFSET);
+}
+
+static esp_err_t rdy_start(ads111x_rdy_t *ctx, ads111x_mux_t mux, ads111x_gain_t gain)
+{
+    i2c_dev_t *dev = ctx->dev;
+
+    // Drop an edge left over from a previous (timed out) conversion
+    if (ctx->alert_gpio != GPIO_NUM_NC)
+        ulTaskNotifyTake(pdTRUE, 0);
+
+    // One write starts the conversion on the new input: no read-modify-write needed
+    I2C_DEV_TAKE_MUTEX(dev);
+    I2C_DEV_CHECK(dev, store_config(dev, rdy_config(ctx, mux, gain)));
+    I2C_DEV_GIVE_MUTEX(dev);
+    ctx->started = esp_timer_get_time();
+
+    return ESP_OK;
+}
+
+// Same as ads111x_convert_next(), the gain of the next conversion may differ from the current one
+static esp_err_t rdy_convert_next(ads111x_rdy_t *ctx, ads111x_mux_t mux, ads111x_gain_t gain, int16_t *previous)
+{
+    i2c_dev_t *dev = ctx->dev;
+
+    I2C_DEV_TAKE_MUTEX(dev);
+    I2C_DEV_CHECK(dev, store_config(dev, rdy_config(ctx, mux, gain)));
+    I2C_DEV_CHECK(dev, read_reg(dev, REG_CONVERSION, (uint16_t *)previous));
+    I2C_DEV_GIVE_MUTEX(dev);
+
+    return ESP_OK;
+}
+
+static esp_err_t rdy_complete(ads111x_rdy_t *ctx, ads111x_mux_t mux)
+{
+    esp_err_t res = rdy_wait(ctx);
+    if (res == ESP_ERR_TIMEOUT)
+    {
+        ctx->timeouts++;
+        ESP_LOGW(TAG, "Conversion on mux %d not ready in time", mux);
+    }
+    return res;
+}
+
+esp_err_t ads111x_rdy_read(ads111x_rdy_t *ctx, ads111x_mux_t mux, int16_t *value)
+{
+    CHECK_ARG(ctx && ctx->dev && value);
+
+    esp_err_t res = rdy_start(ctx, mux, ctx->gain);
+    if (res == ESP_OK)
+        res = rdy_complete(ctx, mux);
+    if (res == ESP_OK)
+        res = ads111x_get_value(ctx->dev, value);
+
+    if (res == ESP_OK)
+        ctx->conversions++;
+    else if (res != ESP_ERR_TIMEOUT)
+        ctx->errors++;
+    return res;
+}
+
+/*
+ * Scan @p count inputs on @p devices devices at once: every device converts the same input
+ * at the same time, so the scan takes as long as on a single device.
+ * values[d * count + i] is input i of device d, converted with gains[d * count + i]
+ * (NULL: the gain of the device context).
+ */
+static esp_err_t rdy_scan_devices(ads111x_rdy_t *ctxs, size_t devices, const ads111x_mux_t *muxes,
+        const ads111x_gain_t *gains, size_t count, int16_t *values)
+{
+    esp_err_t first_error = ESP_OK;
+    bool running[ADS111X_ARRAY_MAX_DEVICES] = { 0 }; // Conversion of muxes[i] already started
+
+    if (count == 0)
+        return ESP_OK;
+
+#define SCAN_GAIN(d, i) (gains ? gains[(d) * count + (i)] : ctxs[d].gain)
+
+    // Kick off the first input everywhere, a failed start is retried in the loop
+    for (size_t d = 0; d < devices; d++)
+        running[d] = (rdy_start(&ctxs[d], muxes[0], SCAN_GAIN(d, 0)) == ESP_OK);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t d = 0; d < devices; d++)
+        {
+            ads111x_rdy_t *ctx = &ctxs[d];
+            int16_t *value = &values[d * count + i];
+
+            esp_err_t res = running[d] ? ESP_OK : rdy_start(ctx, muxes[i], SCAN_GAIN(d, i));
+            running[d] = false;
+            if (res == ESP_OK)
+                res = rdy_complete(ctx, muxes[i]);
+            if (res == ESP_OK)
+            {
+                if (i + 1 < count)
+                {
+                    // Start the next input, then read this result while it converts
+                    ctx->started = esp_timer_get_time();
+                    res = rdy_convert_next(ctx, muxes[i + 1], SCAN_GAIN(d, i + 1), value);
+                    running[d] = (res == ESP_OK);
+                }
+                else
+                    res = ads111x_get_value(ctx->dev, value);
+            }
+
+            if (res == ESP_OK)
+                ctx->conversions++;
+            else
+            {
+                if (res != ESP_ERR_TIMEOUT)
+                    ctx->errors++;
+                if (first_error == ESP_OK)
+                    first_error = res;
+            }
+        }
+    }
+#undef SCAN_GAIN
+    return first_error;
+}
+
+esp_err_t ads111x_rdy_scan(ads111x_rdy_t *ctx, const ads111x_mux_t *muxes, size_t count, int16_t *values)
+{
+    CHECK_ARG(ctx && ctx->dev && muxes && values);
+
+    return rdy_scan_devices(ctx, 1, muxes, NULL, count, values);
+}
+
+esp_err_t ads111x_array_init(ads111x_array_t *array, i2c_dev_t *devs, size_t device_count,
+        const ads111x_mux_t *muxes, size_t input_count, gpio_num_t alert_gpio,
+        ads111x_gain_t gain, ads111x_data_rate_t rate)
+{
+    CHECK_ARG(array && devs && muxes && device_count > 0 && device_count <= ADS111X_ARRAY_MAX_DEVICES
+            && input_count > 0 && input_count <= ADS111X_ARRAY_MAX_INPUTS);
+
+    esp_err_t first_error = ESP_OK;
+
+    array->device_count = device_count;
+    array->input_count = input_count;
+    memcpy(array->muxes, muxes, input_count * sizeof(muxes[0]));
+    for (size_t c = 0; c < device_count * input_count; c++)
+        array->gains[c] = gain;
+    for (size_t d = 0; d < device_count; d++)
+    {
+        // All devices start together, the ALERT/RDY line of the first one paces the scan
+        esp_err_t res = ads111x_rdy_init(&array->devices[d], &devs[d], d == 0 ? alert_gpio : GPIO_NUM_NC, gain, rate);
+        if (res != ESP_OK)
+        {
+            // Keep the device: its channels report errors and hold their values
+            ESP_LOGE(TAG, "Array device %u (0x%02x) init failed: %s", (unsigned)d, devs[d].addr, esp_err_to_name(res));
+            if (first_error == ESP_OK)
+                first_error = res;
+        }
+    }
+    return first_error;
+}
+
+esp_err_t ads111x_array_free(ads111x_array_t *array)
+{
+    CHECK_ARG(array);
+
+    for (size_t d = 0; d < array->device_count; d++)
+        ads111x_rdy_free(&array->devices[d]);
+    return ESP_OK;
+}
+
+esp_err_t ads111x_array_verify(ads111x_array_t *array)
+{
+    CHECK_ARG(array);
+
+    esp_err_t first_error = ESP_OK;
+    for (size_t d = 0; d < array->device_count; d++)
+    {
+        ads111x_rdy_t *ctx = &array->devices[d];
+        esp_err_t res = ads111x_verify_config(ctx->dev);
+        if (res == ESP_ERR_INVALID_STATE)
+        {
+            // Reset lost the ALERT/RDY thresholds too: configure the device again
+            ESP_LOGW(TAG, "Array device %u (0x%02x) lost its configuration, re-initializing", (unsigned)d, ctx->dev->addr);
+            ads111x_rdy_free(ctx);
+            if (ads111x_rdy_init(ctx, ctx->dev, ctx->alert_gpio, ctx->gain, ctx->rate) != ESP_OK)
+                res = ESP_FAIL;
+        }
+        if (res != ESP_OK && first_error == ESP_OK)
+            first_error = res;
+    }
+    return first_error;
+}
+
+esp_err_t ads111x_array_scan(ads111x_array_t *array, int16_t *values)
+{
+    CHECK_ARG(array && values);
+
+    return rdy_scan_devices(array->devices, array->device_count, array->muxes, array->gains, array->input_count, values);
+}
+
+esp_err_t ads111x_array_set_gain(ads111x_array_t *array, size_t channel, ads111x_gain_t gain)
+{
+    CHECK_ARG(array && channel < array->device_count * array->input_count && gain <= ADS111X_GAIN_0V256_3);
+
+    // No bus traffic: the gain is part of the config write that starts every conversion
+    array->gains[channel] = gain;
+    return ESP_OK;
+}
+
+size_t ads111x_array_channel_count(const ads111x_array_t *array)
+{
+    return array->device_count * array->input_count;
+}
+
+uint32_t ads111x_array_lost_count(const ads111x_array_t *array)
+{
+    uint32_t lost = 0;
+    for (size_t d = 0; d < array->device_count; d++)
+        lost += array->devices[d].timeouts + array->devices[d].errors;
+    return lost;
+}
@@ -48,6 +48,10 @@
 #include <stdbool.h>
 #include <esp_err.h>
 #include <i2cdev.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -197,6 +201,51 @@ esp_err_t ads111x_free_desc(i2c_dev_t *dev);
  */
 esp_err_t ads111x_is_busy(i2c_dev_t *dev, bool *busy);
 
+/**
+ * @brief Read the config register into the driver cache
+ *
+ * Setters and getters work on a cached copy of the config register, so changing
+ * one field costs a single write and reading one costs no I2C traffic. The cache
+ * is filled on first access; call this after the device lost its configuration
+ * (power cycle, general call reset).
+ *
+ * @param dev Device descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t ads111x_sync_config(i2c_dev_t *dev);
+
+/**
+ * @brief Compare the config register of the device with the driver cache
+ *
+ * The cache is resynchronized with the device in every case.
+ *
+ * @param dev Device descriptor
+ * @return `ESP_OK` if they match, `ESP_ERR_INVALID_STATE` if the device was reconfigured or reset
+ */
+esp_err_t ads111x_verify_config(i2c_dev_t *dev);
+
+/**
+ * @brief Start a conversion on another input and read the previous result
+ *
+ * Writes the cached config with the new MUX and OS set, then reads the conversion
+ * register, which still holds the result of the previous conversion: 2 I2C
+ * transactions instead of set_input_mux + start_conversion + get_value.
+ * Only in single-shot mode, the previous conversion must be complete.
+ *
+ * @param dev Device descriptor
+ * @param mux Input to convert
+ * @param[out] previous Result of the previous conversion
+ * @return `ESP_OK` on success
+ */
+esp_err_t ads111x_convert_next(i2c_dev_t *dev, ads111x_mux_t mux, int16_t *previous);
+
+/**
+ * @brief Number of I2C register transactions issued by the driver (all devices)
+ *
+ * @return Transaction count since boot
+ */
+uint32_t ads111x_get_transaction_count(void);
+
 /**
  * @brief Begin a single conversion
  *
@@ -432,6 +481,186 @@ esp_err_t ads111x_get_comp_high_thresh(i2c_dev_t *dev, int16_t *th);
  */
 esp_err_t ads111x_set_comp_high_thresh(i2c_dev_t *dev, int16_t th);
 
+/**
+ * Conversion-ready acquisition context.
+ *
+ * The comparator is configured as conversion-ready signal (Hi_thresh MSB = 1,
+ * Lo_thresh MSB = 0, assert after one conversion, active low): ALERT/RDY goes
+ * low at the end of every single-shot conversion. A GPIO ISR on that pin wakes
+ * the reading task, so each channel costs one conversion time plus two I2C
+ * transfers instead of a fixed delay. ADS1114 and ADS1115 only.
+ */
+typedef struct
+{
+    i2c_dev_t *dev;             //!< Device descriptor
+    gpio_num_t alert_gpio;      //!< GPIO connected to ALERT/RDY, GPIO_NUM_NC to poll the OS bit instead
+    ads111x_gain_t gain;        //!< Gain used for every conversion
+    ads111x_data_rate_t rate;   //!< Data rate used for every conversion
+    uint16_t config;            //!< Config register template (without OS and MUX)
+    TaskHandle_t task;          //!< Task calling ads111x_rdy_read()/ads111x_rdy_scan()
+    uint32_t conversions;       //!< Completed conversions
+    uint32_t timeouts;          //!< Conversions not signaled in time
+    uint32_t errors;            //!< Conversions lost on an I2C error
+    int64_t started;            //!< esp_timer time the running conversion was started
+    esp_timer_handle_t sleep_timer; //!< One-shot timer ending a poll sleep (no ALERT/RDY)
+    SemaphoreHandle_t sleep_done;   //!< Given by sleep_timer
+} ads111x_rdy_t;
+
+#define ADS111X_ARRAY_MAX_DEVICES 4 //!< One device per address (ADDR to GND, VCC, SDA, SCL)
+#define ADS111X_ARRAY_MAX_INPUTS  4 //!< Inputs scanned on every device
+
+/**
+ * Several devices sampled as one sensor array: every device converts the same input
+ * at the same time, a scan of N devices takes as long as a scan of one
+ */
+typedef struct
+{
+    ads111x_rdy_t devices[ADS111X_ARRAY_MAX_DEVICES]; //!< Conversion-ready context of each device
+    size_t device_count;                              //!< Devices in use
+    ads111x_mux_t muxes[ADS111X_ARRAY_MAX_INPUTS];    //!< Inputs scanned on every device
+    size_t input_count;                               //!< Inputs per device
+    ads111x_gain_t gains[ADS111X_ARRAY_MAX_DEVICES * ADS111X_ARRAY_MAX_INPUTS]; //!< Gain of every channel, see ads111x_array_set_gain()
+} ads111x_array_t;
+
+/**
+ * @brief Nominal conversion time of a data rate
+ *
+ * @param rate Data rate
+ * @return Conversion time in microseconds
+ */
+uint32_t ads111x_conversion_time_us(ads111x_data_rate_t rate);
+
+/**
+ * @brief Configure the device for conversion-ready acquisition
+ *
+ * Switches the device to single-shot mode, programs gain, data rate,
+ * comparator and thresholds, and installs the ALERT/RDY GPIO interrupt.
+ * Must be called from the task that will read values: that task is the one
+ * woken by the interrupt. Without ALERT/RDY the OS bit is polled, the task
+ * sleeping between two reads on a one-shot esp_timer.
+ *
+ * @param ctx Acquisition context
+ * @param dev Device descriptor (initialized by ads111x_init_desc())
+ * @param alert_gpio GPIO connected to ALERT/RDY, GPIO_NUM_NC to poll the OS bit
+ * @param gain Gain value
+ * @param rate Data rate
+ * @return `ESP_OK` on success
+ */
+esp_err_t ads111x_rdy_init(ads111x_rdy_t *ctx, i2c_dev_t *dev, gpio_num_t alert_gpio,
+        ads111x_gain_t gain, ads111x_data_rate_t rate);
+
+/**
+ * @brief Remove the ALERT/RDY interrupt handler (or the polling timer)
+ *
+ * @param ctx Acquisition context
+ * @return `ESP_OK` on success
+ */
+esp_err_t ads111x_rdy_free(ads111x_rdy_t *ctx);
+
+/**
+ * @brief Convert one input and read the result
+ *
+ * Starts a single-shot conversion on @p mux, waits for ALERT/RDY (or the
+ * OS bit) and reads the conversion register.
+ *
+ * @param ctx Acquisition context
+ * @param mux Input multiplexer configuration
+ * @param[out] value Conversion result
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if the conversion was not signaled
+ */
+esp_err_t ads111x_rdy_read(ads111x_rdy_t *ctx, ads111x_mux_t mux, int16_t *value);
+
+/**
+ * @brief Convert several inputs back to back (round-robin over the mux)
+ *
+ * Pipelined: as soon as an input is converted, the next conversion is started and the
+ * result is read while it runs (ads111x_convert_next()), 2 I2C transactions per input.
+ *
+ * @param ctx Acquisition context
+ * @param muxes Inputs to convert
+ * @param count Number of inputs
+ * @param[out] values Conversion results, one per input. Not modified for a failed input
+ * @return `ESP_OK` on success, first error otherwise (remaining inputs are still converted)
+ */
+esp_err_t ads111x_rdy_scan(ads111x_rdy_t *ctx, const ads111x_mux_t *muxes, size_t count, int16_t *values);
+
+/**
+ * @brief Configure devices for array acquisition
+ *
+ * Every device is configured with ads111x_rdy_init(). Only the first device uses
+ * the ALERT/RDY pin: the others finish at the same time and are polled.
+ * A device that fails is kept, its channels report errors on every scan.
+ *
+ * @param array Array context
+ * @param devs Descriptors of the devices, initialized by ads111x_init_desc()
+ * @param device_count Number of devices, up to ::ADS111X_ARRAY_MAX_DEVICES
+ * @param muxes Inputs scanned on every device
+ * @param input_count Number of inputs, up to ::ADS111X_ARRAY_MAX_INPUTS
+ * @param alert_gpio GPIO connected to ALERT/RDY of the first device or `GPIO_NUM_NC`
+ * @param gain Gain of every device
+ * @param rate Data rate of every device
+ * @return `ESP_OK` on success, first device error otherwise
+ */
+esp_err_t ads111x_array_init(ads111x_array_t *array, i2c_dev_t *devs, size_t device_count,
+        const ads111x_mux_t *muxes, size_t input_count, gpio_num_t alert_gpio,
+        ads111x_gain_t gain, ads111x_data_rate_t rate);
+
+/**
+ * @brief Remove the ALERT/RDY interrupt handler of the array
+ *
+ * @param array Array context
+ * @return `ESP_OK` on success
+ */
+esp_err_t ads111x_array_free(ads111x_array_t *array);
+
+/**
+ * @brief Check the configuration of every device, re-initialize the ones that were reset
+ *
+ * @param array Array context
+ * @return `ESP_OK` if every device kept its configuration, first error otherwise
+ */
+esp_err_t ads111x_array_verify(ads111x_array_t *array);
+
+/**
+ * @brief Scan all inputs of all devices
+ *
+ * @param array Array context
+ * @param[out] values ads111x_array_channel_count() results, input i of device d at
+ *                    `values[d * input_count + i]`. Not modified for a failed channel
+ * @return `ESP_OK` on success, first error otherwise (remaining channels are still converted)
+ */
+esp_err_t ads111x_array_scan(ads111x_array_t *array, int16_t *values);
+
+/**
+ * @brief Set the gain of one channel
+ *
+ * Takes effect at the next conversion of the channel: the gain is written with the
+ * mux by the config write that starts the conversion, no extra I2C transaction.
+ * Every channel starts with the gain given to ads111x_array_init().
+ *
+ * @param array Array context
+ * @param channel Channel index, input i of device d is `d * input_count + i`
+ * @param gain Gain value
+ * @return `ESP_OK` on success
+ */
+esp_err_t ads111x_array_set_gain(ads111x_array_t *array, size_t channel, ads111x_gain_t gain);
+
+/**
+ * @brief Number of channels of the array (devices x inputs)
+ *
+ * @param array Array context
+ * @return Channel count
+ */
+size_t ads111x_array_channel_count(const ads111x_array_t *array);
+
+/**
+ * @brief Conversions lost by all devices (timeouts + I2C errors) since initialization
+ *
+ * @param array Array context
+ * @return Lost conversion count
+ */
+uint32_t ads111x_array_lost_count(const ads111x_array_t *array);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,342 @@
+#include "calibration.h"
+#include <string.h>
+#include <math.h>
+
+static const uint8_t calibration_magic[4] = {'E', 'N', 'C', 'L'};
+
+static int32_t calibration_saturate(int64_t value)
+{
+    // INT32_MIN là CALIBRATION_VALUE_NONE
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < -INT32_MAX) {
+        return -INT32_MAX;
+    }
+    return (int32_t)value;
+}
+
+bool calibration_validateCurve(const calibration_curve_st *curve)
+{
+    if (curve->type == CALIBRATION_CURVE_NONE) {
+        return true;
+    }
+    if (curve->type >= CALIBRATION_CURVE_MAX || curve->pointCount < 2 || curve->pointCount > CALIBRATION_POINT_MAX ||
+        curve->tempCoeff_ppm < -1000000 || curve->tempCoeff_ppm > 1000000 ||
+        curve->humCoeff_ppm < -1000000 || curve->humCoeff_ppm > 1000000) {
+        return false;
+    }
+    for (uint8_t p = 0; p < curve->pointCount; p++)
+    {
+        const calibration_point_st *point = &curve->point[p];
+        if (point->value == CALIBRATION_VALUE_NONE) {
+            return false;
+        }
+        if (p != 0 && point->code <= curve->point[p - 1].code) {
+            return false;
+        }
+        if (curve->type == CALIBRATION_CURVE_LOGLOG && (point->code <= 0 || point->value <= 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Giá trị của đoạn giữa điểm @p p và @p p + 1 tại @p code (số thực, chỉ dùng khi dựng bảng).
+ *        Không kẹp: bước cuối của đoạn có thể vượt quá điểm sau.
+ */
+static double calibration_segmentValue(const calibration_curve_st *curve, uint8_t p, double code)
+{
+    double x0 = curve->point[p].code, x1 = curve->point[p + 1].code;
+    double y0 = curve->point[p].value, y1 = curve->point[p + 1].value;
+    if (curve->type == CALIBRATION_CURVE_LOGLOG) {
+        return exp(log(y0) + (log(y1) - log(y0)) * (log(code) - log(x0)) / (log(x1) - log(x0)));
+    }
+    return y0 + (y1 - y0) * (code - x0) / (x1 - x0);
+}
+
+static void calibration_buildLut(calibration_lut_st *lut, const calibration_curve_st *curve)
+{
+    memset(lut, 0, sizeof(*lut));
+    if (curve->type == CALIBRATION_CURVE_NONE) {
+        return;
+    }
+
+    const uint8_t last = curve->pointCount - 1;
+    const int64_t total = (int64_t)curve->point[last].code - curve->point[0].code;
+    const int64_t budget = (int64_t)CALIBRATION_LUT_SEGMENTS - last;   // Bước chia theo span, ngoài 1 bước mỗi đoạn
+
+    lut->valid = true;
+    lut->pointCount = curve->pointCount;
+    lut->tRef_centi = curve->tRef_centi;
+    lut->hRef_centi = curve->hRef_centi;
+    // ppm / °C -> Q30 / 0.01 °C: x 2^30 / 1e6 / 100
+    lut->tempCoeffQ30 = (int32_t)llround((double)curve->tempCoeff_ppm * 1073741824.0 / 1e8);
+    lut->humCoeffQ30 = (int32_t)llround((double)curve->humCoeff_ppm * 1073741824.0 / 1e8);
+
+    uint8_t entry = 0;
+    for (uint8_t p = 0; p < last; p++)
+    {
+        int64_t span = (int64_t)curve->point[p + 1].code - curve->point[p].code;
+        int64_t steps = 1 + budget * span / total;
+        if (steps > span) {
+            steps = span;
+        }
+        uint8_t shift = 0;
+        while ((steps << shift) < span) {
+            shift++;
+        }
+
+        // Entry đầu của đoạn là chính điểm hiệu chuẩn: tại các điểm bảng trả đúng giá trị đã nhập
+        lut->code[p] = curve->point[p].code;
+        lut->shift[p] = shift;
+        lut->first[p] = entry;
+        lut->value[entry] = curve->point[p].value;
+        for (int64_t k = 1; k <= steps; k++)
+        {
+            double value = floor(calibration_segmentValue(curve, p, (double)curve->point[p].code + (double)(k << shift)) + 0.5);
+            lut->value[entry + k] = calibration_saturate((int64_t)fmax(fmin(value, (double)INT32_MAX), (double)-INT32_MAX));
+        }
+        entry += (uint8_t)(steps + 1);
+    }
+    lut->code[last] = curve->point[last].code;
+    lut->first[last] = entry;
+    lut->value[entry] = curve->point[last].value;
+}
+
+/**
+ * @brief Giá trị của bảng tại @p code, chưa bù T/H.
+ */
+static int32_t calibration_lookup(const calibration_lut_st *lut, int32_t code)
+{
+    const uint8_t last = lut->pointCount - 1;
+    if (code <= lut->code[0]) {
+        return lut->value[0];
+    }
+    if (code >= lut->code[last]) {
+        return lut->value[lut->first[last]];
+    }
+
+    uint8_t p = 0;
+    while (code >= lut->code[p + 1]) {
+        p++;
+    }
+    int64_t offset = (int64_t)code - lut->code[p];
+    const int32_t *entry = &lut->value[lut->first[p] + (uint32_t)(offset >> lut->shift[p])];
+    int64_t fraction = offset & (((int64_t)1 << lut->shift[p]) - 1);
+    int64_t step = (int64_t)entry[1] - entry[0];
+    return entry[0] + (int32_t)((step * fraction) >> lut->shift[p]);
+}
+
+/**
+ * @brief Dựng thử bảng của @p curve và kiểm tra mỗi điểm hiệu chuẩn cho lại đúng giá trị của nó.
+ */
+static bool calibration_checkCurve(const calibration_curve_st *curve)
+{
+    calibration_lut_st lut;
+    if (curve->type == CALIBRATION_CURVE_NONE) {
+        return true;
+    }
+    calibration_buildLut(&lut, curve);
+    for (uint8_t p = 0; p < curve->pointCount; p++)
+    {
+        if (calibration_lookup(&lut, curve->point[p].code) != curve->point[p].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool calibration_build(calibration_engine_st *engine, const calibration_table_st *table)
+{
+    if (engine == NULL || table == NULL || table->channelCount > CALIBRATION_CHANNEL_MAX) {
+        return false;
+    }
+    for (uint8_t i = 0; i < table->channelCount; i++)
+    {
+        if (!calibration_validateCurve(&table->curve[i]) || !calibration_checkCurve(&table->curve[i])) {
+            return false;
+        }
+    }
+
+    engine->channelCount = table->channelCount;
+    for (uint8_t i = 0; i < CALIBRATION_CHANNEL_MAX; i++)
+    {
+        if (i < table->channelCount) {
+            calibration_buildLut(&engine->lut[i], &table->curve[i]);
+        } else {
+            memset(&engine->lut[i], 0, sizeof(engine->lut[i]));
+        }
+    }
+    return true;
+}
+
+void calibration_apply(const calibration_engine_st *engine, const int32_t *codes, uint8_t count,
+                       int32_t temperatureCenti, int32_t humidityCenti, int32_t *values)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const calibration_lut_st *lut = &engine->lut[i];
+        if (i >= engine->channelCount || !lut->valid)
+        {
+            values[i] = CALIBRATION_VALUE_NONE;
+            continue;
+        }
+
+        int32_t value = calibration_lookup(lut, codes[i]);
+
+        if (lut->tempCoeffQ30 != 0 || lut->humCoeffQ30 != 0)
+        {
+            int64_t factor = (int64_t)1 << 30;
+            if (temperatureCenti != CALIBRATION_VALUE_NONE) {
+                factor += (int64_t)lut->tempCoeffQ30 * (temperatureCenti - lut->tRef_centi);
+            }
+            if (humidityCenti != CALIBRATION_VALUE_NONE) {
+                factor += (int64_t)lut->humCoeffQ30 * (humidityCenti - lut->hRef_centi);
+            }
+            if (factor < 0) {
+                factor = 0;
+            }
+            value = calibration_saturate(((int64_t)value * factor) >> 30);
+        }
+        values[i] = value;
+    }
+}
+
+static uint32_t calibration_crc32(const uint8_t *data, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static uint8_t *calibration_putLe16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    return out + 2;
+}
+
+static uint8_t *calibration_putLe32(uint8_t *out, uint32_t value)
+{
+    out = calibration_putLe16(out, (uint16_t)value);
+    return calibration_putLe16(out, (uint16_t)(value >> 16));
+}
+
+static uint16_t calibration_getLe16(const uint8_t *in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t calibration_getLe32(const uint8_t *in)
+{
+    return calibration_getLe16(in) | ((uint32_t)calibration_getLe16(in + 2) << 16);
+}
+
+size_t calibration_encode(const calibration_table_st *table, uint8_t *buffer, size_t size)
+{
+    if (table == NULL || buffer == NULL || table->channelCount > CALIBRATION_CHANNEL_MAX) {
+        return 0;
+    }
+
+    size_t total = CALIBRATION_BLOB_HEADER_SIZE + 4U;
+    for (uint8_t i = 0; i < table->channelCount; i++)
+    {
+        const calibration_curve_st *curve = &table->curve[i];
+        if (!calibration_validateCurve(curve)) {
+            return 0;
+        }
+        total += CALIBRATION_BLOB_CURVE_SIZE(curve->type == CALIBRATION_CURVE_NONE ? 0U : curve->pointCount);
+    }
+    if (size < total) {
+        return 0;
+    }
+
+    uint8_t *out = buffer;
+    memcpy(out, calibration_magic, sizeof(calibration_magic));
+    out += sizeof(calibration_magic);
+    *out++ = CALIBRATION_VERSION;
+    *out++ = table->channelCount;
+    out = calibration_putLe16(out, 0);
+    for (uint8_t i = 0; i < table->channelCount; i++)
+    {
+        const calibration_curve_st *curve = &table->curve[i];
+        uint8_t pointCount = (curve->type == CALIBRATION_CURVE_NONE) ? 0 : curve->pointCount;
+        *out++ = curve->type;
+        *out++ = pointCount;
+        out = calibration_putLe16(out, (uint16_t)curve->tRef_centi);
+        out = calibration_putLe16(out, (uint16_t)curve->hRef_centi);
+        out = calibration_putLe32(out, (uint32_t)curve->tempCoeff_ppm);
+        out = calibration_putLe32(out, (uint32_t)curve->humCoeff_ppm);
+        for (uint8_t p = 0; p < pointCount; p++)
+        {
+            out = calibration_putLe32(out, (uint32_t)curve->point[p].code);
+            out = calibration_putLe32(out, (uint32_t)curve->point[p].value);
+        }
+    }
+    out = calibration_putLe32(out, calibration_crc32(buffer, (size_t)(out - buffer)));
+    return (size_t)(out - buffer);
+}
+
+bool calibration_decode(calibration_table_st *table, const uint8_t *data, size_t size)
+{
+    if (table == NULL || data == NULL || size < CALIBRATION_BLOB_HEADER_SIZE + 4U ||
+        memcmp(data, calibration_magic, sizeof(calibration_magic)) != 0 || data[4] != CALIBRATION_VERSION ||
+        data[5] > CALIBRATION_CHANNEL_MAX) {
+        return false;
+    }
+    if (calibration_getLe32(data + size - 4U) != calibration_crc32(data, size - 4U)) {
+        return false;
+    }
+
+    calibration_table_st decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    decoded.channelCount = data[5];
+    size_t position = CALIBRATION_BLOB_HEADER_SIZE;
+    for (uint8_t i = 0; i < decoded.channelCount; i++)
+    {
+        calibration_curve_st *curve = &decoded.curve[i];
+        if (size - 4U - position < CALIBRATION_BLOB_CURVE_SIZE(0)) {
+            return false;
+        }
+        const uint8_t *in = data + position;
+        curve->type = in[0];
+        curve->pointCount = in[1];
+        curve->tRef_centi = (int16_t)calibration_getLe16(in + 2);
+        curve->hRef_centi = (int16_t)calibration_getLe16(in + 4);
+        curve->tempCoeff_ppm = (int32_t)calibration_getLe32(in + 6);
+        curve->humCoeff_ppm = (int32_t)calibration_getLe32(in + 10);
+        if (curve->pointCount > CALIBRATION_POINT_MAX ||
+            size - 4U - position < CALIBRATION_BLOB_CURVE_SIZE(curve->pointCount)) {
+            return false;
+        }
+        in += CALIBRATION_BLOB_CURVE_SIZE(0);
+        for (uint8_t p = 0; p < curve->pointCount; p++, in += 8)
+        {
+            curve->point[p].code = (int32_t)calibration_getLe32(in);
+            curve->point[p].value = (int32_t)calibration_getLe32(in + 4);
+        }
+        if (!calibration_validateCurve(curve)) {
+            return false;
+        }
+        position += CALIBRATION_BLOB_CURVE_SIZE(curve->pointCount);
+    }
+    if (position != size - 4U) {
+        return false;
+    }
+    *table = decoded;
+    return true;
+}
+
+const char *calibration_curveName(uint8_t type)
+{
+    static const char *const names[CALIBRATION_CURVE_MAX] = {"none", "linear", "loglog"};
+    return (type < CALIBRATION_CURVE_MAX) ? names[type] : "?";
+}
@@ -0,0 +1,159 @@
+/**
+ * @file calibration.h
+ * @brief Per-channel calibration curves (ADC code -> concentration) evaluated with integer lookup tables.
+ *
+ * The same table blob is evaluated by the firmware and by the host reprocessing tool
+ * (tools/calibrate.cpp), so archived CSV/binary logs give the same values.
+ *
+ * A curve maps an ADC code normalized to the ±2.048 V range (the value of the CSV/binlog text
+ * outputs, binlog_normalizeCenti() / 100) to a concentration in milli-units (0.001 mg/L, ppm, ...):
+ *  - CALIBRATION_CURVE_LINEAR: piecewise linear between the calibration points.
+ *  - CALIBRATION_CURVE_LOGLOG: straight segments in log(code) / log(concentration), i.e. a power
+ *    law between two points (MOS sensors), codes and concentrations must be > 0.
+ * Below the first and above the last point the curve is clamped (no extrapolation).
+ *
+ * calibration_build() samples each curve (floating point, once) into integer tables, one per
+ * pair of consecutive points: about CALIBRATION_LUT_SEGMENTS steps in total, split between the
+ * pairs by code span, each pair with its own power-of-two step starting on its first point.
+ * Every calibration point is a table entry, so the points are reproduced exactly (checked by
+ * calibration_build()) and the corners of a piecewise curve are kept. calibration_apply() then
+ * costs a search over the points, one shift, one multiply and a few adds per channel.
+ *
+ * Temperature/humidity compensation (DHT/SHT reading of the frame), multiplicative:
+ *   value = curve(code) x (1 + tempCoeff_ppm 1e-6 (T - tRef) + humCoeff_ppm 1e-6 (H - hRef))
+ * with the coefficients precomputed in Q30 per 0.01 °C / 0.01 %RH (no division per frame).
+ *
+ * Blob (NVS, HTTP upload, host tool), little endian:
+ *   0  magic "ENCL"   4 version   5 channel count   6 reserved (u16)
+ *   per channel: u8 type, u8 point count, i16 tRef x100, i16 hRef x100, i32 tempCoeff_ppm,
+ *                i32 humCoeff_ppm, point count x (i32 code, i32 value milli-units)
+ *   u32 CRC-32 (IEEE) of everything before it
+ */
+
+#ifndef __CALIBRATION_H__
+#define __CALIBRATION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CALIBRATION_CHANNEL_MAX     16U
+#define CALIBRATION_POINT_MAX       8U
+#define CALIBRATION_LUT_SEGMENTS    64U
+#define CALIBRATION_VERSION         1U
+#define CALIBRATION_VALUE_NONE      INT32_MIN   /*!< Output of a channel without curve */
+
+#define CALIBRATION_BLOB_HEADER_SIZE    8U
+#define CALIBRATION_BLOB_CURVE_SIZE(pointCount) (14U + 8U * (pointCount))
+#define CALIBRATION_BLOB_MAX_SIZE       (CALIBRATION_BLOB_HEADER_SIZE + 4U + \
+                                         CALIBRATION_CHANNEL_MAX * CALIBRATION_BLOB_CURVE_SIZE(CALIBRATION_POINT_MAX))
+
+typedef enum calibration_curveType
+{
+    CALIBRATION_CURVE_NONE = 0,
+    CALIBRATION_CURVE_LINEAR,
+    CALIBRATION_CURVE_LOGLOG,
+    CALIBRATION_CURVE_MAX,
+} calibration_curveType_t;
+
+typedef struct calibration_point
+{
+    int32_t code;               /*!< ADC code normalized to ±2.048 V */
+    int32_t value;              /*!< Concentration, milli-units */
+} calibration_point_st;
+
+typedef struct calibration_curve
+{
+    uint8_t type;               /*!< calibration_curveType_t */
+    uint8_t pointCount;         /*!< 2..CALIBRATION_POINT_MAX, codes strictly increasing */
+    int16_t tRef_centi;         /*!< Temperature of the calibration, 0.01 °C */
+    int16_t hRef_centi;         /*!< Humidity of the calibration, 0.01 %RH */
+    int32_t tempCoeff_ppm;      /*!< Correction per °C away from tRef, ppm of the value */
+    int32_t humCoeff_ppm;       /*!< Correction per %RH away from hRef, ppm of the value */
+    calibration_point_st point[CALIBRATION_POINT_MAX];
+} calibration_curve_st;
+
+/**
+ * @brief Calibration definition of the array (what is stored and uploaded).
+ */
+typedef struct calibration_table
+{
+    uint8_t channelCount;
+    calibration_curve_st curve[CALIBRATION_CHANNEL_MAX];
+} calibration_table_st;
+
+typedef struct calibration_lut
+{
+    bool valid;
+    uint8_t pointCount;
+    int16_t tRef_centi;
+    int16_t hRef_centi;
+    int32_t tempCoeffQ30;       /*!< Per 0.01 °C */
+    int32_t humCoeffQ30;        /*!< Per 0.01 %RH */
+    int32_t code[CALIBRATION_POINT_MAX];            /*!< Codes of the calibration points */
+    uint8_t shift[CALIBRATION_POINT_MAX - 1];       /*!< Codes per step from point p = 2^shift[p] */
+    uint8_t first[CALIBRATION_POINT_MAX];           /*!< Entry of point p in value[] */
+    int32_t value[CALIBRATION_LUT_SEGMENTS + CALIBRATION_POINT_MAX];
+} calibration_lut_st;
+
+/**
+ * @brief Lookup tables built from a calibration_table_st, what calibration_apply() evaluates.
+ */
+typedef struct calibration_engine
+{
+    uint8_t channelCount;
+    calibration_lut_st lut[CALIBRATION_CHANNEL_MAX];
+} calibration_engine_st;
+
+/**
+ * @brief Check a curve (type, point count, increasing codes, positive values for log-log).
+ *        CALIBRATION_CURVE_NONE is valid.
+ */
+bool calibration_validateCurve(const calibration_curve_st *curve);
+
+/**
+ * @brief Build the lookup tables of every channel and check that every calibration point
+ *        evaluates to its own value.
+ *
+ * @return false if a curve is invalid or does not reproduce its points (@p engine is left unchanged).
+ */
+bool calibration_build(calibration_engine_st *engine, const calibration_table_st *table);
+
+/**
+ * @brief Convert one frame.
+ *
+ * @param[in]  codes           @p count codes normalized to ±2.048 V.
+ * @param[in]  temperatureCenti Temperature of the frame, 0.01 °C, CALIBRATION_VALUE_NONE without sensor
+ *                              (no temperature compensation).
+ * @param[in]  humidityCenti    Humidity of the frame, 0.01 %RH, CALIBRATION_VALUE_NONE without sensor.
+ * @param[out] values          @p count concentrations in milli-units, CALIBRATION_VALUE_NONE for
+ *                             channels without curve (or beyond engine->channelCount).
+ */
+void calibration_apply(const calibration_engine_st *engine, const int32_t *codes, uint8_t count,
+                       int32_t temperatureCenti, int32_t humidityCenti, int32_t *values);
+
+/**
+ * @brief Serialize a table.
+ *
+ * @return Blob size, 0 if @p size is too small or the table is invalid.
+ */
+size_t calibration_encode(const calibration_table_st *table, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Parse and validate a blob (magic, version, CRC, every curve).
+ *
+ * @return false if the blob is not a valid calibration table.
+ */
+bool calibration_decode(calibration_table_st *table, const uint8_t *data, size_t size);
+
+const char *calibration_curveName(uint8_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
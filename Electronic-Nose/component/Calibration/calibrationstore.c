@@ -0,0 +1,209 @@
+#include "calibrationstore.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define CALIBRATION_NVS_NAMESPACE   "calibration"
+#define CALIBRATION_NVS_KEY_TABLE   "table"
+
+static const char *TAG = "Calibration";
+
+static SemaphoreHandle_t calibrationStore_mutex = NULL;        // Bảng đang dùng
+static SemaphoreHandle_t calibrationStore_buildMutex = NULL;   // calibrationStore_scratch
+static calibration_table_st calibrationStore_table;
+static calibration_engine_st calibrationStore_engine;
+static calibration_engine_st calibrationStore_scratch;
+
+static void calibrationStore_log(const calibration_table_st *table)
+{
+    for (uint8_t i = 0; i < table->channelCount; i++)
+    {
+        const calibration_curve_st *curve = &table->curve[i];
+        if (curve->type != CALIBRATION_CURVE_NONE) {
+            ESP_LOGI(TAG, "Sensor%u: %s, %u points, code %" PRId32 "..%" PRId32 " -> %" PRId32 "..%" PRId32 " m%s",
+                     (unsigned)(i + 1), calibration_curveName(curve->type), curve->pointCount, curve->point[0].code,
+                     curve->point[curve->pointCount - 1].code, curve->point[0].value,
+                     curve->point[curve->pointCount - 1].value, CONFIG_CALIBRATION_UNIT);
+        }
+    }
+}
+
+/**
+ * @brief Dựng lookup table cho @p table rồi thay bảng đang dùng.
+ */
+static bool calibrationStore_activate(const calibration_table_st *table)
+{
+    // Dựng bảng (số thực) ngoài calibrationStore_mutex: task lấy mẫu chỉ chờ lúc copy
+    xSemaphoreTake(calibrationStore_buildMutex, portMAX_DELAY);
+    bool built = calibration_build(&calibrationStore_scratch, table);
+    if (built)
+    {
+        xSemaphoreTake(calibrationStore_mutex, portMAX_DELAY);
+        calibrationStore_table = *table;
+        calibrationStore_engine = calibrationStore_scratch;
+        xSemaphoreGive(calibrationStore_mutex);
+    }
+    xSemaphoreGive(calibrationStore_buildMutex);
+    return built;
+}
+
+esp_err_t calibrationStore_init(void)
+{
+    static uint8_t blob[CALIBRATION_BLOB_MAX_SIZE];
+    static calibration_table_st table;
+    nvs_handle_t handle;
+    size_t size = sizeof(blob);
+
+    if (calibrationStore_mutex == NULL)
+    {
+        calibrationStore_buildMutex = xSemaphoreCreateMutex();
+        calibrationStore_mutex = (calibrationStore_buildMutex != NULL) ? xSemaphoreCreateMutex() : NULL;
+    }
+    if (calibrationStore_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = nvs_open(CALIBRATION_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_OK)
+    {
+        err = nvs_get_blob(handle, CALIBRATION_NVS_KEY_TABLE, blob, &size);
+        nvs_close(handle);
+    }
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+    {
+        ESP_LOGI(TAG, "No calibration stored, concentrations disabled (upload to /api/calibration)");
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Cannot read calibration from NVS (%s)", esp_err_to_name(err));
+        return err;
+    }
+    if (!calibration_decode(&table, blob, size) || !calibrationStore_activate(&table))
+    {
+        ESP_LOGE(TAG, "Stored calibration is corrupt, ignored");
+        return ESP_ERR_INVALID_CRC;
+    }
+    ESP_LOGI(TAG, "Calibration loaded: %u channels, %u calibrated", table.channelCount, calibrationStore_calibratedChannels());
+    calibrationStore_log(&table);
+    return ESP_OK;
+}
+
+esp_err_t calibrationStore_update(const uint8_t *blob, size_t size)
+{
+    static calibration_table_st table;
+    nvs_handle_t handle;
+
+    if (calibrationStore_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (blob == NULL || !calibration_decode(&table, blob, size) || !calibrationStore_activate(&table)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "✅ Calibration updated: %u channels, %u calibrated", table.channelCount, calibrationStore_calibratedChannels());
+    calibrationStore_log(&table);
+
+    esp_err_t err = nvs_open(CALIBRATION_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK)
+    {
+        err = nvs_set_blob(handle, CALIBRATION_NVS_KEY_TABLE, blob, size);
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot save calibration to NVS (%s), active until reboot", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void calibrationStore_apply(const int32_t *codes, uint8_t count, int32_t temperatureCenti, int32_t humidityCenti,
+                            int32_t *values)
+{
+    if (calibrationStore_mutex == NULL)
+    {
+        for (uint8_t i = 0; i < count; i++) {
+            values[i] = CALIBRATION_VALUE_NONE;
+        }
+        return;
+    }
+    xSemaphoreTake(calibrationStore_mutex, portMAX_DELAY);
+    calibration_apply(&calibrationStore_engine, codes, count, temperatureCenti, humidityCenti, values);
+    xSemaphoreGive(calibrationStore_mutex);
+}
+
+size_t calibrationStore_export(uint8_t *buffer, size_t size)
+{
+    size_t length = 0;
+    if (calibrationStore_mutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(calibrationStore_mutex, portMAX_DELAY);
+    if (calibrationStore_table.channelCount != 0) {
+        length = calibration_encode(&calibrationStore_table, buffer, size);
+    }
+    xSemaphoreGive(calibrationStore_mutex);
+    return length;
+}
+
+size_t calibrationStore_formatJson(char *buffer, size_t size)
+{
+    static calibration_table_st table;
+    size_t length;
+
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+    if (calibrationStore_mutex != NULL)
+    {
+        xSemaphoreTake(calibrationStore_mutex, portMAX_DELAY);
+        table = calibrationStore_table;
+        xSemaphoreGive(calibrationStore_mutex);
+    }
+
+    length = (size_t)snprintf(buffer, size, "{\"unit\":\"%s\",\"scale\":1000,\"channels\":[", CONFIG_CALIBRATION_UNIT);
+    for (uint8_t i = 0; i < table.channelCount && length < size; i++)
+    {
+        const calibration_curve_st *curve = &table.curve[i];
+        length += (size_t)snprintf(buffer + length, size - length,
+                                   "%s{\"channel\":%u,\"type\":\"%s\",\"tRef\":%.2f,\"hRef\":%.2f,\"tempCoeff_ppm\":%" PRId32 ",\"humCoeff_ppm\":%" PRId32 ",\"points\":[",
+                                   i ? "," : "", (unsigned)(i + 1), calibration_curveName(curve->type),
+                                   curve->tRef_centi / 100.0, curve->hRef_centi / 100.0, curve->tempCoeff_ppm, curve->humCoeff_ppm);
+        for (uint8_t p = 0; curve->type != CALIBRATION_CURVE_NONE && p < curve->pointCount && length < size; p++) {
+            length += (size_t)snprintf(buffer + length, size - length, "%s[%" PRId32 ",%" PRId32 "]", p ? "," : "",
+                                       curve->point[p].code, curve->point[p].value);
+        }
+        if (length < size) {
+            length += (size_t)snprintf(buffer + length, size - length, "]}");
+        }
+    }
+    if (length < size) {
+        length += (size_t)snprintf(buffer + length, size - length, "]}");
+    }
+    if (length >= size)
+    {
+        buffer[0] = '\0';
+        return 0;
+    }
+    return length;
+}
+
+uint8_t calibrationStore_calibratedChannels(void)
+{
+    uint8_t count = 0;
+    if (calibrationStore_mutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(calibrationStore_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < calibrationStore_engine.channelCount; i++) {
+        count += calibrationStore_engine.lut[i].valid ? 1 : 0;
+    }
+    xSemaphoreGive(calibrationStore_mutex);
+    return count;
+}
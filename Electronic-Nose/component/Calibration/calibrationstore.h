@@ -0,0 +1,70 @@
+/**
+ * @file calibrationstore.h
+ * @brief Active calibration of the device: table blob kept in NVS, lookup tables in RAM.
+ *
+ * calibrationStore_init() loads the blob saved by the last calibrationStore_update() (HTTP
+ * upload, see /api/calibration in FileServer.c) and builds the lookup tables. The tables are
+ * swapped under a mutex, so the acquisition task converts frames while a new table is uploaded.
+ */
+
+#ifndef __CALIBRATIONSTORE_H__
+#define __CALIBRATIONSTORE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "calibration.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Load the calibration from NVS. Call once after nvs_flash_init(), before
+ *        calibrationStore_apply().
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND without stored calibration (every channel uncalibrated),
+ *         ESP_ERR_INVALID_CRC if the stored blob is corrupt (ignored), or the NVS error.
+ */
+esp_err_t calibrationStore_init(void);
+
+/**
+ * @brief Validate a table blob (calibration.h), activate it and save it to NVS.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if the blob is not a valid table (active calibration
+ *         unchanged), or the NVS error (the table is active but not persistent).
+ */
+esp_err_t calibrationStore_update(const uint8_t *blob, size_t size);
+
+/**
+ * @brief Convert one frame with the active calibration (see calibration_apply()).
+ */
+void calibrationStore_apply(const int32_t *codes, uint8_t count, int32_t temperatureCenti, int32_t humidityCenti,
+                            int32_t *values);
+
+/**
+ * @brief Copy the active table blob (what was uploaded).
+ *
+ * @return Blob size, 0 without calibration or if @p size is too small.
+ */
+size_t calibrationStore_export(uint8_t *buffer, size_t size);
+
+/**
+ * @brief Describe the active table as JSON: {"unit":"..","channels":[{"channel":1,"type":"loglog",
+ *        "tRef":25.00,"hRef":50.00,"tempCoeff_ppm":..,"humCoeff_ppm":..,"points":[[code,value],..]},..]}
+ *
+ * @return Length (without NUL), 0 if @p size is too small.
+ */
+size_t calibrationStore_formatJson(char *buffer, size_t size);
+
+/**
+ * @brief Number of channels with a curve.
+ */
+uint8_t calibrationStore_calibratedChannels(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,307 @@
+#include "classifier.h"
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+static const uint8_t classifier_magic[4] = {'E', 'N', 'M', 'D'};
+
+static int32_t classifier_saturate(int64_t value)
+{
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)value;
+}
+
+static int64_t classifier_abs64(int64_t value)
+{
+    return (value < 0) ? -value : value;
+}
+
+/**
+ * @brief log2(@p value) Q8, phần lẻ nội suy tuyến tính giữa hai luỹ thừa của 2 (sai số < 0.09).
+ */
+static int32_t classifier_log2Q8(uint64_t value)
+{
+    if (value == 0) {
+        return 0;
+    }
+    int32_t exponent = 63;
+    while ((value & ((uint64_t)1 << exponent)) == 0) {
+        exponent--;
+    }
+    uint64_t mantissa = (exponent >= 8) ? (value >> (exponent - 8)) : (value << (8 - exponent));
+    return exponent * 256 + (int32_t)(mantissa & 0xFF);
+}
+
+uint8_t classifier_features(const eventDetector_event_st *event, int32_t *features)
+{
+    uint8_t count = (event->channelCount > EVENT_DETECTOR_CHANNEL_MAX) ? EVENT_DETECTOR_CHANNEL_MAX : event->channelCount;
+    int64_t peakSum = 0, areaSum = 0;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        peakSum += classifier_abs64(event->channel[i].peakDelta);
+        areaSum += classifier_abs64(event->channel[i].area);
+    }
+
+    int32_t *out = features;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const eventDetector_features_st *channel = &event->channel[i];
+        int64_t peak = classifier_abs64(channel->peakDelta);
+        *out++ = peakSum ? (int32_t)((int64_t)channel->peakDelta * 1000 / peakSum) : 0;
+        *out++ = areaSum ? (int32_t)((int64_t)channel->area * 1000 / areaSum) : 0;
+        *out++ = channel->riseTime_ms;
+        *out++ = channel->timeToPeak_ms;
+        *out++ = peak ? classifier_saturate((int64_t)channel->recoverySlope * 1000 / peak) : 0;
+    }
+    *out++ = classifier_log2Q8((uint64_t)peakSum);
+    *out++ = classifier_saturate(event->duration_ms);
+    return (uint8_t)(out - features);
+}
+
+/**
+ * @brief Tích vô hướng int8 x int8 -> int32, vòng lặp mở 4 (ESP32 không có SIMD, bớt rẽ nhánh và tận dụng MUL16S).
+ */
+static int32_t classifier_dot(const int8_t *weight, const int8_t *input, uint8_t count)
+{
+    int32_t sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    uint8_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        sum0 += (int16_t)weight[i] * input[i];
+        sum1 += (int16_t)weight[i + 1] * input[i + 1];
+        sum2 += (int16_t)weight[i + 2] * input[i + 2];
+        sum3 += (int16_t)weight[i + 3] * input[i + 3];
+    }
+    for (; i < count; i++) {
+        sum0 += (int16_t)weight[i] * input[i];
+    }
+    return sum0 + sum1 + sum2 + sum3;
+}
+
+static int8_t classifier_clamp8(int64_t value, int32_t min)
+{
+    if (value > 127) {
+        return 127;
+    }
+    return (int8_t)((value < min) ? min : value);
+}
+
+void classifier_runFeatures(const classifier_model_st *model, const int32_t *features, classifier_result_st *result)
+{
+    int8_t input[CLASSIFIER_INPUT_MAX];
+    int8_t hidden[CLASSIFIER_HIDDEN_MAX];
+    const int8_t *layer = input;
+    uint8_t layerCount = model->inputCount;
+
+    for (uint8_t i = 0; i < model->inputCount; i++)
+    {
+        int64_t scaled = ((int64_t)features[i] - model->inputOffset[i]) * model->inputScaleQ16[i];
+        input[i] = classifier_clamp8((scaled + 32768) >> 16, -127);
+    }
+    if (model->hiddenCount != 0)
+    {
+        for (uint8_t h = 0; h < model->hiddenCount; h++)
+        {
+            int64_t sum = (int64_t)model->hiddenBias[h] + classifier_dot(model->hiddenWeight[h], input, model->inputCount);
+            hidden[h] = classifier_clamp8(sum >> model->hiddenShift, 0);
+        }
+        layer = hidden;
+        layerCount = model->hiddenCount;
+    }
+
+    uint8_t best = 0;
+    for (uint8_t c = 0; c < model->classCount; c++)
+    {
+        result->logit[c] = classifier_saturate((int64_t)model->outputBias[c] + classifier_dot(model->outputWeight[c], layer, layerCount));
+        if (result->logit[c] > result->logit[best]) {
+            best = c;
+        }
+    }
+    for (uint8_t c = model->classCount; c < CLASSIFIER_CLASS_MAX; c++) {
+        result->logit[c] = 0;
+    }
+
+    // Softmax một lần mỗi event (số thực, ngoài vòng lặp chính)
+    float scale = (float)model->logitScaleQ16 / 65536.0f;
+    float sum = 0.0f;
+    for (uint8_t c = 0; c < model->classCount; c++) {
+        sum += expf((float)((int64_t)result->logit[c] - result->logit[best]) * scale);
+    }
+    result->classIndex = best;
+    result->confidence = (uint8_t)lroundf(100.0f / sum);
+    result->known = result->confidence >= model->minConfidence;
+    strncpy(result->label, result->known ? model->label[best] : "unknown", CLASSIFIER_LABEL_SIZE - 1);
+    result->label[CLASSIFIER_LABEL_SIZE - 1] = '\0';
+}
+
+bool classifier_run(const classifier_model_st *model, const eventDetector_event_st *event, classifier_result_st *result)
+{
+    int32_t features[CLASSIFIER_INPUT_MAX];
+    if (event->channelCount != model->channelCount) {
+        return false;
+    }
+    classifier_features(event, features);
+    classifier_runFeatures(model, features, result);
+    return true;
+}
+
+bool classifier_validate(const classifier_model_st *model)
+{
+    if (model->channelCount == 0 || model->channelCount > EVENT_DETECTOR_CHANNEL_MAX ||
+        model->inputCount != CLASSIFIER_INPUTS(model->channelCount) || model->hiddenCount > CLASSIFIER_HIDDEN_MAX ||
+        model->classCount < 2 || model->classCount > CLASSIFIER_CLASS_MAX || model->hiddenShift > 31 ||
+        model->minConfidence > 100 || model->logitScaleQ16 <= 0) {
+        return false;
+    }
+    for (uint8_t c = 0; c < model->classCount; c++)
+    {
+        // Label đi thẳng vào JSON/CSV: chỉ chữ, số, '_', '-', '.'
+        if (model->label[c][0] == '\0' || memchr(model->label[c], '\0', CLASSIFIER_LABEL_SIZE) == NULL) {
+            return false;
+        }
+        for (const char *character = model->label[c]; *character != '\0'; character++)
+        {
+            if (!isalnum((unsigned char)*character) && strchr("_-.", *character) == NULL) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static uint32_t classifier_crc32(const uint8_t *data, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static uint8_t *classifier_putLe32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+    return out + 4;
+}
+
+static uint32_t classifier_getLe32(const uint8_t *in)
+{
+    return in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint8_t classifier_outputWidth(const classifier_model_st *model)
+{
+    return model->hiddenCount ? model->hiddenCount : model->inputCount;
+}
+
+static size_t classifier_blobSize(const classifier_model_st *model)
+{
+    return CLASSIFIER_BLOB_HEADER_SIZE + (size_t)model->classCount * CLASSIFIER_LABEL_SIZE +
+           (size_t)model->inputCount * 8U + (size_t)model->hiddenCount * (4U + model->inputCount) +
+           (size_t)model->classCount * (4U + classifier_outputWidth(model)) + 4U;
+}
+
+size_t classifier_encode(const classifier_model_st *model, uint8_t *buffer, size_t size)
+{
+    if (model == NULL || buffer == NULL || !classifier_validate(model) || size < classifier_blobSize(model)) {
+        return 0;
+    }
+
+    uint8_t *out = buffer;
+    memcpy(out, classifier_magic, sizeof(classifier_magic));
+    out += sizeof(classifier_magic);
+    *out++ = CLASSIFIER_VERSION;
+    *out++ = model->channelCount;
+    *out++ = model->inputCount;
+    *out++ = model->hiddenCount;
+    *out++ = model->classCount;
+    *out++ = model->hiddenShift;
+    *out++ = model->minConfidence;
+    *out++ = 0;
+    out = classifier_putLe32(out, (uint32_t)model->logitScaleQ16);
+    for (uint8_t c = 0; c < model->classCount; c++)
+    {
+        memset(out, 0, CLASSIFIER_LABEL_SIZE);
+        memcpy(out, model->label[c], strlen(model->label[c]));
+        out += CLASSIFIER_LABEL_SIZE;
+    }
+    for (uint8_t i = 0; i < model->inputCount; i++)
+    {
+        out = classifier_putLe32(out, (uint32_t)model->inputOffset[i]);
+        out = classifier_putLe32(out, (uint32_t)model->inputScaleQ16[i]);
+    }
+    for (uint8_t h = 0; h < model->hiddenCount; h++)
+    {
+        out = classifier_putLe32(out, (uint32_t)model->hiddenBias[h]);
+        memcpy(out, model->hiddenWeight[h], model->inputCount);
+        out += model->inputCount;
+    }
+    for (uint8_t c = 0; c < model->classCount; c++)
+    {
+        out = classifier_putLe32(out, (uint32_t)model->outputBias[c]);
+        memcpy(out, model->outputWeight[c], classifier_outputWidth(model));
+        out += classifier_outputWidth(model);
+    }
+    out = classifier_putLe32(out, classifier_crc32(buffer, (size_t)(out - buffer)));
+    return (size_t)(out - buffer);
+}
+
+bool classifier_decode(classifier_model_st *model, const uint8_t *data, size_t size)
+{
+    if (model == NULL || data == NULL || size < CLASSIFIER_BLOB_HEADER_SIZE + 4U ||
+        memcmp(data, classifier_magic, sizeof(classifier_magic)) != 0 || data[4] != CLASSIFIER_VERSION ||
+        classifier_getLe32(data + size - 4U) != classifier_crc32(data, size - 4U)) {
+        return false;
+    }
+
+    memset(model, 0, sizeof(*model));
+    model->channelCount = data[5];
+    model->inputCount = data[6];
+    model->hiddenCount = data[7];
+    model->classCount = data[8];
+    model->hiddenShift = data[9];
+    model->minConfidence = data[10];
+    model->logitScaleQ16 = (int32_t)classifier_getLe32(data + 12);
+    // Kích thước trước khi đọc label: classifier_validate() cần label, kích thước chỉ cần các chiều
+    if (model->channelCount == 0 || model->channelCount > EVENT_DETECTOR_CHANNEL_MAX ||
+        model->inputCount != CLASSIFIER_INPUTS(model->channelCount) || model->hiddenCount > CLASSIFIER_HIDDEN_MAX ||
+        model->classCount > CLASSIFIER_CLASS_MAX || size != classifier_blobSize(model)) {
+        return false;
+    }
+
+    const uint8_t *in = data + CLASSIFIER_BLOB_HEADER_SIZE;
+    for (uint8_t c = 0; c < model->classCount; c++, in += CLASSIFIER_LABEL_SIZE) {
+        memcpy(model->label[c], in, CLASSIFIER_LABEL_SIZE);
+    }
+    for (uint8_t i = 0; i < model->inputCount; i++, in += 8)
+    {
+        model->inputOffset[i] = (int32_t)classifier_getLe32(in);
+        model->inputScaleQ16[i] = (int32_t)classifier_getLe32(in + 4);
+    }
+    for (uint8_t h = 0; h < model->hiddenCount; h++)
+    {
+        model->hiddenBias[h] = (int32_t)classifier_getLe32(in);
+        memcpy(model->hiddenWeight[h], in + 4, model->inputCount);
+        in += 4U + model->inputCount;
+    }
+    for (uint8_t c = 0; c < model->classCount; c++)
+    {
+        model->outputBias[c] = (int32_t)classifier_getLe32(in);
+        memcpy(model->outputWeight[c], in + 4, classifier_outputWidth(model));
+        in += 4U + classifier_outputWidth(model);
+    }
+    return classifier_validate(model);
+}
@@ -0,0 +1,131 @@
+/**
+ * @file classifier.h
+ * @brief Fixed-point classifier of exposure events (alcohol vs. interferents) over the features
+ *        of eventdetector.h.
+ *
+ * The trainer (tools/train_classifier.cpp) evaluates the exported model with this code, so the
+ * accuracy it reports is the accuracy of the device.
+ *
+ * Feature vector of an event with N channels (classifier_features(), integers):
+ *   per channel: peak and area relative to the sum over the array (‰, signed, independent of the
+ *                concentration: the "smell" pattern), rise time and time to peak (ms), recovery
+ *                slope relative to the peak (‰ of the peak per s)
+ *   global:      log2 of the summed |peak| (Q8, the intensity), event duration (ms)
+ * i.e. CLASSIFIER_INPUTS(N) = 5 N + 2 values.
+ *
+ * Model, a multilayer perceptron with one hidden layer (hiddenCount 0 = linear model):
+ *   input   x_q = clamp(((x - offset) scaleQ16) >> 16, -127, 127)                  int8
+ *   hidden  h   = clamp((bias + sum w x_q) >> hiddenShift, 0, 127)   (ReLU)          int8 weights
+ *   output  logit = bias + sum w h                                                  int8 weights
+ * The class is the largest logit; the confidence is the softmax of logit x logitScaleQ16 / 2^16,
+ * evaluated once per event. Below minConfidence the event is reported as unknown (interferent
+ * not in the training set).
+ *
+ * Blob (model file on SD card / SPIFFS), little endian:
+ *   0 magic "ENMD"  4 version  5 channel count  6 input count  7 hidden count  8 class count
+ *   9 hidden shift  10 min confidence (%)  11 reserved  12 i32 logitScaleQ16
+ *   class count x label (CLASSIFIER_LABEL_SIZE bytes, NUL padded)
+ *   input count x (i32 offset, i32 scaleQ16)
+ *   hidden count x (i32 bias, input count x i8 weight)
+ *   class count x (i32 bias, max(hidden count, input count if hidden count = 0) x i8 weight)
+ *   u32 CRC-32 (IEEE) of everything before it
+ */
+
+#ifndef __CLASSIFIER_H__
+#define __CLASSIFIER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "eventdetector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLASSIFIER_FEATURES_PER_CHANNEL 5U
+#define CLASSIFIER_GLOBAL_FEATURES      2U
+#define CLASSIFIER_INPUTS(channels)     (CLASSIFIER_FEATURES_PER_CHANNEL * (channels) + CLASSIFIER_GLOBAL_FEATURES)
+#define CLASSIFIER_INPUT_MAX            CLASSIFIER_INPUTS(EVENT_DETECTOR_CHANNEL_MAX)
+#define CLASSIFIER_HIDDEN_MAX           32U
+#define CLASSIFIER_CLASS_MAX            8U
+#define CLASSIFIER_LABEL_SIZE           16U     /*!< Label with NUL */
+#define CLASSIFIER_VERSION              1U
+
+#define CLASSIFIER_BLOB_HEADER_SIZE     16U
+#define CLASSIFIER_BLOB_MAX_SIZE        (CLASSIFIER_BLOB_HEADER_SIZE + CLASSIFIER_CLASS_MAX * CLASSIFIER_LABEL_SIZE + \
+                                         CLASSIFIER_INPUT_MAX * 8U + CLASSIFIER_HIDDEN_MAX * (4U + CLASSIFIER_INPUT_MAX) + \
+                                         CLASSIFIER_CLASS_MAX * (4U + CLASSIFIER_INPUT_MAX) + 4U)
+
+typedef struct classifier_model
+{
+    uint8_t channelCount;       /*!< Channels of the events the model was trained on */
+    uint8_t inputCount;         /*!< CLASSIFIER_INPUTS(channelCount) */
+    uint8_t hiddenCount;        /*!< 0..CLASSIFIER_HIDDEN_MAX, 0 = linear model */
+    uint8_t classCount;         /*!< 2..CLASSIFIER_CLASS_MAX */
+    uint8_t hiddenShift;        /*!< Requantization of the hidden layer, 0..31 */
+    uint8_t minConfidence;      /*!< %, below it the event is unknown */
+    int32_t logitScaleQ16;      /*!< Logit units -> natural log odds, Q16 */
+    char label[CLASSIFIER_CLASS_MAX][CLASSIFIER_LABEL_SIZE];
+    int32_t inputOffset[CLASSIFIER_INPUT_MAX];
+    int32_t inputScaleQ16[CLASSIFIER_INPUT_MAX];
+    int32_t hiddenBias[CLASSIFIER_HIDDEN_MAX];
+    int8_t hiddenWeight[CLASSIFIER_HIDDEN_MAX][CLASSIFIER_INPUT_MAX];
+    int32_t outputBias[CLASSIFIER_CLASS_MAX];
+    int8_t outputWeight[CLASSIFIER_CLASS_MAX][CLASSIFIER_INPUT_MAX];    /*!< hiddenCount (or inputCount) used */
+} classifier_model_st;
+
+typedef struct classifier_result
+{
+    uint8_t classIndex;         /*!< Largest logit */
+    uint8_t confidence;         /*!< Softmax of the class, % */
+    bool known;                 /*!< confidence >= minConfidence */
+    char label[CLASSIFIER_LABEL_SIZE];  /*!< Label of the class, "unknown" if !known */
+    int32_t logit[CLASSIFIER_CLASS_MAX];
+} classifier_result_st;
+
+/**
+ * @brief Feature vector of an event (see the file description).
+ *
+ * @param[out] features CLASSIFIER_INPUTS(event->channelCount) values.
+ * @return Number of values.
+ */
+uint8_t classifier_features(const eventDetector_event_st *event, int32_t *features);
+
+/**
+ * @brief Classify a feature vector of model->inputCount values.
+ */
+void classifier_runFeatures(const classifier_model_st *model, const int32_t *features, classifier_result_st *result);
+
+/**
+ * @brief Classify an event.
+ *
+ * @return false if the event does not have the channel count of the model.
+ */
+bool classifier_run(const classifier_model_st *model, const eventDetector_event_st *event, classifier_result_st *result);
+
+/**
+ * @brief Check the dimensions and parameters of a model.
+ */
+bool classifier_validate(const classifier_model_st *model);
+
+/**
+ * @brief Serialize a model.
+ *
+ * @return Blob size, 0 if @p size is too small or the model is invalid.
+ */
+size_t classifier_encode(const classifier_model_st *model, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Parse and validate a blob (magic, version, CRC, dimensions).
+ *
+ * @return false if the blob is not a valid model (@p model is then undefined: decode into a
+ *         scratch model and copy it once valid).
+ */
+bool classifier_decode(classifier_model_st *model, const uint8_t *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+#include "classifierstore.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define CLASSIFIER_PATH_MAX_SIZE    64U
+
+static const char *TAG = "Classifier";
+
+static SemaphoreHandle_t classifierStore_mutex = NULL;         // Model đang dùng
+static SemaphoreHandle_t classifierStore_loadMutex = NULL;     // classifierStore_scratch, classifierStore_blob
+static classifier_model_st classifierStore_model;
+static classifier_model_st classifierStore_scratch;
+static uint8_t classifierStore_blob[CLASSIFIER_BLOB_MAX_SIZE];
+static bool classifierStore_loaded = false;
+static char classifierStore_source[CLASSIFIER_PATH_MAX_SIZE] = "";
+static char classifierStore_sdDirectory[CLASSIFIER_PATH_MAX_SIZE] = "";
+static SemaphoreHandle_t classifierStore_sdLock = NULL;                 // Mutex thẻ SD của ứng dụng
+static classifierStore_mountedCallback classifierStore_sdMounted = NULL;
+static uint32_t classifierStore_events = 0;
+
+/**
+ * @brief Đọc và kiểm tra model trong @p path vào classifierStore_scratch (giữ classifierStore_loadMutex).
+ */
+static esp_err_t classifierStore_readFile(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t size = fread(classifierStore_blob, 1, sizeof(classifierStore_blob), file);
+    bool tooLarge = (size == sizeof(classifierStore_blob)) && (fgetc(file) != EOF);
+    fclose(file);
+
+    if (tooLarge || !classifier_decode(&classifierStore_scratch, classifierStore_blob, size))
+    {
+        ESP_LOGE(TAG, "%s is not a valid model (%u bytes)", path, (unsigned)size);
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+esp_err_t classifierStore_init(const char *sdDirectory, SemaphoreHandle_t sdLock, classifierStore_mountedCallback sdMounted)
+{
+    if (classifierStore_mutex == NULL)
+    {
+        classifierStore_loadMutex = xSemaphoreCreateMutex();
+        classifierStore_mutex = (classifierStore_loadMutex != NULL) ? xSemaphoreCreateMutex() : NULL;
+    }
+    if (classifierStore_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (sdDirectory != NULL) {
+        snprintf(classifierStore_sdDirectory, sizeof(classifierStore_sdDirectory), "%s", sdDirectory);
+    }
+    classifierStore_sdLock = sdLock;
+    classifierStore_sdMounted = sdMounted;
+
+    // Model mặc định nạp cùng firmware vào phân vùng "data" (không format: phân vùng trống chỉ là không có model)
+    const esp_vfs_spiffs_conf_t spiffsConfig = {
+        .base_path = CLASSIFIER_SPIFFS_BASE_PATH,
+        .partition_label = CLASSIFIER_SPIFFS_PARTITION,
+        .max_files = 2,
+        .format_if_mount_failed = false,
+    };
+    esp_err_t err = esp_vfs_spiffs_register(&spiffsConfig);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "SPIFFS partition \"%s\" not mounted (%s)", CLASSIFIER_SPIFFS_PARTITION, esp_err_to_name(err));
+    }
+    return classifierStore_load();
+}
+
+esp_err_t classifierStore_load(void)
+{
+    char paths[2][CLASSIFIER_PATH_MAX_SIZE];
+    bool onSdCard[2] = {false, false};
+    size_t pathCount = 0;
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+
+    if (classifierStore_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Thẻ SD có thể được tháo/mount sau init: kiểm tra ở mỗi lần nạp
+    if (classifierStore_sdDirectory[0] != '\0' && (classifierStore_sdMounted == NULL || classifierStore_sdMounted()))
+    {
+        onSdCard[pathCount] = true;
+        snprintf(paths[pathCount++], CLASSIFIER_PATH_MAX_SIZE, "%s/%s", classifierStore_sdDirectory, CONFIG_CLASSIFIER_MODEL_FILE);
+    }
+    snprintf(paths[pathCount++], CLASSIFIER_PATH_MAX_SIZE, "%s/%s", CLASSIFIER_SPIFFS_BASE_PATH, CONFIG_CLASSIFIER_MODEL_FILE);
+
+    xSemaphoreTake(classifierStore_loadMutex, portMAX_DELAY);
+    for (size_t p = 0; p < pathCount && err != ESP_OK; p++)
+    {
+        // Đọc thẻ SD trong lock của ứng dụng (task ghi log dùng chung SPI/FATFS)
+        bool locked = onSdCard[p] && classifierStore_sdLock != NULL &&
+                      xSemaphoreTake(classifierStore_sdLock, portMAX_DELAY) == pdTRUE;
+        esp_err_t fileError = classifierStore_readFile(paths[p]);
+        if (locked) {
+            xSemaphoreGive(classifierStore_sdLock);
+        }
+        if (fileError == ESP_OK)
+        {
+            // Task event chỉ chờ lúc copy model
+            xSemaphoreTake(classifierStore_mutex, portMAX_DELAY);
+            classifierStore_model = classifierStore_scratch;
+            classifierStore_loaded = true;
+            snprintf(classifierStore_source, sizeof(classifierStore_source), "%s", paths[p]);
+            xSemaphoreGive(classifierStore_mutex);
+        }
+        // File hỏng thì báo lỗi đó thay vì "không có model", vẫn thử nguồn sau
+        if (fileError != ESP_ERR_NOT_FOUND) {
+            err = fileError;
+        }
+    }
+
+    if (err == ESP_OK)
+    {
+        const classifier_model_st *model = &classifierStore_scratch;
+        ESP_LOGI(TAG, "✅ Model loaded from %s: %u channels, %u inputs, %u hidden, %u classes, min confidence %u%%",
+                 classifierStore_source, model->channelCount, model->inputCount, model->hiddenCount,
+                 model->classCount, model->minConfidence);
+        for (uint8_t c = 0; c < model->classCount; c++) {
+            ESP_LOGI(TAG, "   class %u: %s", c, model->label[c]);
+        }
+    }
+    else if (err == ESP_ERR_NOT_FOUND)
+    {
+        ESP_LOGI(TAG, "No model file %s (SD card or SPIFFS), events are not classified", CONFIG_CLASSIFIER_MODEL_FILE);
+    }
+    xSemaphoreGive(classifierStore_loadMutex);
+    return err;
+}
+
+esp_err_t classifierStore_classify(const eventDetector_event_st *event, classifier_result_st *result)
+{
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    if (classifierStore_mutex == NULL) {
+        return err;
+    }
+    xSemaphoreTake(classifierStore_mutex, portMAX_DELAY);
+    if (classifierStore_loaded)
+    {
+        err = classifier_run(&classifierStore_model, event, result) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+        classifierStore_events += (err == ESP_OK) ? 1 : 0;
+    }
+    xSemaphoreGive(classifierStore_mutex);
+    return err;
+}
+
+size_t classifierStore_formatJson(char *buffer, size_t size)
+{
+    size_t length;
+
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+    if (classifierStore_mutex == NULL || xSemaphoreTake(classifierStore_mutex, portMAX_DELAY) != pdTRUE)
+    {
+        length = (size_t)snprintf(buffer, size, "{\"loaded\":false}");
+        return (length < size) ? length : 0;
+    }
+
+    const classifier_model_st *model = &classifierStore_model;
+    if (!classifierStore_loaded) {
+        length = (size_t)snprintf(buffer, size, "{\"loaded\":false,\"file\":\"%s\"}", CONFIG_CLASSIFIER_MODEL_FILE);
+    } else {
+        length = (size_t)snprintf(buffer, size, "{\"loaded\":true,\"source\":\"%s\",\"channels\":%u,\"inputs\":%u,\"hidden\":%u,\"classes\":[",
+                                  classifierStore_source, model->channelCount, model->inputCount, model->hiddenCount);
+        for (uint8_t c = 0; c < model->classCount && length < size; c++) {
+            length += (size_t)snprintf(buffer + length, size - length, "%s\"%s\"", c ? "," : "", model->label[c]);
+        }
+        if (length < size) {
+            length += (size_t)snprintf(buffer + length, size - length, "],\"minConfidence\":%u,\"events\":%" PRIu32 "}",
+                                       model->minConfidence, classifierStore_events);
+        }
+    }
+    xSemaphoreGive(classifierStore_mutex);
+
+    if (length >= size)
+    {
+        buffer[0] = '\0';
+        return 0;
+    }
+    return length;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file classifierstore.h
+ * @brief Active classifier model of the device, loaded from a file on the SD card or on the
+ *        SPIFFS "data" partition.
+ *
+ * classifierStore_load() reads "<SD directory>/" CONFIG_CLASSIFIER_MODEL_FILE, then the same
+ * name on SPIFFS (flashed with the firmware), and swaps the model under a mutex: a model copied
+ * to the SD card (file server upload) is taken by POST /api/classifier/reload without reboot.
+ * The SD card is read under the lock of the application and only when it is mounted at the
+ * time of the load.
+ */
+
+#ifndef __CLASSIFIERSTORE_H__
+#define __CLASSIFIERSTORE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "classifier.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLASSIFIER_SPIFFS_BASE_PATH     "/spiffs"
+#define CLASSIFIER_SPIFFS_PARTITION     "data"
+
+/**
+ * @brief true if the SD card is mounted (called at every load).
+ */
+typedef bool (*classifierStore_mountedCallback)(void);
+
+/**
+ * @brief Mount the SPIFFS partition (read only use) and load the model.
+ *
+ * @param[in] sdDirectory Mount point of the SD card (searched first), NULL for SPIFFS only.
+ * @param[in] sdLock      Mutex of the SD card, held while the model file is read, NULL if none.
+ * @param[in] sdMounted   Checked before each SD card access, NULL if always mounted.
+ * @return ESP_OK, ESP_ERR_NOT_FOUND without model file (events are not classified),
+ *         ESP_ERR_INVALID_CRC if the file is not a valid model.
+ */
+esp_err_t classifierStore_init(const char *sdDirectory, SemaphoreHandle_t sdLock, classifierStore_mountedCallback sdMounted);
+
+/**
+ * @brief Load the model again (SD card first, then SPIFFS). The active model is kept if no valid
+ *        file is found.
+ */
+esp_err_t classifierStore_load(void);
+
+/**
+ * @brief Classify an event with the active model.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without model, ESP_ERR_INVALID_SIZE if the model was
+ *         trained for another channel count.
+ */
+esp_err_t classifierStore_classify(const eventDetector_event_st *event, classifier_result_st *result);
+
+/**
+ * @brief Describe the active model as JSON: {"loaded":true,"source":"/sdcard/MODEL.ENM",
+ *        "channels":4,"inputs":22,"hidden":16,"classes":["ethanol",..],"minConfidence":60,"events":N}
+ *
+ * @return Length (without NUL), 0 if @p size is too small.
+ */
+size_t classifierStore_formatJson(char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,185 @@
+#include "eventformat.h"
+
+/*
+ * Serializer helpers (same contract as in datamanager.c): append to [out, end) and return the new
+ * position, or NULL when the buffer is too small. A NULL position is passed through so callers
+ * check only once at the end.
+ */
+static char *eventFormat_putString(char *out, const char *end, const char *string)
+{
+    if (out == NULL) {
+        return NULL;
+    }
+    while (*string != '\0')
+    {
+        if (out >= end) {
+            return NULL;
+        }
+        *out++ = *string++;
+    }
+    return out;
+}
+
+static char *eventFormat_putInt(char *out, const char *end, int64_t value)
+{
+    char digits[20];
+    size_t count = 0;
+    uint64_t magnitude = (value < 0) ? (0U - (uint64_t)value) : (uint64_t)value;
+
+    if (out == NULL) {
+        return NULL;
+    }
+    do
+    {
+        digits[count++] = (char)('0' + magnitude % 10U);
+        magnitude /= 10U;
+    } while (magnitude != 0);
+
+    if ((size_t)(end - out) < count + (value < 0 ? 1U : 0U)) {
+        return NULL;
+    }
+    if (value < 0) {
+        *out++ = '-';
+    }
+    while (count != 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+static size_t eventFormat_terminate(char *buffer, char *out, const char *end)
+{
+    if (out == NULL || out >= end)
+    {
+        buffer[0] = '\0';
+        return 0;
+    }
+    *out = '\0';
+    return (size_t)(out - buffer);
+}
+
+static const char *const eventFormat_columns[] = {"Baseline", "Peak", "Onset", "Rise", "TimeToPeak", "Area", "Slope"};
+
+static uint8_t eventFormat_channelCount(const eventDetector_event_st *event)
+{
+    return (event->channelCount > EVENT_DETECTOR_CHANNEL_MAX) ? EVENT_DETECTOR_CHANNEL_MAX : event->channelCount;
+}
+
+static void eventFormat_featureValues(const eventDetector_features_st *features, int32_t *values)
+{
+    values[0] = features->baseline;
+    values[1] = features->peakDelta;
+    values[2] = features->onsetDelay_ms;
+    values[3] = features->riseTime_ms;
+    values[4] = features->timeToPeak_ms;
+    values[5] = features->area;
+    values[6] = features->recoverySlope;
+}
+
+size_t eventFormat_csvHeader(uint8_t channelCount, char *buffer, size_t size)
+{
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    const char *end = buffer + size;
+    char *out = eventFormat_putString(buffer, end, "Event,Time_us,Duration_ms,Frames,Mask,Truncated");
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        for (size_t c = 0; c < sizeof(eventFormat_columns) / sizeof(eventFormat_columns[0]); c++)
+        {
+            out = eventFormat_putString(out, end, ",");
+            out = eventFormat_putString(out, end, eventFormat_columns[c]);
+            out = eventFormat_putInt(out, end, i + 1);
+        }
+    }
+    out = eventFormat_putString(out, end, "\n");
+    return eventFormat_terminate(buffer, out, end);
+}
+
+size_t eventFormat_csvRow(const eventDetector_event_st *event, int64_t time_us, char *buffer, size_t size)
+{
+    if (event == NULL || buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    const char *end = buffer + size;
+    char *out = eventFormat_putInt(buffer, end, event->sequence);
+    out = eventFormat_putString(out, end, ",");
+    out = eventFormat_putInt(out, end, time_us);
+    out = eventFormat_putString(out, end, ",");
+    out = eventFormat_putInt(out, end, event->duration_ms);
+    out = eventFormat_putString(out, end, ",");
+    out = eventFormat_putInt(out, end, event->frames);
+    out = eventFormat_putString(out, end, ",");
+    out = eventFormat_putInt(out, end, event->triggerMask);
+    out = eventFormat_putString(out, end, event->truncated ? ",1" : ",0");
+    for (uint8_t i = 0; i < eventFormat_channelCount(event); i++)
+    {
+        int32_t values[sizeof(eventFormat_columns) / sizeof(eventFormat_columns[0])];
+        eventFormat_featureValues(&event->channel[i], values);
+        for (size_t c = 0; c < sizeof(values) / sizeof(values[0]); c++)
+        {
+            out = eventFormat_putString(out, end, ",");
+            out = eventFormat_putInt(out, end, values[c]);
+        }
+    }
+    out = eventFormat_putString(out, end, "\n");
+    return eventFormat_terminate(buffer, out, end);
+}
+
+size_t eventFormat_json(const eventDetector_event_st *event, int64_t time_us, const char *ipString,
+                                  const classifier_result_st *result, char *buffer, size_t size)
+{
+    static const char *const keys[] = {"{\"baseline\":", ",\"peak\":", ",\"onset_ms\":", ",\"rise_ms\":",
+                                       ",\"ttp_ms\":", ",\"area\":", ",\"slope\":"};
+    if (event == NULL || buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    const char *end = buffer + size;
+    char *out = eventFormat_putString(buffer, end, "{\"event\":");
+    out = eventFormat_putInt(out, end, event->sequence);
+    out = eventFormat_putString(out, end, ",\"Time_us\":");
+    out = eventFormat_putInt(out, end, time_us);
+    out = eventFormat_putString(out, end, ",\"duration_ms\":");
+    out = eventFormat_putInt(out, end, event->duration_ms);
+    out = eventFormat_putString(out, end, ",\"frames\":");
+    out = eventFormat_putInt(out, end, event->frames);
+    out = eventFormat_putString(out, end, ",\"mask\":");
+    out = eventFormat_putInt(out, end, event->triggerMask);
+    out = eventFormat_putString(out, end, event->truncated ? ",\"truncated\":1" : ",\"truncated\":0");
+    if (ipString != NULL && ipString[0] != '\0')
+    {
+        out = eventFormat_putString(out, end, ",\"ip\":\"");
+        out = eventFormat_putString(out, end, ipString);
+        out = eventFormat_putString(out, end, "\"");
+    }
+    if (result != NULL)
+    {
+        out = eventFormat_putString(out, end, ",\"class\":{\"label\":\"");
+        out = eventFormat_putString(out, end, result->label);
+        out = eventFormat_putString(out, end, "\",\"index\":");
+        out = eventFormat_putInt(out, end, result->classIndex);
+        out = eventFormat_putString(out, end, ",\"confidence\":");
+        out = eventFormat_putInt(out, end, result->confidence);
+        out = eventFormat_putString(out, end, result->known ? ",\"known\":1}" : ",\"known\":0}");
+    }
+    out = eventFormat_putString(out, end, ",\"channels\":[");
+    for (uint8_t i = 0; i < eventFormat_channelCount(event); i++)
+    {
+        int32_t values[sizeof(keys) / sizeof(keys[0])];
+        eventFormat_featureValues(&event->channel[i], values);
+        if (i != 0) {
+            out = eventFormat_putString(out, end, ",");
+        }
+        for (size_t c = 0; c < sizeof(values) / sizeof(values[0]); c++)
+        {
+            out = eventFormat_putString(out, end, keys[c]);
+            out = eventFormat_putInt(out, end, values[c]);
+        }
+        out = eventFormat_putString(out, end, "}");
+    }
+    out = eventFormat_putString(out, end, "]}");
+    return eventFormat_terminate(buffer, out, end);
+}
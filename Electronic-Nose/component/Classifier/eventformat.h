@@ -0,0 +1,66 @@
+/**
+ * @file eventformat.h
+ * @brief Text formats of the detected events (eventdetector.h) and their classification
+ *        (classifier.h): rows of the event log (.evt CSV on the SD card) and the dashboard JSON.
+ *
+ * Integer only, no heap allocation, no ESP-IDF dependency (tools/train_classifier.cpp reads
+ * the CSV columns by the names of eventFormat_csvHeader()).
+ */
+
+#ifndef __EVENTFORMAT_H__
+#define __EVENTFORMAT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "eventdetector.h"
+#include "classifier.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_FORMAT_CSV_HEADER_MAX_SIZE    (48U + 64U * EVENT_DETECTOR_CHANNEL_MAX)    /*!< Buffer size for eventFormat_csvHeader() */
+#define EVENT_FORMAT_CSV_ROW_MAX_SIZE       (80U + 84U * EVENT_DETECTOR_CHANNEL_MAX)    /*!< Buffer size for eventFormat_csvRow() */
+#define EVENT_FORMAT_JSON_MAX_SIZE          (256U + 168U * EVENT_DETECTOR_CHANNEL_MAX)  /*!< Buffer size for eventFormat_json() */
+
+/**
+ * @brief Format the event CSV header "Event,Time_us,Duration_ms,Frames,Mask,Truncated" followed by
+ *        "Baseline<i>,Peak<i>,Onset<i>,Rise<i>,TimeToPeak<i>,Area<i>,Slope<i>" for each channel.
+ *
+ * @return Length of the line (without NUL), 0 if @p buffer is too small.
+ */
+size_t eventFormat_csvHeader(uint8_t channelCount, char *buffer, size_t size);
+
+/**
+ * @brief Format an event (eventDetector_push()) as one CSV row, columns of eventFormat_csvHeader().
+ *        Values in ADC codes normalized to the ±2.048 V range, times in ms, area in codes x s,
+ *        slope in codes / s.
+ *
+ * @param[in]  event   Event.
+ * @param[in]  time_us Event start in the time base of dataSensor_timeUs().
+ * @param[out] buffer  Destination, NUL terminated on success.
+ * @param[in]  size    Size of @p buffer.
+ *
+ * @return Length of the row (without NUL), 0 if @p buffer is too small.
+ */
+size_t eventFormat_csvRow(const eventDetector_event_st *event, int64_t time_us, char *buffer, size_t size);
+
+/**
+ * @brief Format an event as the dashboard JSON object (POST /api/esp32/event):
+ *        {"event":N,"Time_us":..,"duration_ms":..,"frames":..,"mask":..,"truncated":0|1,"ip":"..",
+ *         "class":{"label":"..","index":..,"confidence":..,"known":0|1},
+ *         "channels":[{"baseline":..,"peak":..,"onset_ms":..,"rise_ms":..,"ttp_ms":..,"area":..,"slope":..},...]}
+ *
+ * @param[in]  ipString Value of the "ip" field, field is omitted when NULL or empty.
+ * @param[in]  result   Classification of the event, "class" is omitted when NULL.
+ *
+ * @return Length of the JSON text (without NUL), 0 if @p buffer is too small.
+ */
+size_t eventFormat_json(const eventDetector_event_st *event, int64_t time_us, const char *ipString,
+                        const classifier_result_st *result, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,264 @@
+#include "binlog.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define BINLOG_GAIN_COUNT       8U
+#define BINLOG_CODE_MAX         32767
+
+// Full scale (mV) theo ads111x_gain_t
+static const uint16_t binlog_fullScale_mV[BINLOG_GAIN_COUNT] = {6144, 4096, 2048, 1024, 512, 256, 256, 256};
+
+static void binlog_put16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void binlog_put32(uint8_t *out, uint32_t value)
+{
+    binlog_put16(out, (uint16_t)value);
+    binlog_put16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t binlog_get16(const uint8_t *in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t binlog_get32(const uint8_t *in)
+{
+    return (uint32_t)binlog_get16(in) | ((uint32_t)binlog_get16(in + 2) << 16);
+}
+
+// Zigzag + varint: thời gian tăng đều nên delta thường chỉ tốn 1-3 byte
+static size_t binlog_putVarint(uint8_t *out, int64_t delta)
+{
+    uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+    size_t length = 0;
+    do
+    {
+        uint8_t byte = zigzag & 0x7F;
+        zigzag >>= 7;
+        out[length++] = byte | (zigzag ? 0x80 : 0x00);
+    } while (zigzag != 0);
+    return length;
+}
+
+/* Returns the bytes consumed, 0 if [in, in + size) does not hold a complete varint */
+static size_t binlog_getVarint(const uint8_t *in, size_t size, int64_t *delta)
+{
+    uint64_t zigzag = 0;
+    size_t length = 0;
+    for (unsigned shift = 0;; shift += 7)
+    {
+        if (length >= size || shift > 63) {
+            return 0;
+        }
+        uint8_t byte = in[length++];
+        zigzag |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    *delta = (int64_t)((zigzag >> 1) ^ (0U - (zigzag & 1U)));
+    return length;
+}
+
+size_t binlog_encodeHeader(const binlog_header_st *header, uint8_t *out, size_t size)
+{
+    if (header == NULL || out == NULL || size < BINLOG_HEADER_SIZE || header->channelCount > BINLOG_CHANNEL_MAX) {
+        return 0;
+    }
+
+    memset(out, 0, BINLOG_HEADER_SIZE);
+    memcpy(out, BINLOG_MAGIC, 4);
+    out[4] = BINLOG_VERSION;
+    out[5] = BINLOG_HEADER_SIZE;
+    out[6] = header->channelCount;
+    out[7] = header->flags;
+    out[8] = header->gain;
+    out[9] = header->dataRate;
+    binlog_put32(out + 12, header->sampleInterval_ms);
+    binlog_put32(out + 16, (uint32_t)((uint64_t)header->startTime));
+    binlog_put32(out + 20, (uint32_t)((uint64_t)header->startTime >> 32));
+    memcpy(out + 24, header->deviceName, strnlen(header->deviceName, BINLOG_DEVICE_NAME_SIZE - 1));
+    return BINLOG_HEADER_SIZE;
+}
+
+size_t binlog_decodeHeader(binlog_header_st *header, binlog_codec_st *codec, const uint8_t *in, size_t size)
+{
+    if (header == NULL || codec == NULL || in == NULL || size < BINLOG_HEADER_SIZE) {
+        return 0;
+    }
+    if (memcmp(in, BINLOG_MAGIC, 4) != 0 || in[4] < BINLOG_VERSION_MIN || in[4] > BINLOG_VERSION || in[5] < BINLOG_HEADER_SIZE ||
+        in[6] == 0 || in[6] > BINLOG_CHANNEL_MAX || size < in[5]) {
+        return 0;
+    }
+
+    memset(header, 0, sizeof(*header));
+    header->version = in[4];
+    header->channelCount = in[6];
+    header->flags = in[7];
+    header->gain = in[8];
+    header->dataRate = in[9];
+    header->sampleInterval_ms = binlog_get32(in + 12);
+    header->startTime = (int64_t)((uint64_t)binlog_get32(in + 16) | ((uint64_t)binlog_get32(in + 20) << 32));
+    memcpy(header->deviceName, in + 24, BINLOG_DEVICE_NAME_SIZE - 1);
+
+    binlog_codecInit(codec, header);
+    return in[5];
+}
+
+void binlog_codecInit(binlog_codec_st *codec, const binlog_header_st *header)
+{
+    codec->previousTimeStamp = 0;
+    codec->previousMonotonic_us = 0;
+    codec->previousEpochOffset_us = 0;
+    codec->channelCount = header->channelCount;
+    codec->flags = header->flags;
+    codec->gain = header->gain;
+}
+
+size_t binlog_encodeRecord(binlog_codec_st *codec, const binlog_record_st *record, uint8_t *out, size_t size)
+{
+    uint8_t buffer[BINLOG_RECORD_MAX_SIZE];
+    size_t length = 0;
+
+    length += binlog_putVarint(buffer, (int32_t)((uint32_t)record->timeStamp - (uint32_t)codec->previousTimeStamp));
+    if (codec->flags & BINLOG_FLAG_SAMPLE_TIME)
+    {
+        length += binlog_putVarint(buffer + length, record->monotonic_us - codec->previousMonotonic_us);
+        length += binlog_putVarint(buffer + length, record->epochOffset_us - codec->previousEpochOffset_us);
+    }
+
+    binlog_put16(buffer + length, (uint16_t)record->temperature_c);
+    binlog_put16(buffer + length + 2, record->humidity_c);
+    length += 4;
+    for (uint8_t i = 0; i < codec->channelCount; i++)
+    {
+        binlog_put16(buffer + length, (uint16_t)record->ADC_Value[i]);
+        length += 2;
+    }
+    if (codec->flags & BINLOG_FLAG_CHANNEL_GAIN)
+    {
+        for (uint8_t i = 0; i < codec->channelCount; i += 2)
+        {
+            uint8_t high = (i + 1 < codec->channelCount) ? record->gain[i + 1] : 0;
+            buffer[length++] = (uint8_t)((record->gain[i] & 0x0F) | ((high & 0x0F) << 4));
+        }
+    }
+
+    if (out == NULL || size < length) {
+        return 0;
+    }
+    memcpy(out, buffer, length);
+    codec->previousTimeStamp = record->timeStamp;
+    if (codec->flags & BINLOG_FLAG_SAMPLE_TIME)
+    {
+        codec->previousMonotonic_us = record->monotonic_us;
+        codec->previousEpochOffset_us = record->epochOffset_us;
+    }
+    return length;
+}
+
+size_t binlog_decodeRecord(binlog_codec_st *codec, binlog_record_st *record, const uint8_t *in, size_t size)
+{
+    int64_t delta = 0;
+    int64_t monotonicDelta = 0;
+    int64_t offsetDelta = 0;
+    size_t length = binlog_getVarint(in, size, &delta);
+    if (length == 0 || delta < INT32_MIN || delta > INT32_MAX) {
+        return 0;
+    }
+    if (codec->flags & BINLOG_FLAG_SAMPLE_TIME)
+    {
+        size_t consumed = binlog_getVarint(in + length, size - length, &monotonicDelta);
+        if (consumed == 0) {
+            return 0;
+        }
+        length += consumed;
+        consumed = binlog_getVarint(in + length, size - length, &offsetDelta);
+        if (consumed == 0) {
+            return 0;
+        }
+        length += consumed;
+    }
+
+    size_t gainBytes = (codec->flags & BINLOG_FLAG_CHANNEL_GAIN) ? (codec->channelCount + 1U) / 2U : 0;
+    if (size - length < 4U + 2U * codec->channelCount + gainBytes) {
+        return 0;
+    }
+
+    memset(record, 0, sizeof(*record));
+    record->timeStamp = (int32_t)((uint32_t)codec->previousTimeStamp + (uint32_t)(int32_t)delta);
+    record->monotonic_us = codec->previousMonotonic_us + monotonicDelta;
+    record->epochOffset_us = codec->previousEpochOffset_us + offsetDelta;
+    record->temperature_c = (int16_t)binlog_get16(in + length);
+    record->humidity_c = binlog_get16(in + length + 2);
+    length += 4;
+    for (uint8_t i = 0; i < codec->channelCount; i++)
+    {
+        record->ADC_Value[i] = (int16_t)binlog_get16(in + length);
+        length += 2;
+    }
+    for (uint8_t i = 0; i < codec->channelCount; i++)
+    {
+        record->gain[i] = gainBytes ? (uint8_t)((in[length + i / 2] >> (4 * (i & 1))) & 0x0F) : codec->gain;
+    }
+    length += gainBytes;
+
+    codec->previousTimeStamp = record->timeStamp;
+    codec->previousMonotonic_us = record->monotonic_us;
+    codec->previousEpochOffset_us = record->epochOffset_us;
+    return length;
+}
+
+int64_t binlog_recordTimeUs(const binlog_record_st *record)
+{
+    return record->monotonic_us + record->epochOffset_us;
+}
+
+static int64_t binlog_divideRound(int64_t value, int64_t divisor)
+{
+    return (value >= 0) ? (value + divisor / 2) / divisor : -((-value + divisor / 2) / divisor);
+}
+
+int32_t binlog_normalizeCenti(int16_t code, uint8_t gain)
+{
+    uint16_t fullScale = binlog_fullScale_mV[gain % BINLOG_GAIN_COUNT];
+    return (int32_t)binlog_divideRound((int64_t)code * 100 * fullScale, binlog_fullScale_mV[BINLOG_REFERENCE_GAIN]);
+}
+
+bool binlog_denormalizeCenti(int32_t centi, int16_t *code, uint8_t *gain)
+{
+    if (centi % 100 == 0 && centi / 100 >= -BINLOG_CODE_MAX - 1 && centi / 100 <= BINLOG_CODE_MAX)
+    {
+        *code = (int16_t)(centi / 100);
+        *gain = BINLOG_REFERENCE_GAIN;
+        return true;
+    }
+    // Range nhỏ nhất (độ phân giải cao nhất) còn chứa giá trị
+    for (int gainIndex = 5; gainIndex >= 0; gainIndex--)
+    {
+        int64_t value = binlog_divideRound((int64_t)centi * binlog_fullScale_mV[BINLOG_REFERENCE_GAIN],
+                                           100 * (int64_t)binlog_fullScale_mV[gainIndex]);
+        if (value >= -BINLOG_CODE_MAX - 1 && value <= BINLOG_CODE_MAX)
+        {
+            *code = (int16_t)value;
+            *gain = (uint8_t)gainIndex;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t binlog_formatNormalized(int16_t code, uint8_t gain, char *buffer, size_t size)
+{
+    int32_t centi = binlog_normalizeCenti(code, gain);
+    uint32_t magnitude = (centi < 0) ? (0U - (uint32_t)centi) : (uint32_t)centi;
+    int length = (magnitude % 100U == 0)
+        ? snprintf(buffer, size, "%" PRId32, centi / 100)
+        : snprintf(buffer, size, "%s%" PRIu32 ".%02" PRIu32, (centi < 0) ? "-" : "", magnitude / 100U, magnitude % 100U);
+    return (length < 0 || (size_t)length >= size) ? 0 : (size_t)length;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file binlog.h
+ * @brief Compact binary log format for sampling sessions (<name>.bin next to <name>.csv).
+ *
+ * The same encoder/decoder is used by the firmware and by the host converter in
+ * tools/binlog2csv.cpp.
+ *
+ * Layout (little endian):
+ *  - Header, BINLOG_HEADER_SIZE bytes:
+ *      0  magic "ENBL"            4  version             5  header size
+ *      6  channel count           7  flags               8  ADC gain (ads111x_gain_t)
+ *      9  ADC data rate          10  reserved (u16)     12  sample interval ms (u32)
+ *     16  session start, unix s (i64)                   24  device name (32 bytes, NUL padded)
+ *     56  reserved (8 bytes)
+ *  - Records, back to back:
+ *      zigzag varint (timeStamp - previous timeStamp), previous = 0 for the first record
+ *      BINLOG_FLAG_SAMPLE_TIME only (version 3): zigzag varint (monotonic µs - previous),
+ *      zigzag varint (epoch offset µs - previous), previous = 0 for the first record
+ *      int16 temperature * 100, uint16 humidity * 100, int16 ADC value * channel count
+ *      BINLOG_FLAG_CHANNEL_GAIN only (version 2): ADC gain of every value, 4 bits each,
+ *      channel 2k in the low nibble of byte k. Without the flag every value uses the header gain.
+ *
+ * Sample time (version 3): esp_timer microseconds at acquisition plus the epoch offset of the
+ * timebase at that moment (0 while not anchored), see binlog_recordTimeUs().
+ *
+ * ADC values are raw codes of their gain. Text outputs (CSV, JSON) show them normalized to the
+ * ±2.048 V range (binlog_normalizeCenti), so rows of different gains compare directly and
+ * files of a fixed ±2.048 V gain keep their integer values.
+ */
+
+#ifndef __BINLOG_H__
+#define __BINLOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BINLOG_MAGIC            "ENBL"
+#define BINLOG_VERSION          3U
+#define BINLOG_VERSION_MIN      1U     /*!< Oldest version the decoder reads */
+#define BINLOG_HEADER_SIZE      64U
+#define BINLOG_CHANNEL_MAX      16U    /*!< Up to 4 ADS111x x 4 inputs */
+#define BINLOG_DEVICE_NAME_SIZE 32U
+#define BINLOG_RECORD_MAX_SIZE  (5U + 10U + 10U + 2U + 2U + 2U * BINLOG_CHANNEL_MAX + BINLOG_CHANNEL_MAX / 2U)
+
+#define BINLOG_FLAG_ENVIRONMENT (1U << 0) /*!< Temperature and humidity fields are valid */
+#define BINLOG_FLAG_CHANNEL_GAIN (1U << 1) /*!< Every record stores the gain of each ADC value (auto gain) */
+#define BINLOG_FLAG_SAMPLE_TIME (1U << 2) /*!< Every record stores its acquisition time (monotonic + epoch offset) */
+
+#define BINLOG_REFERENCE_GAIN   2U     /*!< ads111x_gain_t of ±2.048 V, unit of normalized values (62.5 µV) */
+#define BINLOG_NORMALIZED_TEXT_MAX_SIZE 12U /*!< Buffer size for binlog_formatNormalized() */
+
+typedef struct binlog_header
+{
+    uint8_t version;
+    uint8_t channelCount;
+    uint8_t flags;
+    uint8_t gain;           /*!< ads111x_gain_t, of every value or the initial one with BINLOG_FLAG_CHANNEL_GAIN */
+    uint8_t dataRate;
+    uint32_t sampleInterval_ms;
+    int64_t startTime;
+    char deviceName[BINLOG_DEVICE_NAME_SIZE];
+} binlog_header_st;
+
+typedef struct binlog_record
+{
+    int32_t timeStamp;
+    int64_t monotonic_us;   /*!< esp_timer time at acquisition */
+    int64_t epochOffset_us; /*!< Unix time (µs) - monotonic_us, 0 while the timebase was not anchored */
+    int16_t temperature_c;  /*!< Temperature in 0.01 °C */
+    uint16_t humidity_c;    /*!< Relative humidity in 0.01 % */
+    int16_t ADC_Value[BINLOG_CHANNEL_MAX];
+    uint8_t gain[BINLOG_CHANNEL_MAX];   /*!< ads111x_gain_t of each ADC value */
+} binlog_record_st;
+
+/**
+ * @brief Running state shared by encoder and decoder (previous time stamp, channel count, gain layout).
+ */
+typedef struct binlog_codec
+{
+    int32_t previousTimeStamp;
+    int64_t previousMonotonic_us;
+    int64_t previousEpochOffset_us;
+    uint8_t channelCount;
+    uint8_t flags;
+    uint8_t gain;           /*!< Gain of every value without BINLOG_FLAG_CHANNEL_GAIN */
+} binlog_codec_st;
+
+/**
+ * @brief Serialize a header.
+ *
+ * @return Number of bytes written (BINLOG_HEADER_SIZE), 0 if @p size is too small.
+ */
+size_t binlog_encodeHeader(const binlog_header_st *header, uint8_t *out, size_t size);
+
+/**
+ * @brief Parse a header and prepare @p codec for the following records.
+ *
+ * @return Number of bytes consumed, 0 if the data is not a valid header of a supported version.
+ */
+size_t binlog_decodeHeader(binlog_header_st *header, binlog_codec_st *codec, const uint8_t *in, size_t size);
+
+/**
+ * @brief Initialize @p codec for encoding records of a new file written with @p header.
+ */
+void binlog_codecInit(binlog_codec_st *codec, const binlog_header_st *header);
+
+/**
+ * @brief Serialize one record.
+ *
+ * @return Number of bytes written, 0 if @p size is too small (codec state is unchanged then).
+ */
+size_t binlog_encodeRecord(binlog_codec_st *codec, const binlog_record_st *record, uint8_t *out, size_t size);
+
+/**
+ * @brief Parse one record.
+ *
+ * @return Number of bytes consumed, 0 if @p in does not hold a complete record
+ *         (e.g. the tail of a file cut by a power loss).
+ */
+size_t binlog_decodeRecord(binlog_codec_st *codec, binlog_record_st *record, const uint8_t *in, size_t size);
+
+/**
+ * @brief Time of a record in µs: Unix time when the timebase was anchored, else time since boot.
+ */
+int64_t binlog_recordTimeUs(const binlog_record_st *record);
+
+/**
+ * @brief Value of a raw @p code of @p gain in 0.01 LSB of the ±2.048 V range (BINLOG_REFERENCE_GAIN).
+ */
+int32_t binlog_normalizeCenti(int16_t code, uint8_t gain);
+
+/**
+ * @brief Inverse of binlog_normalizeCenti() for values read back from text: the reference gain
+ *        when the value is an integer code of it, else the smallest range holding the value.
+ *
+ * @return false if the value is outside the ±6.144 V range.
+ */
+bool binlog_denormalizeCenti(int32_t centi, int16_t *code, uint8_t *gain);
+
+/**
+ * @brief Write the normalized value as text: "1234" when it is a whole reference code, else "1234.56".
+ *
+ * @return Length written (without NUL), 0 if @p size is too small.
+ */
+size_t binlog_formatNormalized(int16_t code, uint8_t gain, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
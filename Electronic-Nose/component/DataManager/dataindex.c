@@ -0,0 +1,508 @@
+#include "dataindex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+
+__attribute__((unused)) static const char TAG[] = "Data_index";
+
+static void dataIndex_putLe32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t dataIndex_getLe32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void dataIndex_putLe64(uint8_t *out, int64_t value)
+{
+    dataIndex_putLe32(out, (uint32_t)(uint64_t)value);
+    dataIndex_putLe32(out + 4, (uint32_t)((uint64_t)value >> 32));
+}
+
+static int64_t dataIndex_getLe64(const uint8_t *in)
+{
+    return (int64_t)((uint64_t)dataIndex_getLe32(in) | ((uint64_t)dataIndex_getLe32(in + 4) << 32));
+}
+
+static bool dataIndex_writeHeader(FILE *file, const dataIndex_info_st *info)
+{
+    uint8_t header[DATA_INDEX_HEADER_SIZE];
+    memcpy(header, DATA_INDEX_MAGIC, 4);
+    header[4] = DATA_INDEX_VERSION;
+    header[5] = (uint8_t)info->format;
+    header[6] = (uint8_t)info->stride;
+    header[7] = (uint8_t)(info->stride >> 8);
+    dataIndex_putLe32(&header[8], info->indexedSize);
+    dataIndex_putLe32(&header[12], info->rowCount);
+    dataIndex_putLe32(&header[16], (uint32_t)info->lastTimeStamp);
+    header[20] = info->channelCount;
+    memset(&header[21], 0, 3);
+    dataIndex_putLe64(&header[24], info->lastMonotonic_us);
+    dataIndex_putLe64(&header[32], info->lastEpochOffset_us);
+    return fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+static bool dataIndex_readHeader(FILE *file, dataIndex_info_st *info)
+{
+    uint8_t header[DATA_INDEX_HEADER_SIZE];
+    if (fseek(file, 0, SEEK_SET) != 0 || fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header, DATA_INDEX_MAGIC, 4) != 0 || header[4] != DATA_INDEX_VERSION) {
+        return false;
+    }
+    info->format = (dataIndex_format_t)header[5];
+    info->stride = (uint16_t)(header[6] | (header[7] << 8));
+    info->indexedSize = dataIndex_getLe32(&header[8]);
+    info->rowCount = dataIndex_getLe32(&header[12]);
+    info->lastTimeStamp = (int32_t)dataIndex_getLe32(&header[16]);
+    info->channelCount = header[20];
+    info->lastMonotonic_us = dataIndex_getLe64(&header[24]);
+    info->lastEpochOffset_us = dataIndex_getLe64(&header[32]);
+    return info->stride != 0;
+}
+
+static bool dataIndex_readEntry(FILE *file, uint32_t number, dataIndex_entry_st *entry)
+{
+    uint8_t buffer[DATA_INDEX_ENTRY_SIZE];
+    if (fseek(file, (long)(DATA_INDEX_HEADER_SIZE + number * DATA_INDEX_ENTRY_SIZE), SEEK_SET) != 0 ||
+        fread(buffer, 1, sizeof(buffer), file) != sizeof(buffer)) {
+        return false;
+    }
+    entry->timeStamp = (int32_t)dataIndex_getLe32(&buffer[0]);
+    entry->previousTimeStamp = (int32_t)dataIndex_getLe32(&buffer[4]);
+    entry->offset = dataIndex_getLe32(&buffer[8]);
+    entry->previousMonotonic_us = dataIndex_getLe64(&buffer[12]);
+    entry->previousEpochOffset_us = dataIndex_getLe64(&buffer[20]);
+    return true;
+}
+
+static uint32_t dataIndex_entryCount(const dataIndex_info_st *info)
+{
+    return (info->rowCount + info->stride - 1U) / info->stride;
+}
+
+static FILE *dataIndex_openIndex(const char *dataPath, const char *mode)
+{
+    char indexPath[128];
+    if (snprintf(indexPath, sizeof(indexPath), "%s" DATA_INDEX_EXTENSION, dataPath) >= (int)sizeof(indexPath)) {
+        return NULL;
+    }
+    return fopen(indexPath, mode);
+}
+
+/*
+ * CSV parser helpers: parse [in, end) and return the position after the field, or NULL.
+ */
+static const char *dataIndex_parseInt64(const char *in, const char *end, int64_t *value)
+{
+    bool negative = (in < end && *in == '-');
+    if (negative) {
+        in++;
+    }
+    const char *digits = in;
+    int64_t magnitude = 0;
+    while (in < end && *in >= '0' && *in <= '9')
+    {
+        if (magnitude > (INT64_MAX - 9) / 10) {
+            return NULL;
+        }
+        magnitude = magnitude * 10 + (*in++ - '0');
+    }
+    if (in == digits) {
+        return NULL;
+    }
+    *value = negative ? -magnitude : magnitude;
+    return in;
+}
+
+static const char *dataIndex_parseInt(const char *in, const char *end, int32_t *value)
+{
+    int64_t value64 = 0;
+    in = dataIndex_parseInt64(in, end, &value64);
+    if (in == NULL || value64 > INT32_MAX || value64 < -INT32_MAX) {
+        return NULL;
+    }
+    *value = (int32_t)value64;
+    return in;
+}
+
+/* "-12.34" -> -1234. "nan"/"inf" (old printf based rows without a valid DHT reading) -> 0 */
+static const char *dataIndex_parseCenti(const char *in, const char *end, int32_t *value)
+{
+    bool negative = (in < end && *in == '-');
+    if (negative) {
+        in++;
+    }
+    if (in < end && (*in == 'n' || *in == 'i'))
+    {
+        while (in < end && *in != ',') {
+            in++;
+        }
+        *value = 0;
+        return in;
+    }
+    int32_t integer = 0;
+    in = dataIndex_parseInt(in, end, &integer);
+    if (in == NULL || integer > INT32_MAX / 100 - 1) {
+        return NULL;
+    }
+    int32_t centi = integer * 100;
+    if (in < end && *in == '.')
+    {
+        in++;
+        for (int32_t scale = 10; in < end && *in >= '0' && *in <= '9'; in++, scale /= 10) {
+            centi += (*in - '0') * scale;
+        }
+    }
+    *value = negative ? -centi : centi;
+    return in;
+}
+
+static const char *dataIndex_expectComma(const char *in, const char *end)
+{
+    return (in != NULL && in < end && *in == ',') ? in + 1 : NULL;
+}
+
+/* "STT,Time_us,Temperature,Humidity,Sensor1..SensorN", same layout as dataSensor_formatCsvRow(),
+ * or "STT,Temperature,Humidity,Sensor1..SensorN" of files written before Time_us (@p hasTime false).
+ * Time_us goes to monotonic_us (epoch offset 0), so binlog_recordTimeUs() gives it back.
+ * Returns N, 0 if the line is not a row */
+static uint8_t dataIndex_parseCsvRow(const char *in, const char *end, bool hasTime, binlog_record_st *record)
+{
+    int32_t value = 0;
+    memset(record, 0, sizeof(*record));
+
+    in = dataIndex_parseInt(in, end, &record->timeStamp);
+    in = dataIndex_expectComma(in, end);
+    if (hasTime && in != NULL) {
+        in = dataIndex_expectComma(dataIndex_parseInt64(in, end, &record->monotonic_us), end);
+    }
+    if (in == NULL || (in = dataIndex_parseCenti(in, end, &value)) == NULL) {
+        return 0;
+    }
+    record->temperature_c = (int16_t)((value < INT16_MIN) ? INT16_MIN : (value > INT16_MAX) ? INT16_MAX : value);
+    in = dataIndex_expectComma(in, end);
+    if (in == NULL || (in = dataIndex_parseCenti(in, end, &value)) == NULL) {
+        return 0;
+    }
+    record->humidity_c = (uint16_t)((value < 0) ? 0 : (value > INT16_MAX) ? INT16_MAX : value);
+    uint8_t channelCount = 0;
+    while (in < end && *in == ',')
+    {
+        // Giá trị đã chuẩn hóa về dải ±2.048 V (auto gain có thể ghi phần lẻ), đổi lại thành code + gain
+        in = dataIndex_expectComma(in, end);
+        if (channelCount == BINLOG_CHANNEL_MAX || (in = dataIndex_parseCenti(in, end, &value)) == NULL ||
+            !binlog_denormalizeCenti(value, &record->ADC_Value[channelCount], &record->gain[channelCount])) {
+            return 0;
+        }
+        channelCount++;
+    }
+    return (in == end || *in == '\r') ? channelCount : 0;
+}
+
+static void dataIndex_readerFill(dataIndex_reader_st *reader)
+{
+    if (reader->position != 0)
+    {
+        memmove(reader->buffer, reader->buffer + reader->position, reader->length - reader->position);
+        reader->length -= reader->position;
+        reader->position = 0;
+    }
+    size_t wanted = sizeof(reader->buffer) - reader->length;
+    if (!reader->endOfFile && wanted != 0)
+    {
+        size_t count = fread(reader->buffer + reader->length, 1, wanted, reader->file);
+        reader->length += count;
+        reader->endOfFile = (count < wanted);
+    }
+}
+
+esp_err_t dataIndex_formatFromPath(const char *dataPath, dataIndex_format_t *format)
+{
+    const char *extension = strrchr(dataPath, '.');
+    if (extension != NULL && strcasecmp(extension, ".csv") == 0) {
+        *format = DATA_INDEX_FORMAT_CSV;
+    } else if (extension != NULL && strcasecmp(extension, ".bin") == 0) {
+        *format = DATA_INDEX_FORMAT_BINLOG;
+    } else {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dataIndex_readerOpen(dataIndex_reader_st *reader, const char *dataPath, const dataIndex_entry_st *start)
+{
+    memset(reader, 0, sizeof(*reader));
+    esp_err_t errorCode = dataIndex_formatFromPath(dataPath, &reader->format);
+    if (errorCode != ESP_OK) {
+        return errorCode;
+    }
+    reader->file = fopen(dataPath, "rb");
+    if (reader->file == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (reader->format == DATA_INDEX_FORMAT_BINLOG)
+    {
+        uint8_t header[BINLOG_HEADER_SIZE];
+        size_t length = fread(header, 1, sizeof(header), reader->file);
+        if (binlog_decodeHeader(&reader->header, &reader->codec, header, length) == 0)
+        {
+            dataIndex_readerClose(reader);
+            return ESP_ERR_INVALID_VERSION;
+        }
+        reader->offset = BINLOG_HEADER_SIZE;
+        reader->channelCount = reader->header.channelCount;
+    }
+    else
+    {
+        // Dòng header quyết định layout (có cột Time_us hay không), kể cả khi đọc từ giữa file
+        static const char timeHeader[] = "STT,Time_us,";
+        char line[sizeof(timeHeader) - 1];
+        reader->csvTime = fread(line, 1, sizeof(line), reader->file) == sizeof(line) &&
+                          memcmp(line, timeHeader, sizeof(line)) == 0;
+        if (fseek(reader->file, 0, SEEK_SET) != 0)
+        {
+            dataIndex_readerClose(reader);
+            return ESP_FAIL;
+        }
+    }
+
+    if (start != NULL && start->offset > reader->offset)
+    {
+        if (fseek(reader->file, (long)start->offset, SEEK_SET) != 0)
+        {
+            dataIndex_readerClose(reader);
+            return ESP_FAIL;
+        }
+        reader->offset = start->offset;
+        reader->codec.previousTimeStamp = start->previousTimeStamp;
+        reader->codec.previousMonotonic_us = start->previousMonotonic_us;
+        reader->codec.previousEpochOffset_us = start->previousEpochOffset_us;
+    }
+    reader->rowOffset = reader->offset;
+    return ESP_OK;
+}
+
+bool dataIndex_readerNext(dataIndex_reader_st *reader, binlog_record_st *record)
+{
+    for (;;)
+    {
+        const uint8_t *start = reader->buffer + reader->position;
+        size_t available = reader->length - reader->position;
+
+        if (reader->format == DATA_INDEX_FORMAT_BINLOG)
+        {
+            if (available < BINLOG_RECORD_MAX_SIZE && !reader->endOfFile)
+            {
+                dataIndex_readerFill(reader);
+                continue;
+            }
+            size_t consumed = binlog_decodeRecord(&reader->codec, record, start, available);
+            if (consumed == 0) {
+                return false;   // Hết file hoặc record cuối bị cắt (đang ghi / mất điện)
+            }
+            reader->rowOffset = reader->offset;
+            reader->offset += consumed;
+            reader->position += consumed;
+            return true;
+        }
+
+        const uint8_t *newline = memchr(start, '\n', available);
+        if (newline == NULL)
+        {
+            if (reader->endOfFile) {
+                return false;   // Dòng cuối chưa có '\n': chưa ghi xong
+            }
+            if (available == sizeof(reader->buffer))
+            {
+                // Dòng dài bất thường (file hỏng): bỏ qua
+                reader->offset += available;
+                reader->position = reader->length;
+            }
+            dataIndex_readerFill(reader);
+            continue;
+        }
+
+        size_t lineLength = (size_t)(newline - start) + 1U;
+        uint32_t lineOffset = reader->offset;
+        reader->offset += lineLength;
+        reader->position += lineLength;
+        uint8_t channelCount = dataIndex_parseCsvRow((const char *)start, (const char *)newline, reader->csvTime, record);
+        if (channelCount != 0 && (reader->channelCount == 0 || channelCount == reader->channelCount))
+        {
+            reader->channelCount = channelCount;
+            reader->rowOffset = lineOffset;
+            return true;
+        }
+    }
+}
+
+void dataIndex_readerClose(dataIndex_reader_st *reader)
+{
+    if (reader->file != NULL)
+    {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+esp_err_t dataIndex_update(const char *dataPath, dataIndex_info_st *info)
+{
+    dataIndex_format_t format;
+    esp_err_t errorCode = dataIndex_formatFromPath(dataPath, &format);
+    if (errorCode != ESP_OK) {
+        return errorCode;
+    }
+    struct stat st;
+    if (stat(dataPath, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    FILE *indexFile = dataIndex_openIndex(dataPath, "r+b");
+    bool valid = indexFile != NULL && dataIndex_readHeader(indexFile, info) && info->format == format &&
+                 info->stride == CONFIG_DATALOG_INDEX_STRIDE && info->indexedSize <= (uint32_t)st.st_size;
+    if (valid && info->indexedSize == (uint32_t)st.st_size)
+    {
+        fclose(indexFile);
+        return ESP_OK;
+    }
+    if (!valid)
+    {
+        if (indexFile != NULL) {
+            fclose(indexFile);
+        }
+        indexFile = dataIndex_openIndex(dataPath, "w+b");
+        if (indexFile == NULL) {
+            ESP_LOGE(__func__, "Failed to create index of %s.", dataPath);
+            return ESP_FAIL;
+        }
+        *info = (dataIndex_info_st){.format = format, .stride = CONFIG_DATALOG_INDEX_STRIDE};
+    }
+
+    dataIndex_reader_st *reader = malloc(sizeof(dataIndex_reader_st));
+    if (reader == NULL)
+    {
+        fclose(indexFile);
+        return ESP_ERR_NO_MEM;
+    }
+    const dataIndex_entry_st resume = {
+        .previousTimeStamp = info->lastTimeStamp,
+        .offset = info->indexedSize,
+        .previousMonotonic_us = info->lastMonotonic_us,
+        .previousEpochOffset_us = info->lastEpochOffset_us,
+    };
+    errorCode = dataIndex_readerOpen(reader, dataPath, &resume);
+    if (errorCode == ESP_OK)
+    {
+        if (reader->channelCount == 0) {
+            reader->channelCount = info->channelCount;   // CSV resumed after the first row
+        }
+        binlog_record_st record;
+        uint32_t rowsBefore = info->rowCount;
+        bool writeOk = fseek(indexFile, (long)(DATA_INDEX_HEADER_SIZE + dataIndex_entryCount(info) * DATA_INDEX_ENTRY_SIZE), SEEK_SET) == 0;
+        while (writeOk && dataIndex_readerNext(reader, &record))
+        {
+            if (info->rowCount % info->stride == 0)
+            {
+                uint8_t entry[DATA_INDEX_ENTRY_SIZE];
+                dataIndex_putLe32(&entry[0], (uint32_t)record.timeStamp);
+                dataIndex_putLe32(&entry[4], (uint32_t)info->lastTimeStamp);
+                dataIndex_putLe32(&entry[8], reader->rowOffset);
+                dataIndex_putLe64(&entry[12], info->lastMonotonic_us);
+                dataIndex_putLe64(&entry[20], info->lastEpochOffset_us);
+                writeOk = fwrite(entry, 1, sizeof(entry), indexFile) == sizeof(entry);
+            }
+            info->rowCount++;
+            info->lastTimeStamp = record.timeStamp;
+            info->lastMonotonic_us = record.monotonic_us;
+            info->lastEpochOffset_us = record.epochOffset_us;
+        }
+        info->indexedSize = reader->offset;
+        info->channelCount = reader->channelCount;
+        dataIndex_readerClose(reader);
+
+        if (!writeOk || !dataIndex_writeHeader(indexFile, info)) {
+            errorCode = ESP_FAIL;
+        }
+        ESP_LOGD(__func__, "%s: +%" PRIu32 " rows indexed, %" PRIu32 " rows total.", dataPath, info->rowCount - rowsBefore, info->rowCount);
+    }
+    free(reader);
+
+    if (fclose(indexFile) != 0) {
+        errorCode = ESP_FAIL;
+    }
+    if (errorCode == ESP_FAIL) {
+        ESP_LOGE(__func__, "Failed to update index of %s.", dataPath);
+    }
+    return errorCode;
+}
+
+esp_err_t dataIndex_findTimeStamp(const char *dataPath, const dataIndex_info_st *info, int32_t timeStamp, dataIndex_entry_st *entry)
+{
+    memset(entry, 0, sizeof(*entry));
+    uint32_t count = dataIndex_entryCount(info);
+    if (count == 0) {
+        return ESP_OK;
+    }
+    FILE *indexFile = dataIndex_openIndex(dataPath, "rb");
+    if (indexFile == NULL) {
+        return ESP_FAIL;
+    }
+
+    // Entry cuối cùng có timeStamp <= timeStamp cần tìm
+    uint32_t low = 0;
+    uint32_t high = count;
+    esp_err_t errorCode = ESP_OK;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2U;
+        dataIndex_entry_st candidate;
+        if (!dataIndex_readEntry(indexFile, middle, &candidate))
+        {
+            errorCode = ESP_FAIL;
+            break;
+        }
+        if (candidate.timeStamp <= timeStamp)
+        {
+            *entry = candidate;
+            low = middle + 1U;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    fclose(indexFile);
+    return errorCode;
+}
+
+esp_err_t dataIndex_findRow(const char *dataPath, const dataIndex_info_st *info, uint32_t row,
+                            dataIndex_entry_st *entry, uint32_t *skip)
+{
+    memset(entry, 0, sizeof(*entry));
+    *skip = row;
+    if (row == 0 || info->rowCount == 0) {
+        return ESP_OK;
+    }
+    FILE *indexFile = dataIndex_openIndex(dataPath, "rb");
+    if (indexFile == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t number = MIN(row, info->rowCount - 1U) / info->stride;
+    bool readOk = dataIndex_readEntry(indexFile, number, entry);
+    fclose(indexFile);
+    if (!readOk) {
+        return ESP_FAIL;
+    }
+    *skip = row - number * info->stride;
+    return ESP_OK;
+}
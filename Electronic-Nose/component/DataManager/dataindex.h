@@ -0,0 +1,153 @@
+/**
+ * @file dataindex.h
+ * @brief Sparse row index (<name>.csv.idx / <name>.bin.idx) and row reader for sampling logs.
+ *
+ * The index stores one entry every CONFIG_DATALOG_INDEX_STRIDE rows, so a query for a window of
+ * a session file seeks close to the first row instead of parsing the whole file. It is built
+ * lazily by dataIndex_update() and only extended afterwards (the data files are append-only).
+ *
+ * Index layout (little endian):
+ *  - Header, DATA_INDEX_HEADER_SIZE bytes:
+ *      0  magic "ENIX"    4  version    5  data format (dataIndex_format_t)    6  stride (u16)
+ *      8  indexed size of the data file (u32)   12  row count (u32)   16  last timeStamp (i32)
+ *     20  sensor channel count of the rows       21  reserved (3 bytes)
+ *     24  monotonic µs of the last row (i64)     32  epoch offset µs of the last row (i64)
+ *  - Entries, DATA_INDEX_ENTRY_SIZE bytes each, entry k describes row k * stride:
+ *      0  timeStamp (i32)   4  timeStamp of the previous row (i32, binlog delta base)   8  offset (u32)
+ *     12  monotonic µs of the previous row (i64)   20  epoch offset µs of the previous row (i64)
+ *     (binlog delta bases of BINLOG_FLAG_SAMPLE_TIME, 0 for CSV and older binlogs)
+ */
+
+#ifndef __DATAINDEX_H__
+#define __DATAINDEX_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "binlog.h"
+
+#define DATA_INDEX_MAGIC            "ENIX"
+#define DATA_INDEX_VERSION          3U
+#define DATA_INDEX_HEADER_SIZE      40U
+#define DATA_INDEX_ENTRY_SIZE       28U
+#define DATA_INDEX_EXTENSION        ".idx"
+
+typedef enum dataIndex_format
+{
+    DATA_INDEX_FORMAT_CSV = 0,
+    DATA_INDEX_FORMAT_BINLOG,
+} dataIndex_format_t;
+
+typedef struct dataIndex_info
+{
+    dataIndex_format_t format;
+    uint16_t stride;
+    uint32_t indexedSize;       /*!< Bytes of the data file covered by the index (complete rows only) */
+    uint32_t rowCount;
+    int32_t lastTimeStamp;
+    int64_t lastMonotonic_us;
+    int64_t lastEpochOffset_us;
+    uint8_t channelCount;       /*!< Sensor channels of the rows, 0 while the file has no row */
+} dataIndex_info_st;
+
+typedef struct dataIndex_entry
+{
+    int32_t timeStamp;
+    int32_t previousTimeStamp;
+    uint32_t offset;
+    int64_t previousMonotonic_us;
+    int64_t previousEpochOffset_us;
+} dataIndex_entry_st;
+
+/**
+ * @brief Sequential reader of the rows of a .csv or .bin session file.
+ *        Unparsable CSV lines (header, corrupted rows) are skipped, an incomplete last row ends the file.
+ *        CSV rows must all have the same number of sensor columns: channelCount is taken from
+ *        the first row (or set by the caller from dataIndex_info_st), other rows are skipped.
+ *        A CSV header "STT,Time_us,..." (first line) selects the layout with the time column.
+ */
+typedef struct dataIndex_reader
+{
+    FILE *file;
+    dataIndex_format_t format;
+    binlog_codec_st codec;
+    binlog_header_st header;    /*!< Header of a .bin file */
+    uint8_t channelCount;       /*!< Sensor channels of the rows, 0 until known */
+    bool csvTime;               /*!< CSV rows have the Time_us column */
+    uint32_t rowOffset;         /*!< File offset of the row returned by the last dataIndex_readerNext() */
+    uint32_t offset;            /*!< File offset following that row */
+    uint8_t buffer[256];
+    size_t position;
+    size_t length;
+    bool endOfFile;
+} dataIndex_reader_st;
+
+/**
+ * @brief Data format of a file, from its extension.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED if the file is neither .csv nor .bin.
+ */
+esp_err_t dataIndex_formatFromPath(const char *dataPath, dataIndex_format_t *format);
+
+/**
+ * @brief Create or extend the index of @p dataPath (<dataPath>.idx) to cover every complete row.
+ *        A data file smaller than the indexed size (rewritten) makes the index rebuilt.
+ *
+ * @param[in]  dataPath Full path of the .csv or .bin file.
+ * @param[out] info     Index state after the update.
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK on success.
+ * @retval  - ESP_ERR_NOT_FOUND if the data file does not exist.
+ * @retval  - ESP_ERR_NOT_SUPPORTED if the file is not a .csv or .bin file.
+ * @retval  - ESP_ERR_INVALID_VERSION if the .bin file header is not supported.
+ * @retval  - ESP_FAIL on read/write error.
+ */
+esp_err_t dataIndex_update(const char *dataPath, dataIndex_info_st *info);
+
+/**
+ * @brief Find the entry to start reading from so that every row with timeStamp >= @p timeStamp follows.
+ *        Rows in a session file have increasing time stamps.
+ *
+ * @param[in]  dataPath  Full path of the data file.
+ * @param[in]  info      Index state returned by dataIndex_update().
+ * @param[in]  timeStamp First time stamp wanted.
+ * @param[out] entry     Start position, row offset 0 means "from the first row".
+ *
+ * @return ESP_OK, ESP_FAIL on read error.
+ */
+esp_err_t dataIndex_findTimeStamp(const char *dataPath, const dataIndex_info_st *info, int32_t timeStamp, dataIndex_entry_st *entry);
+
+/**
+ * @brief Find the entry at or before row number @p row (0 based).
+ *
+ * @param[out] entry Start position.
+ * @param[out] skip  Rows to skip after @p entry to reach @p row.
+ *
+ * @return ESP_OK, ESP_FAIL on read error.
+ */
+esp_err_t dataIndex_findRow(const char *dataPath, const dataIndex_info_st *info, uint32_t row,
+                            dataIndex_entry_st *entry, uint32_t *skip);
+
+/**
+ * @brief Open @p dataPath for reading rows.
+ *
+ * @param[in] start Position from the index, NULL (or offset 0) to start at the first row.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_NOT_SUPPORTED or ESP_ERR_INVALID_VERSION.
+ */
+esp_err_t dataIndex_readerOpen(dataIndex_reader_st *reader, const char *dataPath, const dataIndex_entry_st *start);
+
+/**
+ * @brief Read the next row.
+ *
+ * @return true if @p record holds a row, false at the end of the file.
+ */
+bool dataIndex_readerNext(dataIndex_reader_st *reader, binlog_record_st *record);
+
+void dataIndex_readerClose(dataIndex_reader_st *reader);
+
+#endif
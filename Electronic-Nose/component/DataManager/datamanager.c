@@ -1,3 +1,397 @@
 #include "datamanager.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 __attribute__((unused)) static const char TAG[] = "Data_manager";
+
+/**
+ * @brief Round |value| to 0.01 units exactly like "%.2f" does.
+ *
+ * |value| = mantissa x 2^exponent, so |value| x 100 = (mantissa x 100) x 2^exponent with
+ * mantissa x 100 < 2^31: the shifted-out bits are the exact fraction, halves are rounded to
+ * even as newlib's printf does.
+ */
+static uint32_t dataSensor_roundCentiMagnitude(float value)
+{
+    const uint32_t limit = 2000000000U;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t biasedExponent = (bits >> 23) & 0xFFU;
+    uint32_t mantissa = bits & 0x7FFFFFU;
+    if (biasedExponent == 0xFFU) {
+        return (mantissa != 0) ? 0U : limit;        // NaN, infinity
+    }
+    int32_t exponent = -149;                        // Subnormal
+    if (biasedExponent != 0)
+    {
+        mantissa |= 0x800000U;
+        exponent = (int32_t)biasedExponent - 150;
+    }
+
+    uint64_t scaled = (uint64_t)mantissa * 100U;
+    if (exponent >= 0) {
+        return (exponent > 32 || (scaled << exponent) > limit) ? limit : (uint32_t)(scaled << exponent);
+    }
+    if (exponent < -62) {
+        return 0U;                                  // < 2^-31
+    }
+
+    uint32_t shift = (uint32_t)-exponent;
+    uint64_t integer = scaled >> shift;
+    uint64_t fraction = scaled & ((1ULL << shift) - 1U);
+    uint64_t half = 1ULL << (shift - 1U);
+    if (fraction > half || (fraction == half && (integer & 1U))) {
+        integer++;
+    }
+    return (integer > limit) ? limit : (uint32_t)integer;
+}
+
+static int32_t dataSensor_roundCenti(float value)
+{
+    int32_t magnitude = (int32_t)dataSensor_roundCentiMagnitude(value);
+    return signbit(value) ? -magnitude : magnitude;
+}
+
+static int16_t dataSensor_toCenti(float value, int32_t minValue, int32_t maxValue)
+{
+    int32_t centi = dataSensor_roundCenti(value);
+    if (centi < minValue) {
+        centi = minValue;
+    } else if (centi > maxValue) {
+        centi = maxValue;
+    }
+    return (int16_t)centi;
+}
+
+/*
+ * Serializer helpers: append to [out, end) and return the new position, or NULL when the
+ * buffer is too small. A NULL position is passed through so callers check only once at the end.
+ */
+static char *dataSensor_putString(char *out, const char *end, const char *string)
+{
+    if (out == NULL) {
+        return NULL;
+    }
+    while (*string != '\0')
+    {
+        if (out >= end) {
+            return NULL;
+        }
+        *out++ = *string++;
+    }
+    return out;
+}
+
+static char *dataSensor_putInt(char *out, const char *end, int64_t value)
+{
+    char digits[20];
+    size_t count = 0;
+    uint64_t magnitude = (value < 0) ? (0U - (uint64_t)value) : (uint64_t)value;
+
+    if (out == NULL) {
+        return NULL;
+    }
+    do
+    {
+        digits[count++] = (char)('0' + magnitude % 10U);
+        magnitude /= 10U;
+    } while (magnitude != 0);
+
+    if ((size_t)(end - out) < count + (value < 0 ? 1U : 0U)) {
+        return NULL;
+    }
+    if (value < 0) {
+        *out++ = '-';
+    }
+    while (count != 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+static char *dataSensor_putCenti(char *out, const char *end, float value)
+{
+    if (out == NULL) {
+        return NULL;
+    }
+    if (signbit(value) && value == value) {
+        out = dataSensor_putString(out, end, "-");
+    }
+    uint32_t centi = dataSensor_roundCentiMagnitude(value);
+    out = dataSensor_putInt(out, end, centi / 100U);
+    if (out == NULL || end - out < 3) {
+        return NULL;
+    }
+    *out++ = '.';
+    *out++ = (char)('0' + (centi / 10U) % 10U);
+    *out++ = (char)('0' + centi % 10U);
+    return out;
+}
+
+static char *dataSensor_putMilli(char *out, const char *end, int32_t value)
+{
+    if (out == NULL) {
+        return NULL;
+    }
+    if (value < 0) {
+        out = dataSensor_putString(out, end, "-");
+    }
+    uint32_t milli = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+    out = dataSensor_putInt(out, end, milli / 1000U);
+    if (out == NULL || end - out < 4) {
+        return NULL;
+    }
+    *out++ = '.';
+    *out++ = (char)('0' + (milli / 100U) % 10U);
+    *out++ = (char)('0' + (milli / 10U) % 10U);
+    *out++ = (char)('0' + milli % 10U);
+    return out;
+}
+
+static char *dataSensor_putNormalized(char *out, const char *end, const struct dataSensor_st *dataSensor, uint8_t channel)
+{
+    char text[BINLOG_NORMALIZED_TEXT_MAX_SIZE];
+    if (binlog_formatNormalized(dataSensor->ADC_Value[channel], dataSensor->gain[channel], text, sizeof(text)) == 0) {
+        return NULL;
+    }
+    return dataSensor_putString(out, end, text);
+}
+
+static size_t dataSensor_terminate(char *buffer, char *out, const char *end)
+{
+    if (out == NULL || out >= end)
+    {
+        buffer[0] = '\0';
+        return 0;
+    }
+    *out = '\0';
+    return (size_t)(out - buffer);
+}
+
+size_t dataSensor_formatCsvHeader(uint8_t channelCount, char *buffer, size_t size)
+{
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    const char *end = buffer + size;
+    char *out = dataSensor_putString(buffer, end, "STT,Time_us,Temperature,Humidity");
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        out = dataSensor_putString(out, end, ",Sensor");
+        out = dataSensor_putInt(out, end, i + 1);
+    }
+    out = dataSensor_putString(out, end, "\n");
+    return dataSensor_terminate(buffer, out, end);
+}
+
+int64_t dataSensor_timeUs(const struct dataSensor_st *dataSensor)
+{
+    return dataSensor->monotonic_us + dataSensor->epochOffset_us;
+}
+
+static uint8_t dataSensor_channelCount(const struct dataSensor_st *dataSensor)
+{
+    return (dataSensor->channelCount > DATA_SENSOR_CHANNEL_MAX) ? DATA_SENSOR_CHANNEL_MAX : dataSensor->channelCount;
+}
+
+size_t dataSensor_formatCsvRow(const struct dataSensor_st *dataSensor, char *buffer, size_t size)
+{
+    if (dataSensor == NULL || buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    const char *end = buffer + size;
+    char *out = dataSensor_putInt(buffer, end, dataSensor->timeStamp);
+    out = dataSensor_putString(out, end, ",");
+    out = dataSensor_putInt(out, end, dataSensor_timeUs(dataSensor));
+    out = dataSensor_putString(out, end, ",");
+    out = dataSensor_putCenti(out, end, dataSensor->temperature);
+    out = dataSensor_putString(out, end, ",");
+    out = dataSensor_putCenti(out, end, dataSensor->humidity);
+    for (uint8_t i = 0; i < dataSensor_channelCount(dataSensor); i++)
+    {
+        out = dataSensor_putString(out, end, ",");
+        out = dataSensor_putNormalized(out, end, dataSensor, i);
+    }
+    out = dataSensor_putString(out, end, "\n");
+    return dataSensor_terminate(buffer, out, end);
+}
+
+size_t dataSensor_formatDashboardJson(const struct dataSensor_st *dataSensor, const char *timeString,
+                                      const char *ipString, char *buffer, size_t size)
+{
+    if (dataSensor == NULL || timeString == NULL || buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    const char *end = buffer + size;
+    char *out = dataSensor_putString(buffer, end, "{\"Time\":\"");
+    out = dataSensor_putString(out, end, timeString);
+    out = dataSensor_putString(out, end, "\",\"Time_us\":");
+    out = dataSensor_putInt(out, end, dataSensor_timeUs(dataSensor));
+    out = dataSensor_putString(out, end, ",\"Temperature\":");
+    out = dataSensor_putCenti(out, end, dataSensor->temperature);
+    out = dataSensor_putString(out, end, ",\"Humidity\":");
+    out = dataSensor_putCenti(out, end, dataSensor->humidity);
+    out = dataSensor_putString(out, end, ",\"Pressure\":0");
+    for (uint8_t i = 0; i < dataSensor_channelCount(dataSensor); i++)
+    {
+        out = dataSensor_putString(out, end, ",\"EtOH");
+        out = dataSensor_putInt(out, end, i + 1);
+        out = dataSensor_putString(out, end, "\":");
+        out = dataSensor_putNormalized(out, end, dataSensor, i);
+    }
+    for (uint8_t i = 0; i < dataSensor_channelCount(dataSensor); i++)
+    {
+        if (dataSensor->concentration[i] == CALIBRATION_VALUE_NONE) {
+            continue;
+        }
+        out = dataSensor_putString(out, end, ",\"Conc");
+        out = dataSensor_putInt(out, end, i + 1);
+        out = dataSensor_putString(out, end, "\":");
+        out = dataSensor_putMilli(out, end, dataSensor->concentration[i]);
+    }
+    if (ipString != NULL && ipString[0] != '\0')
+    {
+        out = dataSensor_putString(out, end, ",\"ip\":\"");
+        out = dataSensor_putString(out, end, ipString);
+        out = dataSensor_putString(out, end, "\"");
+    }
+    out = dataSensor_putString(out, end, "}");
+    return dataSensor_terminate(buffer, out, end);
+}
+
+static uint8_t *dataSensor_putLe16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    return out + 2;
+}
+
+static uint8_t *dataSensor_putLe32(uint8_t *out, uint32_t value)
+{
+    out = dataSensor_putLe16(out, (uint16_t)value);
+    return dataSensor_putLe16(out, (uint16_t)(value >> 16));
+}
+
+size_t dataSensor_encodeStreamFrame(const struct dataSensor_st *dataSensor, int64_t time_ms, uint8_t *frame)
+{
+    uint8_t channelCount = dataSensor_channelCount(dataSensor);
+    uint8_t *out = frame;
+    *out++ = DATA_SENSOR_STREAM_FRAME_TYPE;
+    *out++ = channelCount;
+    out = dataSensor_putLe32(out, (uint32_t)dataSensor->timeStamp);
+    out = dataSensor_putLe32(out, (uint32_t)(time_ms / 1000));
+    out = dataSensor_putLe16(out, (uint16_t)(time_ms % 1000));
+    out = dataSensor_putLe16(out, (uint16_t)dataSensor_toCenti(dataSensor->temperature, INT16_MIN, INT16_MAX));
+    out = dataSensor_putLe16(out, (uint16_t)dataSensor_toCenti(dataSensor->humidity, 0, INT16_MAX));
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        out = dataSensor_putLe16(out, (uint16_t)dataSensor->ADC_Value[i]);
+    }
+    memcpy(out, dataSensor->gain, channelCount);
+    out += channelCount;
+    return (size_t)(out - frame);
+}
+
+void dataSensor_toBinlogRecord(const struct dataSensor_st *dataSensor, binlog_record_st *record)
+{
+    memset(record, 0, sizeof(*record));
+    record->timeStamp = dataSensor->timeStamp;
+    record->monotonic_us = dataSensor->monotonic_us;
+    record->epochOffset_us = dataSensor->epochOffset_us;
+    record->temperature_c = dataSensor_toCenti(dataSensor->temperature, INT16_MIN, INT16_MAX);
+    record->humidity_c = (uint16_t)dataSensor_toCenti(dataSensor->humidity, 0, INT16_MAX);
+    for (uint8_t i = 0; i < dataSensor_channelCount(dataSensor); i++)
+    {
+        record->ADC_Value[i] = dataSensor->ADC_Value[i];
+        record->gain[i] = dataSensor->gain[i];
+    }
+}
+
+esp_err_t dataSensor_resumeBinlog(const char *pathFile, binlog_codec_st *codec)
+{
+    struct stat st;
+    if (stat(pathFile, &st) != 0 || st.st_size == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    FILE *file = fopen(pathFile, "rb");
+    if (file == NULL) {
+        ESP_LOGE(__func__, "Failed to open file %s for reading.", pathFile);
+        return ESP_FAIL;
+    }
+
+    uint8_t buffer[512];
+    binlog_header_st header;
+    size_t length = fread(buffer, 1, sizeof(buffer), file);
+    size_t position = binlog_decodeHeader(&header, codec, buffer, length);
+    if (position == 0)
+    {
+        fclose(file);
+        ESP_LOGE(__func__, "File %s is not a binary log of version %u..%u.", pathFile, BINLOG_VERSION_MIN, BINLOG_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    // Duyệt toàn bộ record để lấy lại timeStamp cuối cùng (delta encoding)
+    long validLength = (long)position;
+    binlog_record_st record;
+    for (;;)
+    {
+        size_t consumed = binlog_decodeRecord(codec, &record, buffer + position, length - position);
+        if (consumed != 0)
+        {
+            position += consumed;
+            validLength += (long)consumed;
+            continue;
+        }
+
+        // Record bị cắt ở cuối buffer: dời phần còn lại lên đầu và đọc tiếp
+        memmove(buffer, buffer + position, length - position);
+        length -= position;
+        position = 0;
+        size_t readLength = fread(buffer + length, 1, sizeof(buffer) - length, file);
+        if (readLength == 0) {
+            break;
+        }
+        length += readLength;
+    }
+    fclose(file);
+
+    if (validLength != (long)st.st_size)
+    {
+        ESP_LOGW(__func__, "Cut %ld bytes of incomplete record at the end of %s.", (long)st.st_size - validLength, pathFile);
+        if (truncate(pathFile, validLength) != 0) {
+            ESP_LOGE(__func__, "Failed to truncate %s.", pathFile);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t dataSensor_checkCsvHeader(const char *pathFile, uint8_t channelCount)
+{
+    struct stat st;
+    if (stat(pathFile, &st) != 0 || st.st_size == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char header[DATA_SENSOR_CSV_HEADER_MAX_SIZE];
+    char line[DATA_SENSOR_CSV_HEADER_MAX_SIZE];
+    size_t length = dataSensor_formatCsvHeader(channelCount, header, sizeof(header));
+
+    FILE *file = fopen(pathFile, "r");
+    if (file == NULL) {
+        ESP_LOGE(__func__, "Failed to open file %s for reading.", pathFile);
+        return ESP_FAIL;
+    }
+    size_t readLength = fread(line, 1, length, file);
+    fclose(file);
+
+    return (length != 0 && readLength == length && memcmp(line, header, length) == 0) ? ESP_OK : ESP_ERR_INVALID_VERSION;
+}
@@ -6,18 +6,139 @@
 #include "sdkconfig.h"
 #include <string.h>
 #include <inttypes.h>
+#include "binlog.h"
+#include "calibration.h"
 
 #define ERROR_VALUE UINT32_MAX
 
+#define DATA_SENSOR_CHANNEL_MAX         BINLOG_CHANNEL_MAX  /*!< Gas sensor channels of a sample (ADS111x array) */
+
+#define DATA_SENSOR_CSV_ROW_MAX_SIZE    (54U + BINLOG_NORMALIZED_TEXT_MAX_SIZE * DATA_SENSOR_CHANNEL_MAX)    /*!< Buffer size for dataSensor_formatCsvRow() */
+#define DATA_SENSOR_CSV_HEADER_MAX_SIZE (32U + 10U * DATA_SENSOR_CHANNEL_MAX)   /*!< Buffer size for dataSensor_formatCsvHeader() */
+
+#define DATA_SENSOR_STREAM_FRAME_TYPE   0xE2U   /*!< First byte of a binary stream frame (0xE1: frame without gains) */
+#define DATA_SENSOR_STREAM_FRAME_HEADER_SIZE 16U /*!< Stream frame size without the ADC values and gains */
+#define DATA_SENSOR_STREAM_FRAME_SIZE(channelCount) (DATA_SENSOR_STREAM_FRAME_HEADER_SIZE + 3U * (channelCount))
+#define DATA_SENSOR_STREAM_FRAME_MAX_SIZE DATA_SENSOR_STREAM_FRAME_SIZE(DATA_SENSOR_CHANNEL_MAX)
+
 struct dataSensor_st
 {
-    int timeStamp;
+    int timeStamp;                                  /*!< Sample number of the session (STT) */
+    int64_t monotonic_us;                           /*!< esp_timer time at acquisition (timeBase_stamp()) */
+    int64_t epochOffset_us;                         /*!< Unix time (µs) - monotonic_us, 0 while the timebase was not anchored */
     float temperature;
     float humidity;
     float pressure;
-    int16_t ADC_Value[4];
+    uint8_t channelCount;                           /*!< Valid entries of ADC_Value */
+    int16_t ADC_Value[DATA_SENSOR_CHANNEL_MAX];     /*!< Raw ADC codes */
+    uint8_t gain[DATA_SENSOR_CHANNEL_MAX];          /*!< ads111x_gain_t each code was converted with */
+    int32_t concentration[DATA_SENSOR_CHANNEL_MAX]; /*!< Calibrated value, 1/1000 unit, CALIBRATION_VALUE_NONE without curve */
 };
 
-const char dataSensor_templateSaveToSDCard[] = "%d,%.2f,%.2f,%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 "\n";
+// Layout printf cũ (4 kênh, chưa có Time_us), chỉ còn làm mốc so sánh trong test_benchmark
+static const char dataSensor_templateSaveToSDCard[] = "%d,%.2f,%.2f,%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 "\n";
+
+/**
+ * @brief Acquisition time of a sample in µs: Unix time when the timebase was anchored (SNTP/DS3231),
+ *        else time since boot.
+ */
+int64_t dataSensor_timeUs(const struct dataSensor_st *dataSensor);
+
+/**
+ * @brief Format the CSV header line "STT,Time_us,Temperature,Humidity,Sensor1,...,SensorN".
+ *
+ * @param[in]  channelCount Number of sensor columns.
+ * @param[out] buffer       Destination, NUL terminated on success.
+ * @param[in]  size         Size of @p buffer.
+ *
+ * @return Length of the line (without NUL), 0 if @p buffer is too small.
+ */
+size_t dataSensor_formatCsvHeader(uint8_t channelCount, char *buffer, size_t size);
+
+/**
+ * @brief Format a sample as one CSV row: STT, time (dataSensor_timeUs()), temperature, humidity, then channelCount ADC values
+ *        normalized to the ±2.048 V range (binlog_formatNormalized(): the raw codes at that gain).
+ *        Integer math only, no heap allocation.
+ *
+ * @param[in]  dataSensor Sample.
+ * @param[out] buffer     Destination, NUL terminated on success.
+ * @param[in]  size       Size of @p buffer.
+ *
+ * @return Length of the row (without NUL), 0 if @p buffer is too small.
+ */
+size_t dataSensor_formatCsvRow(const struct dataSensor_st *dataSensor, char *buffer, size_t size);
+
+/**
+ * @brief Format a sample as the dashboard JSON object (POST /api/esp32/data), normalized ADC values
+ *        as "EtOH1".."EtOH<channelCount>", calibrated channels as "Conc<i>" (3 decimals, see
+ *        calibration.h) and the acquisition time as "Time_us" (dataSensor_timeUs()).
+ *        Integer math only, no heap allocation.
+ *
+ * @param[in]  dataSensor Sample.
+ * @param[in]  timeString Value of the "Time" field.
+ * @param[in]  ipString   Value of the "ip" field, field is omitted when NULL or empty.
+ * @param[out] buffer     Destination, NUL terminated on success.
+ * @param[in]  size       Size of @p buffer.
+ *
+ * @return Length of the JSON text (without NUL), 0 if @p buffer is too small.
+ */
+size_t dataSensor_formatDashboardJson(const struct dataSensor_st *dataSensor, const char *timeString,
+                                      const char *ipString, char *buffer, size_t size);
+
+/**
+ * @brief Encode a sample as a binary WebSocket stream frame (live view on the dashboard).
+ *
+ * Layout, little-endian, DATA_SENSOR_STREAM_FRAME_SIZE(channel count) bytes:
+ *   [0] u8  DATA_SENSOR_STREAM_FRAME_TYPE   [1] u8  channel count N
+ *   [2] u32 timeStamp (sample counter)      [6] u32 epoch seconds   [10] u16 milliseconds
+ *   [12] i16 temperature x100               [14] u16 humidity x100  [16] i16 ADC_Value[0..N-1]
+ *   [16 + 2N] u8 gain[0..N-1] (ads111x_gain_t, raw code x full scale / 2.048 V = normalized value)
+ *
+ * @param[in]  dataSensor Sample.
+ * @param[in]  time_ms    Sample time, milliseconds since epoch (dataSensor_timeUs() / 1000 once anchored).
+ * @param[out] frame      Destination, at least DATA_SENSOR_STREAM_FRAME_MAX_SIZE bytes.
+ *
+ * @return Size of the frame.
+ */
+size_t dataSensor_encodeStreamFrame(const struct dataSensor_st *dataSensor, int64_t time_ms, uint8_t *frame);
+
+/**
+ * @brief Convert a sample to a binary log record (temperature/humidity in 0.01 units, acquisition time).
+ */
+void dataSensor_toBinlogRecord(const struct dataSensor_st *dataSensor, binlog_record_st *record);
+
+/**
+ * @brief Prepare appending to an existing binary log file.
+ *
+ * Reads the header and all records to restore @p codec (previous time stamp), and cuts an
+ * incomplete last record (power loss in the middle of a commit) so new records stay decodable.
+ *
+ * @param[in]  pathFile Full path of the .bin file.
+ * @param[out] codec    Codec to continue encoding with.
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK on success, @p codec is ready to append.
+ * @retval  - ESP_ERR_NOT_FOUND if the file does not exist or is empty (a header must be written).
+ * @retval  - ESP_ERR_INVALID_VERSION if the file is not a binary log of a supported version.
+ * @retval  - ESP_FAIL on read error.
+ */
+esp_err_t dataSensor_resumeBinlog(const char *pathFile, binlog_codec_st *codec);
+
+/**
+ * @brief Check that an existing CSV file has the column layout of dataSensor_formatCsvHeader()
+ *        before rows are appended to it (e.g. a file of a firmware without the Time_us column).
+ *
+ * @param[in]  pathFile     Full path of the .csv file.
+ * @param[in]  channelCount Number of sensor columns of the new rows.
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK if the first line is the current header.
+ * @retval  - ESP_ERR_NOT_FOUND if the file does not exist or is empty (a header must be written).
+ * @retval  - ESP_ERR_INVALID_VERSION if the file has another header.
+ * @retval  - ESP_FAIL on read error.
+ */
+esp_err_t dataSensor_checkCsvHeader(const char *pathFile, uint8_t channelCount);
 
 #endif
\ No newline at end of file
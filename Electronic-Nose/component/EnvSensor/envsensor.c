@@ -0,0 +1,152 @@
+#include "envsensor.h"
+
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "envSensor";
+
+// SHT3x không trả lời: thử khởi động lại mỗi giây
+#define ENV_SENSOR_RETRY_US     1000000
+
+// Chu kỳ đo của periodic mode (ms), theo sht3x_mode_t
+static const uint16_t sht3x_interval_ms[] = {0, 2000, 1000, 500, 250, 100};
+
+static int64_t envSensor_sht3xInterval_us(const envSensor_st *sensor)
+{
+    return (int64_t)sht3x_interval_ms[sensor->sht3xMode] * 1000;
+}
+
+/**
+ * @brief Dừng periodic mode cũ (nếu ESP32 reset mà sensor vẫn đang đo, nó chỉ nhận lệnh break/fetch),
+ *        xoá status rồi bắt đầu periodic mode.
+ */
+static esp_err_t envSensor_startSht3x(envSensor_st *sensor)
+{
+    sht3x_stop_periodic_measurement(&sensor->sht3x);
+    vTaskDelay(1);
+
+    esp_err_t err = sht3x_init(&sensor->sht3x);
+    if (err == ESP_OK) {
+        err = sht3x_start_measurement(&sensor->sht3x, sensor->sht3xMode, sensor->sht3xRepeatability);
+    }
+    sensor->sht3xStarted = err == ESP_OK;
+    // Kết quả đầu tiên có sau một lần đo
+    sensor->sht3xNextResult_us = esp_timer_get_time() +
+        (sensor->sht3xStarted ? (int64_t)sht3x_get_measurement_duration(sensor->sht3xRepeatability) * portTICK_PERIOD_MS * 1000
+                              : ENV_SENSOR_RETRY_US);
+    return err;
+}
+
+esp_err_t envSensor_init(envSensor_st *sensor, const envSensor_config_st *config)
+{
+    if (sensor == NULL || config == NULL) return ESP_ERR_INVALID_ARG;
+    memset(sensor, 0, sizeof(envSensor_st));
+    sensor->backend = config->backend;
+
+    if (config->backend == ENV_SENSOR_BACKEND_DHT) {
+        sensor->dhtGpio = config->dht.gpio;
+        sensor->dhtType = config->dht.type;
+        sensor->period_ms = ENV_SENSOR_DHT_PERIOD_MS;
+        if (config->dht.useRmt && dht_rmt_init(config->dht.gpio, config->dht.type, &sensor->dhtReader) != ESP_OK) {
+            ESP_LOGW(TAG, "No RMT channel for DHT, using GPIO polling");
+            sensor->dhtReader = NULL;
+        }
+        gpio_num_t gpio = config->dht.gpio;
+        ESP_LOGI(TAG, "%s on GPIO%d (%s), period %" PRIu32 " ms", envSensor_name(sensor), gpio,
+                 sensor->dhtReader ? "RMT capture" : "GPIO polling", sensor->period_ms);
+        return ESP_OK;
+    }
+
+    if (config->backend != ENV_SENSOR_BACKEND_SHT3X ||
+        config->sht3x.mode < SHT3X_PERIODIC_05MPS || config->sht3x.mode > SHT3X_PERIODIC_10MPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sensor->sht3xMode = config->sht3x.mode;
+    sensor->sht3xRepeatability = config->sht3x.repeatability;
+    sensor->period_ms = sht3x_interval_ms[sensor->sht3xMode] * 11U / 10U;
+
+    esp_err_t err = sht3x_init_desc(&sensor->sht3x, config->sht3x.address, config->sht3x.port,
+                                    config->sht3x.sda, config->sht3x.scl);
+    if (err != ESP_OK) return err;
+
+    err = envSensor_startSht3x(sensor);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "SHT3x 0x%02x periodic mode, %u ms/measurement, read period %" PRIu32 " ms",
+                 config->sht3x.address, sht3x_interval_ms[sensor->sht3xMode], sensor->period_ms);
+    } else {
+        ESP_LOGE(TAG, "SHT3x 0x%02x not responding: %s", config->sht3x.address, esp_err_to_name(err));
+    }
+    return err;
+}
+
+static esp_err_t envSensor_readSht3x(envSensor_st *sensor, float *temperature, float *humidity)
+{
+    int64_t now = esp_timer_get_time();
+    if (now < sensor->sht3xNextResult_us) return ESP_ERR_NOT_FINISHED;
+
+    if (!sensor->sht3xStarted) {
+        esp_err_t err = envSensor_startSht3x(sensor);
+        return err == ESP_OK ? ESP_ERR_NOT_FINISHED : err;
+    }
+
+    // Fetch Data: một giao dịch I2C, sensor đã đo xong theo clock riêng
+    sensor->sht3xNextResult_us = now + envSensor_sht3xInterval_us(sensor);
+    return sht3x_get_results(&sensor->sht3x, temperature, humidity);
+}
+
+esp_err_t envSensor_read(envSensor_st *sensor, float *temperature, float *humidity)
+{
+    if (sensor == NULL || temperature == NULL || humidity == NULL) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err;
+    if (sensor->backend == ENV_SENSOR_BACKEND_SHT3X) {
+        err = envSensor_readSht3x(sensor, temperature, humidity);
+    } else if (sensor->dhtReader) {
+        err = dht_rmt_read(sensor->dhtReader, humidity, temperature);
+    } else {
+        err = dht_read_float(sensor->dhtGpio, sensor->dhtType, humidity, temperature);
+    }
+
+    if (err == ESP_OK) {
+        sensor->readCount++;
+        sensor->consecutiveErrors = 0;
+    } else if (err != ESP_ERR_NOT_FINISHED) {
+        sensor->errorCount++;
+        sensor->consecutiveErrors++;
+        if (sensor->backend == ENV_SENSOR_BACKEND_SHT3X && sensor->sht3xStarted &&
+            sensor->consecutiveErrors % ENV_SENSOR_RESTART_ERRORS == 0) {
+            // Sensor bị reset (mất nguồn...) thì không còn ở periodic mode: khởi động lại ở lần đọc sau
+            ESP_LOGW(TAG, "SHT3x: %" PRIu32 " errors in a row, restarting periodic mode", sensor->consecutiveErrors);
+            sensor->sht3xStarted = false;
+            sensor->sht3xNextResult_us = 0;
+        }
+    }
+    return err;
+}
+
+uint32_t envSensor_periodMs(const envSensor_st *sensor)
+{
+    return sensor->period_ms;
+}
+
+const char *envSensor_name(const envSensor_st *sensor)
+{
+    if (sensor->backend == ENV_SENSOR_BACKEND_SHT3X) return "SHT3x";
+    return sensor->dhtType == DHT_TYPE_DHT11 ? "DHT11" : "DHT22";
+}
+
+void envSensor_free(envSensor_st *sensor)
+{
+    if (sensor == NULL) return;
+    if (sensor->backend == ENV_SENSOR_BACKEND_SHT3X) {
+        if (sensor->sht3xStarted) sht3x_stop_periodic_measurement(&sensor->sht3x);
+        sht3x_free_desc(&sensor->sht3x);
+    } else if (sensor->dhtReader) {
+        dht_rmt_free(sensor->dhtReader);
+    }
+    memset(sensor, 0, sizeof(envSensor_st));
+}
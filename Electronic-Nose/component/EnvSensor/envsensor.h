@@ -0,0 +1,115 @@
+/**
+ * @file envsensor.h
+ * @brief Temperature/humidity sensor behind one interface: DHT22/DHT11 (one-wire) or SHT3x (I2C).
+ *
+ * DHT: one frame per read (RMT capture or GPIO polling), at most one read every 2 s.
+ * SHT3x: periodic mode, the sensor measures on its own clock (0.5..10 measurements/s) and
+ * envSensor_read() only fetches the last result (one I2C transaction, no conversion wait).
+ * Reads issued before the next result is due return ESP_ERR_NOT_FINISHED without bus traffic.
+ *
+ * Not thread safe: one owner task calls envSensor_read() every envSensor_periodMs().
+ */
+
+#ifndef __ENVSENSOR_H__
+#define __ENVSENSOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "dht.h"
+#include "sht3x.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// DHT22 cần tối thiểu ~2 s giữa 2 lần đọc
+#define ENV_SENSOR_DHT_PERIOD_MS        2000U
+// Lỗi liên tiếp trước khi khởi động lại periodic mode của SHT3x
+#define ENV_SENSOR_RESTART_ERRORS       5U
+
+typedef enum envSensor_backend
+{
+    ENV_SENSOR_BACKEND_DHT = 0,
+    ENV_SENSOR_BACKEND_SHT3X,
+} envSensor_backend_t;
+
+typedef struct envSensor_config
+{
+    envSensor_backend_t backend;
+    struct {
+        gpio_num_t gpio;
+        dht_type_t type;
+        bool useRmt;                /*!< RMT capture, fall back to GPIO polling if no RMT channel is free */
+    } dht;
+    struct {
+        i2c_port_t port;
+        uint8_t address;            /*!< SHT3X_I2C_ADDR_GND or SHT3X_I2C_ADDR_VDD */
+        gpio_num_t sda;
+        gpio_num_t scl;
+        sht3x_mode_t mode;          /*!< SHT3X_PERIODIC_05MPS..SHT3X_PERIODIC_10MPS */
+        sht3x_repeat_t repeatability;
+    } sht3x;
+} envSensor_config_st;
+
+typedef struct envSensor
+{
+    envSensor_backend_t backend;
+    uint32_t period_ms;             /*!< Read period matching the sensor rate */
+
+    gpio_num_t dhtGpio;
+    dht_type_t dhtType;
+    dht_rmt_handle_t dhtReader;     /*!< NULL = GPIO polling */
+
+    sht3x_t sht3x;
+    sht3x_mode_t sht3xMode;
+    sht3x_repeat_t sht3xRepeatability;
+    bool sht3xStarted;
+    int64_t sht3xNextResult_us;     /*!< Earliest time a new periodic result is available */
+
+    uint32_t readCount;
+    uint32_t errorCount;
+    uint32_t consecutiveErrors;
+} envSensor_st;
+
+/**
+ * @brief Initialize the selected backend. SHT3x: start periodic measurements.
+ *        i2cdev_init() must have been called for the SHT3x backend.
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK on success.
+ * @retval  - ESP_ERR_INVALID_ARG on invalid configuration.
+ * @retval  - Other: the SHT3x did not answer. The sensor is still usable, envSensor_read()
+ *            retries to start it.
+ */
+esp_err_t envSensor_init(envSensor_st *sensor, const envSensor_config_st *config);
+
+/**
+ * @brief Read temperature (°C) and humidity (%RH).
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK on success.
+ * @retval  - ESP_ERR_NOT_FINISHED (SHT3x) if no new result is due yet, nothing was read.
+ * @retval  - Other: read failed (timeout, CRC...), the previous values should be kept.
+ */
+esp_err_t envSensor_read(envSensor_st *sensor, float *temperature, float *humidity);
+
+/**
+ * @brief Period to call envSensor_read() at: 2 s for DHT, measurement interval + 10 % for
+ *        SHT3x (the sensor clock is only accurate to a few %, reading slower never misses data).
+ */
+uint32_t envSensor_periodMs(const envSensor_st *sensor);
+
+const char *envSensor_name(const envSensor_st *sensor);
+
+void envSensor_free(envSensor_st *sensor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,6 +1,11 @@
 #include "sdcard.h"
+#include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <errno.h>
+#include <inttypes.h>
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
 
 __attribute__((unused)) static const char *TAG = "SDcard";
 
@@ -348,6 +353,505 @@ esp_err_t sdcard_removeFile(const char *nameFile)
 
 }
 
+/*------------------------------------ SESSION WRITER ------------------------------------ */
+
+/**
+ * @brief Write the staging buffer with one write() call and fsync() the file once.
+ */
+static esp_err_t sdcard_writerFlushBuffer(sdcard_writer_st *writer)
+{
+    if (writer->bufferUsed == 0) {
+        return ESP_OK;
+    }
+
+    int fd = fileno(writer->file);
+    size_t written = 0;
+    while (written < writer->bufferUsed)
+    {
+        ssize_t returnValue = write(fd, writer->buffer + written, writer->bufferUsed - written);
+        if (returnValue <= 0)
+        {
+            ESP_LOGE(__func__, "Failed to write %u bytes to file %s (errno: %d).",
+                     (unsigned)(writer->bufferUsed - written), writer->pathFile, errno);
+            // Phần đã ghi đã nằm trong file; giữ lại phần chưa ghi để lần commit sau thử lại
+            writer->totalBytes += written;
+            memmove(writer->buffer, writer->buffer + written, writer->bufferUsed - written);
+            writer->bufferUsed -= written;
+            return ESP_ERROR_SD_WRITE_DATA_FAILED;
+        }
+        written += (size_t)returnValue;
+    }
+
+    writer->totalBytes += writer->bufferUsed;
+    writer->bufferUsed = 0;
+
+    errno = 0;
+    if (fsync(fd) != 0 && errno != EINVAL)
+    {
+        ESP_LOGE(__func__, "❌ fsync() error for file %s (errno: %d) - DATA MAY NOT BE WRITTEN!", writer->pathFile, errno);
+        return ESP_ERROR_SD_SYNC_FILE_FAILED;
+    }
+    writer->totalSyncs++;
+    return ESP_OK;
+}
+
+esp_err_t sdcard_writerOpen(sdcard_writer_st *writer, const char *nameFile, const char *extension,
+                            const sdcard_writerConfig_st *config)
+{
+    if (writer == NULL || nameFile == NULL || extension == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const sdcard_writerConfig_st defaultConfig = SDCARD_WRITER_CONFIG_DEFAULT();
+    memset(writer, 0, sizeof(*writer));
+    writer->config = (config != NULL) ? *config : defaultConfig;
+    if (writer->config.bufferSize == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    snprintf(writer->pathFile, sizeof(writer->pathFile), "%s/%s.%s", mount_point, nameFile, extension);
+
+    writer->buffer = (char *)malloc(writer->config.bufferSize);
+    if (writer->buffer == NULL) {
+        ESP_LOGE(__func__, "Failed to allocate %u bytes writer buffer.", (unsigned)writer->config.bufferSize);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(__func__, "Opening file %s for session writing...", writer->pathFile);
+    writer->file = fopen(writer->pathFile, "a");
+    if (writer->file == NULL)
+    {
+        ESP_LOGE(__func__, "Failed to open file for writing: %s (errno: %d)", writer->pathFile, errno);
+        free(writer->buffer);
+        writer->buffer = NULL;
+        return ESP_ERROR_SD_OPEN_FILE_FAILED;
+    }
+    // Dữ liệu đã được gom trong buffer của writer, không cần thêm buffer của stdio
+    setvbuf(writer->file, NULL, _IONBF, 0);
+
+    struct stat st;
+    if (fstat(fileno(writer->file), &st) == 0) {
+        writer->endOffset = (uint64_t)st.st_size;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sdcard_writerCommit(sdcard_writer_st *writer)
+{
+    if (!sdcard_writerIsOpen(writer)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (writer->bufferUsed == 0) {
+        return ESP_OK;
+    }
+
+    uint32_t rows = writer->pendingRows;
+    size_t bytes = writer->bufferUsed;
+    esp_err_t errorCode = sdcard_writerFlushBuffer(writer);
+    if (errorCode == ESP_OK || writer->bufferUsed == 0)
+    {
+        writer->pendingRows = 0;
+        writer->totalCommits++;
+    }
+    if (errorCode == ESP_OK) {
+        ESP_LOGI(__func__, "Committed %" PRIu32 " rows (%u bytes) to %s.", rows, (unsigned)bytes, writer->pathFile);
+    }
+    return errorCode;
+}
+
+/**
+ * @brief Check the commit policy after a row has been staged.
+ */
+static esp_err_t sdcard_writerCheckPolicy(sdcard_writer_st *writer, bool checkCount)
+{
+    if (writer->pendingRows == 0) {
+        return ESP_OK;
+    }
+
+    const sdcard_writerConfig_st *config = &writer->config;
+    bool commit = false;
+    if (checkCount)
+    {
+        commit |= (config->commitRows != 0 && writer->pendingRows >= config->commitRows);
+        commit |= (config->commitBytes != 0 && writer->bufferUsed >= config->commitBytes);
+    }
+    commit |= (config->commitInterval_ms != 0 &&
+               (esp_timer_get_time() - writer->firstPendingTime_us) >= (int64_t)config->commitInterval_ms * 1000);
+
+    return commit ? sdcard_writerCommit(writer) : ESP_OK;
+}
+
+/**
+ * @brief Account one staged row of @p length bytes.
+ */
+static void sdcard_writerAccountRow(sdcard_writer_st *writer, size_t length)
+{
+    if (writer->pendingRows == 0) {
+        writer->firstPendingTime_us = esp_timer_get_time();
+    }
+    writer->bufferUsed += length;
+    writer->endOffset += length;
+    writer->pendingRows++;
+    writer->totalRows++;
+}
+
+esp_err_t sdcard_writerAppend(sdcard_writer_st *writer, const void *data, size_t length)
+{
+    if (!sdcard_writerIsOpen(writer)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (data == NULL && length != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (writer->bufferUsed + length > writer->config.bufferSize)
+    {
+        esp_err_t errorCode = sdcard_writerCommit(writer);
+        if (errorCode != ESP_OK) {
+            return errorCode;
+        }
+    }
+
+    if (length > writer->config.bufferSize)
+    {
+        // Row lớn hơn buffer: ghi thẳng xuống thẻ
+        int fd = fileno(writer->file);
+        if (write(fd, data, length) != (ssize_t)length)
+        {
+            ESP_LOGE(__func__, "Failed to write data to file %s (errno: %d).", writer->pathFile, errno);
+            return ESP_ERROR_SD_WRITE_DATA_FAILED;
+        }
+        writer->totalBytes += length;
+        writer->endOffset += length;
+        writer->totalRows++;
+        if (fsync(fd) != 0 && errno != EINVAL) {
+            return ESP_ERROR_SD_SYNC_FILE_FAILED;
+        }
+        writer->totalSyncs++;
+        return ESP_OK;
+    }
+
+    memcpy(writer->buffer + writer->bufferUsed, data, length);
+    sdcard_writerAccountRow(writer, length);
+    return sdcard_writerCheckPolicy(writer, true);
+}
+
+esp_err_t sdcard_writerPrintf(sdcard_writer_st *writer, const char *format, ...)
+{
+    if (!sdcard_writerIsOpen(writer)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    va_list argumentsList;
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        size_t space = writer->config.bufferSize - writer->bufferUsed;
+        va_start(argumentsList, format);
+        int length = vsnprintf(writer->buffer + writer->bufferUsed, space, format, argumentsList);
+        va_end(argumentsList);
+
+        if (length < 0) {
+            ESP_LOGE(TAG, "Failed to format string data for writing.");
+            return ESP_ERROR_SD_WRITE_DATA_FAILED;
+        }
+        if ((size_t)length < space)
+        {
+            sdcard_writerAccountRow(writer, (size_t)length);
+            return sdcard_writerCheckPolicy(writer, true);
+        }
+        if (attempt == 0 && writer->bufferUsed != 0)
+        {
+            // Không đủ chỗ: commit phần đang chờ rồi format lại vào buffer trống
+            esp_err_t errorCode = sdcard_writerCommit(writer);
+            if (errorCode != ESP_OK) {
+                return errorCode;
+            }
+            continue;
+        }
+        break;
+    }
+
+    ESP_LOGE(TAG, "Row does not fit in %u bytes writer buffer.", (unsigned)writer->config.bufferSize);
+    return ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t sdcard_writerPoll(sdcard_writer_st *writer)
+{
+    if (!sdcard_writerIsOpen(writer)) {
+        return ESP_OK;
+    }
+    return sdcard_writerCheckPolicy(writer, false);
+}
+
+esp_err_t sdcard_writerClose(sdcard_writer_st *writer)
+{
+    if (!sdcard_writerIsOpen(writer)) {
+        return ESP_OK;
+    }
+
+    esp_err_t errorCode = sdcard_writerCommit(writer);
+    if (errorCode != ESP_OK) {
+        ESP_LOGE(__func__, "Final commit of %s failed, %u bytes lost.", writer->pathFile, (unsigned)writer->bufferUsed);
+    }
+    fclose(writer->file);
+    writer->file = NULL;
+    free(writer->buffer);
+    writer->buffer = NULL;
+    writer->bufferUsed = 0;
+    writer->pendingRows = 0;
+
+    ESP_LOGI(__func__, "Closed %s: %" PRIu32 " rows, %" PRIu64 " bytes, %" PRIu32 " commits, %" PRIu32 " fsync.",
+             writer->pathFile, writer->totalRows, writer->totalBytes, writer->totalCommits, writer->totalSyncs);
+    return errorCode;
+}
+
+
+/*------------------------------------ Journal ------------------------------------ */
+
+#define SDCARD_JOURNAL_MAGIC        0x4C4A4E45UL   // "ENJL"
+#define SDCARD_JOURNAL_VERSION      1U
+#define SDCARD_JOURNAL_SLOT_SIZE    64U
+#define SDCARD_JOURNAL_DATA_OFFSET  (2U * SDCARD_JOURNAL_SLOT_SIZE)
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t slotSize;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t writeSequence;
+    uint32_t readSequence;
+    uint32_t dropped;
+    uint32_t generation;
+    uint32_t crc;
+} sdcard_journalHeader_st;
+
+static uint32_t sdcard_journalHeaderCrc(const sdcard_journalHeader_st *header)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)header, offsetof(sdcard_journalHeader_st, crc));
+}
+
+static esp_err_t sdcard_journalSync(sdcard_journal_st *journal)
+{
+    if (fflush(journal->file) != 0 || fsync(fileno(journal->file)) != 0)
+    {
+        ESP_LOGE(__func__, "fsync of %s failed (errno: %d)", journal->pathFile, errno);
+        return ESP_ERROR_SD_SYNC_FILE_FAILED;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Ghi header vào slot A/B luân phiên rồi fsync: mất điện giữa chừng thì slot còn lại vẫn hợp lệ
+ */
+static esp_err_t sdcard_journalWriteHeader(sdcard_journal_st *journal)
+{
+    uint8_t slot[SDCARD_JOURNAL_SLOT_SIZE] = {0};
+    sdcard_journalHeader_st header = {
+        .magic = SDCARD_JOURNAL_MAGIC,
+        .version = SDCARD_JOURNAL_VERSION,
+        .slotSize = SDCARD_JOURNAL_SLOT_SIZE,
+        .recordSize = journal->recordSize,
+        .capacity = journal->capacity,
+        .writeSequence = journal->writeSequence,
+        .readSequence = journal->readSequence,
+        .dropped = journal->dropped,
+        .generation = journal->generation + 1,
+    };
+    header.crc = sdcard_journalHeaderCrc(&header);
+    memcpy(slot, &header, sizeof(header));
+
+    long offset = (long)(header.generation & 1U) * SDCARD_JOURNAL_SLOT_SIZE;
+    if (fseek(journal->file, offset, SEEK_SET) != 0 || fwrite(slot, 1, sizeof(slot), journal->file) != sizeof(slot))
+    {
+        ESP_LOGE(__func__, "Failed to write header of %s (errno: %d)", journal->pathFile, errno);
+        return ESP_ERROR_SD_WRITE_DATA_FAILED;
+    }
+    journal->generation = header.generation;
+    return sdcard_journalSync(journal);
+}
+
+/**
+ * @brief Đọc/ghi @p count record liên tiếp bắt đầu từ @p sequence, tách làm 2 đoạn khi vòng qua cuối file
+ */
+static esp_err_t sdcard_journalTransfer(sdcard_journal_st *journal, uint32_t sequence, void *records, size_t count, bool write)
+{
+    uint8_t *data = (uint8_t *)records;
+
+    while (count != 0)
+    {
+        uint32_t slot = sequence % journal->capacity;
+        size_t chunk = journal->capacity - slot;
+        if (chunk > count) {
+            chunk = count;
+        }
+
+        long offset = (long)SDCARD_JOURNAL_DATA_OFFSET + (long)slot * (long)journal->recordSize;
+        size_t bytes = chunk * journal->recordSize;
+        if (fseek(journal->file, offset, SEEK_SET) != 0) {
+            return write ? ESP_ERROR_SD_WRITE_DATA_FAILED : ESP_ERROR_SD_READ_DATA_FAILED;
+        }
+        if (write ? (fwrite(data, 1, bytes, journal->file) != bytes) : (fread(data, 1, bytes, journal->file) != bytes))
+        {
+            ESP_LOGE(__func__, "Failed to %s %u records of %s (errno: %d)", write ? "write" : "read",
+                     (unsigned)chunk, journal->pathFile, errno);
+            return write ? ESP_ERROR_SD_WRITE_DATA_FAILED : ESP_ERROR_SD_READ_DATA_FAILED;
+        }
+
+        data += bytes;
+        sequence += chunk;
+        count -= chunk;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sdcard_journalOpen(sdcard_journal_st *journal, const char *nameFile, const char *extension,
+                             uint32_t recordSize, uint32_t capacity)
+{
+    if (journal == NULL || nameFile == NULL || extension == NULL || recordSize == 0 || capacity == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(journal, 0, sizeof(*journal));
+    journal->recordSize = recordSize;
+    journal->capacity = capacity;
+    snprintf(journal->pathFile, sizeof(journal->pathFile), "%s/%s.%s", mount_point, nameFile, extension);
+
+    journal->file = fopen(journal->pathFile, "r+b");
+    if (journal->file == NULL) {
+        journal->file = fopen(journal->pathFile, "w+b");
+    }
+    if (journal->file == NULL)
+    {
+        ESP_LOGE(__func__, "Failed to open journal %s (errno: %d)", journal->pathFile, errno);
+        return ESP_ERROR_SD_OPEN_FILE_FAILED;
+    }
+    setvbuf(journal->file, NULL, _IONBF, 0);
+
+    // Chọn header hợp lệ có generation mới nhất trong 2 slot
+    bool found = false;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        sdcard_journalHeader_st header;
+        if (fseek(journal->file, (long)(i * SDCARD_JOURNAL_SLOT_SIZE), SEEK_SET) != 0 ||
+            fread(&header, 1, sizeof(header), journal->file) != sizeof(header)) {
+            continue;
+        }
+        if (header.magic != SDCARD_JOURNAL_MAGIC || header.version != SDCARD_JOURNAL_VERSION ||
+            header.crc != sdcard_journalHeaderCrc(&header) ||
+            header.recordSize != recordSize || header.capacity != capacity ||
+            header.writeSequence - header.readSequence > capacity) {
+            continue;
+        }
+        if (!found || (int32_t)(header.generation - journal->generation) > 0)
+        {
+            journal->writeSequence = header.writeSequence;
+            journal->readSequence = header.readSequence;
+            journal->dropped = header.dropped;
+            journal->generation = header.generation;
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        ESP_LOGI(__func__, "Creating journal %s (%" PRIu32 " x %" PRIu32 " bytes)", journal->pathFile, capacity, recordSize);
+        esp_err_t errorCode = sdcard_journalWriteHeader(journal);
+        if (errorCode != ESP_OK)
+        {
+            fclose(journal->file);
+            journal->file = NULL;
+            return errorCode;
+        }
+    }
+    else
+    {
+        ESP_LOGI(__func__, "Resumed journal %s: %" PRIu32 " pending records, %" PRIu32 " dropped",
+                 journal->pathFile, sdcard_journalPending(journal), journal->dropped);
+    }
+    return ESP_OK;
+}
+
+esp_err_t sdcard_journalAppend(sdcard_journal_st *journal, const void *records, size_t count)
+{
+    if (!sdcard_journalIsOpen(journal)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (records == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Nhiều hơn capacity: chỉ giữ capacity record mới nhất
+    if (count > journal->capacity)
+    {
+        size_t skipped = count - journal->capacity;
+        records = (const uint8_t *)records + skipped * journal->recordSize;
+        journal->dropped += skipped;
+        count = journal->capacity;
+    }
+
+    esp_err_t errorCode = sdcard_journalTransfer(journal, journal->writeSequence, (void *)records, count, true);
+    if (errorCode == ESP_OK) {
+        errorCode = sdcard_journalSync(journal);
+    }
+    if (errorCode != ESP_OK) {
+        return errorCode;
+    }
+
+    journal->writeSequence += count;
+    if (journal->writeSequence - journal->readSequence > journal->capacity)
+    {
+        uint32_t overwritten = journal->writeSequence - journal->readSequence - journal->capacity;
+        journal->readSequence += overwritten;
+        journal->dropped += overwritten;
+    }
+    return sdcard_journalWriteHeader(journal);
+}
+
+esp_err_t sdcard_journalRead(sdcard_journal_st *journal, void *records, size_t maxCount, size_t *count)
+{
+    if (!sdcard_journalIsOpen(journal)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (records == NULL || count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t available = sdcard_journalPending(journal);
+    *count = 0;
+    if (available > maxCount) {
+        available = maxCount;
+    }
+
+    esp_err_t errorCode = sdcard_journalTransfer(journal, journal->readSequence, records, available, false);
+    if (errorCode == ESP_OK) {
+        *count = available;
+    }
+    return errorCode;
+}
+
+esp_err_t sdcard_journalConsume(sdcard_journal_st *journal, size_t count)
+{
+    if (!sdcard_journalIsOpen(journal)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t pending = sdcard_journalPending(journal);
+    journal->readSequence += (count > pending) ? pending : (uint32_t)count;
+    return sdcard_journalWriteHeader(journal);
+}
+
+esp_err_t sdcard_journalClose(sdcard_journal_st *journal)
+{
+    if (!sdcard_journalIsOpen(journal)) {
+        return ESP_OK;
+    }
+    fclose(journal->file);
+    journal->file = NULL;
+    return ESP_OK;
+}
+
 
 esp_err_t sdcard_deinitialize(const char* _mount_point, sdmmc_card_t *_sdcard, sdmmc_host_t *_host)
 {
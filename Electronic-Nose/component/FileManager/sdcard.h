@@ -2,6 +2,9 @@
 #define SDCARD_H
 
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <esp_log.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
@@ -19,6 +22,7 @@
 #define ESP_ERROR_SD_READ_DATA_FAILED       ((ID_SD_CARD << 12)|(0x03))
 #define ESP_ERROR_SD_RENAME_FILE_FAILED     ((ID_SD_CARD << 12)|(0x04))
 #define ESP_ERROR_SD_REMOVE_FILE_FAILED     ((ID_SD_CARD << 12)|(0x05))
+#define ESP_ERROR_SD_SYNC_FILE_FAILED       ((ID_SD_CARD << 12)|(0x06))
 
 // #define PIN_NUM_MISO 21
 // #define PIN_NUM_MOSI 19
@@ -38,9 +42,52 @@
                                     .allocation_unit_size = (1024 * 1024),  \
 }
 
-#define MOUNT_POINT "/sdcard"
+#ifndef MOUNT_POINT
+#define MOUNT_POINT "/sdcard"      // Host tools: -DMOUNT_POINT=\"<dir>\" (tools/sdcard_bench.c)
+#endif
 extern const char mount_point[];
 
+/**
+ * @brief Commit policy of a session writer (see sdcard_writerOpen()).
+ *
+ * Rows are staged in RAM and written to the card with a single write() + fsync()
+ * as soon as any enabled threshold is reached. A threshold of 0 disables it.
+ */
+typedef struct sdcard_writerConfig
+{
+    size_t bufferSize;          /*!< Size of the RAM staging buffer (bytes) */
+    uint32_t commitRows;        /*!< Commit after this many pending rows */
+    size_t commitBytes;         /*!< Commit when this many bytes are pending */
+    uint32_t commitInterval_ms; /*!< Commit when the oldest pending row is older than this */
+} sdcard_writerConfig_st;
+
+#define SDCARD_WRITER_CONFIG_DEFAULT()  { .bufferSize = CONFIG_SDCARD_WRITER_BUFFER_SIZE,               \
+                                          .commitRows = CONFIG_SDCARD_WRITER_COMMIT_ROWS,               \
+                                          .commitBytes = CONFIG_SDCARD_WRITER_COMMIT_BYTES,             \
+                                          .commitInterval_ms = CONFIG_SDCARD_WRITER_COMMIT_INTERVAL_MS, \
+}
+
+/**
+ * @brief Session writer: one file handle kept open for a whole sampling cycle.
+ */
+typedef struct sdcard_writer
+{
+    FILE *file;
+    char pathFile[64];
+    char *buffer;
+    size_t bufferUsed;
+    uint32_t pendingRows;
+    int64_t firstPendingTime_us;
+    uint64_t endOffset;         /*!< File offset of the next appended byte (committed + pending) */
+    sdcard_writerConfig_st config;
+
+    // Statistics since sdcard_writerOpen()
+    uint32_t totalRows;
+    uint32_t totalCommits;
+    uint32_t totalSyncs;
+    uint64_t totalBytes;
+} sdcard_writer_st;
+
 
 /**
  * @brief Initializes SD card with configuration.
@@ -125,4 +172,133 @@ esp_err_t sdcard_renameFile(const char *oldNameFile, char *newNameFile);
 
 esp_err_t sdcard_removeFile(const char *nameFile);
 
+/**
+ * @brief Open a session writer on "<MOUNT_POINT>/<nameFile>.<extension>" in append mode.
+ *
+ * The file stays open until sdcard_writerClose(). Stdio buffering is disabled; rows are
+ * staged in the writer's own buffer and committed according to the given policy.
+ *
+ * @param[out] writer    Writer to initialize.
+ * @param[in]  nameFile  Name file (without extension).
+ * @param[in]  extension File extension without dot, e.g. "csv".
+ * @param[in]  config    Commit policy, NULL for SDCARD_WRITER_CONFIG_DEFAULT().
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK on success.
+ * @retval  - ESP_ERR_INVALID_ARG on invalid arguments.
+ * @retval  - ESP_ERR_NO_MEM if the staging buffer cannot be allocated.
+ * @retval  - ESP_ERROR_SD_OPEN_FILE_FAILED on can't open file.
+ */
+esp_err_t sdcard_writerOpen(sdcard_writer_st *writer, const char *nameFile, const char *extension,
+                            const sdcard_writerConfig_st *config);
+
+/**
+ * @brief Append raw bytes as one row. Commits if a threshold of the policy is reached.
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK on success.
+ * @retval  - ESP_ERR_INVALID_STATE if the writer is not open.
+ * @retval  - ESP_ERROR_SD_WRITE_DATA_FAILED / ESP_ERROR_SD_SYNC_FILE_FAILED on commit failure.
+ */
+esp_err_t sdcard_writerAppend(sdcard_writer_st *writer, const void *data, size_t length);
+
+/**
+ * @brief Format a row directly into the staging buffer (no heap allocation) and append it.
+ *
+ * @param writer Open writer.
+ * @param format Template structure for data store.
+ * @param ... #__VA_ARGS__ : List arguments
+ *
+ * @return Same as sdcard_writerAppend().
+ */
+esp_err_t sdcard_writerPrintf(sdcard_writer_st *writer, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Commit only if the oldest pending row exceeded the time budget.
+ *        Call periodically when no new rows arrive.
+ */
+esp_err_t sdcard_writerPoll(sdcard_writer_st *writer);
+
+/**
+ * @brief Write all pending rows and fsync() the file once.
+ */
+esp_err_t sdcard_writerCommit(sdcard_writer_st *writer);
+
+/**
+ * @brief Commit pending rows, close the file and release the staging buffer.
+ *        Safe to call on a writer that is not open.
+ */
+esp_err_t sdcard_writerClose(sdcard_writer_st *writer);
+
+static inline bool sdcard_writerIsOpen(const sdcard_writer_st *writer)
+{
+    return (writer != NULL && writer->file != NULL);
+}
+
+/**
+ * @brief Bounded on-card journal of fixed-size records (store-and-forward backlog).
+ *
+ * Circular file: header A/B (CRC, generation) + capacity record slots. Read/write sequences are
+ * persisted in the header on every append/consume, so a reboot neither replays consumed records
+ * nor loses appended ones (a record consumed right before a power loss may be read once more).
+ * When full, the oldest records are overwritten and counted in @c dropped.
+ */
+typedef struct sdcard_journal
+{
+    FILE *file;
+    char pathFile[64];
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t writeSequence;     /*!< Sequence of the next record to append */
+    uint32_t readSequence;      /*!< Sequence of the oldest record not consumed */
+    uint32_t dropped;           /*!< Records overwritten while the journal was full */
+    uint32_t generation;        /*!< Header generation, selects header slot A/B */
+} sdcard_journal_st;
+
+/**
+ * @brief Open (or create) the journal "<MOUNT_POINT>/<nameFile>.<extension>".
+ *        An existing journal with another record size/capacity or a corrupted header is reset.
+ *
+ * @retval  - ESP_OK on success.
+ * @retval  - ESP_ERR_INVALID_ARG on invalid arguments.
+ * @retval  - ESP_ERROR_SD_OPEN_FILE_FAILED on can't open file.
+ * @retval  - ESP_ERROR_SD_WRITE_DATA_FAILED / ESP_ERROR_SD_SYNC_FILE_FAILED if a new header can't be written.
+ */
+esp_err_t sdcard_journalOpen(sdcard_journal_st *journal, const char *nameFile, const char *extension,
+                             uint32_t recordSize, uint32_t capacity);
+
+/**
+ * @brief Append @p count records and persist the write cursor (one header update + fsync).
+ */
+esp_err_t sdcard_journalAppend(sdcard_journal_st *journal, const void *records, size_t count);
+
+/**
+ * @brief Read up to @p maxCount oldest records without consuming them.
+ *
+ * @param[out] count Number of records read.
+ */
+esp_err_t sdcard_journalRead(sdcard_journal_st *journal, void *records, size_t maxCount, size_t *count);
+
+/**
+ * @brief Consume (drop) the @p count oldest records and persist the read cursor.
+ */
+esp_err_t sdcard_journalConsume(sdcard_journal_st *journal, size_t count);
+
+/**
+ * @brief Close the journal. Safe to call on a journal that is not open.
+ */
+esp_err_t sdcard_journalClose(sdcard_journal_st *journal);
+
+static inline bool sdcard_journalIsOpen(const sdcard_journal_st *journal)
+{
+    return (journal != NULL && journal->file != NULL);
+}
+
+static inline uint32_t sdcard_journalPending(const sdcard_journal_st *journal)
+{
+    return sdcard_journalIsOpen(journal) ? journal->writeSequence - journal->readSequence : 0;
+}
+
 #endif
@@ -0,0 +1,165 @@
+#include "framering.h"
+#include <stdlib.h>
+#include <string.h>
+
+static portMUX_TYPE frameRing_readerLock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t frameRing_init(frameRing_st *ring, size_t frameSize, uint32_t capacity)
+{
+    if (ring == NULL || frameSize == 0 || capacity == 0 || capacity > (1UL << 30)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->storage = calloc(size, frameSize);
+    if (ring->storage == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ring->frameSize = frameSize;
+    ring->capacity = size;
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->writing, 0);
+    return ESP_OK;
+}
+
+void frameRing_deinit(frameRing_st *ring)
+{
+    free(ring->storage);
+    ring->storage = NULL;
+}
+
+void *frameRing_reserve(frameRing_st *ring)
+{
+    uint32_t head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // Seqlock: báo trước cho reader rằng slot (head - capacity) sắp bị ghi đè
+    atomic_store_explicit(&ring->writing, head + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return ring->storage + (size_t)(head & ring->mask) * ring->frameSize;
+}
+
+void frameRing_publish(frameRing_st *ring)
+{
+    uint32_t head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    ring->published++;
+
+    for (size_t i = 0; i < FRAME_RING_READER_MAX; i++)
+    {
+        TaskHandle_t task = ring->readerTasks[i];
+        if (task != NULL) {
+            xTaskNotifyGive(task);
+        }
+    }
+}
+
+esp_err_t frameRing_readerAttach(frameRing_reader_st *reader, frameRing_st *ring)
+{
+    esp_err_t errorCode = ESP_ERR_NO_MEM;
+
+    memset(reader, 0, sizeof(*reader));
+    reader->ring = ring;
+    reader->tail = (uint32_t)atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    portENTER_CRITICAL(&frameRing_readerLock);
+    for (size_t i = 0; i < FRAME_RING_READER_MAX; i++)
+    {
+        if (ring->readerTasks[i] == NULL) {
+            ring->readerTasks[i] = xTaskGetCurrentTaskHandle();
+            errorCode = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&frameRing_readerLock);
+    return errorCode;
+}
+
+void frameRing_readerDetach(frameRing_reader_st *reader)
+{
+    frameRing_st *ring = reader->ring;
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    if (ring == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&frameRing_readerLock);
+    for (size_t i = 0; i < FRAME_RING_READER_MAX; i++)
+    {
+        if (ring->readerTasks[i] == task) {
+            ring->readerTasks[i] = NULL;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&frameRing_readerLock);
+    reader->ring = NULL;
+}
+
+const void *frameRing_peek(frameRing_reader_st *reader, TickType_t timeout)
+{
+    frameRing_st *ring = reader->ring;
+    uint32_t head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while (head == reader->tail)
+    {
+        // Notification có thể là của frame đã đọc rồi: kiểm tra lại head sau mỗi lần thức
+        if (timeout == 0 || ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            return NULL;
+        }
+        head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+
+    // Reader bị bỏ xa hơn capacity: nhảy tới frame cũ nhất còn trong ring
+    if (head - reader->tail > ring->capacity)
+    {
+        reader->overruns += head - reader->tail - ring->capacity;
+        reader->tail = head - ring->capacity;
+    }
+    return ring->storage + (size_t)(reader->tail & ring->mask) * ring->frameSize;
+}
+
+bool frameRing_commit(frameRing_reader_st *reader)
+{
+    frameRing_st *ring = reader->ring;
+
+    // Frame đã bị ghi đè trong lúc đọc nếu producer đã bắt đầu ghi sequence tail + capacity
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t writing = (uint32_t)atomic_load_explicit(&ring->writing, memory_order_relaxed);
+    bool valid = (writing - reader->tail) <= ring->capacity;
+
+    reader->tail++;
+    if (valid) {
+        reader->consumed++;
+    } else {
+        reader->overruns++;
+    }
+    return valid;
+}
+
+uint32_t frameRing_copyPending(const frameRing_reader_st *reader, void *frames, uint32_t maxFrames)
+{
+    const frameRing_st *ring = reader->ring;
+    uint32_t head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t count = head - reader->tail;
+
+    // Chỉ còn capacity frame mới nhất trong ring, giữ các frame mới nhất khi out không đủ chỗ
+    if (count > ring->capacity) {
+        count = ring->capacity;
+    }
+    if (count > maxFrames) {
+        count = maxFrames;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t sequence = head - count + i;
+        memcpy((uint8_t *)frames + (size_t)i * ring->frameSize,
+               ring->storage + (size_t)(sequence & ring->mask) * ring->frameSize, ring->frameSize);
+    }
+    return count;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file framering.h
+ * @brief Lock-free single-producer / multi-consumer ring of fixed-size frames.
+ *
+ * Producer ghi mỗi frame đúng một lần vào slot của ring (reserve/publish, không copy).
+ * Mỗi consumer có con trỏ đọc riêng (frameRing_reader_st) và đọc theo tốc độ của nó
+ * (peek/commit, không copy). Producer không bao giờ bị chặn: consumer chậm hơn
+ * capacity frame sẽ mất frame cũ nhất và được đếm vào overruns.
+ *
+ * - Một producer task duy nhất gọi frameRing_reserve()/frameRing_publish().
+ * - Mỗi reader chỉ được dùng bởi một consumer task.
+ */
+
+#ifndef __FRAMERING_H__
+#define __FRAMERING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_RING_READER_MAX   4U
+
+typedef struct frameRing
+{
+    uint8_t *storage;
+    size_t frameSize;
+    uint32_t capacity;                  /*!< Power of two */
+    uint32_t mask;
+    atomic_uint_fast32_t head;          /*!< Sequence of the next frame to publish */
+    atomic_uint_fast32_t writing;       /*!< head + 1 while a slot is being overwritten */
+    TaskHandle_t readerTasks[FRAME_RING_READER_MAX];    /*!< Notified on publish */
+    uint32_t published;
+} frameRing_st;
+
+typedef struct frameRing_reader
+{
+    frameRing_st *ring;
+    uint32_t tail;                      /*!< Sequence of the next frame to read */
+    uint32_t consumed;
+    uint32_t overruns;                  /*!< Frames lost because this reader fell behind */
+} frameRing_reader_st;
+
+/**
+ * @brief Allocate the ring.
+ *
+ * @param capacity  Number of frames, rounded up to a power of two.
+ * @return ESP_ERR_NO_MEM / ESP_ERR_INVALID_ARG on failure.
+ */
+esp_err_t frameRing_init(frameRing_st *ring, size_t frameSize, uint32_t capacity);
+
+/**
+ * @brief Free the ring storage. Readers must be detached first.
+ */
+void frameRing_deinit(frameRing_st *ring);
+
+/**
+ * @brief Producer: slot to fill with the next frame. Valid until frameRing_publish().
+ */
+void *frameRing_reserve(frameRing_st *ring);
+
+/**
+ * @brief Producer: make the reserved frame visible and wake the waiting readers.
+ */
+void frameRing_publish(frameRing_st *ring);
+
+/**
+ * @brief Consumer: attach a reader to the ring, starting at the next published frame.
+ *        The calling task is notified (task notification) when frames are published.
+ *
+ * @return ESP_ERR_NO_MEM if FRAME_RING_READER_MAX readers are already attached.
+ */
+esp_err_t frameRing_readerAttach(frameRing_reader_st *reader, frameRing_st *ring);
+
+/**
+ * @brief Consumer: detach a reader.
+ */
+void frameRing_readerDetach(frameRing_reader_st *reader);
+
+/**
+ * @brief Consumer: oldest unread frame, in place (no copy).
+ *        Frames overwritten before being read are skipped and added to reader->overruns.
+ *
+ * @param timeout Ticks to wait when no frame is available (0 = do not wait).
+ * @return Frame pointer, NULL on timeout.
+ */
+const void *frameRing_peek(frameRing_reader_st *reader, TickType_t timeout);
+
+/**
+ * @brief Consumer: release the frame returned by frameRing_peek().
+ *
+ * @return false if the producer overwrote the frame while it was in use (the data read
+ *         from it may be torn and must be dropped). It is counted as an overrun.
+ */
+bool frameRing_commit(frameRing_reader_st *reader);
+
+/**
+ * @brief Copy the unread frames of a reader (oldest first, at most the newest @p maxFrames
+ *        still in the ring) without consuming them. The producer must be stopped.
+ *
+ * @return Number of frames copied.
+ */
+uint32_t frameRing_copyPending(const frameRing_reader_st *reader, void *frames, uint32_t maxFrames);
+
+/**
+ * @brief Number of published frames not read yet by this reader (may exceed capacity).
+ */
+static inline uint32_t frameRing_pending(const frameRing_reader_st *reader)
+{
+    return (uint32_t)atomic_load_explicit(&reader->ring->head, memory_order_acquire) - reader->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,255 @@
+#include "powermanager.h"
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+#define POWER_MANAGER_MAUS_PER_UAH  3600000ULL      // 1 µAh = 3.6e6 mA·µs
+
+static const char *TAG = "PowerManager";
+
+typedef struct powerManager_stageProfile
+{
+    const char *name;
+    bool cpuMax;        // ESP_PM_CPU_FREQ_MAX
+    bool noSleep;       // ESP_PM_NO_LIGHT_SLEEP
+} powerManager_stageProfile_st;
+
+static const powerManager_stageProfile_st powerManager_profiles[POWER_STAGE_MAX] = {
+    [POWER_STAGE_ACQUISITION] = {"acquisition", false, true},
+    [POWER_STAGE_FORMAT]      = {"format",      true,  false},
+    [POWER_STAGE_STORAGE]     = {"storage",     true,  true},
+    [POWER_STAGE_NETWORK]     = {"network",     true,  true},
+};
+
+static const uint32_t powerManager_levelCurrent_mA[POWER_LEVEL_MAX] = {
+    [POWER_LEVEL_LIGHT_SLEEP] = CONFIG_POWER_MODEL_LIGHT_SLEEP_MA,
+    [POWER_LEVEL_MIN_CLOCK]   = CONFIG_POWER_MODEL_MIN_CLOCK_MA,
+    [POWER_LEVEL_MAX_CLOCK]   = CONFIG_POWER_MODEL_MAX_CLOCK_MA,
+};
+
+typedef struct powerManager_stageState
+{
+    uint32_t depth;
+    uint32_t bursts;
+    int64_t since_us;
+    int64_t active_us;
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t cpuLock;
+    esp_pm_lock_handle_t sleepLock;
+#endif
+} powerManager_stageState_st;
+
+static portMUX_TYPE powerManager_lock = portMUX_INITIALIZER_UNLOCKED;
+static powerManager_stageState_st powerManager_stages[POWER_STAGE_MAX];
+// Mức khi không stage nào chạy: chưa cấu hình esp_pm thì CPU luôn ở clock mặc định
+static powerManager_level_t powerManager_idleLevel = POWER_LEVEL_MAX_CLOCK;
+static powerManager_level_t powerManager_level = POWER_LEVEL_MAX_CLOCK;
+static int64_t powerManager_levelSince_us;
+static int64_t powerManager_windowStart_us;
+static int64_t powerManager_levelTime_us[POWER_LEVEL_MAX];
+static uint64_t powerManager_charge_mAus;
+static uint32_t powerManager_samples;
+
+/**
+ * @brief Mức công suất theo các stage đang chạy, gọi khi giữ powerManager_lock.
+ */
+static powerManager_level_t powerManager_levelNow(void)
+{
+    powerManager_level_t level = powerManager_idleLevel;
+    for (size_t i = 0; i < POWER_STAGE_MAX && level != POWER_LEVEL_MAX_CLOCK; i++)
+    {
+        if (powerManager_stages[i].depth == 0) {
+            continue;
+        }
+        level = powerManager_profiles[i].cpuMax ? POWER_LEVEL_MAX_CLOCK : POWER_LEVEL_MIN_CLOCK;
+    }
+    return level;
+}
+
+/**
+ * @brief Cộng thời gian và điện tích của mức hiện tại tới @p now_us, gọi khi giữ powerManager_lock.
+ */
+static void powerManager_account(int64_t now_us)
+{
+    int64_t elapsed_us = now_us - powerManager_levelSince_us;
+    powerManager_levelTime_us[powerManager_level] += elapsed_us;
+    powerManager_charge_mAus += (uint64_t)elapsed_us * powerManager_levelCurrent_mA[powerManager_level];
+    powerManager_levelSince_us = now_us;
+}
+
+esp_err_t powerManager_init(uint32_t maxFreq_mhz, uint32_t minFreq_mhz, bool lightSleep)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&powerManager_lock);
+    powerManager_levelSince_us = now;
+    powerManager_windowStart_us = now;
+    portEXIT_CRITICAL(&powerManager_lock);
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pmConfig = {
+        .max_freq_mhz = (int)maxFreq_mhz,
+        .min_freq_mhz = (int)minFreq_mhz,
+        .light_sleep_enable = lightSleep,
+    };
+    esp_err_t err = esp_pm_configure(&pmConfig);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure(%" PRIu32 "/%" PRIu32 " MHz, light sleep %d) failed (%s)",
+                 maxFreq_mhz, minFreq_mhz, lightSleep, esp_err_to_name(err));
+        return err;
+    }
+
+    for (size_t i = 0; i < POWER_STAGE_MAX && err == ESP_OK; i++)
+    {
+        const powerManager_stageProfile_st *profile = &powerManager_profiles[i];
+        if (profile->cpuMax && powerManager_stages[i].cpuLock == NULL) {
+            err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, profile->name, &powerManager_stages[i].cpuLock);
+        }
+        if (err == ESP_OK && profile->noSleep && powerManager_stages[i].sleepLock == NULL) {
+            err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, profile->name, &powerManager_stages[i].sleepLock);
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_lock_create failed (%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    portENTER_CRITICAL(&powerManager_lock);
+    powerManager_account(esp_timer_get_time());
+    powerManager_idleLevel = lightSleep ? POWER_LEVEL_LIGHT_SLEEP : POWER_LEVEL_MIN_CLOCK;
+    powerManager_level = powerManager_levelNow();
+    portEXIT_CRITICAL(&powerManager_lock);
+
+    ESP_LOGI(TAG, "DFS %" PRIu32 "-%" PRIu32 " MHz, automatic light sleep %s", minFreq_mhz, maxFreq_mhz,
+             lightSleep ? "on" : "off");
+    return ESP_OK;
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off, CPU stays at the default clock");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void powerManager_begin(powerManager_stage_t stage)
+{
+    if (stage >= POWER_STAGE_MAX) return;
+    powerManager_stageState_st *state = &powerManager_stages[stage];
+
+#if CONFIG_PM_ENABLE
+    // Khoá được esp_pm đếm: mỗi begin lấy một lần, mỗi end nhả một lần
+    if (state->cpuLock != NULL) {
+        esp_pm_lock_acquire(state->cpuLock);
+    }
+    if (state->sleepLock != NULL) {
+        esp_pm_lock_acquire(state->sleepLock);
+    }
+#endif
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&powerManager_lock);
+    powerManager_account(now);
+    if (state->depth++ == 0)
+    {
+        state->since_us = now;
+        state->bursts++;
+    }
+    powerManager_level = powerManager_levelNow();
+    portEXIT_CRITICAL(&powerManager_lock);
+}
+
+void powerManager_end(powerManager_stage_t stage)
+{
+    if (stage >= POWER_STAGE_MAX) return;
+    powerManager_stageState_st *state = &powerManager_stages[stage];
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&powerManager_lock);
+    bool held = (state->depth != 0);
+    powerManager_account(now);
+    if (held && --state->depth == 0)
+    {
+        int64_t burst_us = now - state->since_us;
+        state->active_us += burst_us;
+        if (stage == POWER_STAGE_NETWORK) {
+            // Dòng của radio khi gửi, cộng thêm vào mức CPU
+            powerManager_charge_mAus += (uint64_t)burst_us * CONFIG_POWER_MODEL_RADIO_MA;
+        }
+    }
+    powerManager_level = powerManager_levelNow();
+    portEXIT_CRITICAL(&powerManager_lock);
+
+#if CONFIG_PM_ENABLE
+    if (held && state->sleepLock != NULL) {
+        esp_pm_lock_release(state->sleepLock);
+    }
+    if (held && state->cpuLock != NULL) {
+        esp_pm_lock_release(state->cpuLock);
+    }
+#endif
+}
+
+void powerManager_countSamples(uint32_t count)
+{
+    portENTER_CRITICAL(&powerManager_lock);
+    powerManager_samples += count;
+    portEXIT_CRITICAL(&powerManager_lock);
+}
+
+void powerManager_stats(powerManager_stats_st *stats, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&powerManager_lock);
+    powerManager_account(now);
+    stats->window_us = now - powerManager_windowStart_us;
+    uint64_t charge_mAus = powerManager_charge_mAus;
+    for (size_t i = 0; i < POWER_STAGE_MAX; i++)
+    {
+        powerManager_stageState_st *state = &powerManager_stages[i];
+        int64_t running_us = state->depth ? now - state->since_us : 0;  // Burst chưa kết thúc
+        stats->stageActive_us[i] = state->active_us + running_us;
+        stats->stageBursts[i] = state->bursts;
+        if (i == POWER_STAGE_NETWORK) {
+            charge_mAus += (uint64_t)running_us * CONFIG_POWER_MODEL_RADIO_MA;
+        }
+        if (reset)
+        {
+            state->active_us = 0;
+            state->bursts = state->depth ? 1 : 0;
+            state->since_us = now;
+        }
+    }
+    memcpy(stats->levelTime_us, powerManager_levelTime_us, sizeof(stats->levelTime_us));
+    stats->samples = powerManager_samples;
+    if (reset)
+    {
+        memset(powerManager_levelTime_us, 0, sizeof(powerManager_levelTime_us));
+        powerManager_charge_mAus = 0;
+        powerManager_samples = 0;
+        powerManager_windowStart_us = now;
+    }
+    portEXIT_CRITICAL(&powerManager_lock);
+
+    stats->charge_uAh = (uint32_t)(charge_mAus / POWER_MANAGER_MAUS_PER_UAH);
+    stats->uAhPer1000Samples = stats->samples ? (uint32_t)(charge_mAus * 1000 / POWER_MANAGER_MAUS_PER_UAH / stats->samples) : 0;
+}
+
+bool powerManager_lightSleepEnabled(void)
+{
+    return powerManager_idleLevel == POWER_LEVEL_LIGHT_SLEEP;
+}
+
+const char *powerManager_stageName(powerManager_stage_t stage)
+{
+    return (stage < POWER_STAGE_MAX) ? powerManager_profiles[stage].name : "?";
+}
+
+const char *powerManager_levelName(powerManager_level_t level)
+{
+    static const char *const names[POWER_LEVEL_MAX] = {"light sleep", "min clock", "max clock"};
+    return (level < POWER_LEVEL_MAX) ? names[level] : "?";
+}
@@ -0,0 +1,113 @@
+/**
+ * @file powermanager.h
+ * @brief Dynamic frequency scaling with per-stage esp_pm locks, and a duty cycle / energy counter.
+ *
+ * powerManager_init() configures esp_pm: the CPU runs at the minimum clock and enters automatic
+ * light sleep whenever it is idle. Each pipeline stage brackets its active burst with
+ * powerManager_begin()/powerManager_end(), which take and release the locks of that stage:
+ *
+ * | Stage       | Locks                                | Burst                                    |
+ * |-------------|--------------------------------------|------------------------------------------|
+ * | ACQUISITION | NO_LIGHT_SLEEP                       | ADC scans of a sampling cycle, T/H reads |
+ * | FORMAT      | CPU_FREQ_MAX                         | Frame assembly, CSV/binlog/JSON encoding |
+ * | STORAGE     | CPU_FREQ_MAX + NO_LIGHT_SLEEP        | SD card append/commit                    |
+ * | NETWORK     | CPU_FREQ_MAX + NO_LIGHT_SLEEP        | Dashboard POST, WebSocket send           |
+ *
+ * Acquisition only needs the chip awake (conversions are waited on the ADS111x ALERT/RDY
+ * interrupt, which cannot wake light sleep), not the maximum clock.
+ *
+ * The same calls drive the counter: time at each power level (maximum clock, minimum clock,
+ * light sleep), time and bursts per stage, and a charge estimate from the currents of
+ * CONFIG_POWER_MODEL_*. Comparing the charge per 1000 samples of two builds (PM off, PM without
+ * light sleep, PM with light sleep) gives the saving of each mode. It is a model, not a
+ * measurement: calibrate the currents with a meter on the real board.
+ *
+ * Nesting is allowed (begin/end are counted per stage). Thread safe.
+ */
+
+#ifndef __POWERMANAGER_H__
+#define __POWERMANAGER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum powerManager_stage
+{
+    POWER_STAGE_ACQUISITION = 0,
+    POWER_STAGE_FORMAT,
+    POWER_STAGE_STORAGE,
+    POWER_STAGE_NETWORK,
+    POWER_STAGE_MAX,
+} powerManager_stage_t;
+
+typedef enum powerManager_level
+{
+    POWER_LEVEL_LIGHT_SLEEP = 0,    /*!< No stage active, automatic light sleep allowed */
+    POWER_LEVEL_MIN_CLOCK,          /*!< Awake at the minimum clock */
+    POWER_LEVEL_MAX_CLOCK,          /*!< A stage holds CPU_FREQ_MAX (or esp_pm is not configured) */
+    POWER_LEVEL_MAX,
+} powerManager_level_t;
+
+typedef struct powerManager_stats
+{
+    int64_t window_us;                          /*!< Time since the last reset */
+    int64_t stageActive_us[POWER_STAGE_MAX];    /*!< Time each stage was active */
+    uint32_t stageBursts[POWER_STAGE_MAX];
+    int64_t levelTime_us[POWER_LEVEL_MAX];      /*!< Time at each power level (model) */
+    uint32_t charge_uAh;                        /*!< Estimated charge over the window */
+    uint32_t samples;                           /*!< Frames counted with powerManager_countSamples() */
+    uint32_t uAhPer1000Samples;                 /*!< charge_uAh * 1000 / samples, 0 without samples */
+} powerManager_stats_st;
+
+/**
+ * @brief Configure dynamic frequency scaling and create the stage locks. Call once, before the
+ *        tasks that use powerManager_begin().
+ *
+ * @param maxFreq_mhz CPU clock while a stage holds CPU_FREQ_MAX (CONFIG_MAX_CPU_FREQ_MHZ).
+ * @param minFreq_mhz CPU clock the rest of the time (CONFIG_MIN_CPU_FREQ_MHZ).
+ * @param lightSleep  Automatic light sleep when idle (needs CONFIG_FREERTOS_USE_TICKLESS_IDLE).
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED without CONFIG_PM_ENABLE (the counter still works, at
+ *         the maximum clock level), or the esp_pm error.
+ */
+esp_err_t powerManager_init(uint32_t maxFreq_mhz, uint32_t minFreq_mhz, bool lightSleep);
+
+/**
+ * @brief Start a burst of @p stage: take its locks.
+ */
+void powerManager_begin(powerManager_stage_t stage);
+
+/**
+ * @brief End a burst of @p stage: release its locks.
+ */
+void powerManager_end(powerManager_stage_t stage);
+
+/**
+ * @brief Count acquired samples (frames) for the charge per 1000 samples.
+ */
+void powerManager_countSamples(uint32_t count);
+
+/**
+ * @brief Counters since the last reset, then optionally reset them.
+ */
+void powerManager_stats(powerManager_stats_st *stats, bool reset);
+
+/**
+ * @brief true if esp_pm was configured with automatic light sleep.
+ */
+bool powerManager_lightSleepEnabled(void);
+
+const char *powerManager_stageName(powerManager_stage_t stage);
+
+const char *powerManager_levelName(powerManager_level_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+#include "autorange.h"
+#include <string.h>
+
+bool autoRange_init(autoRange_st *autoRange, uint8_t channelCount, const autoRange_config_st *config)
+{
+    if (autoRange == NULL || config == NULL || config->fullScale == NULL ||
+        channelCount == 0 || channelCount > AUTORANGE_CHANNEL_MAX ||
+        config->rangeCount == 0 || config->rangeCount > AUTORANGE_RANGE_MAX ||
+        config->initialRange >= config->rangeCount || config->codeMax <= 0 ||
+        config->upshiftPercent == 0 || config->upshiftPercent >= config->downshiftPercent ||
+        config->downshiftPercent > 100) {
+        return false;
+    }
+
+    memset(autoRange, 0, sizeof(*autoRange));
+    for (uint8_t range = 0; range < config->rangeCount; range++)
+    {
+        // Full scale phải giảm dần theo index
+        if (config->fullScale[range] == 0 || (range > 0 && config->fullScale[range] >= config->fullScale[range - 1])) {
+            return false;
+        }
+        autoRange->fullScale[range] = config->fullScale[range];
+    }
+    autoRange->rangeCount = config->rangeCount;
+    autoRange->downshiftPercent = config->downshiftPercent;
+    autoRange->upshiftPercent = config->upshiftPercent;
+    autoRange->holdFrames = config->holdFrames;
+    autoRange->codeMax = config->codeMax;
+    autoRange->channelCount = channelCount;
+    memset(autoRange->range, config->initialRange, sizeof(autoRange->range));
+    return true;
+}
+
+void autoRange_observe(autoRange_st *autoRange, const int16_t *codes)
+{
+    for (uint8_t channel = 0; channel < autoRange->channelCount; channel++)
+    {
+        int32_t code = codes[channel];
+        uint16_t magnitude = (uint16_t)(code < 0 ? -code : code);
+        if (magnitude > autoRange->peak[channel]) {
+            autoRange->peak[channel] = magnitude;
+        }
+    }
+}
+
+/**
+ * @brief Peak (% of full scale, x100 to keep integer math) the channel would show in @p range.
+ */
+static uint64_t autoRange_projectedPercent(const autoRange_st *autoRange, uint16_t peak, uint8_t from, uint8_t range)
+{
+    return (uint64_t)peak * 100U * autoRange->fullScale[from] / autoRange->fullScale[range];
+}
+
+uint32_t autoRange_update(autoRange_st *autoRange)
+{
+    uint32_t changed = 0;
+
+    for (uint8_t channel = 0; channel < autoRange->channelCount; channel++)
+    {
+        const uint8_t current = autoRange->range[channel];
+        const uint16_t peak = autoRange->peak[channel];
+        const uint64_t upshiftLimit = (uint64_t)autoRange->upshiftPercent * (uint64_t)autoRange->codeMax;
+        uint8_t target = current;
+
+        autoRange->peak[channel] = 0;
+        if (peak >= (uint16_t)autoRange->codeMax) {
+            autoRange->clipCount++;
+        }
+
+        if ((uint64_t)peak * 100U > (uint64_t)autoRange->downshiftPercent * (uint64_t)autoRange->codeMax)
+        {
+            // Sắp tràn (hoặc đã tràn): lên ngay range nhỏ nhất mà peak nằm dưới ngưỡng upshift,
+            // tín hiệu bị clip có biên độ thật lớn hơn nên ít nhất lên một range
+            target = 0;
+            for (uint8_t range = current; range-- > 0;)
+            {
+                if (autoRange_projectedPercent(autoRange, peak, current, range) < upshiftLimit) {
+                    target = range;
+                    break;
+                }
+            }
+            autoRange->upshiftFrames[channel] = 0;
+        }
+        else
+        {
+            // Range nhỏ nhất (gain lớn nhất) còn chứa được peak với khoảng trống hysteresis
+            uint8_t candidate = current;
+            for (uint8_t range = (uint8_t)(current + 1); range < autoRange->rangeCount; range++)
+            {
+                if (autoRange_projectedPercent(autoRange, peak, current, range) >= upshiftLimit) {
+                    break;
+                }
+                candidate = range;
+            }
+            if (candidate == current) {
+                autoRange->upshiftFrames[channel] = 0;
+            } else if (++autoRange->upshiftFrames[channel] >= autoRange->holdFrames) {
+                target = candidate;
+                autoRange->upshiftFrames[channel] = 0;
+            }
+        }
+
+        if (target != current)
+        {
+            autoRange->range[channel] = target;
+            autoRange->switchCount++;
+            changed |= 1UL << channel;
+        }
+    }
+    return changed;
+}
+
+int16_t autoRange_rescale(const autoRange_st *autoRange, int16_t code, uint8_t from, uint8_t to)
+{
+    int64_t numerator = (int64_t)code * autoRange->fullScale[from];
+    int64_t denominator = autoRange->fullScale[to];
+    int64_t value = (numerator >= 0) ? (numerator + denominator / 2) / denominator
+                                     : -((-numerator + denominator / 2) / denominator);
+    if (value > autoRange->codeMax) {
+        return autoRange->codeMax;
+    }
+    if (value < -(int64_t)autoRange->codeMax - 1) {
+        return (int16_t)(-autoRange->codeMax - 1);
+    }
+    return (int16_t)value;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file autorange.h
+ * @brief Per-channel automatic range selection (ADC PGA gain ranging) with hysteresis.
+ *
+ * Ranges are indexed from the largest full scale to the smallest (the order of ads111x_gain_t).
+ * The producer task feeds every raw scan to autoRange_observe() and calls autoRange_update()
+ * at the end of each output frame: a channel whose peak comes close to full scale moves to a
+ * larger range at once, a channel whose peak would fit a smaller range moves there only after
+ * holdFrames frames in a row. Ranges change only between frames, so every frame of a channel
+ * is converted with one range.
+ *
+ * Not thread safe: one instance per producer task.
+ */
+
+#ifndef __AUTORANGE_H__
+#define __AUTORANGE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUTORANGE_CHANNEL_MAX   16U
+#define AUTORANGE_RANGE_MAX     8U
+
+typedef struct autoRange_config
+{
+    const uint16_t *fullScale;  /*!< Full scale of each range (any unit, e.g. mV), largest first */
+    uint8_t rangeCount;
+    uint8_t initialRange;
+    uint8_t downshiftPercent;   /*!< Peak above this % of full scale: switch to a larger range */
+    uint8_t upshiftPercent;     /*!< Peak below this % of a smaller range's full scale: candidate to switch */
+    uint8_t holdFrames;         /*!< Frames in a row a smaller range must fit before switching */
+    int16_t codeMax;            /*!< Largest positive code of every range (ADC full scale) */
+} autoRange_config_st;
+
+typedef struct autoRange
+{
+    uint16_t fullScale[AUTORANGE_RANGE_MAX];
+    uint8_t rangeCount;
+    uint8_t downshiftPercent;
+    uint8_t upshiftPercent;
+    uint8_t holdFrames;
+    int16_t codeMax;
+
+    uint8_t channelCount;
+    uint8_t range[AUTORANGE_CHANNEL_MAX];       /*!< Current range of each channel */
+    uint8_t upshiftFrames[AUTORANGE_CHANNEL_MAX];
+    uint16_t peak[AUTORANGE_CHANNEL_MAX];       /*!< Largest |code| since the last update */
+
+    uint32_t switchCount;       /*!< Range changes since init */
+    uint32_t clipCount;         /*!< Frames with a code at full scale */
+} autoRange_st;
+
+/**
+ * @brief Initialize, every channel starts at config->initialRange.
+ *
+ * @return false on invalid parameters (upshiftPercent must be below downshiftPercent).
+ */
+bool autoRange_init(autoRange_st *autoRange, uint8_t channelCount, const autoRange_config_st *config);
+
+/**
+ * @brief Track the peak of every channel, call with every raw scan (channelCount codes).
+ */
+void autoRange_observe(autoRange_st *autoRange, const int16_t *codes);
+
+/**
+ * @brief End of a frame: pick the range of the next frame from the peaks, then clear them.
+ *
+ * @return Bit mask of the channels whose range changed (bit i = channel i).
+ */
+uint32_t autoRange_update(autoRange_st *autoRange);
+
+/**
+ * @brief Convert a code of range @p from to range @p to (rounded, saturated to the code range).
+ */
+int16_t autoRange_rescale(const autoRange_st *autoRange, int16_t code, uint8_t from, uint8_t to);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
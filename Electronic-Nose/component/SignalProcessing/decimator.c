@@ -0,0 +1,232 @@
+#include "decimator.h"
+#include <string.h>
+#include <math.h>
+
+static int16_t decimator_saturate(int64_t value)
+{
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+/**
+ * @brief Division rounding half away from zero (divisor > 0).
+ */
+static int64_t decimator_divideRound(int64_t value, int64_t divisor)
+{
+    return (value >= 0) ? (value + divisor / 2) / divisor : -((-value + divisor / 2) / divisor);
+}
+
+bool decimator_init(decimator_st *decimator, uint8_t channelCount, uint16_t factor, uint8_t order)
+{
+    if (decimator == NULL || channelCount == 0 || channelCount > DECIMATOR_CHANNEL_MAX ||
+        factor == 0 || order == 0 || order > DECIMATOR_ORDER_MAX) {
+        return false;
+    }
+
+    memset(decimator, 0, sizeof(*decimator));
+    decimator->channelCount = channelCount;
+    decimator->factor = factor;
+    decimator->order = order;
+    decimator->gain = 1;
+    for (uint8_t stage = 0; stage < order; stage++) {
+        decimator->gain *= factor;
+    }
+    return true;
+}
+
+void decimator_reset(decimator_st *decimator)
+{
+    memset(decimator->integrator, 0, sizeof(decimator->integrator));
+    memset(decimator->combDelay, 0, sizeof(decimator->combDelay));
+    memset(decimator->firHistory, 0, sizeof(decimator->firHistory));
+    decimator->phase = 0;
+    decimator->firIndex = 0;
+    decimator->inputCount = 0;
+    decimator->outputCount = 0;
+}
+
+bool decimator_setFir(decimator_st *decimator, const int16_t *coefficients, uint8_t taps)
+{
+    if (taps > DECIMATOR_FIR_TAPS_MAX) {
+        return false;
+    }
+    if (coefficients == NULL) {
+        taps = 0;
+    }
+    decimator->firTaps = taps;
+    decimator->firIndex = 0;
+    memset(decimator->firHistory, 0, sizeof(decimator->firHistory));
+    if (taps != 0) {
+        memcpy(decimator->firCoefficients, coefficients, taps * sizeof(coefficients[0]));
+    }
+    return true;
+}
+
+void decimator_designLowpass(int16_t *coefficients, uint8_t taps, float cutoff)
+{
+    const float pi = 3.14159265f;
+    float weights[DECIMATOR_FIR_TAPS_MAX];
+    float sum = 0;
+
+    if (taps == 0 || taps > DECIMATOR_FIR_TAPS_MAX) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < taps; i++)
+    {
+        float n = (float)i - (float)(taps - 1) / 2.0f;
+        float sinc = (n == 0) ? 2.0f * cutoff : sinf(2.0f * pi * cutoff * n) / (pi * n);
+        float window = (taps == 1) ? 1.0f : 0.5f - 0.5f * cosf(2.0f * pi * (float)(i + 1) / (float)(taps + 1));
+        weights[i] = sinc * window;
+        sum += weights[i];
+    }
+
+    // Chuẩn hóa DC gain = 1, phần sai số làm tròn dồn vào tap giữa
+    int32_t total = 0;
+    for (uint8_t i = 0; i < taps; i++)
+    {
+        coefficients[i] = (int16_t)lroundf(weights[i] / sum * 32767.0f);
+        total += coefficients[i];
+    }
+    coefficients[taps / 2] = decimator_saturate((int64_t)coefficients[taps / 2] + 32767 - total);
+}
+
+static uint32_t decimator_gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0)
+    {
+        uint32_t remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+/**
+ * @brief Replace the CIC state of a channel by zero integrators and comb delays giving the same
+ *        outputs: the comb delays are then bounded (|value| < R^order x 2^15 x 2^order).
+ *
+ * With no further input, the last integrator follows a polynomial Q of degree order - 1 at the
+ * output instants, which the comb chain (order-th difference) cancels. Subtracting the backward
+ * differences of Q at the last output from the comb delays moves that part of the history out
+ * of the integrators. Only add/sub modulo 2^64: exact even after the integrators wrapped.
+ */
+static void decimator_rebaseChannel(decimator_st *decimator, uint8_t channel)
+{
+    const uint8_t order = decimator->order;
+    uint64_t integrator[DECIMATOR_ORDER_MAX];
+    uint64_t history[DECIMATOR_ORDER_MAX];     // Q(0), Q(-1), .. at the output instants
+
+    memcpy(integrator, decimator->integrator[channel], sizeof(integrator));
+    uint32_t steps = decimator->phase;          // Back to the last output
+    for (uint8_t k = 0; k < order; k++)
+    {
+        for (uint32_t step = 0; step < steps; step++)
+        {
+            // Inverse of one decimator_push() step with a zero input
+            for (uint8_t stage = (uint8_t)(order - 1); stage > 0; stage--) {
+                integrator[stage] -= integrator[stage - 1];
+            }
+        }
+        history[k] = integrator[order - 1];
+        steps = decimator->factor;
+    }
+
+    // combDelay[s] holds the s-th backward difference of the comb input at the last output
+    for (uint8_t s = 0; s < order; s++)
+    {
+        decimator->combDelay[channel][s] -= history[0];
+        for (uint8_t k = 0; k + 1 < order - s; k++) {
+            history[k] -= history[k + 1];
+        }
+    }
+    memset(decimator->integrator[channel], 0, sizeof(decimator->integrator[channel]));
+}
+
+bool decimator_scaleChannel(decimator_st *decimator, uint8_t channel, int32_t numerator, int32_t denominator)
+{
+    if (channel >= decimator->channelCount || denominator <= 0) {
+        return false;
+    }
+    uint32_t divisor = decimator_gcd((numerator < 0) ? -(uint32_t)numerator : (uint32_t)numerator, (uint32_t)denominator);
+    if (divisor > 1)
+    {
+        numerator /= (int32_t)divisor;
+        denominator /= (int32_t)divisor;
+    }
+
+    // Trạng thái CIC/FIR tuyến tính theo đầu vào: nhân cùng hệ số là đủ, sau khi đưa về dạng
+    // bị chặn (không tràn int64). Sai số làm tròn bị comb triệt tiêu sau `order` frame
+    decimator_rebaseChannel(decimator, channel);
+    for (uint8_t stage = 0; stage < decimator->order; stage++)
+    {
+        decimator->combDelay[channel][stage] =
+            (uint64_t)decimator_divideRound((int64_t)decimator->combDelay[channel][stage] * numerator, denominator);
+    }
+    for (uint8_t tap = 0; tap < decimator->firTaps; tap++)
+    {
+        decimator->firHistory[channel][tap] =
+            decimator_saturate(decimator_divideRound((int64_t)decimator->firHistory[channel][tap] * numerator, denominator));
+    }
+    return true;
+}
+
+bool decimator_push(decimator_st *decimator, const int16_t *input, int16_t *output)
+{
+    const uint8_t order = decimator->order;
+
+    decimator->inputCount++;
+    for (uint8_t channel = 0; channel < decimator->channelCount; channel++)
+    {
+        uint64_t value = (uint64_t)(int64_t)input[channel];
+        for (uint8_t stage = 0; stage < order; stage++)
+        {
+            decimator->integrator[channel][stage] += value;
+            value = decimator->integrator[channel][stage];
+        }
+    }
+
+    if (++decimator->phase < decimator->factor) {
+        return false;
+    }
+    decimator->phase = 0;
+
+    for (uint8_t channel = 0; channel < decimator->channelCount; channel++)
+    {
+        // Comb stages chạy ở tốc độ ra (differential delay = 1)
+        uint64_t value = decimator->integrator[channel][order - 1];
+        for (uint8_t stage = 0; stage < order; stage++)
+        {
+            uint64_t delayed = decimator->combDelay[channel][stage];
+            decimator->combDelay[channel][stage] = value;
+            value -= delayed;
+        }
+        output[channel] = decimator_saturate(decimator_divideRound((int64_t)value, decimator->gain));
+    }
+
+    if (decimator->firTaps != 0)
+    {
+        const uint8_t taps = decimator->firTaps;
+        for (uint8_t channel = 0; channel < decimator->channelCount; channel++)
+        {
+            decimator->firHistory[channel][decimator->firIndex] = output[channel];
+            int64_t accumulator = 0;
+            uint8_t index = decimator->firIndex;
+            for (uint8_t tap = 0; tap < taps; tap++)
+            {
+                accumulator += (int32_t)decimator->firCoefficients[tap] * decimator->firHistory[channel][index];
+                index = (index == 0) ? (uint8_t)(taps - 1) : (uint8_t)(index - 1);
+            }
+            output[channel] = decimator_saturate(decimator_divideRound(accumulator, 32767));
+        }
+        decimator->firIndex = (uint8_t)((decimator->firIndex + 1) % taps);
+    }
+
+    decimator->outputCount++;
+    return true;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file decimator.h
+ * @brief Multi-channel integer decimator: CIC (order 1 = boxcar average) + optional FIR.
+ *
+ * Not thread safe: one decimator per producer task.
+ */
+
+#ifndef __DECIMATOR_H__
+#define __DECIMATOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DECIMATOR_CHANNEL_MAX   16U
+#define DECIMATOR_ORDER_MAX     3U
+#define DECIMATOR_FIR_TAPS_MAX  16U
+
+typedef struct decimator
+{
+    uint8_t channelCount;
+    uint8_t order;              /*!< CIC order, 1 = boxcar average */
+    uint16_t factor;            /*!< Decimation factor R */
+    uint16_t phase;             /*!< Input samples since last output */
+    int64_t gain;               /*!< R^order, CIC DC gain */
+    uint64_t integrator[DECIMATOR_CHANNEL_MAX][DECIMATOR_ORDER_MAX];   /*!< Modulo 2^64: wrap-around is cancelled by the combs */
+    uint64_t combDelay[DECIMATOR_CHANNEL_MAX][DECIMATOR_ORDER_MAX];
+
+    uint8_t firTaps;            /*!< 0 = FIR disabled */
+    uint8_t firIndex;
+    int16_t firCoefficients[DECIMATOR_FIR_TAPS_MAX];    /*!< Q15 */
+    int16_t firHistory[DECIMATOR_CHANNEL_MAX][DECIMATOR_FIR_TAPS_MAX];
+
+    uint32_t inputCount;
+    uint32_t outputCount;
+} decimator_st;
+
+/**
+ * @brief Initialize a decimator (FIR disabled).
+ *
+ * @return false on invalid parameters.
+ */
+bool decimator_init(decimator_st *decimator, uint8_t channelCount, uint16_t factor, uint8_t order);
+
+/**
+ * @brief Clear filter state (e.g. at the start of a sampling cycle), keep configuration.
+ */
+void decimator_reset(decimator_st *decimator);
+
+/**
+ * @brief Enable a FIR stage on the decimated output.
+ *
+ * @param coefficients Q15 coefficients, NULL or @p taps = 0 disables the FIR.
+ * @return false if @p taps > DECIMATOR_FIR_TAPS_MAX.
+ */
+bool decimator_setFir(decimator_st *decimator, const int16_t *coefficients, uint8_t taps);
+
+/**
+ * @brief Hann-windowed sinc low-pass with unity DC gain.
+ *
+ * @param[out] coefficients Q15 coefficients.
+ * @param[in]  taps         Number of taps.
+ * @param[in]  cutoff       Cutoff frequency as a fraction of the sample rate (0 < cutoff <= 0.5).
+ */
+void decimator_designLowpass(int16_t *coefficients, uint8_t taps, float cutoff);
+
+/**
+ * @brief Rescale the filter state of one channel by numerator / denominator (e.g. after the ADC
+ *        gain of the channel changed), as if all past inputs had been scaled the same way.
+ *        Call between decimator_push() calls; the next outputs need no settling.
+ *
+ * The integrators grow without bound (and wrap), so they are not scaled directly: the state is
+ * first rebased to zero integrators and bounded comb delays that give the same outputs, then the
+ * delays are scaled by the ratio reduced by its gcd.
+ *
+ * @return false on invalid parameters.
+ */
+bool decimator_scaleChannel(decimator_st *decimator, uint8_t channel, int32_t numerator, int32_t denominator);
+
+/**
+ * @brief Push one input sample per channel.
+ *
+ * @param[in]  input  channelCount samples.
+ * @param[out] output channelCount decimated samples, written only when true is returned.
+ * @return true every @c factor inputs, when a decimated frame is available.
+ */
+bool decimator_push(decimator_st *decimator, const int16_t *input, int16_t *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,262 @@
+#include "eventdetector.h"
+#include <string.h>
+
+static int32_t eventDetector_abs(int32_t value)
+{
+    return (value < 0) ? -value : value;
+}
+
+static int32_t eventDetector_saturate(int64_t value)
+{
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)value;
+}
+
+static int32_t eventDetector_baseline(const eventDetector_channel_st *channel)
+{
+    return (channel->baselineQ8 + 128) >> 8;
+}
+
+bool eventDetector_init(eventDetector_st *detector, const eventDetector_config_st *config)
+{
+    if (detector == NULL || config == NULL ||
+        config->channelCount == 0 || config->channelCount > EVENT_DETECTOR_CHANNEL_MAX ||
+        config->baselineShift == 0 || config->baselineShift > 15 || config->onsetThreshold <= 0 ||
+        config->onsetFrames == 0 || config->recoveryPercent == 0 || config->recoveryPercent >= 100 ||
+        config->recoveryFrames == 0 || config->maxFrames < 2) {
+        return false;
+    }
+
+    memset(detector, 0, sizeof(*detector));
+    detector->config = *config;
+    eventDetector_reset(detector);
+    return true;
+}
+
+void eventDetector_reset(eventDetector_st *detector)
+{
+    detector->active = false;
+    detector->primed = false;
+    detector->settle = detector->config.settleFrames;
+    detector->frames = 0;
+    for (uint8_t i = 0; i < detector->config.channelCount; i++) {
+        detector->channel[i].overCount = 0;
+    }
+}
+
+/**
+ * @brief Bắt đầu event: baseline giữ nguyên tới hết event, kênh đã vượt ngưỡng có onset là frame vượt đầu tiên.
+ */
+static void eventDetector_start(eventDetector_st *detector)
+{
+    int64_t start_us = detector->last_us;
+    for (uint8_t i = 0; i < detector->config.channelCount; i++)
+    {
+        if (detector->channel[i].overCount != 0 && detector->channel[i].firstOver_us < start_us) {
+            start_us = detector->channel[i].firstOver_us;
+        }
+    }
+
+    detector->active = true;
+    detector->frames = 0;
+    detector->start_us = start_us;
+    detector->traceCount = 0;
+    detector->traceStride = 1;
+    for (uint8_t i = 0; i < detector->config.channelCount; i++)
+    {
+        eventDetector_channel_st *channel = &detector->channel[i];
+        channel->onset_us = (channel->overCount != 0) ? channel->firstOver_us : -1;
+        channel->peak = 0;
+        channel->peak_us = start_us;
+        channel->area_ms = 0;
+        channel->recoveredCount = 0;
+    }
+}
+
+/**
+ * @brief Lưu một điểm trace mỗi traceStride frame; trace đầy thì bỏ một nửa số điểm và nhân đôi stride,
+ *        bộ nhớ cố định với mọi độ dài event.
+ */
+static void eventDetector_trace(eventDetector_st *detector, uint32_t time_ms)
+{
+    uint32_t index = detector->frames - 1;
+    if (index % detector->traceStride != 0) {
+        return;
+    }
+    if (detector->traceCount == EVENT_DETECTOR_TRACE_MAX)
+    {
+        for (uint8_t p = 0; p < EVENT_DETECTOR_TRACE_MAX / 2; p++)
+        {
+            detector->traceTime_ms[p] = detector->traceTime_ms[2 * p];
+            for (uint8_t i = 0; i < detector->config.channelCount; i++) {
+                detector->channel[i].trace[p] = detector->channel[i].trace[2 * p];
+            }
+        }
+        detector->traceCount = EVENT_DETECTOR_TRACE_MAX / 2;
+        detector->traceStride *= 2;
+        if (index % detector->traceStride != 0) {
+            return;
+        }
+    }
+
+    detector->traceTime_ms[detector->traceCount] = time_ms;
+    for (uint8_t i = 0; i < detector->config.channelCount; i++) {
+        detector->channel[i].trace[detector->traceCount] = detector->channel[i].last;
+    }
+    detector->traceCount++;
+}
+
+/**
+ * @brief Thời điểm (ms sau đầu event) trace của kênh đạt @p level theo chiều của peak, nội suy tuyến tính.
+ *
+ * @return -1 nếu trace không đạt @p level.
+ */
+static int32_t eventDetector_crossing(const eventDetector_st *detector, const eventDetector_channel_st *channel, int32_t level)
+{
+    int32_t sign = (channel->peak < 0) ? -1 : 1;
+    for (uint8_t p = 0; p < detector->traceCount; p++)
+    {
+        int32_t value = channel->trace[p] * sign;
+        if (value < level) {
+            continue;
+        }
+        if (p == 0) {
+            return (int32_t)detector->traceTime_ms[0];
+        }
+        int32_t previous = channel->trace[p - 1] * sign;
+        int64_t span_ms = (int64_t)detector->traceTime_ms[p] - detector->traceTime_ms[p - 1];
+        return (int32_t)(detector->traceTime_ms[p - 1] + span_ms * (level - previous) / (value - previous));
+    }
+    return -1;
+}
+
+static void eventDetector_finish(eventDetector_st *detector, bool truncated, eventDetector_event_st *event)
+{
+    const uint8_t count = detector->config.channelCount;
+
+    memset(event, 0, sizeof(*event));
+    event->sequence = detector->sequence++;
+    event->start_us = detector->start_us;
+    event->duration_ms = (uint32_t)((detector->last_us - detector->start_us) / 1000);
+    event->frames = detector->frames;
+    event->channelCount = count;
+    event->truncated = truncated;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        eventDetector_channel_st *channel = &detector->channel[i];
+        eventDetector_features_st *features = &event->channel[i];
+        int64_t onset_us = (channel->onset_us >= 0) ? channel->onset_us : detector->start_us;
+
+        if (channel->onset_us >= 0) {
+            event->triggerMask |= (uint16_t)(1U << i);
+        }
+        features->baseline = eventDetector_baseline(channel);
+        features->peakDelta = channel->peak;
+        features->onsetDelay_ms = (channel->onset_us >= 0) ? (int32_t)((channel->onset_us - detector->start_us) / 1000) : -1;
+        features->timeToPeak_ms = (channel->peak_us > onset_us) ? (int32_t)((channel->peak_us - onset_us) / 1000) : 0;
+        features->area = eventDetector_saturate(channel->area_ms / 1000);
+
+        int32_t magnitude = eventDetector_abs(channel->peak);
+        int32_t rise10 = eventDetector_crossing(detector, channel, (magnitude + 5) / 10);
+        int32_t rise90 = eventDetector_crossing(detector, channel, (magnitude * 9 + 5) / 10);
+        features->riseTime_ms = (magnitude != 0 && rise10 >= 0 && rise90 >= rise10) ? rise90 - rise10 : 0;
+
+        int64_t recovery_ms = (detector->last_us - channel->peak_us) / 1000;
+        features->recoverySlope = (recovery_ms > 0) ? eventDetector_saturate((int64_t)(channel->last - channel->peak) * 1000 / recovery_ms) : 0;
+
+        channel->overCount = 0;
+    }
+
+    detector->active = false;
+    detector->settle = detector->config.settleFrames;
+}
+
+bool eventDetector_push(eventDetector_st *detector, const int32_t *values, int64_t time_us, eventDetector_event_st *event)
+{
+    const eventDetector_config_st *config = &detector->config;
+
+    if (!detector->primed)
+    {
+        for (uint8_t i = 0; i < config->channelCount; i++) {
+            detector->channel[i].baselineQ8 = values[i] * 256;
+        }
+        detector->primed = true;
+        detector->last_us = time_us;
+        return false;
+    }
+    int64_t dt_ms = (time_us - detector->last_us) / 1000;
+    detector->last_us = time_us;
+
+    if (!detector->active)
+    {
+        // Sau event: baseline bám nhanh gấp đôi phần đuôi của lần hồi phục, không phát hiện
+        uint8_t shift = detector->settle ? (uint8_t)((config->baselineShift + 1) / 2) : config->baselineShift;
+        bool trigger = false;
+        for (uint8_t i = 0; i < config->channelCount; i++)
+        {
+            eventDetector_channel_st *channel = &detector->channel[i];
+            int32_t deviation = values[i] - eventDetector_baseline(channel);
+            if (detector->settle == 0 && eventDetector_abs(deviation) > config->onsetThreshold)
+            {
+                // Không cập nhật baseline trong lúc tín hiệu đang lên
+                if (channel->overCount++ == 0) {
+                    channel->firstOver_us = time_us;
+                }
+                trigger |= (channel->overCount >= config->onsetFrames);
+            }
+            else
+            {
+                channel->overCount = 0;
+                channel->baselineQ8 += (values[i] * 256 - channel->baselineQ8) >> shift;
+            }
+        }
+        if (detector->settle != 0) {
+            detector->settle--;
+        }
+        if (!trigger) {
+            return false;
+        }
+        eventDetector_start(detector);
+    }
+
+    detector->frames++;
+    bool recovered = true;
+    for (uint8_t i = 0; i < config->channelCount; i++)
+    {
+        eventDetector_channel_st *channel = &detector->channel[i];
+        int32_t deviation = values[i] - eventDetector_baseline(channel);
+        int32_t magnitude = eventDetector_abs(deviation);
+
+        if (channel->onset_us < 0 && magnitude > config->onsetThreshold) {
+            channel->onset_us = time_us;
+        }
+        if (magnitude > eventDetector_abs(channel->peak))
+        {
+            channel->peak = deviation;
+            channel->peak_us = time_us;
+        }
+        channel->area_ms += (int64_t)deviation * dt_ms;
+        channel->last = deviation;
+
+        if (channel->onset_us >= 0)
+        {
+            bool back = (int64_t)magnitude * 100 <= (int64_t)eventDetector_abs(channel->peak) * config->recoveryPercent;
+            channel->recoveredCount = back ? channel->recoveredCount + 1 : 0;
+            recovered &= (channel->recoveredCount >= config->recoveryFrames);
+        }
+    }
+    eventDetector_trace(detector, (uint32_t)((time_us - detector->start_us) / 1000));
+
+    bool truncated = detector->frames >= config->maxFrames;
+    if (!recovered && !truncated) {
+        return false;
+    }
+    eventDetector_finish(detector, !recovered, event);
+    return true;
+}
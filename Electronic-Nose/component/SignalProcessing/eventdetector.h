@@ -0,0 +1,136 @@
+/**
+ * @file eventdetector.h
+ * @brief Incremental exposure (breath) event detector with per-channel feature extraction.
+ *
+ * Runs on the decimated frames of the sensor array, one call per frame. Each channel tracks its
+ * baseline with an EWMA (alpha = 2^-baselineShift per frame, fixed point) while it is quiet. An
+ * event starts when one channel stays more than onsetThreshold away from its baseline for
+ * onsetFrames frames in a row. From then on the baselines are frozen and every channel follows
+ * its deviation: onset (first frame over the threshold), peak (largest deviation, signed), area
+ * and a short trace for the rise time. The event ends when every triggered channel is back
+ * within recoveryPercent of its peak for recoveryFrames frames (or after maxFrames), then the
+ * detector ignores settleFrames frames while the baselines follow the tail of the recovery.
+ *
+ * Features of every channel are computed over the event window, also for channels that did not
+ * trigger, so an event is a fixed-size feature vector of the whole array.
+ *
+ * Not thread safe: one detector per consumer task.
+ */
+
+#ifndef __EVENTDETECTOR_H__
+#define __EVENTDETECTOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_DETECTOR_CHANNEL_MAX  16U
+#define EVENT_DETECTOR_TRACE_MAX    64U     /*!< Trace points per channel, halved when full */
+
+typedef struct eventDetector_config
+{
+    uint8_t channelCount;
+    uint8_t baselineShift;      /*!< Baseline EWMA alpha = 2^-baselineShift per frame (1..15) */
+    int32_t onsetThreshold;     /*!< Deviation from the baseline that starts an event (input units) */
+    uint8_t onsetFrames;        /*!< Frames in a row over the threshold to start an event */
+    uint8_t recoveryPercent;    /*!< Event ends when every triggered channel is back below this % of its peak */
+    uint8_t recoveryFrames;     /*!< ... for this many frames in a row */
+    uint16_t maxFrames;         /*!< Longest event, ended (truncated) after this many frames */
+    uint16_t settleFrames;      /*!< Frames without detection at start and after each event */
+} eventDetector_config_st;
+
+/**
+ * @brief Features of one channel over an event. Times in ms, values in input units.
+ */
+typedef struct eventDetector_features
+{
+    int32_t baseline;           /*!< Baseline frozen at the event start */
+    int32_t peakDelta;          /*!< Largest deviation from the baseline, signed */
+    int32_t onsetDelay_ms;      /*!< Channel onset after the event start, -1 if it never crossed the threshold */
+    int32_t riseTime_ms;        /*!< 10 % to 90 % of peakDelta */
+    int32_t timeToPeak_ms;      /*!< Channel onset (event start if none) to the peak */
+    int32_t area;               /*!< Integral of the deviation over the event, units x s */
+    int32_t recoverySlope;      /*!< Deviation change from the peak to the event end, units / s */
+} eventDetector_features_st;
+
+typedef struct eventDetector_event
+{
+    uint32_t sequence;          /*!< Event number since eventDetector_init() */
+    int64_t start_us;           /*!< Time of the first frame over the threshold (time base of eventDetector_push()) */
+    uint32_t duration_ms;
+    uint32_t frames;
+    uint16_t triggerMask;       /*!< Channels that crossed the threshold */
+    uint8_t channelCount;
+    bool truncated;             /*!< Ended by maxFrames, not by recovery */
+    eventDetector_features_st channel[EVENT_DETECTOR_CHANNEL_MAX];
+} eventDetector_event_st;
+
+typedef struct eventDetector_channel
+{
+    int32_t baselineQ8;         /*!< Baseline x 256 */
+    int64_t firstOver_us;
+    uint16_t overCount;
+    uint16_t recoveredCount;
+    int32_t peak;
+    int64_t peak_us;
+    int64_t onset_us;           /*!< -1 before the channel crosses the threshold */
+    int64_t area_ms;            /*!< Sum of deviation x ms */
+    int32_t last;
+    int32_t trace[EVENT_DETECTOR_TRACE_MAX];
+} eventDetector_channel_st;
+
+typedef struct eventDetector
+{
+    eventDetector_config_st config;
+    bool active;                /*!< Event in progress */
+    bool primed;                /*!< Baselines initialized */
+    uint16_t settle;            /*!< Frames left without detection */
+    uint32_t frames;            /*!< Frames of the event in progress */
+    int64_t start_us;
+    int64_t last_us;
+    uint32_t sequence;
+    uint8_t traceCount;
+    uint16_t traceStride;       /*!< Frames per trace point */
+    uint32_t traceTime_ms[EVENT_DETECTOR_TRACE_MAX];   /*!< Trace point times after the event start */
+    eventDetector_channel_st channel[EVENT_DETECTOR_CHANNEL_MAX];
+} eventDetector_st;
+
+/**
+ * @brief Initialize a detector.
+ *
+ * @return false on invalid parameters.
+ */
+bool eventDetector_init(eventDetector_st *detector, const eventDetector_config_st *config);
+
+/**
+ * @brief Drop the event in progress and relearn the baselines (e.g. at the start of a sampling
+ *        cycle, the sensors may have drifted). Keeps the configuration and the sequence number.
+ */
+void eventDetector_reset(eventDetector_st *detector);
+
+/**
+ * @brief Push one frame.
+ *
+ * @param[in]  values  channelCount values (e.g. ADC codes normalized to one gain).
+ * @param[in]  time_us Frame time, monotonic (gaps are allowed, time must not go back).
+ * @param[out] event   Completed event, written only when true is returned.
+ * @return true when an event ended with this frame.
+ */
+bool eventDetector_push(eventDetector_st *detector, const int32_t *values, int64_t time_us, eventDetector_event_st *event);
+
+/**
+ * @brief true while an event is in progress.
+ */
+static inline bool eventDetector_active(const eventDetector_st *detector)
+{
+    return detector->active;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#include "sleepschedule.h"
+
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "driver/rtc_io.h"
+#include "ds3231.h"
+#include "timebase.h"
+
+static const char *TAG = "sleepSchedule";
+
+time_t sleepSchedule_nextWindow(time_t now_s, uint32_t period_s, uint32_t minLead_s)
+{
+    if (period_s == 0) {
+        return now_s + minLead_s;
+    }
+    int64_t earliest = (int64_t)now_s + minLead_s;
+    return (time_t)((earliest + period_s - 1) / period_s * period_s);
+}
+
+esp_err_t sleepSchedule_arm(i2c_dev_t *rtc, time_t wake_s)
+{
+    struct tm alarmTime;
+
+    // DS3231 giữ giờ địa phương (TZ), alarm so khớp ngày/giờ/phút/giây
+    localtime_r(&wake_s, &alarmTime);
+    esp_err_t err = ds3231_set_alarm(rtc, DS3231_ALARM_1, &alarmTime, DS3231_ALARM1_MATCH_SECMINHOURDATE, NULL, 0);
+    if (err == ESP_OK) {
+        err = ds3231_clear_alarm_flags(rtc, DS3231_ALARM_BOTH);
+    }
+    if (err == ESP_OK) {
+        err = ds3231_enable_alarm_ints(rtc, DS3231_ALARM_1);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Program DS3231 alarm failed (%s)", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "DS3231 alarm at %02d/%02d %02d:%02d:%02d", alarmTime.tm_mday, alarmTime.tm_mon + 1,
+             alarmTime.tm_hour, alarmTime.tm_min, alarmTime.tm_sec);
+    return ESP_OK;
+}
+
+esp_err_t sleepSchedule_disarm(i2c_dev_t *rtc)
+{
+    esp_err_t err = ds3231_clear_alarm_flags(rtc, DS3231_ALARM_BOTH);
+    if (err == ESP_OK) {
+        err = ds3231_disable_alarm_ints(rtc, DS3231_ALARM_BOTH);
+    }
+    return err;
+}
+
+/**
+ * @brief Sleep time until the backup wakeup, from the timebase (no bus access).
+ */
+static uint64_t sleepSchedule_backupSleepUs(time_t wake_s)
+{
+    int64_t sleep_us = ((int64_t)wake_s + SLEEP_SCHEDULE_BACKUP_WAKE_S) * 1000000 - timeBase_nowUs();
+    return (sleep_us > 1000) ? (uint64_t)sleep_us : 1000U;
+}
+
+bool sleepSchedule_lightSleep(gpio_num_t intGpio, time_t wake_s, int64_t *wakeMonotonic_us)
+{
+    // INT/SQW open drain, tích cực mức thấp cho tới khi xóa cờ alarm
+    gpio_intr_disable(intGpio);
+    gpio_set_direction(intGpio, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(intGpio, GPIO_PULLUP_ONLY);
+    gpio_wakeup_enable(intGpio, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup(sleepSchedule_backupSleepUs(wake_s));
+
+    esp_light_sleep_start();
+    *wakeMonotonic_us = esp_timer_get_time();
+
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    gpio_wakeup_disable(intGpio);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    if (cause != ESP_SLEEP_WAKEUP_GPIO) {
+        ESP_LOGW(TAG, "⚠️  Woken by the backup timer, no DS3231 alarm on GPIO%d", intGpio);
+    }
+    return cause == ESP_SLEEP_WAKEUP_GPIO;
+}
+
+void sleepSchedule_deepSleep(gpio_num_t intGpio, time_t wake_s)
+{
+    // Pull-up nội giữ INT/SQW ở mức cao trong deep sleep (RTC domain)
+    rtc_gpio_pullup_en(intGpio);
+    rtc_gpio_pulldown_dis(intGpio);
+    esp_sleep_enable_ext0_wakeup(intGpio, 0);
+    esp_sleep_enable_timer_wakeup(sleepSchedule_backupSleepUs(wake_s));
+    ESP_LOGI(TAG, "Deep sleep until the DS3231 alarm on GPIO%d", intGpio);
+    esp_deep_sleep_start();
+}
+
+bool sleepSchedule_resume(gpio_num_t intGpio, bool *byAlarm)
+{
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+
+    *byAlarm = (cause == ESP_SLEEP_WAKEUP_EXT0);
+    if (cause == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        return false;
+    }
+    // Ext0 chuyển chân sang RTC IO: trả về GPIO số để dùng lại cho ngắt SQW
+    if (rtc_gpio_is_valid_gpio(intGpio)) {
+        rtc_gpio_deinit(intGpio);
+    }
+    if (!*byAlarm) {
+        ESP_LOGW(TAG, "⚠️  Deep sleep wakeup cause %d, not the DS3231 alarm", (int)cause);
+    }
+    return true;
+}
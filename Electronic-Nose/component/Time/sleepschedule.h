@@ -0,0 +1,75 @@
+/**
+ * @file sleepschedule.h
+ * @brief Scheduled sampling windows: DS3231 alarm 1 wakes the ESP32 from light or deep sleep.
+ *
+ * Windows start every period seconds, aligned to the wall clock (e.g. every 10 min at :00, :10).
+ * Between windows the DS3231 is programmed to assert INT/SQW (open drain, active low) at the
+ * next window start, and the ESP32 sleeps with that pin as wake source (GPIO wakeup in light
+ * sleep, ext0 in deep sleep, so the pin must be an RTC GPIO). The alarm fires on the DS3231
+ * second boundary, so the wake instant is also a time reference (timeBase_anchorToRtcEdge()).
+ * A timer wakeup a few seconds after the alarm keeps the unit from sleeping forever if the RTC
+ * is not wired.
+ *
+ * INT/SQW carries either the alarm or the 1 Hz square wave: stop the square wave before
+ * sleepSchedule_arm() and restart it after sleepSchedule_disarm().
+ */
+
+#ifndef __SLEEPSCHEDULE_H__
+#define __SLEEPSCHEDULE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "i2cdev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SLEEP_SCHEDULE_BACKUP_WAKE_S    5   /*!< Timer wakeup this long after the alarm time */
+
+/**
+ * @brief Start of the next window: the first multiple of @p period_s at or after now_s + minLead_s.
+ */
+time_t sleepSchedule_nextWindow(time_t now_s, uint32_t period_s, uint32_t minLead_s);
+
+/**
+ * @brief Program DS3231 alarm 1 at @p wake_s (matched on date, hour, minute and second of the
+ *        local time the RTC holds) and enable its interrupt. Disables the square wave output.
+ */
+esp_err_t sleepSchedule_arm(i2c_dev_t *rtc, time_t wake_s);
+
+/**
+ * @brief Clear the alarm flags (releases INT/SQW) and disable the alarm interrupts.
+ */
+esp_err_t sleepSchedule_disarm(i2c_dev_t *rtc);
+
+/**
+ * @brief Light sleep until INT/SQW goes low, or the backup timer.
+ *
+ * @param[out] wakeMonotonic_us esp_timer time right after wakeup.
+ * @return true if woken by the alarm, false by the backup timer.
+ */
+bool sleepSchedule_lightSleep(gpio_num_t intGpio, time_t wake_s, int64_t *wakeMonotonic_us);
+
+/**
+ * @brief Deep sleep until INT/SQW goes low (ext0), or the backup timer. Does not return:
+ *        the chip reboots, keep state in RTC_DATA_ATTR memory.
+ */
+void sleepSchedule_deepSleep(gpio_num_t intGpio, time_t wake_s) __attribute__((noreturn));
+
+/**
+ * @brief Call once at boot: returns the wake pin to a digital GPIO after a deep sleep wakeup.
+ *
+ * @param[out] byAlarm true if woken by the DS3231 alarm, false by the backup timer.
+ * @return true if this boot is a deep sleep wakeup.
+ */
+bool sleepSchedule_resume(gpio_num_t intGpio, bool *byAlarm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
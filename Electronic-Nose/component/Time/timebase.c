@@ -0,0 +1,404 @@
+#include "timebase.h"
+
+#include <time.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ds3231.h"
+
+static const char *TAG = "timeBase";
+
+#define TIMEBASE_SQW_GLITCH_US          500000LL    // Cạnh cách cạnh trước < 0.5 s: nhiễu, bỏ qua
+#define TIMEBASE_SQW_LOST_US            3000000LL   // Không có cạnh trong 3 s: mất SQW, về offset SNTP/DS3231
+#define TIMEBASE_SQW_RATE_LIMIT_PPB     500000LL    // Sai số tần số > 500 ppm: phép đo hỏng
+#define TIMEBASE_SQW_EDGE_WAIT_MS       1500
+#define TIMEBASE_SQW_LABEL_ATTEMPTS     3
+
+typedef struct timeBase_sqw
+{
+    bool running;
+    bool labeled;
+    bool rateValid;
+    gpio_num_t gpio;
+    uint32_t edges;
+    uint32_t missedEdges;
+    uint32_t glitches;
+    int64_t edgeMonotonic_us;       // esp_timer tại cạnh cuối
+    int64_t edgeEpoch_us;           // Unix time của cạnh cuối (giây tròn của DS3231)
+    int64_t windowMonotonic_us;     // Cạnh bắt đầu cửa sổ đo tần số
+    int64_t windowEpoch_us;
+    int64_t ratePpb;
+} timeBase_sqw_st;
+
+static portMUX_TYPE timeBase_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t timeBase_epochOffset_us = 0;
+static timeBase_source_t timeBase_currentSource = TIMEBASE_SOURCE_NONE;
+static int64_t timeBase_lastAnchor_us = 0;      // Monotonic time of the last anchor
+static timeBase_sqw_st timeBase_sqw = {.gpio = GPIO_NUM_NC};
+
+/**
+ * @brief Epoch offset at @p monotonic_us, call with timeBase_lock held.
+ */
+static inline int64_t timeBase_offsetAt(int64_t monotonic_us)
+{
+    if (!timeBase_sqw.labeled) {
+        return timeBase_epochOffset_us;
+    }
+    // Cạnh cuối + thời gian esp_timer đã trôi, bù sai số tần số của esp_timer so với DS3231
+    int64_t elapsed_us = monotonic_us - timeBase_sqw.edgeMonotonic_us;
+    return timeBase_sqw.edgeEpoch_us - timeBase_sqw.edgeMonotonic_us - elapsed_us * timeBase_sqw.ratePpb / 1000000000LL;
+}
+
+int64_t timeBase_monotonicUs(void)
+{
+    return esp_timer_get_time();
+}
+
+void timeBase_stamp(int64_t *monotonic_us, int64_t *epochOffset_us)
+{
+    portENTER_CRITICAL(&timeBase_lock);
+    *monotonic_us = esp_timer_get_time();
+    *epochOffset_us = timeBase_offsetAt(*monotonic_us);
+    portEXIT_CRITICAL(&timeBase_lock);
+}
+
+int64_t timeBase_toEpochUs(int64_t monotonic_us)
+{
+    portENTER_CRITICAL(&timeBase_lock);
+    int64_t offset = timeBase_offsetAt(monotonic_us);
+    portEXIT_CRITICAL(&timeBase_lock);
+    return offset != 0 ? monotonic_us + offset : 0;
+}
+
+int64_t timeBase_nowUs(void)
+{
+    int64_t monotonic_us, offset;
+
+    timeBase_stamp(&monotonic_us, &offset);
+    return offset != 0 ? monotonic_us + offset : 0;
+}
+
+timeBase_source_t timeBase_source(void)
+{
+    portENTER_CRITICAL(&timeBase_lock);
+    timeBase_source_t source = timeBase_sqw.labeled ? TIMEBASE_SOURCE_RTC_SQW : timeBase_currentSource;
+    portEXIT_CRITICAL(&timeBase_lock);
+    return source;
+}
+
+const char *timeBase_sourceName(timeBase_source_t source)
+{
+    switch (source)
+    {
+    case TIMEBASE_SOURCE_RTC:
+        return "DS3231";
+    case TIMEBASE_SOURCE_SYSTEM:
+        return "SNTP";
+    case TIMEBASE_SOURCE_RTC_SQW:
+        return "DS3231 SQW";
+    default:
+        return "none";
+    }
+}
+
+static void timeBase_anchor(int64_t epoch_us, int64_t monotonic_us, timeBase_source_t source)
+{
+    int64_t offset = epoch_us - monotonic_us;
+
+    portENTER_CRITICAL(&timeBase_lock);
+    int64_t step = (timeBase_epochOffset_us != 0) ? offset - timeBase_epochOffset_us : 0;
+    timeBase_source_t previous = timeBase_currentSource;
+    timeBase_epochOffset_us = offset;
+    timeBase_currentSource = source;
+    timeBase_lastAnchor_us = monotonic_us;
+    portEXIT_CRITICAL(&timeBase_lock);
+
+    if (source != previous) {
+        ESP_LOGI(TAG, "Anchored to %s, step %" PRId64 " us", timeBase_sourceName(source), step);
+    } else {
+        ESP_LOGD(TAG, "Refreshed from %s, step %" PRId64 " us", timeBase_sourceName(source), step);
+    }
+}
+
+esp_err_t timeBase_anchorToSystemTime(void)
+{
+    struct timeval tv;
+
+    // Hai lần đọc esp_timer bao quanh gettimeofday: lấy điểm giữa
+    int64_t before = esp_timer_get_time();
+    gettimeofday(&tv, NULL);
+    int64_t after = esp_timer_get_time();
+    if (tv.tv_sec < TIMEBASE_VALID_EPOCH_S) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timeBase_anchor((int64_t)tv.tv_sec * 1000000 + tv.tv_usec, before + (after - before) / 2, TIMEBASE_SOURCE_SYSTEM);
+    return ESP_OK;
+}
+
+/**
+ * @brief Read the DS3231 as Unix time (s), @p monotonic_us is taken right after the transfer.
+ */
+static esp_err_t timeBase_readRtc(i2c_dev_t *rtc, time_t *epoch, int64_t *monotonic_us)
+{
+    struct tm rtcTime = {0};
+
+    if (rtc == NULL) return ESP_ERR_INVALID_ARG;
+    esp_err_t err = ds3231_get_time(rtc, &rtcTime);
+    *monotonic_us = esp_timer_get_time();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Driver trả về năm đầy đủ, mktime cần số năm từ 1900
+    rtcTime.tm_year -= 1900;
+    rtcTime.tm_isdst = 0;
+    *epoch = mktime(&rtcTime);
+    return (*epoch < TIMEBASE_VALID_EPOCH_S) ? ESP_ERR_INVALID_STATE : ESP_OK;
+}
+
+esp_err_t timeBase_anchorToRtc(i2c_dev_t *rtc)
+{
+    time_t epoch;
+    int64_t monotonic_us;
+
+    esp_err_t err = timeBase_readRtc(rtc, &epoch, &monotonic_us);
+    if (err != ESP_OK) {
+        return err;
+    }
+    timeBase_anchor((int64_t)epoch * 1000000, monotonic_us, TIMEBASE_SOURCE_RTC);
+    return ESP_OK;
+}
+
+void timeBase_anchorToRtcEdge(time_t epoch_s, int64_t monotonic_us)
+{
+    timeBase_anchor((int64_t)epoch_s * 1000000, monotonic_us, TIMEBASE_SOURCE_RTC);
+}
+
+esp_err_t timeBase_refresh(i2c_dev_t *rtc)
+{
+    esp_err_t err = timeBase_anchorToSystemTime();
+    if (err != ESP_OK && rtc != NULL) {
+        err = timeBase_anchorToRtc(rtc);
+    }
+    return err;
+}
+
+void timeBase_poll(void)
+{
+    portENTER_CRITICAL(&timeBase_lock);
+    int64_t now = esp_timer_get_time();
+    bool lost = timeBase_sqw.labeled && now - timeBase_sqw.edgeMonotonic_us > TIMEBASE_SQW_LOST_US;
+    if (lost)
+    {
+        // Giữ liên tục: offset dự phòng tiếp tục từ giá trị cuối của SQW
+        timeBase_epochOffset_us = timeBase_offsetAt(now);
+        timeBase_currentSource = TIMEBASE_SOURCE_RTC;
+        timeBase_sqw.labeled = false;
+    }
+    // SQW đang chạy: không cần re-anchor theo system time
+    bool due = !timeBase_sqw.labeled &&
+               now - timeBase_lastAnchor_us >= (int64_t)CONFIG_TIMEBASE_REFRESH_PERIOD_S * 1000000;
+    portEXIT_CRITICAL(&timeBase_lock);
+
+    if (lost) {
+        ESP_LOGW(TAG, "⚠️  No DS3231 SQW edge on GPIO%d, falling back to SNTP/DS3231 offset", timeBase_sqw.gpio);
+    }
+
+    if (due && timeBase_anchorToSystemTime() != ESP_OK)
+    {
+        // System time chưa có (chưa SNTP): giữ anchor cũ, thử lại sau một chu kỳ
+        portENTER_CRITICAL(&timeBase_lock);
+        timeBase_lastAnchor_us = esp_timer_get_time();
+        portEXIT_CRITICAL(&timeBase_lock);
+    }
+}
+
+static void IRAM_ATTR timeBase_sqwIsr(void *arg)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&timeBase_lock);
+    if (timeBase_sqw.edges == 0)
+    {
+        timeBase_sqw.edgeMonotonic_us = now;
+        timeBase_sqw.edges = 1;
+        portEXIT_CRITICAL_ISR(&timeBase_lock);
+        return;
+    }
+
+    int64_t interval_us = now - timeBase_sqw.edgeMonotonic_us;
+    if (interval_us < TIMEBASE_SQW_GLITCH_US)
+    {
+        timeBase_sqw.glitches++;
+        portEXIT_CRITICAL_ISR(&timeBase_lock);
+        return;
+    }
+    // Làm tròn theo giây: chịu được cạnh bị mất (ISR bị chặn, nhiễu)
+    int64_t seconds = (interval_us + 500000) / 1000000;
+    timeBase_sqw.missedEdges += (uint32_t)(seconds - 1);
+    timeBase_sqw.edgeMonotonic_us = now;
+    timeBase_sqw.edgeEpoch_us += seconds * 1000000;
+    timeBase_sqw.edges++;
+
+    int64_t windowEpoch_us = timeBase_sqw.edgeEpoch_us - timeBase_sqw.windowEpoch_us;
+    if (timeBase_sqw.labeled && windowEpoch_us >= (int64_t)CONFIG_TIMEBASE_SQW_WINDOW_S * 1000000)
+    {
+        // Sai số tần số của esp_timer trên cả cửa sổ: jitter ngắt (vài µs) chia cho hàng chục giây
+        int64_t windowMonotonic_us = now - timeBase_sqw.windowMonotonic_us;
+        int64_t ratePpb = (windowMonotonic_us - windowEpoch_us) * 1000000000LL / windowEpoch_us;
+        if (ratePpb > -TIMEBASE_SQW_RATE_LIMIT_PPB && ratePpb < TIMEBASE_SQW_RATE_LIMIT_PPB)
+        {
+            timeBase_sqw.ratePpb = timeBase_sqw.rateValid ? timeBase_sqw.ratePpb + (ratePpb - timeBase_sqw.ratePpb) / 4 : ratePpb;
+            timeBase_sqw.rateValid = true;
+        }
+        timeBase_sqw.windowMonotonic_us = now;
+        timeBase_sqw.windowEpoch_us = timeBase_sqw.edgeEpoch_us;
+    }
+    portEXIT_CRITICAL_ISR(&timeBase_lock);
+}
+
+esp_err_t timeBase_labelSqw(i2c_dev_t *rtc)
+{
+    if (rtc == NULL) return ESP_ERR_INVALID_ARG;
+    if (!timeBase_sqw.running) return ESP_ERR_INVALID_STATE;
+
+    for (int attempt = 0; attempt < TIMEBASE_SQW_LABEL_ATTEMPTS; attempt++)
+    {
+        // Cạnh tiếp theo là cạnh đầu tiên: pha SQW có thể đã đổi (DS3231 vừa được ghi)
+        portENTER_CRITICAL(&timeBase_lock);
+        if (timeBase_sqw.labeled) {
+            timeBase_epochOffset_us = timeBase_offsetAt(esp_timer_get_time());
+        }
+        timeBase_sqw.labeled = false;
+        timeBase_sqw.edges = 0;
+        portEXIT_CRITICAL(&timeBase_lock);
+
+        uint32_t edges = 0;
+        for (int waited = 0; edges == 0 && waited < TIMEBASE_SQW_EDGE_WAIT_MS; waited += portTICK_PERIOD_MS)
+        {
+            vTaskDelay(1);
+            portENTER_CRITICAL(&timeBase_lock);
+            edges = timeBase_sqw.edges;
+            portEXIT_CRITICAL(&timeBase_lock);
+        }
+        if (edges == 0) {
+            ESP_LOGE(TAG, "No DS3231 SQW edge on GPIO%d", timeBase_sqw.gpio);
+            return ESP_ERR_TIMEOUT;
+        }
+
+        // Thanh ghi giây tăng tại cạnh xuống: đọc ngay sau cạnh được đúng giây của cạnh đó
+        time_t epoch;
+        int64_t readDone_us;
+        esp_err_t err = timeBase_readRtc(rtc, &epoch, &readDone_us);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        portENTER_CRITICAL(&timeBase_lock);
+        bool sameSecond = (timeBase_sqw.edges == edges);
+        if (sameSecond)
+        {
+            timeBase_sqw.edgeEpoch_us = (int64_t)epoch * 1000000;
+            timeBase_sqw.windowMonotonic_us = timeBase_sqw.edgeMonotonic_us;
+            timeBase_sqw.windowEpoch_us = timeBase_sqw.edgeEpoch_us;
+            timeBase_sqw.labeled = true;
+        }
+        int64_t readDelay_us = readDone_us - timeBase_sqw.edgeMonotonic_us;
+        portEXIT_CRITICAL(&timeBase_lock);
+
+        if (sameSecond) {
+            ESP_LOGI(TAG, "DS3231 SQW edge labeled %lld, read %" PRId64 " us after the edge", (long long)epoch, readDelay_us);
+            return ESP_OK;
+        }
+        // Cạnh mới tới trong lúc đọc I2C: không biết giây đọc được thuộc cạnh nào, thử lại
+        ESP_LOGW(TAG, "SQW edge during the DS3231 read, retrying");
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t timeBase_startSqw(i2c_dev_t *rtc, gpio_num_t gpio)
+{
+    if (rtc == NULL || gpio == GPIO_NUM_NC) return ESP_ERR_INVALID_ARG;
+    if (timeBase_sqw.running) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t err = ds3231_set_squarewave_freq(rtc, DS3231_SQWAVE_1HZ);
+    if (err == ESP_OK) {
+        err = ds3231_enable_squarewave(rtc);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Enable DS3231 SQW failed (%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,   // INT/SQW is open drain
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    err = gpio_config(&io_conf);
+    if (err != ESP_OK) return err;
+
+    // The ISR service may already be installed by another component
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;
+
+    portENTER_CRITICAL(&timeBase_lock);
+    // Sai số tần số esp_timer đo được trước đó vẫn đúng (cùng hai thạch anh): giữ qua stop/start
+    timeBase_sqw = (timeBase_sqw_st){.gpio = gpio, .running = true,
+                                     .rateValid = timeBase_sqw.rateValid, .ratePpb = timeBase_sqw.ratePpb};
+    portEXIT_CRITICAL(&timeBase_lock);
+    err = gpio_isr_handler_add(gpio, timeBase_sqwIsr, NULL);
+    if (err != ESP_OK) {
+        timeBase_sqw.running = false;
+        return err;
+    }
+
+    err = timeBase_labelSqw(rtc);
+    if (err != ESP_OK) {
+        timeBase_stopSqw();
+        return err;
+    }
+    ESP_LOGI(TAG, "Timebase disciplined by DS3231 SQW on GPIO%d, rate window %d s", gpio, CONFIG_TIMEBASE_SQW_WINDOW_S);
+    return ESP_OK;
+}
+
+esp_err_t timeBase_stopSqw(void)
+{
+    if (!timeBase_sqw.running) return ESP_OK;
+
+    esp_err_t err = gpio_isr_handler_remove(timeBase_sqw.gpio);
+    portENTER_CRITICAL(&timeBase_lock);
+    if (timeBase_sqw.labeled)
+    {
+        timeBase_epochOffset_us = timeBase_offsetAt(esp_timer_get_time());
+        timeBase_currentSource = TIMEBASE_SOURCE_RTC;
+    }
+    timeBase_sqw.labeled = false;
+    timeBase_sqw.running = false;
+    portEXIT_CRITICAL(&timeBase_lock);
+    return err;
+}
+
+bool timeBase_sqwRunning(void)
+{
+    return timeBase_sqw.running;
+}
+
+void timeBase_sqwStats(timeBase_sqwStats_st *stats)
+{
+    portENTER_CRITICAL(&timeBase_lock);
+    stats->running = timeBase_sqw.running;
+    stats->labeled = timeBase_sqw.labeled;
+    stats->edges = timeBase_sqw.edges;
+    stats->missedEdges = timeBase_sqw.missedEdges;
+    stats->glitches = timeBase_sqw.glitches;
+    stats->ratePpb = (int32_t)timeBase_sqw.ratePpb;
+    stats->lastEdgeAge_us = timeBase_sqw.edges ? esp_timer_get_time() - timeBase_sqw.edgeMonotonic_us : -1;
+    portEXIT_CRITICAL(&timeBase_lock);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file timebase.h
+ * @brief Sample timebase: esp_timer monotonic microseconds plus an epoch offset anchored to SNTP or the DS3231.
+ *
+ * Frames are stamped at acquisition with timeBase_stamp(): the monotonic time never jumps and
+ * aligns channels and frames exactly, wall-clock time is monotonic + epoch offset. The offset is
+ * refreshed from the system time once SNTP has set it (no bus traffic), or read from the DS3231
+ * (1 s resolution) before that. Re-anchoring only changes the offset: every sample keeps the
+ * offset it was stamped with.
+ *
+ * With timeBase_startSqw() the DS3231 1 Hz square wave disciplines esp_timer: the GPIO interrupt
+ * timestamps every edge (one whole RTC second), the DS3231 is read once to label an edge, and
+ * the esp_timer rate error against the RTC is measured over CONFIG_TIMEBASE_SQW_WINDOW_S. Wall-
+ * clock time is then last edge + rate-corrected esp_timer elapsed time: sub-millisecond, drift
+ * corrected, and no I2C transfer per call (timeBase_nowUs()).
+ *
+ * Thread safe: the offset is shared under a spinlock.
+ */
+
+#ifndef __TIMEBASE_H__
+#define __TIMEBASE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "i2cdev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMEBASE_VALID_EPOCH_S      1577836800LL    /*!< 2020-01-01: earlier system/RTC time is not set */
+
+typedef enum timeBase_source
+{
+    TIMEBASE_SOURCE_NONE = 0,       /*!< Not anchored, epoch offset is 0 */
+    TIMEBASE_SOURCE_RTC,            /*!< DS3231 time, 1 s resolution */
+    TIMEBASE_SOURCE_SYSTEM,         /*!< System time set by SNTP */
+    TIMEBASE_SOURCE_RTC_SQW,        /*!< DS3231 seconds + esp_timer disciplined by the 1 Hz square wave */
+} timeBase_source_t;
+
+typedef struct timeBase_sqwStats
+{
+    bool running;                   /*!< Edge interrupt installed */
+    bool labeled;                   /*!< An edge has been labeled with the DS3231 time */
+    uint32_t edges;                 /*!< Edges since the last label */
+    uint32_t missedEdges;           /*!< Seconds bridged without an edge */
+    uint32_t glitches;              /*!< Edges closer than 0.5 s to the previous one, ignored */
+    int32_t ratePpb;                /*!< esp_timer rate error against the DS3231 (positive: esp_timer fast) */
+    int64_t lastEdgeAge_us;         /*!< Monotonic time since the last edge */
+} timeBase_sqwStats_st;
+
+/**
+ * @brief Monotonic time since boot (esp_timer), microseconds.
+ */
+int64_t timeBase_monotonicUs(void);
+
+/**
+ * @brief Monotonic time and the current epoch offset, read together.
+ *
+ * @param[out] monotonic_us   Monotonic time, microseconds.
+ * @param[out] epochOffset_us Unix time (µs) minus monotonic time, 0 while not anchored.
+ */
+void timeBase_stamp(int64_t *monotonic_us, int64_t *epochOffset_us);
+
+/**
+ * @brief Unix time (µs) of a monotonic time, 0 while not anchored.
+ */
+int64_t timeBase_toEpochUs(int64_t monotonic_us);
+
+/**
+ * @brief Current Unix time (µs) without any bus access, 0 while not anchored.
+ */
+int64_t timeBase_nowUs(void);
+
+timeBase_source_t timeBase_source(void);
+
+const char *timeBase_sourceName(timeBase_source_t source);
+
+/**
+ * @brief Anchor to the system time (set by SNTP).
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the system time is not set (before 2020).
+ */
+esp_err_t timeBase_anchorToSystemTime(void);
+
+/**
+ * @brief Anchor to the DS3231 (one I2C read). The RTC holds local time of the TZ environment
+ *        (sntp_setTimmeZoneToVN()), the anchor is accurate to 1 s.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the RTC time is not set, or the I2C error.
+ */
+esp_err_t timeBase_anchorToRtc(i2c_dev_t *rtc);
+
+/**
+ * @brief Anchor to a DS3231 second boundary observed at @p monotonic_us (an alarm wakeup),
+ *        no bus access. Accurate to the latency of the observation.
+ */
+void timeBase_anchorToRtcEdge(time_t epoch_s, int64_t monotonic_us);
+
+/**
+ * @brief Refresh the anchor: the system time if it is set, else the DS3231 when @p rtc is not NULL.
+ *
+ * @return ESP_OK if anchored, else the error of the last source tried.
+ */
+esp_err_t timeBase_refresh(i2c_dev_t *rtc);
+
+/**
+ * @brief Cheap periodic refresh for the acquisition loop: re-anchor to the system time every
+ *        CONFIG_TIMEBASE_REFRESH_PERIOD_S (follows SNTP corrections), never touches the bus.
+ *        Nothing to do while the square wave disciplines the timebase, except noticing that
+ *        the edges stopped (falls back to the last offset, then the system time).
+ */
+void timeBase_poll(void);
+
+/**
+ * @brief Enable the DS3231 1 Hz square wave on INT/SQW and discipline the timebase with it.
+ *
+ * Installs a falling edge interrupt on @p gpio (open drain output, the internal pull-up is
+ * enabled) and labels the next edge with one DS3231 read (timeBase_labelSqw()). Enabling the
+ * square wave disables the DS3231 alarm interrupts, which share the pin.
+ *
+ * @return ESP_OK, ESP_ERR_TIMEOUT if no edge arrives (pin not wired), or the I2C/GPIO error.
+ */
+esp_err_t timeBase_startSqw(i2c_dev_t *rtc, gpio_num_t gpio);
+
+/**
+ * @brief Stop the edge interrupt, the timebase falls back to the SNTP/DS3231 offset. The
+ *        measured esp_timer rate error is kept for the next timeBase_startSqw().
+ */
+esp_err_t timeBase_stopSqw(void);
+
+/**
+ * @brief Label the next square wave edge with the DS3231 time (one I2C read).
+ *
+ * Writing the DS3231 time restarts its one second countdown: call this after every write.
+ *
+ * @return ESP_OK, ESP_ERR_TIMEOUT if no edge arrives, ESP_ERR_INVALID_STATE if the square wave
+ *         is not running or the RTC time is not set, or the I2C error.
+ */
+esp_err_t timeBase_labelSqw(i2c_dev_t *rtc);
+
+/**
+ * @brief true while the square wave edge interrupt is installed.
+ */
+bool timeBase_sqwRunning(void);
+
+void timeBase_sqwStats(timeBase_sqwStats_st *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,8 +1,14 @@
 #include "FileServer.h"
+#include <stdlib.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
+#include "dataindex.h"
+#include "i2cdev.h"
+#include "calibrationstore.h"
+#include "classifierstore.h"
 
 // Tag for this component
 static const char *TAG = "FileServer";
@@ -221,6 +227,8 @@ esp_err_t set_content_type_from_file(httpd_req_t *req, const char *filename)
         return httpd_resp_set_type(req, "image/jpeg");
     } else if (IS_FILE_EXT(filename, ".ico")) {
         return httpd_resp_set_type(req, "image/x-icon");
+    } else if (IS_FILE_EXT(filename, ".bin")) {
+        return httpd_resp_set_type(req, "application/octet-stream");
     }
     /* This is a limited set only */
     /* For any other type always set as plain text */
@@ -256,10 +264,52 @@ const char* get_path_from_uri(char *dest, const char *base_path, const char *uri
     return dest + base_pathlen;
 }
 
-/* Handler to download a file kept on the server */
+/* Parse a single byte range of the "Range" header: "bytes=first-last", "bytes=first-" or "bytes=-suffix".
+ * Returns 1 and the inclusive range, 0 to send the whole file (no header, multiple or malformed ranges),
+ * -1 if the range is not satisfiable */
+static int parse_range_header(httpd_req_t *req, long size, long *first, long *last)
+{
+    char range[64];
+    if (httpd_req_get_hdr_value_str(req, "Range", range, sizeof(range)) != ESP_OK ||
+        strncmp(range, "bytes=", 6) != 0 || strchr(range, ',') != NULL) {
+        return 0;
+    }
+
+    char *cursor = range + 6;
+    char *end = NULL;
+    if (*cursor == '-')
+    {
+        long suffix = strtol(cursor + 1, &end, 10);
+        if (end == cursor + 1 || *end != '\0' || suffix <= 0) {
+            return (end != cursor + 1 && *end == '\0') ? -1 : 0;
+        }
+        *first = (suffix >= size) ? 0 : size - suffix;
+        *last = size - 1;
+        return (size > 0) ? 1 : -1;
+    }
+
+    *first = strtol(cursor, &end, 10);
+    if (end == cursor || *end != '-' || *first < 0) {
+        return 0;
+    }
+    cursor = end + 1;
+    *last = size - 1;
+    if (*cursor != '\0')
+    {
+        long requested = strtol(cursor, &end, 10);
+        if (*end != '\0' || requested < *first) {
+            return 0;
+        }
+        *last = MIN(requested, size - 1);
+    }
+    return (*first < size) ? 1 : -1;
+}
+
+/* Handler to download a file kept on the server (supports a single HTTP Range) */
 esp_err_t download_get_handler(httpd_req_t *req)
 {
     char filepath[FILE_PATH_MAX];
+    char content_range[48];
     FILE *fd = NULL;
     struct stat file_stat;
 
@@ -299,15 +349,41 @@ esp_err_t download_get_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    ESP_LOGI(__func__, "Sending file : %s (%ld bytes)...", filename, file_stat.st_size);
+    long first = 0;
+    long last = file_stat.st_size - 1;
+    int range = parse_range_header(req, file_stat.st_size, &first, &last);
+    if (range < 0) {
+        fclose(fd);
+        snprintf(content_range, sizeof(content_range), "bytes */%ld", file_stat.st_size);
+        httpd_resp_set_status(req, "416 Range Not Satisfiable");
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+        httpd_resp_send(req, NULL, 0);
+        return ESP_OK;
+    }
+    if (range > 0) {
+        if (fseek(fd, first, SEEK_SET) != 0) {
+            fclose(fd);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read existing file");
+            return ESP_FAIL;
+        }
+        snprintf(content_range, sizeof(content_range), "bytes %ld-%ld/%ld", first, last, file_stat.st_size);
+        httpd_resp_set_status(req, "206 Partial Content");
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+        ESP_LOGI(__func__, "Sending file : %s (bytes %ld-%ld of %ld)...", filename, first, last, file_stat.st_size);
+    } else {
+        ESP_LOGI(__func__, "Sending file : %s (%ld bytes)...", filename, file_stat.st_size);
+    }
+    httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
     set_content_type_from_file(req, filename);
 
     /* Retrieve the pointer to scratch buffer for temporary storage */
     char *chunk = ((struct file_server_data *)req->user_ctx)->scratch;
     size_t chunksize;
+    long remaining = last - first + 1;
     do {
         /* Read file in chunks into the scratch buffer */
-        chunksize = fread(chunk, 1, SCRATCH_BUFSIZE, fd);
+        chunksize = (remaining > 0) ? fread(chunk, 1, MIN((long)SCRATCH_BUFSIZE, remaining), fd) : 0;
+        remaining -= (long)chunksize;
 
         if (chunksize > 0) {
             /* Send the buffer contents as HTTP response chunk */
@@ -337,6 +413,426 @@ esp_err_t download_get_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+/* Output of /api/data: rows are packed into the scratch buffer and sent as HTTP chunks */
+typedef struct api_data_output
+{
+    httpd_req_t *req;
+    char *buffer;
+    size_t length;
+    bool failed;
+} api_data_output_st;
+
+static void api_data_flush(api_data_output_st *output)
+{
+    if (output->length != 0 && !output->failed) {
+        output->failed = httpd_resp_send_chunk(output->req, output->buffer, output->length) != ESP_OK;
+    }
+    output->length = 0;
+}
+
+static void api_data_write(api_data_output_st *output, const void *data, size_t size)
+{
+    if (SCRATCH_BUFSIZE - output->length < size) {
+        api_data_flush(output);
+    }
+    memcpy(output->buffer + output->length, data, size);
+    output->length += size;
+}
+
+static int api_data_formatCenti(char *buffer, size_t size, int32_t centi)
+{
+    uint32_t magnitude = (centi < 0) ? (0U - (uint32_t)centi) : (uint32_t)centi;
+    return snprintf(buffer, size, "%s%" PRIu32 ".%02" PRIu32, (centi < 0) ? "-" : "", magnitude / 100U, magnitude % 100U);
+}
+
+/* "1,3" -> bit 0 and bit 2. Returns false on an unknown channel */
+static bool api_data_parseChannels(const char *list, uint16_t *mask)
+{
+    *mask = 0;
+    while (*list != '\0')
+    {
+        char *end = NULL;
+        long channel = strtol(list, &end, 10);
+        if (end == list || channel < 1 || channel > BINLOG_CHANNEL_MAX || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        *mask |= (uint16_t)(1U << (channel - 1));
+        list = (*end == ',') ? end + 1 : end;
+    }
+    return *mask != 0;
+}
+
+/* Handler to query a window of a sampling log:
+ *   GET /api/data?file=<name>.csv|<name>.bin[&from=STT][&to=STT][&channels=1,3][&format=csv|json|bin]
+ * from/to select rows by STT (first CSV column, inclusive), from=-N selects the last N rows.
+ * Files with sample times (Time_us) keep them in every format.
+ * The sparse index (<file>.idx) is created/extended first, so only the requested window is read.
+ * format=bin answers a binary log (binlog.h) holding the selected channels, see tools/binlog2csv */
+esp_err_t api_data_handler(httpd_req_t *req)
+{
+    char query[192];
+    char parameter[64];
+    char filename[48];
+    char filepath[FILE_PATH_MAX];
+    char row[512];      // One JSON row of 16 channels (normalized values up to 11 characters)
+    int32_t from = INT32_MIN;
+    int32_t to = INT32_MAX;
+    uint16_t channelMask = 0;   // 0 = every channel of the file
+    enum { FORMAT_CSV, FORMAT_JSON, FORMAT_BIN } format = FORMAT_CSV;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "file", filename, sizeof(filename)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing file parameter");
+        return ESP_FAIL;
+    }
+    if (!is_valid_filename(filename) || strchr(filename, '/') != NULL || strstr(filename, "..") != NULL) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid file name");
+        return ESP_FAIL;
+    }
+    if (httpd_query_key_value(query, "from", parameter, sizeof(parameter)) == ESP_OK) {
+        from = (int32_t)strtol(parameter, NULL, 10);
+    }
+    if (httpd_query_key_value(query, "to", parameter, sizeof(parameter)) == ESP_OK) {
+        to = (int32_t)strtol(parameter, NULL, 10);
+    }
+    if (httpd_query_key_value(query, "channels", parameter, sizeof(parameter)) == ESP_OK &&
+        !api_data_parseChannels(parameter, &channelMask)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "channels must be a list of 1..16");
+        return ESP_FAIL;
+    }
+    if (httpd_query_key_value(query, "format", parameter, sizeof(parameter)) == ESP_OK) {
+        if (strcmp(parameter, "json") == 0) {
+            format = FORMAT_JSON;
+        } else if (strcmp(parameter, "bin") == 0) {
+            format = FORMAT_BIN;
+        } else if (strcmp(parameter, "csv") != 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "format must be csv, json or bin");
+            return ESP_FAIL;
+        }
+    }
+    snprintf(filepath, sizeof(filepath), "%s/%s", ((struct file_server_data *)req->user_ctx)->base_path, filename);
+
+    /* Bring the index up to date, then find where the window starts */
+    dataIndex_info_st info;
+    dataIndex_entry_st start;
+    uint32_t skip = 0;
+    esp_err_t errorCode = dataIndex_update(filepath, &info);
+    if (errorCode == ESP_OK) {
+        if (from < 0 && from != INT32_MIN) {
+            uint32_t last = (uint32_t)(-(int64_t)from);
+            errorCode = dataIndex_findRow(filepath, &info, (last >= info.rowCount) ? 0 : info.rowCount - last, &start, &skip);
+            from = INT32_MIN;
+        } else {
+            errorCode = dataIndex_findTimeStamp(filepath, &info, from, &start);
+        }
+    }
+    if (errorCode == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File does not exist");
+        return ESP_FAIL;
+    } else if (errorCode == ESP_ERR_NOT_SUPPORTED || errorCode == ESP_ERR_INVALID_VERSION) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Not a sampling log (.csv or .bin)");
+        return ESP_FAIL;
+    } else if (errorCode != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to index file");
+        return ESP_FAIL;
+    }
+
+    dataIndex_reader_st *reader = malloc(sizeof(dataIndex_reader_st));
+    if (reader == NULL || dataIndex_readerOpen(reader, filepath, &start) != ESP_OK) {
+        free(reader);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read existing file");
+        return ESP_FAIL;
+    }
+
+    /* Channels of the file: a CSV reader started from an index entry has not seen the first row */
+    if (reader->channelCount == 0) {
+        reader->channelCount = info.channelCount;
+    }
+    uint16_t fileMask = (uint16_t)((1UL << reader->channelCount) - 1U);
+    if (channelMask == 0) {
+        channelMask = fileMask;
+    } else if ((channelMask & ~fileMask) != 0 && info.rowCount != 0) {
+        dataIndex_readerClose(reader);
+        free(reader);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "channels exceed the sensor count of the file");
+        return ESP_FAIL;
+    }
+
+    api_data_output_st output = {
+        .req = req,
+        .buffer = ((struct file_server_data *)req->user_ctx)->scratch,
+    };
+    uint8_t channelCount = 0;
+    for (uint8_t i = 0; i < BINLOG_CHANNEL_MAX; i++) {
+        channelCount += (channelMask >> i) & 1U;
+    }
+    // Thời điểm lấy mẫu (Time_us): binlog có BINLOG_FLAG_SAMPLE_TIME hoặc CSV có cột Time_us
+    bool hasTime = (reader->format == DATA_INDEX_FORMAT_BINLOG) ? (reader->header.flags & BINLOG_FLAG_SAMPLE_TIME) != 0
+                                                                : reader->csvTime;
+    binlog_codec_st codec;
+    if (format == FORMAT_BIN)
+    {
+        // Dòng CSV đọc lại có thể mang gain khác nhau (auto gain): ghi gain theo từng record
+        binlog_header_st header = {.flags = BINLOG_FLAG_ENVIRONMENT | BINLOG_FLAG_CHANNEL_GAIN, .gain = BINLOG_REFERENCE_GAIN};
+        if (hasTime) {
+            header.flags |= BINLOG_FLAG_SAMPLE_TIME;
+        }
+        if (reader->format == DATA_INDEX_FORMAT_BINLOG) {
+            header = reader->header;
+        }
+        header.channelCount = channelCount;
+        size_t length = binlog_encodeHeader(&header, (uint8_t *)row, sizeof(row));
+        binlog_codecInit(&codec, &header);
+        httpd_resp_set_type(req, "application/octet-stream");
+        api_data_write(&output, row, length);
+    }
+    else if (format == FORMAT_JSON)
+    {
+        httpd_resp_set_type(req, "application/json");
+        api_data_write(&output, "[", 1);
+    }
+    else
+    {
+        int length = snprintf(row, sizeof(row), "STT,%sTemperature,Humidity", hasTime ? "Time_us," : "");
+        for (uint8_t i = 0; i < BINLOG_CHANNEL_MAX; i++) {
+            if (channelMask & (1U << i)) {
+                length += snprintf(row + length, sizeof(row) - length, ",Sensor%u", i + 1U);
+            }
+        }
+        row[length++] = '\n';
+        httpd_resp_set_type(req, "text/csv");
+        api_data_write(&output, row, length);
+    }
+
+    uint32_t rows = 0;
+    binlog_record_st record;
+    while (!output.failed && dataIndex_readerNext(reader, &record))
+    {
+        if (skip != 0) {
+            skip--;
+            continue;
+        }
+        if (record.timeStamp < from) {
+            continue;
+        }
+        if (record.timeStamp > to) {
+            break;
+        }
+
+        binlog_record_st selected = record;
+        uint8_t channel = 0;
+        for (uint8_t i = 0; i < BINLOG_CHANNEL_MAX; i++) {
+            if (channelMask & (1U << i)) {
+                selected.gain[channel] = record.gain[i];
+                selected.ADC_Value[channel++] = record.ADC_Value[i];
+            }
+        }
+
+        int length = 0;
+        if (format == FORMAT_BIN)
+        {
+            length = (int)binlog_encodeRecord(&codec, &selected, (uint8_t *)row, sizeof(row));
+        }
+        else if (format == FORMAT_JSON)
+        {
+            length = snprintf(row, sizeof(row), "%s{\"STT\":%" PRId32 ",", rows ? "," : "", record.timeStamp);
+            if (hasTime) {
+                length += snprintf(row + length, sizeof(row) - length, "\"Time_us\":%" PRId64 ",", binlog_recordTimeUs(&record));
+            }
+            length += snprintf(row + length, sizeof(row) - length, "\"Temperature\":");
+            length += api_data_formatCenti(row + length, sizeof(row) - length, record.temperature_c);
+            length += snprintf(row + length, sizeof(row) - length, ",\"Humidity\":");
+            length += api_data_formatCenti(row + length, sizeof(row) - length, record.humidity_c);
+            channel = 0;
+            for (uint8_t i = 0; i < BINLOG_CHANNEL_MAX; i++) {
+                if (channelMask & (1U << i)) {
+                    length += snprintf(row + length, sizeof(row) - length, ",\"Sensor%u\":", i + 1U);
+                    length += binlog_formatNormalized(selected.ADC_Value[channel], selected.gain[channel],
+                                                      row + length, sizeof(row) - length);
+                    channel++;
+                }
+            }
+            row[length++] = '}';
+        }
+        else
+        {
+            length = snprintf(row, sizeof(row), "%" PRId32 ",", record.timeStamp);
+            if (hasTime) {
+                length += snprintf(row + length, sizeof(row) - length, "%" PRId64 ",", binlog_recordTimeUs(&record));
+            }
+            length += api_data_formatCenti(row + length, sizeof(row) - length, record.temperature_c);
+            row[length++] = ',';
+            length += api_data_formatCenti(row + length, sizeof(row) - length, record.humidity_c);
+            for (uint8_t i = 0; i < channelCount; i++) {
+                row[length++] = ',';
+                length += binlog_formatNormalized(selected.ADC_Value[i], selected.gain[i], row + length, sizeof(row) - length);
+            }
+            row[length++] = '\n';
+        }
+        api_data_write(&output, row, length);
+        rows++;
+    }
+    dataIndex_readerClose(reader);
+    free(reader);
+
+    if (format == FORMAT_JSON) {
+        api_data_write(&output, "]", 1);
+    }
+    api_data_flush(&output);
+    if (output.failed) {
+        ESP_LOGE(__func__, "Sending %s failed after %" PRIu32 " rows", filename, rows);
+        httpd_resp_sendstr_chunk(req, NULL);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(__func__, "Sent %" PRIu32 " rows of %s (%" PRIu32 " rows in file)", rows, filename, info.rowCount);
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+static esp_err_t api_i2c_trace_write(void *ctx, const char *text, size_t length)
+{
+    api_data_output_st *output = ctx;
+    api_data_write(output, text, length);
+    return output->failed ? ESP_FAIL : ESP_OK;
+}
+
+/* Handler to dump the I2C transaction trace (CONFIG_I2CDEV_TRACE), see i2c_dev_trace_dump():
+ *   GET /api/i2c/trace[?since=N]
+ * since = "next" of the previous dump returns only the new records, see tools/i2c_trace.js */
+esp_err_t api_i2c_trace_handler(httpd_req_t *req)
+{
+    char query[48];
+    char parameter[16];
+    uint32_t since = 0;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "since", parameter, sizeof(parameter)) == ESP_OK) {
+        since = (uint32_t)strtoul(parameter, NULL, 10);
+    }
+
+    api_data_output_st output = {
+        .req = req,
+        .buffer = ((struct file_server_data *)req->user_ctx)->scratch,
+    };
+    httpd_resp_set_type(req, "text/csv");
+    esp_err_t errorCode = i2c_dev_trace_dump(since, api_i2c_trace_write, &output, NULL);
+    if (errorCode == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "I2C trace disabled (CONFIG_I2CDEV_TRACE)");
+        return ESP_FAIL;
+    }
+    api_data_flush(&output);
+    if (errorCode != ESP_OK || output.failed) {
+        httpd_resp_sendstr_chunk(req, NULL);
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+/* Handler to read the calibration table (see calibration.h):
+ *   GET /api/calibration              -> JSON description
+ *   GET /api/calibration?format=bin   -> table blob, input of tools/calibrate.cpp */
+esp_err_t api_calibration_get_handler(httpd_req_t *req)
+{
+    char query[32];
+    char parameter[8];
+    char *scratch = ((struct file_server_data *)req->user_ctx)->scratch;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "format", parameter, sizeof(parameter)) == ESP_OK && strcmp(parameter, "bin") == 0)
+    {
+        size_t length = calibrationStore_export((uint8_t *)scratch, SCRATCH_BUFSIZE);
+        if (length == 0) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No calibration");
+            return ESP_FAIL;
+        }
+        httpd_resp_set_type(req, "application/octet-stream");
+        httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"calibration.cal\"");
+        return httpd_resp_send(req, scratch, (ssize_t)length);
+    }
+
+    size_t length = calibrationStore_formatJson(scratch, SCRATCH_BUFSIZE);
+    if (length == 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Calibration does not fit in the response buffer");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, scratch, (ssize_t)length);
+}
+
+/* Handler to upload a calibration table blob built with tools/calibrate.cpp:
+ *   curl --data-binary @table.cal http://<ESP32_IP>/api/calibration
+ * The table is validated (CRC, curves), applied from the next frame and saved to NVS. */
+esp_err_t api_calibration_post_handler(httpd_req_t *req)
+{
+    uint8_t *blob = (uint8_t *)((struct file_server_data *)req->user_ctx)->scratch;
+    size_t received = 0;
+
+    if (req->content_len == 0 || req->content_len > CALIBRATION_BLOB_MAX_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid calibration size");
+        return ESP_FAIL;
+    }
+    while (received < req->content_len)
+    {
+        int ret = httpd_req_recv(req, (char *)blob + received, req->content_len - received);
+        if (ret <= 0)
+        {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            }
+            return ESP_FAIL;
+        }
+        received += (size_t)ret;
+    }
+
+    esp_err_t err = calibrationStore_update(blob, received);
+    if (err == ESP_ERR_INVALID_ARG || err == ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGE(TAG, "Calibration upload rejected (%s)", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err == ESP_ERR_INVALID_STATE ? "Calibration disabled (CONFIG_CALIBRATION_ENABLE)"
+                                                                                       : "Invalid calibration table");
+        return ESP_FAIL;
+    }
+
+    char response[128];
+    snprintf(response, sizeof(response), "{\"status\":\"%s\",\"calibrated\":%u,\"saved\":%s}",
+             err == ESP_OK ? "success" : "warning", calibrationStore_calibratedChannels(), err == ESP_OK ? "true" : "false");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, response);
+    return ESP_OK;
+}
+
+/* Handler to describe the event classifier model (see classifier.h):
+ *   GET /api/classifier -> {"loaded":..,"source":..,"classes":[..],..} */
+esp_err_t api_classifier_get_handler(httpd_req_t *req)
+{
+    char *scratch = ((struct file_server_data *)req->user_ctx)->scratch;
+    size_t length = classifierStore_formatJson(scratch, SCRATCH_BUFSIZE);
+    if (length == 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Model description does not fit in the response buffer");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, scratch, (ssize_t)length);
+}
+
+/* Handler to load the classifier model again after copying a new MODEL.ENM (tools/train_classifier.cpp)
+ * to the SD card, e.g. with /upload/MODEL.ENM:
+ *   curl -X POST http://<ESP32_IP>/api/classifier/reload */
+esp_err_t api_classifier_reload_handler(httpd_req_t *req)
+{
+    esp_err_t err = classifierStore_load();
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Classifier model not reloaded (%s)", esp_err_to_name(err));
+        httpd_resp_send_err(req, (err == ESP_ERR_NOT_FOUND) ? HTTPD_404_NOT_FOUND : HTTPD_400_BAD_REQUEST,
+                            (err == ESP_ERR_INVALID_STATE) ? "Classifier disabled (CONFIG_CLASSIFIER_ENABLE)"
+                            : (err == ESP_ERR_NOT_FOUND) ? "No model file" : "Invalid model file");
+        return ESP_FAIL;
+    }
+    return api_classifier_get_handler(req);
+}
+
 /* Handler to delete a file from the server */
 esp_err_t delete_post_handler(httpd_req_t *req)
 {
@@ -838,6 +1334,9 @@ esp_err_t start_file_server(const char *base_path)
      * allow the same handler to respond to multiple different
      * target URIs which match the wildcard scheme */
     config.uri_match_fn = httpd_uri_match_wildcard;
+    /* /api/data builds the row index and parses rows in the server task */
+    config.stack_size = 6144;
+    config.max_uri_handlers = 16;
 
     ESP_LOGI(__func__, "Starting HTTP Server on port: '%d'", config.server_port);
     if (httpd_start(&server, &config) != ESP_OK) {
@@ -901,6 +1400,58 @@ esp_err_t start_file_server(const char *base_path)
     };
     httpd_register_uri_handler(server, &api_config_static_ip);
 
+    /* API handler for querying a window of a sampling log */
+    httpd_uri_t api_data = {
+        .uri       = "/api/data",
+        .method    = HTTP_GET,
+        .handler   = api_data_handler,
+        .user_ctx  = server_data    // Pass server data as context (scratch buffer)
+    };
+    httpd_register_uri_handler(server, &api_data);
+
+    /* API handler for the I2C transaction trace */
+    httpd_uri_t api_i2c_trace = {
+        .uri       = "/api/i2c/trace",
+        .method    = HTTP_GET,
+        .handler   = api_i2c_trace_handler,
+        .user_ctx  = server_data    // Scratch buffer
+    };
+    httpd_register_uri_handler(server, &api_i2c_trace);
+
+    /* API handlers for the calibration table */
+    httpd_uri_t api_calibration_get = {
+        .uri       = "/api/calibration",
+        .method    = HTTP_GET,
+        .handler   = api_calibration_get_handler,
+        .user_ctx  = server_data    // Scratch buffer
+    };
+    httpd_register_uri_handler(server, &api_calibration_get);
+
+    httpd_uri_t api_calibration_post = {
+        .uri       = "/api/calibration",
+        .method    = HTTP_POST,
+        .handler   = api_calibration_post_handler,
+        .user_ctx  = server_data    // Scratch buffer
+    };
+    httpd_register_uri_handler(server, &api_calibration_post);
+
+    /* API handlers for the event classifier model */
+    httpd_uri_t api_classifier_get = {
+        .uri       = "/api/classifier",
+        .method    = HTTP_GET,
+        .handler   = api_classifier_get_handler,
+        .user_ctx  = server_data    // Scratch buffer
+    };
+    httpd_register_uri_handler(server, &api_classifier_get);
+
+    httpd_uri_t api_classifier_reload = {
+        .uri       = "/api/classifier/reload",
+        .method    = HTTP_POST,
+        .handler   = api_classifier_reload_handler,
+        .user_ctx  = server_data    // Scratch buffer
+    };
+    httpd_register_uri_handler(server, &api_classifier_reload);
+
     /* URI handler for deleting files from server */
     httpd_uri_t file_delete = {
         .uri       = "/delete/*",   // Match all URIs of type /delete/path/to/file
@@ -53,6 +53,22 @@ esp_err_t download_get_handler(httpd_req_t *req);
 
 esp_err_t delete_post_handler(httpd_req_t *req);
 
+/* API handler for querying a window of a sampling log (/api/data) */
+esp_err_t api_data_handler(httpd_req_t *req);
+
+/* API handler for the I2C transaction trace (/api/i2c/trace) */
+esp_err_t api_i2c_trace_handler(httpd_req_t *req);
+
+/* API handlers for the calibration table (/api/calibration, GET JSON or ?format=bin, POST blob) */
+esp_err_t api_calibration_get_handler(httpd_req_t *req);
+
+esp_err_t api_calibration_post_handler(httpd_req_t *req);
+
+/* API handlers for the event classifier model (GET /api/classifier, POST /api/classifier/reload) */
+esp_err_t api_classifier_get_handler(httpd_req_t *req);
+
+esp_err_t api_classifier_reload_handler(httpd_req_t *req);
+
 /* API handlers for sampling control */
 esp_err_t api_start_sampling_handler(httpd_req_t *req);
 esp_err_t api_stop_sampling_handler(httpd_req_t *req);
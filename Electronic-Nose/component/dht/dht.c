@@ -1,10 +1,37 @@
 #include "dht.h"
+#include <stdlib.h>
 #include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_rom_sys.h"
+#include "driver/rmt_rx.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 
 // Timeout chờ mức HIGH/LOW (µs). Nâng cao để dễ bắt xung hơn.
 #define DHT_TIMEOUT_US 20000
+#define DHT_READ_ATTEMPTS 3
+#define DHT_RETRY_DELAY_MS 80
+
+// RMT RX: 1 tick = 1 µs, lọc nhiễu < 1 µs, 200 µs không có cạnh = hết frame (frame dài ~5 ms)
+#define DHT_RMT_RESOLUTION_HZ 1000000
+#define DHT_RMT_SYMBOLS 64
+#define DHT_RMT_GLITCH_NS 1000
+#define DHT_RMT_IDLE_NS 200000
+#define DHT_RMT_TIMEOUT_MS 20
+// Xung start của host: DHT11 >= 18 ms, DHT22 typ 1 ms (tối đa 20 ms)
+#define DHT11_START_LOW_MS 18
+#define DHT22_START_LOW_MS 1
+
+struct dht_rmt {
+    gpio_num_t gpio;
+    dht_type_t type;
+    rmt_channel_handle_t channel;
+    QueueHandle_t done_queue;
+    rmt_symbol_word_t symbols[DHT_RMT_SYMBOLS];
+    dht_pulse_t pulses[DHT_RMT_SYMBOLS * 2];
+    char dump[DHT_RMT_SYMBOLS * 2 * 6];
+};
 
 static const char *TAG = "dht";
 
@@ -57,28 +84,157 @@ static esp_err_t dht_read_once(gpio_num_t gpio, dht_type_t type, float *humidity
         return ESP_ERR_INVALID_CRC;
     }
 
-    if (type == DHT_TYPE_DHT11) {
-        if (humidity) *humidity = data[0];
-        if (temperature) *temperature = data[2];
-    } else { // DHT22
-        int16_t hum = (data[0] << 8) | data[1];
-        int16_t temp = (data[2] << 8) | data[3];
-        if (temp & 0x8000) temp = -(temp & 0x7FFF);
-        if (humidity) *humidity = hum / 10.0f;
-        if (temperature) *temperature = temp / 10.0f;
-    }
-    return ESP_OK;
+    return dht_convert(type, data, humidity, temperature) ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
 }
 
 esp_err_t dht_read_float(gpio_num_t gpio, dht_type_t type, float *humidity, float *temperature)
 {
     // Thử đọc tối đa 3 lần, mỗi lần cách nhau 80 ms nếu lỗi
-    for (int attempt = 0; attempt < 3; ++attempt) {
+    for (int attempt = 0; attempt < DHT_READ_ATTEMPTS; ++attempt) {
         esp_err_t err = dht_read_once(gpio, type, humidity, temperature);
         if (err == ESP_OK) return err;
-        if (attempt == 2) return err;
-        esp_rom_delay_us(80000); // 80 ms giữa các lần thử
+        if (attempt == DHT_READ_ATTEMPTS - 1) return err;
+        vTaskDelay(pdMS_TO_TICKS(DHT_RETRY_DELAY_MS)); // nhường CPU giữa các lần thử
     }
     return ESP_FAIL;
 }
 
+/*------------------------------------ RMT capture ------------------------------------ */
+
+/* Số tick tối thiểu để chờ ít nhất @p ms (pdMS_TO_TICKS làm tròn xuống, +1 cho tick đang chạy dở) */
+static TickType_t dht_ms_to_ticks(uint32_t ms)
+{
+    return (TickType_t)((ms * configTICK_RATE_HZ + 999) / 1000) + 1;
+}
+
+static bool dht_rmt_on_recv_done(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t task_woken = pdFALSE;
+    size_t count = edata->num_symbols;
+    xQueueSendFromISR((QueueHandle_t)user_ctx, &count, &task_woken);
+    return task_woken == pdTRUE;
+}
+
+esp_err_t dht_rmt_init(gpio_num_t gpio, dht_type_t type, dht_rmt_handle_t *handle)
+{
+    if (handle == NULL) return ESP_ERR_INVALID_ARG;
+    *handle = NULL;
+
+    struct dht_rmt *dht = calloc(1, sizeof(struct dht_rmt));
+    if (dht == NULL) return ESP_ERR_NO_MEM;
+    dht->gpio = gpio;
+    dht->type = type;
+    dht->done_queue = xQueueCreate(1, sizeof(size_t));
+    if (dht->done_queue == NULL) {
+        dht_rmt_free(dht);
+        return ESP_ERR_NO_MEM;
+    }
+
+    rmt_rx_channel_config_t channel_config = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DHT_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT_RMT_SYMBOLS,
+    };
+    esp_err_t err = rmt_new_rx_channel(&channel_config, &dht->channel);
+    if (err == ESP_OK) {
+        rmt_rx_event_callbacks_t callbacks = {
+            .on_recv_done = dht_rmt_on_recv_done,
+        };
+        err = rmt_rx_register_event_callbacks(dht->channel, &callbacks, dht->done_queue);
+    }
+    if (err == ESP_OK) err = rmt_enable(dht->channel);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "RMT RX init failed on GPIO%d: %s", gpio, esp_err_to_name(err));
+        dht_rmt_free(dht);
+        return err;
+    }
+
+    // rmt_new_rx_channel cấu hình chân là input; thêm output open-drain để host gửi xung start,
+    // đường input qua GPIO matrix tới RMT vẫn giữ nguyên
+    gpio_set_direction(gpio, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(gpio, GPIO_PULLUP_ONLY);
+    gpio_set_level(gpio, 1);
+
+    *handle = dht;
+    return ESP_OK;
+}
+
+static esp_err_t dht_rmt_read_once(struct dht_rmt *dht, float *humidity, float *temperature)
+{
+    const rmt_receive_config_t receive_config = {
+        .signal_range_min_ns = DHT_RMT_GLITCH_NS,
+        .signal_range_max_ns = DHT_RMT_IDLE_NS,
+    };
+    size_t symbol_count = 0;
+
+    xQueueReset(dht->done_queue);
+
+    // Start signal: task ngủ trong lúc giữ mức thấp
+    gpio_set_level(dht->gpio, 0);
+    vTaskDelay(dht_ms_to_ticks(dht->type == DHT_TYPE_DHT11 ? DHT11_START_LOW_MS : DHT22_START_LOW_MS));
+    // Bật nhận trước khi nhả đường dây, RMT ghi từ cạnh lên đầu tiên; phần trước response do decoder bỏ qua
+    esp_err_t err = rmt_receive(dht->channel, dht->symbols, sizeof(dht->symbols), &receive_config);
+    gpio_set_level(dht->gpio, 1);
+    if (err != ESP_OK) return err;
+
+    if (xQueueReceive(dht->done_queue, &symbol_count, dht_ms_to_ticks(DHT_RMT_TIMEOUT_MS)) != pdTRUE) {
+        // Không có frame (cảm biến không trả lời): huỷ lần nhận đang chờ
+        rmt_disable(dht->channel);
+        rmt_enable(dht->channel);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    size_t pulse_count = 0;
+    for (size_t i = 0; i < symbol_count && i < DHT_RMT_SYMBOLS; i++) {
+        dht->pulses[pulse_count].level = dht->symbols[i].level0;
+        dht->pulses[pulse_count++].duration_us = dht->symbols[i].duration0;
+        dht->pulses[pulse_count].level = dht->symbols[i].level1;
+        dht->pulses[pulse_count++].duration_us = dht->symbols[i].duration1;
+    }
+
+    uint8_t data[DHT_DATA_BYTES];
+    dht_decode_result_t result = dht_decode_pulses(dht->pulses, pulse_count, data);
+    if (result == DHT_DECODE_OK) {
+        return dht_convert(dht->type, data, humidity, temperature) ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+    }
+
+    ESP_LOGW(TAG, "DHT decode failed: %s (%u pulses)", dht_decode_result_name(result), (unsigned)pulse_count);
+    if (LOG_LOCAL_LEVEL >= ESP_LOG_DEBUG) {
+        dht_format_pulses(dht->pulses, pulse_count, dht->dump, sizeof(dht->dump));
+        ESP_LOGD(TAG, "pulses: %s", dht->dump);
+    }
+    switch (result) {
+    case DHT_DECODE_CHECKSUM:
+        return ESP_ERR_INVALID_CRC;
+    case DHT_DECODE_BAD_TIMING:
+        return ESP_ERR_INVALID_RESPONSE;
+    default:
+        return ESP_ERR_TIMEOUT;
+    }
+}
+
+esp_err_t dht_rmt_read(dht_rmt_handle_t handle, float *humidity, float *temperature)
+{
+    if (handle == NULL) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = ESP_FAIL;
+    for (int attempt = 0; attempt < DHT_READ_ATTEMPTS; ++attempt) {
+        err = dht_rmt_read_once(handle, humidity, temperature);
+        if (err == ESP_OK || attempt == DHT_READ_ATTEMPTS - 1) break;
+        vTaskDelay(pdMS_TO_TICKS(DHT_RETRY_DELAY_MS));
+    }
+    return err;
+}
+
+void dht_rmt_free(dht_rmt_handle_t handle)
+{
+    if (handle == NULL) return;
+    if (handle->channel) {
+        rmt_disable(handle->channel);
+        rmt_del_channel(handle->channel);
+    }
+    if (handle->done_queue) vQueueDelete(handle->done_queue);
+    free(handle);
+}
+
@@ -2,11 +2,38 @@
 
 #include "esp_err.h"
 #include "driver/gpio.h"
+#include "dht_decoder.h"
 
-typedef enum {
-    DHT_TYPE_DHT11 = 0,
-    DHT_TYPE_DHT22 = 1
-} dht_type_t;
-
+/**
+ * @brief Đọc DHT bằng cách polling GPIO (busy-wait ~5 ms mỗi frame, CPU bị chiếm trong lúc đọc).
+ */
 esp_err_t dht_read_float(gpio_num_t gpio, dht_type_t type, float *humidity, float *temperature);
 
+typedef struct dht_rmt *dht_rmt_handle_t;
+
+/**
+ * @brief Tạo bộ đọc DHT dùng RMT RX: độ rộng xung được phần cứng ghi lại, task gọi chỉ block
+ *        (không chiếm CPU) trong lúc chờ frame, decode bằng dht_decode_pulses().
+ *
+ * @param[in]  gpio   Chân DATA (open-drain, pull-up), dùng một kênh RMT RX.
+ * @param[out] handle Bộ đọc, giải phóng bằng dht_rmt_free().
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM, hoặc lỗi của driver RMT (hết kênh RX...).
+ */
+esp_err_t dht_rmt_init(gpio_num_t gpio, dht_type_t type, dht_rmt_handle_t *handle);
+
+/**
+ * @brief Đọc nhiệt độ/độ ẩm, thử lại tối đa 3 lần (cách nhau 80 ms, vTaskDelay).
+ *        Không gọi từ ISR. Frame lỗi được log ở mức debug dạng "L80 H80 L50 ..." để phân tích
+ *        bằng tools/dht_decode.
+ *
+ * @return esp_err_t
+ *
+ * @retval  - ESP_OK on success.
+ * @retval  - ESP_ERR_TIMEOUT nếu cảm biến không trả lời hoặc frame bị cụt.
+ * @retval  - ESP_ERR_INVALID_RESPONSE nếu độ rộng xung/giá trị ngoài dải của cảm biến.
+ * @retval  - ESP_ERR_INVALID_CRC nếu sai checksum.
+ */
+esp_err_t dht_rmt_read(dht_rmt_handle_t handle, float *humidity, float *temperature);
+
+void dht_rmt_free(dht_rmt_handle_t handle);
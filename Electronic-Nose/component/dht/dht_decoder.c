@@ -0,0 +1,121 @@
+#include "dht_decoder.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Cửa sổ thời gian (µs), rộng hơn datasheet để chịu sai số của cảm biến và của bộ capture
+#define DHT_RESPONSE_MIN_US     40U
+#define DHT_RESPONSE_MAX_US     140U
+#define DHT_BIT_LOW_MIN_US      20U
+#define DHT_BIT_LOW_MAX_US      100U
+#define DHT_BIT_HIGH_MIN_US     8U
+#define DHT_BIT_HIGH_MAX_US     110U
+// '0' = 26-28 µs, '1' = 70 µs
+#define DHT_BIT_ONE_MIN_US      48U
+
+static bool dht_in_window(const dht_pulse_t *pulse, uint8_t level, uint16_t min_us, uint16_t max_us)
+{
+    return pulse->level == level && pulse->duration_us >= min_us && pulse->duration_us <= max_us;
+}
+
+/* Bỏ xung độ dài 0 (symbol kết thúc của RMT) và gộp các xung liên tiếp cùng mức */
+static size_t dht_merge_pulses(const dht_pulse_t *pulses, size_t count, dht_pulse_t *merged, size_t size)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (pulses[i].duration_us == 0) continue;
+        uint8_t level = pulses[i].level ? 1 : 0;
+        if (length > 0 && merged[length - 1].level == level) {
+            uint32_t sum = (uint32_t)merged[length - 1].duration_us + pulses[i].duration_us;
+            merged[length - 1].duration_us = sum > UINT16_MAX ? UINT16_MAX : (uint16_t)sum;
+        } else if (length < size) {
+            merged[length].level = level;
+            merged[length].duration_us = pulses[i].duration_us;
+            length++;
+        } else {
+            break;
+        }
+    }
+    return length;
+}
+
+dht_decode_result_t dht_decode_pulses(const dht_pulse_t *pulses, size_t count, uint8_t data[DHT_DATA_BYTES])
+{
+    dht_pulse_t merged[DHT_PULSES_MAX];
+    size_t length = dht_merge_pulses(pulses, count, merged, DHT_PULSES_MAX);
+    memset(data, 0, DHT_DATA_BYTES);
+
+    // Bỏ phần trước response: mức cao khi host nhả đường dây, phần cuối xung start (mức thấp dài)
+    size_t index = 0;
+    while (index < length &&
+           (merged[index].level == 1 || merged[index].duration_us > DHT_RESPONSE_MAX_US)) {
+        index++;
+    }
+    if (index + 1 >= length ||
+        !dht_in_window(&merged[index], 0, DHT_RESPONSE_MIN_US, DHT_RESPONSE_MAX_US) ||
+        !dht_in_window(&merged[index + 1], 1, DHT_RESPONSE_MIN_US, DHT_RESPONSE_MAX_US)) {
+        return DHT_DECODE_NO_RESPONSE;
+    }
+    index += 2;
+
+    for (size_t bit = 0; bit < DHT_DATA_BITS; bit++, index += 2) {
+        if (index + 1 >= length) return DHT_DECODE_TRUNCATED;
+        if (!dht_in_window(&merged[index], 0, DHT_BIT_LOW_MIN_US, DHT_BIT_LOW_MAX_US) ||
+            !dht_in_window(&merged[index + 1], 1, DHT_BIT_HIGH_MIN_US, DHT_BIT_HIGH_MAX_US)) {
+            return DHT_DECODE_BAD_TIMING;
+        }
+        data[bit / 8] <<= 1;
+        if (merged[index + 1].duration_us >= DHT_BIT_ONE_MIN_US) data[bit / 8] |= 1;
+    }
+
+    uint8_t sum = (uint8_t)(data[0] + data[1] + data[2] + data[3]);
+    return sum == data[4] ? DHT_DECODE_OK : DHT_DECODE_CHECKSUM;
+}
+
+bool dht_convert(dht_type_t type, const uint8_t data[DHT_DATA_BYTES], float *humidity, float *temperature)
+{
+    float hum, temp;
+    if (type == DHT_TYPE_DHT11) {
+        hum = data[0];
+        temp = data[2];
+        if (hum > 100.0f || temp > 60.0f) return false;
+    } else { // DHT22
+        int16_t rawTemperature = (int16_t)(((data[2] & 0x7F) << 8) | data[3]);
+        if (data[2] & 0x80) rawTemperature = -rawTemperature;
+        hum = ((data[0] << 8) | data[1]) / 10.0f;
+        temp = rawTemperature / 10.0f;
+        if (hum > 100.0f || temp < -40.0f || temp > 80.0f) return false;
+    }
+    if (humidity) *humidity = hum;
+    if (temperature) *temperature = temp;
+    return true;
+}
+
+const char *dht_decode_result_name(dht_decode_result_t result)
+{
+    switch (result) {
+    case DHT_DECODE_OK:          return "ok";
+    case DHT_DECODE_NO_RESPONSE: return "no response";
+    case DHT_DECODE_TRUNCATED:   return "truncated";
+    case DHT_DECODE_BAD_TIMING:  return "bad timing";
+    case DHT_DECODE_CHECKSUM:    return "checksum";
+    }
+    return "?";
+}
+
+size_t dht_format_pulses(const dht_pulse_t *pulses, size_t count, char *buffer, size_t size)
+{
+    size_t length = 0;
+    if (size == 0) return 0;
+    buffer[0] = '\0';
+    for (size_t i = 0; i < count; i++) {
+        int written = snprintf(buffer + length, size - length, "%s%c%u", i ? " " : "",
+                               pulses[i].level ? 'H' : 'L', (unsigned)pulses[i].duration_us);
+        if (written < 0 || (size_t)written >= size - length) {
+            buffer[length] = '\0';
+            break;
+        }
+        length += (size_t)written;
+    }
+    return length;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file dht_decoder.h
+ * @brief Decode a DHT11/DHT22 frame from captured pulse widths (RMT, edge capture or a recording).
+ *
+ * The firmware (dht.c, RMT capture) and the host checker tools/dht_decode.c share this decoder.
+ *
+ * Frame on the wire after the host start signal (line idles high):
+ *   response  low ~80 us, high ~80 us
+ *   40 bits   low ~50 us, then high 26-28 us ('0') or ~70 us ('1'), MSB first
+ *   end       low ~50 us, line released
+ * Bytes: humidity (2), temperature (2), checksum = low byte of the sum of the first four.
+ *
+ * Text form of a pulse train (dht_format_pulses, parsed by tools/dht_decode.c):
+ *   "L80 H80 L50 H27 L50 H70 ..." level (L/H) followed by the duration in microseconds.
+ */
+
+#ifndef __DHT_DECODER_H__
+#define __DHT_DECODER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT_DATA_BYTES          5U
+#define DHT_DATA_BITS           (DHT_DATA_BYTES * 8U)
+/* response (2) + 40 bits (2 each) + end low + the pulses before the response */
+#define DHT_PULSES_MAX          96U
+
+typedef enum {
+    DHT_TYPE_DHT11 = 0,
+    DHT_TYPE_DHT22 = 1
+} dht_type_t;
+
+/**
+ * @brief Line held at @c level for @c duration_us.
+ */
+typedef struct dht_pulse
+{
+    uint8_t level;
+    uint16_t duration_us;
+} dht_pulse_t;
+
+typedef enum dht_decode_result
+{
+    DHT_DECODE_OK = 0,
+    DHT_DECODE_NO_RESPONSE,     /*!< No 80 us low / 80 us high response from the sensor */
+    DHT_DECODE_TRUNCATED,       /*!< Fewer than 40 bits captured */
+    DHT_DECODE_BAD_TIMING,      /*!< A bit pulse outside the DHT timing window */
+    DHT_DECODE_CHECKSUM,
+} dht_decode_result_t;
+
+/**
+ * @brief Decode the 5 data bytes from a pulse train.
+ *        Zero length pulses are ignored and consecutive pulses of the same level are merged.
+ *        Pulses before the response (host start signal, line released) are skipped.
+ *
+ * @param[out] data Raw bytes, valid for DHT_DECODE_OK and DHT_DECODE_CHECKSUM.
+ */
+dht_decode_result_t dht_decode_pulses(const dht_pulse_t *pulses, size_t count, uint8_t data[DHT_DATA_BYTES]);
+
+/**
+ * @brief Convert raw bytes to humidity (%RH) and temperature (°C).
+ *
+ * @return false if the values are outside the sensor range (bad frame with a valid checksum).
+ */
+bool dht_convert(dht_type_t type, const uint8_t data[DHT_DATA_BYTES], float *humidity, float *temperature);
+
+const char *dht_decode_result_name(dht_decode_result_t result);
+
+/**
+ * @brief Write @p pulses as "L80 H80 L50 ..." (NUL terminated, truncated to @p size).
+ *
+ * @return Length written, without the NUL.
+ */
+size_t dht_format_pulses(const dht_pulse_t *pulses, size_t count, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
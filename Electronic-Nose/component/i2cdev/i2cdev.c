@@ -30,23 +30,111 @@
  *
  * MIT Licensed as described in the file LICENSE
  */
+#include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include "i2cdev.h"
 
+#if I2CDEV_MASTER_BUS
+#include <driver/i2c_master.h>
+#endif
+
 static const char *TAG = "i2cdev";
 
+#if I2CDEV_MASTER_BUS
+// Số device handle tối đa trên một port (mỗi cặp địa chỉ/tốc độ clock một handle)
+#define I2CDEV_MAX_DEVICES 16
+// Bộ đệm ghép thanh ghi + dữ liệu cho i2c_dev_write (i2c_master_transmit nhận một buffer)
+#define I2CDEV_WRITE_BUFFER_SIZE 32
+
+typedef struct {
+    uint16_t addr;
+    uint32_t clk_speed;
+    i2c_master_dev_handle_t handle;
+} i2c_dev_slot_t;
+#else
+// Command link dựng trên stack: start + addr + reg, start + addr + read (2 lệnh) + stop
+#define I2CDEV_LINK_SIZE I2C_LINK_RECOMMENDED_SIZE(3)
+#endif
+
 typedef struct {
     SemaphoreHandle_t lock;
     i2c_config_t config;
     bool installed;
+#if I2CDEV_MASTER_BUS
+    i2c_master_bus_handle_t bus;
+    i2c_dev_slot_t devices[I2CDEV_MAX_DEVICES];  //!< Filled in order, handle set last
+    size_t device_count;
+#else
+    uint32_t timeout_ticks;  //!< Timeout last written to the port, 0 = unknown
+#endif
 } i2c_port_state_t;
 
 static i2c_port_state_t states[I2C_NUM_MAX];
 
+#if CONFIG_I2CDEV_SCHEDULER
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES < 2
+#error "CONFIG_I2CDEV_SCHEDULER needs CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2"
+#endif
+// Slot thông báo hoàn thành giao dịch; slot 0 để cho ứng dụng (ALERT/RDY của ADS111x, FrameRing...)
+#define I2CDEV_NOTIFY_INDEX 1
+
+typedef struct {
+    TaskHandle_t task;
+    TaskHandle_t stopper;   //!< Task waiting in i2cdev_done()
+    bool stopping;
+    i2c_dev_transaction_t *pending[I2C_DEV_PRIORITY_MAX];  //!< Per class, by deadline then FIFO
+    uint32_t depth;
+    i2c_dev_scheduler_stats_t stats;
+    int64_t window_start_us;
+} i2c_scheduler_t;
+
+static i2c_scheduler_t schedulers[I2C_NUM_MAX];
+static portMUX_TYPE scheduler_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Thứ tự phục vụ các lớp ưu tiên
+static const i2c_dev_priority_t service_order[I2C_DEV_PRIORITY_MAX] = {
+    I2C_DEV_PRIORITY_ACQUISITION, I2C_DEV_PRIORITY_CONTROL, I2C_DEV_PRIORITY_HOUSEKEEPING
+};
+
+static void i2c_scheduler_stop(i2c_port_t port);
+#endif
+
+#if CONFIG_I2CDEV_TRACE
+#if (CONFIG_I2CDEV_TRACE_ENTRIES & (CONFIG_I2CDEV_TRACE_ENTRIES - 1)) != 0
+#error "CONFIG_I2CDEV_TRACE_ENTRIES must be a power of two"
+#endif
+// Ring không khoá: writer lấy số thứ tự bằng atomic add, ghi record rồi mới công bố stamp (kiểu seqlock)
+static i2c_dev_trace_entry_t trace_ring[CONFIG_I2CDEV_TRACE_ENTRIES];
+static uint32_t trace_head;  //!< Sequence number of the next record
+
+static void i2c_trace_record(const i2c_dev_transaction_t *t, int64_t start, int64_t end, esp_err_t res)
+{
+    uint32_t seq = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    i2c_dev_trace_entry_t *e = &trace_ring[seq & (CONFIG_I2CDEV_TRACE_ENTRIES - 1)];
+
+    __atomic_store_n(&e->stamp, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    e->start_us = start;
+    e->duration_us = (uint32_t)(end - start);
+    e->wait_us = (uint32_t)(start - t->queued_us);
+    e->port = (uint8_t)t->dev->port;
+    e->addr = t->dev->addr;
+    e->op = (uint8_t)t->op;
+    e->priority = (uint8_t)t->priority;
+    e->out_bytes = (uint16_t)(t->op == I2C_DEV_OP_PROBE ? 0 : t->out_size + (t->op == I2C_DEV_OP_WRITE ? t->out_reg_size : 0));
+    e->in_bytes = (uint16_t)(t->op == I2C_DEV_OP_READ ? t->in_size : 0);
+    e->result = (int16_t)res;
+    __atomic_store_n(&e->stamp, seq + 1, __ATOMIC_RELEASE);
+}
+#else
+#define i2c_trace_record(t, start, end, res) ((void)(start))
+#endif
+
 #if CONFIG_I2CDEV_NOLOCK
 #define SEMAPHORE_TAKE(port)
 #else
@@ -94,12 +182,24 @@ esp_err_t i2cdev_done()
 {
     for (int i = 0; i < I2C_NUM_MAX; i++)
     {
+#if CONFIG_I2CDEV_SCHEDULER
+        i2c_scheduler_stop(i);
+#endif
         if (!states[i].lock) continue;
 
         if (states[i].installed)
         {
             SEMAPHORE_TAKE(i);
+#if I2CDEV_MASTER_BUS
+            for (size_t d = 0; d < states[i].device_count; d++)
+                i2c_master_bus_rm_device(states[i].devices[d].handle);
+            states[i].device_count = 0;
+            memset(states[i].devices, 0, sizeof(states[i].devices));
+            i2c_del_master_bus(states[i].bus);
+            states[i].bus = NULL;
+#else
             i2c_driver_delete(i);
+#endif
             states[i].installed = false;
             SEMAPHORE_GIVE(i);
         }
@@ -174,6 +274,172 @@ esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev)
     return ESP_OK;
 }
 
+#if I2CDEV_MASTER_BUS
+
+/**
+ * Bus của port, tạo ở lần dùng đầu tiên với chân SDA/SCL của thiết bị đó.
+ * Phải giữ port mutex.
+ */
+static esp_err_t i2c_get_bus(const i2c_dev_t *dev)
+{
+    i2c_port_state_t *state = &states[dev->port];
+    if (state->installed)
+    {
+        if (state->config.sda_io_num != dev->cfg.sda_io_num || state->config.scl_io_num != dev->cfg.scl_io_num)
+        {
+            ESP_LOGE(TAG, "[0x%02x at %d] port already used with SDA %d / SCL %d", dev->addr, dev->port,
+                     state->config.sda_io_num, state->config.scl_io_num);
+            return ESP_ERR_INVALID_STATE;
+        }
+        return ESP_OK;
+    }
+
+    i2c_master_bus_config_t bus_config = {
+        .i2c_port = dev->port,
+        .sda_io_num = dev->cfg.sda_io_num,
+        .scl_io_num = dev->cfg.scl_io_num,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = dev->cfg.sda_pullup_en || dev->cfg.scl_pullup_en,
+    };
+    esp_err_t res = i2c_new_master_bus(&bus_config, &state->bus);
+    if (res != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Could not create I2C master bus on port %d: %s", dev->port, esp_err_to_name(res));
+        return res;
+    }
+    memcpy(&state->config, &dev->cfg, sizeof(i2c_config_t));
+    state->installed = true;
+    ESP_LOGD(TAG, "I2C master bus created on port %d", dev->port);
+    return ESP_OK;
+}
+
+static i2c_master_dev_handle_t i2c_find_device(const i2c_port_state_t *state, const i2c_dev_t *dev)
+{
+    for (size_t i = 0; i < I2CDEV_MAX_DEVICES; i++)
+    {
+        i2c_master_dev_handle_t handle = __atomic_load_n(&state->devices[i].handle, __ATOMIC_ACQUIRE);
+        if (!handle)
+            break;
+        if (state->devices[i].addr == dev->addr && state->devices[i].clk_speed == dev->cfg.master.clk_speed)
+            return handle;
+    }
+    return NULL;
+}
+
+/**
+ * Device handle của (port, địa chỉ, tốc độ clock). Handle tạo một lần rồi dùng lại:
+ * đường thường chỉ là một vòng tìm không khoá, không cấp phát.
+ */
+static esp_err_t i2c_get_device(const i2c_dev_t *dev, i2c_master_dev_handle_t *handle)
+{
+    if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    i2c_port_state_t *state = &states[dev->port];
+    *handle = i2c_find_device(state, dev);
+    if (*handle)
+        return ESP_OK;
+
+    SEMAPHORE_TAKE(dev->port);
+    esp_err_t res = ESP_OK;
+    *handle = i2c_find_device(state, dev);
+    if (!*handle)
+        res = i2c_get_bus(dev);
+    if (!*handle && res == ESP_OK)
+    {
+        if (state->device_count >= I2CDEV_MAX_DEVICES)
+        {
+            ESP_LOGE(TAG, "[0x%02x at %d] too many devices on port", dev->addr, dev->port);
+            res = ESP_ERR_NO_MEM;
+        }
+        else
+        {
+            i2c_device_config_t device_config = {
+                .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+                .device_address = dev->addr,
+                .scl_speed_hz = dev->cfg.master.clk_speed,
+            };
+            i2c_dev_slot_t *slot = &state->devices[state->device_count];
+            res = i2c_master_bus_add_device(state->bus, &device_config, handle);
+            if (res == ESP_OK)
+            {
+                slot->addr = dev->addr;
+                slot->clk_speed = dev->cfg.master.clk_speed;
+                __atomic_store_n(&slot->handle, *handle, __ATOMIC_RELEASE);
+                state->device_count++;
+                ESP_LOGD(TAG, "[0x%02x at %d] device handle created, %" PRIu32 " Hz", dev->addr, dev->port, slot->clk_speed);
+            }
+            else
+                ESP_LOGE(TAG, "[0x%02x at %d] Could not add device: %s", dev->addr, dev->port, esp_err_to_name(res));
+        }
+    }
+    SEMAPHORE_GIVE(dev->port);
+    return res;
+}
+
+static esp_err_t i2c_bus_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type, uint32_t timeout_ms)
+{
+    if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    // i2c_master_probe gửi địa chỉ với bit write, operation_type không dùng
+    SEMAPHORE_TAKE(dev->port);
+    esp_err_t res = i2c_get_bus(dev);
+    SEMAPHORE_GIVE(dev->port);
+    if (res == ESP_OK)
+        res = i2c_master_probe(states[dev->port].bus, dev->addr, timeout_ms);
+
+    return res;
+}
+
+static esp_err_t i2c_bus_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size,
+        uint32_t timeout_ms)
+{
+    i2c_master_dev_handle_t handle;
+    esp_err_t res = i2c_get_device(dev, &handle);
+    if (res != ESP_OK)
+        return res;
+
+    if (out_data && out_size)
+        res = i2c_master_transmit_receive(handle, out_data, out_size, in_data, in_size, timeout_ms);
+    else
+        res = i2c_master_receive(handle, in_data, in_size, timeout_ms);
+    if (res != ESP_OK)
+        ESP_LOGE(TAG, "Could not read from device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
+
+    return res;
+}
+
+static esp_err_t i2c_bus_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data,
+        size_t out_size, uint32_t timeout_ms)
+{
+    i2c_master_dev_handle_t handle;
+    esp_err_t res = i2c_get_device(dev, &handle);
+    if (res != ESP_OK)
+        return res;
+
+    if (out_reg && out_reg_size)
+    {
+        uint8_t buffer[I2CDEV_WRITE_BUFFER_SIZE];
+        if (out_reg_size + out_size > sizeof(buffer))
+        {
+            ESP_LOGE(TAG, "[0x%02x at %d] write of %u bytes exceeds %u", dev->addr, dev->port,
+                     (unsigned)(out_reg_size + out_size), (unsigned)sizeof(buffer));
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(buffer, out_reg, out_reg_size);
+        memcpy(buffer + out_reg_size, out_data, out_size);
+        res = i2c_master_transmit(handle, buffer, out_reg_size + out_size, timeout_ms);
+    }
+    else
+        res = i2c_master_transmit(handle, out_data, out_size, timeout_ms);
+    if (res != ESP_OK)
+        ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
+
+    return res;
+}
+
+#else /* legacy driver */
+
 inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
 {
     return a->scl_io_num == b->scl_io_num
@@ -205,6 +471,7 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
             i2c_driver_delete(dev->port);
             states[dev->port].installed = false;
         }
+        states[dev->port].timeout_ticks = 0;
 #if HELPER_TARGET_IS_ESP32
         if ((res = i2c_param_config(dev->port, &temp)) != ESP_OK)
             return res;
@@ -225,36 +492,36 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
         ESP_LOGD(TAG, "I2C driver successfully reconfigured on port %d", dev->port);
     }
 #if HELPER_TARGET_IS_ESP32
-    int t;
-    if ((res = i2c_get_timeout(dev->port, &t)) != ESP_OK)
-        return res;
-    // Timeout cannot be 0
+    // Timeout cannot be 0. Giá trị đã ghi được nhớ lại, không đọc lại thanh ghi mỗi giao dịch
     uint32_t ticks = dev->timeout_ticks ? dev->timeout_ticks : I2CDEV_MAX_STRETCH_TIME;
-    if ((ticks != t) && (res = i2c_set_timeout(dev->port, ticks)) != ESP_OK)
-        return res;
-    ESP_LOGD(TAG, "Timeout: ticks = %" PRIu32 " (%" PRIu32 " usec) on port %d", dev->timeout_ticks, dev->timeout_ticks / 80, dev->port);
+    if (ticks != states[dev->port].timeout_ticks)
+    {
+        if ((res = i2c_set_timeout(dev->port, ticks)) != ESP_OK)
+            return res;
+        states[dev->port].timeout_ticks = ticks;
+        ESP_LOGD(TAG, "Timeout: ticks = %" PRIu32 " (%" PRIu32 " usec) on port %d", ticks, ticks / 80, dev->port);
+    }
 #endif
 
     return ESP_OK;
 }
 
-esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+static esp_err_t i2c_bus_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type, uint32_t timeout_ms)
 {
-    if (!dev) return ESP_ERR_INVALID_ARG;
-
     SEMAPHORE_TAKE(dev->port);
 
     esp_err_t res = i2c_setup_port(dev);
     if (res == ESP_OK)
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+        uint8_t link[I2CDEV_LINK_SIZE];
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
         i2c_master_start(cmd);
         i2c_master_write_byte(cmd, dev->addr << 1 | (operation_type == I2C_DEV_READ ? 1 : 0), true);
         i2c_master_stop(cmd);
 
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(timeout_ms));
 
-        i2c_cmd_link_delete(cmd);
+        i2c_cmd_link_delete_static(cmd);
     }
 
     SEMAPHORE_GIVE(dev->port);
@@ -262,16 +529,17 @@ esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
     return res;
 }
 
-esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
+static esp_err_t i2c_bus_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size,
+        uint32_t timeout_ms)
 {
-    if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
-
     SEMAPHORE_TAKE(dev->port);
 
     esp_err_t res = i2c_setup_port(dev);
     if (res == ESP_OK)
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+        // Command link trên stack thay vì i2c_cmd_link_create() (không cấp phát heap mỗi giao dịch)
+        uint8_t link[I2CDEV_LINK_SIZE];
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
         if (out_data && out_size)
         {
             i2c_master_start(cmd);
@@ -281,45 +549,397 @@ esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_si
         i2c_master_start(cmd);
         i2c_master_write_byte(cmd, (dev->addr << 1) | 1, true);
         i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
-        i2c_master_stop(cmd);
+        res = i2c_master_stop(cmd);
 
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        if (res == ESP_OK)
+            res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(timeout_ms));
         if (res != ESP_OK)
             ESP_LOGE(TAG, "Could not read from device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
 
-        i2c_cmd_link_delete(cmd);
+        i2c_cmd_link_delete_static(cmd);
     }
 
     SEMAPHORE_GIVE(dev->port);
     return res;
 }
 
-esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size)
+static esp_err_t i2c_bus_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data,
+        size_t out_size, uint32_t timeout_ms)
 {
-    if (!dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
-
     SEMAPHORE_TAKE(dev->port);
 
     esp_err_t res = i2c_setup_port(dev);
     if (res == ESP_OK)
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+        uint8_t link[I2CDEV_LINK_SIZE];
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
         i2c_master_start(cmd);
         i2c_master_write_byte(cmd, dev->addr << 1, true);
         if (out_reg && out_reg_size)
             i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
         i2c_master_write(cmd, (void *)out_data, out_size, true);
-        i2c_master_stop(cmd);
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        res = i2c_master_stop(cmd);
+        if (res == ESP_OK)
+            res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(timeout_ms));
         if (res != ESP_OK)
             ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
-        i2c_cmd_link_delete(cmd);
+        i2c_cmd_link_delete_static(cmd);
     }
 
     SEMAPHORE_GIVE(dev->port);
     return res;
 }
 
+#endif /* I2CDEV_MASTER_BUS */
+
+static esp_err_t i2c_execute(const i2c_dev_transaction_t *t, uint32_t timeout_ms)
+{
+    switch (t->op)
+    {
+        case I2C_DEV_OP_READ:
+            return i2c_bus_read(t->dev, t->out_data, t->out_size, t->in_data, t->in_size, timeout_ms);
+        case I2C_DEV_OP_WRITE:
+            return i2c_bus_write(t->dev, t->out_reg, t->out_reg_size, t->out_data, t->out_size, timeout_ms);
+        default:
+            return i2c_bus_probe(t->dev, t->probe_type, timeout_ms);
+    }
+}
+
+/*------------------------------------ Bus scheduler ------------------------------------ */
+
+#if CONFIG_I2CDEV_SCHEDULER
+
+static int64_t i2c_deadline_key(const i2c_dev_transaction_t *t)
+{
+    return t->deadline_us ? t->deadline_us : INT64_MAX;
+}
+
+/* Chèn theo deadline, cùng deadline (hoặc không có) thì theo thứ tự đến. Phải giữ scheduler_lock */
+static void i2c_scheduler_insert(i2c_scheduler_t *s, i2c_dev_transaction_t *t)
+{
+    int64_t key = i2c_deadline_key(t);
+    i2c_dev_transaction_t **link = &s->pending[t->priority];
+    while (*link && i2c_deadline_key(*link) <= key)
+        link = &(*link)->next;
+    t->next = *link;
+    *link = t;
+    if (++s->depth > s->stats.max_depth)
+        s->stats.max_depth = s->depth;
+}
+
+/* Giao dịch kế tiếp: lớp cao nhất còn hàng đợi. Phải giữ scheduler_lock */
+static i2c_dev_transaction_t *i2c_scheduler_pop(i2c_scheduler_t *s)
+{
+    for (size_t i = 0; i < I2C_DEV_PRIORITY_MAX; i++)
+    {
+        i2c_dev_transaction_t *t = s->pending[service_order[i]];
+        if (t)
+        {
+            s->pending[service_order[i]] = t->next;
+            s->depth--;
+            return t;
+        }
+    }
+    return NULL;
+}
+
+/* Housekeeping chạy với timeout ngắn: thiết bị treo chỉ giữ bus tối đa chừng đó */
+static uint32_t i2c_scheduler_timeout_ms(i2c_dev_priority_t priority)
+{
+    return priority == I2C_DEV_PRIORITY_HOUSEKEEPING ? CONFIG_I2CDEV_HOUSEKEEPING_TIMEOUT : CONFIG_I2CDEV_TIMEOUT;
+}
+
+static void i2c_scheduler_task(void *arg)
+{
+    i2c_port_t port = (i2c_port_t)(intptr_t)arg;
+    i2c_scheduler_t *s = &schedulers[port];
+    TaskHandle_t stopper = NULL;
+
+    for (;;)
+    {
+        portENTER_CRITICAL(&scheduler_lock);
+        i2c_dev_transaction_t *t = i2c_scheduler_pop(s);
+        if (!t && s->stopping)
+        {
+            stopper = s->stopper;
+            s->task = NULL;
+        }
+        portEXIT_CRITICAL(&scheduler_lock);
+
+        if (!t)
+        {
+            if (stopper)
+                break;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        int64_t start = esp_timer_get_time();
+        bool expired = t->deadline_us && start > t->deadline_us;
+        esp_err_t res = expired ? ESP_ERR_TIMEOUT : i2c_execute(t, i2c_scheduler_timeout_ms(t->priority));
+        int64_t end = esp_timer_get_time();
+        uint32_t wait_us = (uint32_t)(start - t->queued_us);
+
+        portENTER_CRITICAL(&scheduler_lock);
+        i2c_dev_scheduler_stats_t *stats = &s->stats;
+        if (expired)
+            stats->expired[t->priority]++;
+        else
+        {
+            stats->count[t->priority]++;
+            stats->busy_us += (uint64_t)(end - start);
+            if (res != ESP_OK)
+                stats->errors[t->priority]++;
+        }
+        stats->queue_total_us[t->priority] += wait_us;
+        if (wait_us > stats->queue_max_us[t->priority])
+            stats->queue_max_us[t->priority] = wait_us;
+        portEXIT_CRITICAL(&scheduler_lock);
+
+        i2c_trace_record(t, start, end, res);
+        if (expired)
+            ESP_LOGD(TAG, "[0x%02x at %d] %s transaction %" PRIu32 " us late, dropped", t->dev->addr, port,
+                     i2c_dev_priority_name(t->priority), (uint32_t)(start - t->deadline_us));
+
+        // Sau khi báo, t (trên stack của client) không còn hợp lệ
+        TaskHandle_t waiter = t->waiter;
+        t->result = res;
+        xTaskNotifyGiveIndexed(waiter, I2CDEV_NOTIFY_INDEX);
+    }
+
+    ESP_LOGD(TAG, "Scheduler on port %d stopped", port);
+    xTaskNotifyGiveIndexed(stopper, I2CDEV_NOTIFY_INDEX);
+    vTaskDelete(NULL);
+}
+
+/* Các giao dịch đang chờ được chạy hết trước khi task dừng */
+static void i2c_scheduler_stop(i2c_port_t port)
+{
+    i2c_scheduler_t *s = &schedulers[port];
+
+    portENTER_CRITICAL(&scheduler_lock);
+    TaskHandle_t task = s->task;
+    if (task)
+    {
+        s->stopping = true;
+        s->stopper = xTaskGetCurrentTaskHandle();
+    }
+    portEXIT_CRITICAL(&scheduler_lock);
+
+    if (!task) return;
+    xTaskNotifyGive(task);
+    ulTaskNotifyTakeIndexed(I2CDEV_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+}
+
+#endif /* CONFIG_I2CDEV_SCHEDULER */
+
+esp_err_t i2c_dev_scheduler_start(i2c_port_t port)
+{
+#if CONFIG_I2CDEV_SCHEDULER
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    i2c_scheduler_t *s = &schedulers[port];
+    if (s->task) return ESP_OK;
+
+    memset(s, 0, sizeof(i2c_scheduler_t));
+    s->window_start_us = esp_timer_get_time();
+
+    char name[configMAX_TASK_NAME_LEN];
+    snprintf(name, sizeof(name), "i2c%d_sched", port);
+    TaskHandle_t task;
+    if (xTaskCreate(i2c_scheduler_task, name, CONFIG_I2CDEV_SCHEDULER_STACK_SIZE, (void *)(intptr_t)port,
+                    CONFIG_I2CDEV_SCHEDULER_TASK_PRIORITY, &task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Could not create scheduler task for port %d", port);
+        return ESP_ERR_NO_MEM;
+    }
+    portENTER_CRITICAL(&scheduler_lock);
+    s->task = task;
+    portEXIT_CRITICAL(&scheduler_lock);
+
+    ESP_LOGI(TAG, "Scheduler started on port %d (priority %d)", port, CONFIG_I2CDEV_SCHEDULER_TASK_PRIORITY);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t i2c_dev_scheduler_get_stats(i2c_port_t port, i2c_dev_scheduler_stats_t *stats, bool reset)
+{
+    if (port >= I2C_NUM_MAX || !stats) return ESP_ERR_INVALID_ARG;
+#if CONFIG_I2CDEV_SCHEDULER
+    i2c_scheduler_t *s = &schedulers[port];
+    int64_t now = esp_timer_get_time();
+    esp_err_t res = ESP_OK;
+
+    portENTER_CRITICAL(&scheduler_lock);
+    if (!s->task)
+        res = ESP_ERR_INVALID_STATE;
+    else
+    {
+        *stats = s->stats;
+        stats->window_us = now - s->window_start_us;
+        if (reset)
+        {
+            memset(&s->stats, 0, sizeof(s->stats));
+            s->stats.max_depth = s->depth;
+            s->window_start_us = now;
+        }
+    }
+    portEXIT_CRITICAL(&scheduler_lock);
+    return res;
+#else
+    return ESP_ERR_INVALID_STATE;
+#endif
+}
+
+esp_err_t i2c_dev_trace_dump(uint32_t since, i2c_dev_trace_writer_t writer, void *ctx, uint32_t *next)
+{
+#if CONFIG_I2CDEV_TRACE
+    static const char *op_names[] = {"read", "write", "probe"};
+    const uint32_t size = CONFIG_I2CDEV_TRACE_ENTRIES;
+    char line[128];
+    int length;
+    esp_err_t res;
+
+    if (!writer) return ESP_ERR_INVALID_ARG;
+
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    uint32_t oldest = head > size ? head - size : 0;
+    // since > head: số thứ tự của lần chạy trước (ESP32 đã reset), dump cả ring
+    uint32_t first = (since >= oldest && since <= head) ? since : oldest;
+    uint32_t lost = (since != 0 && since < oldest) ? oldest - since : 0;
+
+    length = snprintf(line, sizeof(line), "# i2c trace: seq %" PRIu32 "..%" PRIu32 ", lost %" PRIu32 ", now_us %lld\n",
+                      first, head, lost, (long long)esp_timer_get_time());
+    if ((res = writer(ctx, line, length)) != ESP_OK) return res;
+    length = snprintf(line, sizeof(line), "seq,start_us,end_us,wait_us,port,addr,op,priority,out_bytes,in_bytes,result\n");
+    if ((res = writer(ctx, line, length)) != ESP_OK) return res;
+
+    for (uint32_t seq = first; seq != head; seq++)
+    {
+        const i2c_dev_trace_entry_t *slot = &trace_ring[seq & (size - 1)];
+        i2c_dev_trace_entry_t e;
+        uint32_t stamp = __atomic_load_n(&slot->stamp, __ATOMIC_ACQUIRE);
+        memcpy(&e, slot, sizeof(e));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (stamp != seq + 1 || __atomic_load_n(&slot->stamp, __ATOMIC_RELAXED) != stamp)
+        {
+            lost++;     // Bị ghi đè (hoặc đang ghi) trong lúc dump
+            continue;
+        }
+        length = snprintf(line, sizeof(line), "%" PRIu32 ",%lld,%lld,%" PRIu32 ",%u,0x%02x,%s,%s,%u,%u,%s\n",
+                          seq, (long long)e.start_us, (long long)(e.start_us + e.duration_us), e.wait_us, e.port, e.addr,
+                          e.op < 3 ? op_names[e.op] : "?", i2c_dev_priority_name(e.priority), e.out_bytes, e.in_bytes,
+                          esp_err_to_name(e.result));
+        if ((res = writer(ctx, line, length)) != ESP_OK) return res;
+    }
+
+    length = snprintf(line, sizeof(line), "# next %" PRIu32 ", lost %" PRIu32 "\n", head, lost);
+    if ((res = writer(ctx, line, length)) != ESP_OK) return res;
+    if (next) *next = head;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const char *i2c_dev_priority_name(i2c_dev_priority_t priority)
+{
+    switch (priority)
+    {
+        case I2C_DEV_PRIORITY_ACQUISITION:  return "acquisition";
+        case I2C_DEV_PRIORITY_CONTROL:      return "control";
+        case I2C_DEV_PRIORITY_HOUSEKEEPING: return "housekeeping";
+        default:                            return "?";
+    }
+}
+
+esp_err_t i2c_dev_transfer(i2c_dev_transaction_t *t)
+{
+    if (!t || !t->dev || t->dev->port >= I2C_NUM_MAX || t->priority >= I2C_DEV_PRIORITY_MAX)
+        return ESP_ERR_INVALID_ARG;
+    if ((t->op == I2C_DEV_OP_READ && (!t->in_data || !t->in_size))
+            || (t->op == I2C_DEV_OP_WRITE && (!t->out_data || !t->out_size))
+            || t->op > I2C_DEV_OP_PROBE)
+        return ESP_ERR_INVALID_ARG;
+
+    t->queued_us = esp_timer_get_time();
+#if CONFIG_I2CDEV_SCHEDULER
+    i2c_scheduler_t *s = &schedulers[t->dev->port];
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    t->waiter = self;
+    t->result = ESP_FAIL;
+
+    // Task scheduler gọi lại (không xảy ra với driver hiện có) hoặc đang dừng: chạy trực tiếp dưới port mutex
+    portENTER_CRITICAL(&scheduler_lock);
+    TaskHandle_t task = s->task;
+    bool queued = task && task != self && !s->stopping;
+    if (queued)
+        i2c_scheduler_insert(s, t);
+    portEXIT_CRITICAL(&scheduler_lock);
+
+    if (queued)
+    {
+        xTaskNotifyGive(task);
+        ulTaskNotifyTakeIndexed(I2CDEV_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        return t->result;
+    }
+#endif
+
+    esp_err_t res = ESP_ERR_TIMEOUT;
+    int64_t start = esp_timer_get_time();
+    if (!t->deadline_us || start <= t->deadline_us)
+        res = i2c_execute(t, CONFIG_I2CDEV_TIMEOUT);
+    i2c_trace_record(t, start, esp_timer_get_time(), res);
+    return res;
+}
+
+esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+{
+    if (!dev) return ESP_ERR_INVALID_ARG;
+
+    i2c_dev_transaction_t t = {
+        .dev = dev,
+        .op = I2C_DEV_OP_PROBE,
+        .probe_type = operation_type,
+        .priority = dev->priority,
+    };
+    return i2c_dev_transfer(&t);
+}
+
+esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
+{
+    if (!dev) return ESP_ERR_INVALID_ARG;
+
+    i2c_dev_transaction_t t = {
+        .dev = dev,
+        .op = I2C_DEV_OP_READ,
+        .out_data = out_data,
+        .out_size = out_size,
+        .in_data = in_data,
+        .in_size = in_size,
+        .priority = dev->priority,
+    };
+    return i2c_dev_transfer(&t);
+}
+
+esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size)
+{
+    if (!dev) return ESP_ERR_INVALID_ARG;
+
+    i2c_dev_transaction_t t = {
+        .dev = dev,
+        .op = I2C_DEV_OP_WRITE,
+        .out_reg = out_reg,
+        .out_reg_size = out_reg_size,
+        .out_data = out_data,
+        .out_size = out_size,
+        .priority = dev->priority,
+    };
+    return i2c_dev_transfer(&t);
+}
+
 esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
 {
     return i2c_dev_read(dev, &reg, 1, in_data, in_size);
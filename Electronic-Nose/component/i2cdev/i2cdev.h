@@ -38,7 +38,10 @@
 #include <driver/i2c.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <esp_err.h>
+#include <esp_idf_version.h>
+#include <sdkconfig.h>
 #include <esp_idf_lib_helpers.h>
 
 #ifdef __cplusplus
@@ -62,6 +65,31 @@ extern "C" {
 
 #endif /* HELPER_TARGET_IS_ESP8266 */
 
+/**
+ * Backend: 1 = ESP-IDF i2c_master bus/device driver (IDF >= 5.2, CONFIG_I2CDEV_USE_MASTER_BUS).
+ * One bus handle per port and one persistent device handle per address/clock speed,
+ * transactions are issued without command link, heap allocation or port mutex.
+ * 0 = legacy driver/i2c.h with a command link built on the stack.
+ * The i2c_dev_* API is the same for both.
+ */
+#if HELPER_TARGET_IS_ESP32 && CONFIG_I2CDEV_USE_MASTER_BUS && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+#define I2CDEV_MASTER_BUS 1
+#else
+#define I2CDEV_MASTER_BUS 0
+#endif
+
+/**
+ * Priority class of a transaction when the port scheduler runs (see i2c_dev_scheduler_start()).
+ * Pending transactions are served acquisition first, then control, then housekeeping.
+ * The default (zero initialized descriptor) is control.
+ */
+typedef enum {
+    I2C_DEV_PRIORITY_CONTROL = 0, //!< Configuration, environment sensors
+    I2C_DEV_PRIORITY_ACQUISITION, //!< Time critical sampling (ADC)
+    I2C_DEV_PRIORITY_HOUSEKEEPING,//!< RTC, expanders, anything that can wait
+    I2C_DEV_PRIORITY_MAX
+} i2c_dev_priority_t;
+
 /**
  * I2C device descriptor
  */
@@ -73,7 +101,9 @@ typedef struct
     SemaphoreHandle_t mutex; //!< Device mutex
     uint32_t timeout_ticks;  /*!< HW I2C bus timeout (stretch time), in ticks. 80MHz APB clock
                                   ticks for ESP-IDF, CPU ticks for ESP8266.
-                                  When this value is 0, I2CDEV_MAX_STRETCH_TIME will be used */
+                                  When this value is 0, I2CDEV_MAX_STRETCH_TIME will be used.
+                                  Not used by the i2c_master backend */
+    i2c_dev_priority_t priority; //!< Scheduler class of the i2c_dev_* calls on this device
 } i2c_dev_t;
 
 /**
@@ -84,6 +114,80 @@ typedef enum {
     I2C_DEV_READ       /**< Read operation */
 } i2c_dev_type_t;
 
+/**
+ * Transaction kind of ::i2c_dev_transaction_t
+ */
+typedef enum {
+    I2C_DEV_OP_READ = 0, //!< Write out_data (register address) if any, then read in_size bytes
+    I2C_DEV_OP_WRITE,    //!< Write out_reg if any, followed by out_data
+    I2C_DEV_OP_PROBE,    //!< Address only, direction given by probe_type
+} i2c_dev_op_t;
+
+/**
+ * Transaction descriptor, see ::i2c_dev_transfer().
+ * Lives on the caller's stack: the caller blocks until the transaction is done.
+ */
+typedef struct i2c_dev_transaction
+{
+    const i2c_dev_t *dev;
+    i2c_dev_op_t op;
+    i2c_dev_type_t probe_type;      //!< I2C_DEV_OP_PROBE only
+    const void *out_reg;            //!< I2C_DEV_OP_WRITE only, may be NULL
+    size_t out_reg_size;
+    const void *out_data;
+    size_t out_size;
+    void *in_data;                  //!< I2C_DEV_OP_READ only
+    size_t in_size;
+    i2c_dev_priority_t priority;
+    int64_t deadline_us;            /*!< esp_timer time the transaction must start by, 0 = none.
+                                         A late transaction completes with ESP_ERR_TIMEOUT without
+                                         touching the bus. Earlier deadlines go first within a class */
+
+    /* Scheduler private */
+    struct i2c_dev_transaction *next;
+    TaskHandle_t waiter;
+    int64_t queued_us;
+    esp_err_t result;
+} i2c_dev_transaction_t;
+
+/**
+ * Statistics of a port scheduler, see ::i2c_dev_scheduler_get_stats()
+ */
+typedef struct
+{
+    uint32_t count[I2C_DEV_PRIORITY_MAX];          //!< Transactions run on the bus
+    uint32_t errors[I2C_DEV_PRIORITY_MAX];         //!< Of which failed
+    uint32_t expired[I2C_DEV_PRIORITY_MAX];        //!< Dropped, deadline passed while queued
+    uint64_t queue_total_us[I2C_DEV_PRIORITY_MAX]; //!< Sum of the queueing delays (submit to start)
+    uint32_t queue_max_us[I2C_DEV_PRIORITY_MAX];
+    uint32_t max_depth;                            //!< Most transactions pending at once
+    uint64_t busy_us;                              //!< Time spent running transactions
+    int64_t window_us;                             //!< Length of the statistics window
+} i2c_dev_scheduler_stats_t;
+
+/**
+ * Trace record of one transaction, see ::i2c_dev_trace_dump()
+ */
+typedef struct
+{
+    int64_t start_us;       //!< esp_timer time the transaction started on the bus
+    uint32_t stamp;         //!< Sequence number + 1, 0 while the record is written
+    uint32_t duration_us;   //!< Bus time, including the port mutex wait when run directly
+    uint32_t wait_us;       //!< Scheduler queueing delay, ~0 when run directly
+    uint8_t port;
+    uint8_t addr;
+    uint8_t op;             //!< ::i2c_dev_op_t
+    uint8_t priority;       //!< ::i2c_dev_priority_t
+    uint16_t out_bytes;     //!< Bytes written (register address included)
+    uint16_t in_bytes;      //!< Bytes read
+    int16_t result;         //!< esp_err_t
+} i2c_dev_trace_entry_t;
+
+/**
+ * Output function of ::i2c_dev_trace_dump(), a non ESP_OK return stops the dump
+ */
+typedef esp_err_t (*i2c_dev_trace_writer_t)(void *ctx, const char *text, size_t length);
+
 /**
  * @brief Init library
  *
@@ -97,7 +201,7 @@ esp_err_t i2cdev_init();
 /**
  * @brief Finish work with library
  *
- * Uninstall i2c drivers.
+ * Stop the port schedulers (pending transactions are completed first), uninstall i2c drivers.
  *
  * @return ESP_OK on success
  */
@@ -147,6 +251,7 @@ esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev);
  * @brief Check the availability of the device
  *
  * Issue an operation of \p operation_type to the I2C device then stops.
+ * The i2c_master backend always probes with a write.
  *
  * @param dev Device descriptor
  * @param operation_type Operation type
@@ -215,6 +320,77 @@ esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg,
 esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg,
         const void *out_data, size_t out_size);
 
+/**
+ * @brief Run a transaction
+ *
+ * When the scheduler of the port runs, the transaction is queued by priority class and
+ * deadline and the calling task blocks until the scheduler task has run it. Otherwise it
+ * runs directly under the port mutex.
+ * i2c_dev_probe(), i2c_dev_read() and i2c_dev_write() go through this function with the
+ * priority of the device descriptor and no deadline.
+ *
+ * @param t Transaction descriptor
+ * @return Transaction result, ESP_ERR_TIMEOUT if the deadline passed before it could start
+ */
+esp_err_t i2c_dev_transfer(i2c_dev_transaction_t *t);
+
+/**
+ * @brief Start the scheduler task of a port
+ *
+ * From then on the scheduler task owns the bus: transactions are no longer served in the
+ * order the port mutex is taken but acquisition > control > housekeeping, earliest deadline
+ * first within a class. A transaction already on the bus is never preempted; housekeeping
+ * transactions use the shorter CONFIG_I2CDEV_HOUSEKEEPING_TIMEOUT so a stuck device delays
+ * the other classes by at most that much.
+ * Needs CONFIG_I2CDEV_SCHEDULER and a second task notification slot
+ * (CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2), index 0 stays free for the clients.
+ *
+ * @param port I2C port
+ * @return ESP_OK on success (also if already running), ESP_ERR_NOT_SUPPORTED if disabled
+ */
+esp_err_t i2c_dev_scheduler_start(i2c_port_t port);
+
+/**
+ * @brief Get the scheduler statistics of a port
+ *
+ * Bus utilization is busy_us / window_us, mean queueing delay queue_total_us / (count + expired).
+ *
+ * @param port I2C port
+ * @param[out] stats Statistics since start or the last reset
+ * @param reset Start a new statistics window
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the scheduler does not run
+ */
+esp_err_t i2c_dev_scheduler_get_stats(i2c_port_t port, i2c_dev_scheduler_stats_t *stats, bool reset);
+
+/**
+ * @brief Write the transaction trace as CSV text
+ *
+ * With CONFIG_I2CDEV_TRACE every transaction is recorded into a RAM ring of
+ * CONFIG_I2CDEV_TRACE_ENTRIES records. Recording is lock-free (one atomic increment per
+ * transaction), the dump runs concurrently with the bus and skips records overwritten
+ * while it reads them. Output, parsed by tools/i2c_trace.js:
+ *
+ *     # i2c trace: seq 1200..1711, lost 0, now_us 81234567
+ *     seq,start_us,end_us,wait_us,port,addr,op,priority,out_bytes,in_bytes,result
+ *     1200,81230012,81230101,12,0,0x48,read,acquisition,1,2,ESP_OK
+ *     ...
+ *     # next 1712, lost 0
+ *
+ * @param since First sequence number wanted: 0 for the whole ring, or the "next" value of
+ *              the previous dump to get only new records. Older records already overwritten
+ *              are counted as lost
+ * @param writer Output function, called once per line
+ * @param ctx Writer argument
+ * @param[out] next Sequence number to pass as @p since next time, may be NULL
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED if CONFIG_I2CDEV_TRACE is disabled, or the writer error
+ */
+esp_err_t i2c_dev_trace_dump(uint32_t since, i2c_dev_trace_writer_t writer, void *ctx, uint32_t *next);
+
+/**
+ * @brief Name of a priority class ("acquisition", "control", "housekeeping")
+ */
+const char *i2c_dev_priority_name(i2c_dev_priority_t priority);
+
 #define I2C_DEV_TAKE_MUTEX(dev) do { \
         esp_err_t __ = i2c_dev_take_mutex(dev); \
         if (__ != ESP_OK) return __;\
@@ -48,7 +48,7 @@
 
 #define I2C_FREQ_HZ 1000000 // 1MHz
 
-const char *TAG = "sht3x";
+static const char *TAG = "sht3x";
 
 #define SHT3X_STATUS_CMD               0xF32D
 #define SHT3X_CLEAR_STATUS_CMD         0x3041
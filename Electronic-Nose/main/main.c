@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <sys/param.h>
 #include <sys/time.h>
+#include <math.h>
 
 #include "sdkconfig.h"
 #include "esp_err.h"
@@ -46,8 +47,11 @@
 #include "esp_ota_ops.h"
 #include "esp_smartconfig.h"
 #include "esp_http_client.h"
+#if CONFIG_DASHBOARD_WEBSOCKET_ENABLED
+#include "esp_websocket_client.h"
+#endif
 #include "cJSON.h"
-#include "dht.h"
+#include "envsensor.h"
 
 #include "driver/gpio.h"
 #include "driver/i2c.h"
@@ -64,13 +68,24 @@
 
 #include "sdcard.h"
 #include "DS3231Time.h"
+#include "timebase.h"
+#include "sleepschedule.h"
 #include "datamanager.h"
 #include "sntp_sync.h"
 #include "ADS111x.h"
+#include "decimator.h"
+#include "autorange.h"
+#include "eventdetector.h"
+#include "framering.h"
+#include "powermanager.h"
+#include "calibrationstore.h"
+#include "classifierstore.h"
+#include "eventformat.h"
 #include "button.h"
 #include "FileServer.h"
 #include "test_i2c_devices.h"
 #include "test_sdcard.h"
+#include "test_benchmark.h"
 
 /*------------------------------------ DEFINE ------------------------------------ */
 
@@ -80,6 +95,9 @@
 // Uncomment dòng dưới để chạy test SD card thay vì chạy ứng dụng chính
 //#define ENABLE_SDCARD_TEST_MODE
 
+// Uncomment dòng dưới để chạy benchmark hiệu năng thay vì chạy ứng dụng chính
+//#define ENABLE_BENCHMARK_TEST_MODE
+
 __attribute__((unused)) static const char *TAG = "Main";
 
 // Dashboard config (loaded from NVS or use CONFIG defaults)
@@ -127,8 +145,6 @@ esp_err_t save_dashboard_config_to_nvs(const char *host, int port);  // Not stat
 // Always declare this function to ensure linking works, even when CONFIG_DASHBOARD_ENABLED is disabled
 void trigger_dashboard_registration_main(void);  // Not static - used by FileServer.c wrapper to trigger re-registration
 
-// Chu kỳ đọc cảm biến (DHT22 yêu cầu tối thiểu ~2s giữa 2 lần đọc)
-#define PERIOD_GET_DATA_FROM_SENSOR (TickType_t)(2000 / portTICK_PERIOD_MS)
 #define PERIOD_SAVE_DATA_SENSOR_TO_SDCARD (TickType_t)(50 / portTICK_PERIOD_MS)
 #define SAMPLING_TIMME  (TickType_t)(300000 / portTICK_PERIOD_MS)
 
@@ -136,14 +152,33 @@ void trigger_dashboard_registration_main(void);  // Not static - used by FileSer
 #define WAIT_10_TICK (TickType_t)(10 / portTICK_PERIOD_MS)
 #define WAIT_100_TICK (TickType_t)(100 / portTICK_PERIOD_MS)
 
-#define QUEUE_SIZE 10U
+// Cấu hình ADS111x dùng khi đo (ghi vào header của file binary log), với auto gain là gain ban đầu của mọi kênh
+#define ADS111X_GAIN_IN_USE         ADS111X_GAIN_2V048
+#define ADS111X_DATA_RATE_IN_USE    ((ads111x_data_rate_t)CONFIG_ADS111X_DATA_RATE)
 #define DATA_SENSOR_MIDLEWARE_QUEUE_SIZE 20
-
+#define ADC_INPUTS_PER_DEVICE       4U
+// Mảng cảm biến: CONFIG_ADS111X_DEVICE_COUNT chip x 4 kênh, kênh i của chip d là ADC_Value[d * 4 + i]
+#define ADC_CHANNEL_COUNT           (CONFIG_ADS111X_DEVICE_COUNT * ADC_INPUTS_PER_DEVICE)
+// Chu kỳ một frame đã decimate (ms): factor * số kênh mỗi chip * thời gian chuyển đổi (các chip chuyển đổi song song)
+#define ADC_FRAME_PERIOD_MS         ((uint32_t)((uint64_t)CONFIG_SIGNAL_DECIMATION_FACTOR * ADC_INPUTS_PER_DEVICE * \
+                                                ads111x_conversion_time_us(ADS111X_DATA_RATE_IN_USE) / 1000))
+
+
+// WiFi power save theo menuconfig (POWER_SAVE_MODE)
+#if CONFIG_POWER_SAVE_MAX_MODEM
+#define WIFI_POWER_SAVE_MODE        WIFI_PS_MAX_MODEM
+#elif CONFIG_POWER_SAVE_MIN_MODEM
+#define WIFI_POWER_SAVE_MODE        WIFI_PS_MIN_MODEM
+#else
+#define WIFI_POWER_SAVE_MODE        WIFI_PS_NONE
+#endif
 
 #define BUTTON_PRESSED_BIT BIT1
 #define START_SAMPLING_BIT BIT1  // Bit để signal start sampling (dùng cho HTTP/UART command)
+#define SAMPLING_IDLE_BIT  BIT2  // getDataFromSensor_task đang chờ start (giữa hai chu kỳ)
 
 TaskHandle_t getDataFromSensorTask_handle = NULL;
+TaskHandle_t getEnvironmentDataTask_handle = NULL;
 TaskHandle_t saveDataSensorToSDcardTask_handle = NULL;
 TaskHandle_t sntp_syncTimeTask_handle = NULL;
 TaskHandle_t allocateDataForMultipleQueuesTask_handle = NULL;
@@ -152,19 +187,53 @@ TaskHandle_t smartConfigTask_handle = NULL;
 SemaphoreHandle_t getDataSensor_semaphore = NULL;
 SemaphoreHandle_t SDcard_semaphore = NULL;
 
-QueueHandle_t dataSensorSentToSD_queue = NULL;
-QueueHandle_t dataSensorSentToDashboard_queue = NULL; // Queue để gửi dữ liệu đến dashboard qua HTTP POST
-
-#if CONFIG_DHT_USE
+// Ring frame dùng chung: getDataFromSensor_task ghi mỗi frame một lần, SD card / dashboard đọc theo tốc độ riêng
+static frameRing_st dataSensor_ring;
+
+#if CONFIG_ENV_SENSOR_USE
+// Cảm biến nhiệt độ/độ ẩm, chu kỳ đọc theo backend (DHT 2 s, SHT3x đến 10 Hz), xem getEnvironmentData_task
+static const envSensor_config_st envSensor_config = {
+#if CONFIG_ENV_SENSOR_SHT3X
+    .backend = ENV_SENSOR_BACKEND_SHT3X,
+    .sht3x = {
+        .port = CONFIG_ADS111X_I2C_PORT,
+        .address = CONFIG_SHT3X_I2C_ADDRESS,
+        .sda = CONFIG_ADS111X_I2C_MASTER_SDA,
+        .scl = CONFIG_ADS111X_I2C_MASTER_SCL,
+        .mode = (sht3x_mode_t)CONFIG_SHT3X_MODE,
+#if CONFIG_SHT3X_REPEATABILITY_LOW
+        .repeatability = SHT3X_LOW,
+#elif CONFIG_SHT3X_REPEATABILITY_MEDIUM
+        .repeatability = SHT3X_MEDIUM,
+#else
+        .repeatability = SHT3X_HIGH,
+#endif
+    },
+#else
+    .backend = ENV_SENSOR_BACKEND_DHT,
+    .dht = {
+        .gpio = (gpio_num_t)CONFIG_DHT_GPIO,
 #if CONFIG_DHT_TYPE_DHT11
-#define DHT_TYPE  DHT_TYPE_DHT11
+        .type = DHT_TYPE_DHT11,
 #else
-#define DHT_TYPE  DHT_TYPE_DHT22
+        .type = DHT_TYPE_DHT22,
+#endif
+#if CONFIG_DHT_USE_RMT
+        .useRmt = true,
 #endif
-#define DHT_GPIO  ((gpio_num_t)CONFIG_DHT_GPIO)
+    },
+#endif
+};
 #endif
 // Flag to track SD card mount status
 static bool sdcard_mounted = false;
+#if CONFIG_CLASSIFIER_ENABLE
+// classifierStore_load() hỏi trạng thái thẻ ở mỗi lần nạp model
+static bool sdcard_isMounted(void)
+{
+    return sdcard_mounted;
+}
+#endif
 // QueueHandle_t moduleError_queue = NULL;
 
 //static EventGroupHandle_t fileStore_eventGroup;
@@ -180,7 +249,23 @@ static const int MAX_WIFI_RETRY = 5;  // Sau 5 lần retry thất bại, chuyể
 
 /*------------------------------------ Define devices ------------------------------------ */
 static i2c_dev_t ds3231_device = {0};
+// System time được đặt lại từ alarm DS3231 sau khi ngủ: không ghi ngược vào DS3231 cho tới lần SNTP sync kế tiếp
+static bool systemTime_fromRtc = false;
 static i2c_dev_t ads111x_devices[CONFIG_ADS111X_DEVICE_COUNT] = {0};
+static ads111x_array_t ads111x_sensorArray; // Đọc song song các ADS111x theo tín hiệu ALERT/RDY (xem ads111x_array_init)
+
+#if CONFIG_ADS111X_AUTO_GAIN
+// Full scale (mV) theo ads111x_gain_t, các range của auto gain (ADS111X_GAIN_6V144..ADS111X_GAIN_0V256)
+static const uint16_t adcFullScale_mV[] = {6144, 4096, 2048, 1024, 512, 256};
+#endif
+
+// Nhiệt độ/độ ẩm mới nhất, cập nhật bởi getEnvironmentData_task và ghép vào mỗi frame ADC.
+// Chưa đọc được lần nào hoặc lỗi liên tiếp thì không hợp lệ: frame ghi 0/0 và không bù T/H
+static portMUX_TYPE environmentData_lock = portMUX_INITIALIZER_UNLOCKED;
+static float environmentData_temperature = 0;
+static float environmentData_humidity = 0;
+static bool environmentData_valid = false;
+#define ENVIRONMENT_DATA_MAX_ERRORS     5U      // Lỗi đọc liên tiếp trước khi bỏ giá trị cũ
 
 // static i2c_dev_t pcf8574_device = {0};
 //static i2c_dev_t pcf8575_device = {0};
@@ -190,7 +275,13 @@ static i2c_dev_t ads111x_devices[CONFIG_ADS111X_DEVICE_COUNT] = {0};
 const uint8_t addresses[CONFIG_ADS111X_DEVICE_COUNT] = {
     ADS111X_ADDR_GND   // 0x48 - Đã xác nhận hoạt động
 #if CONFIG_ADS111X_DEVICE_COUNT > 1
-    , ADS111X_ADDR_VCC   // 0x49 - Dự phòng nếu có thiết bị thứ 2
+    , ADS111X_ADDR_VCC   // 0x49 - ADDR nối VCC
+#endif
+#if CONFIG_ADS111X_DEVICE_COUNT > 2
+    , ADS111X_ADDR_SDA   // 0x4A - ADDR nối SDA
+#endif
+#if CONFIG_ADS111X_DEVICE_COUNT > 3
+    , ADS111X_ADDR_SCL   // 0x4B - ADDR nối SCL
 #endif
 };
 
@@ -540,6 +631,58 @@ static void smartConfig_task(void * parameter)
     }
 }
 
+static void systemSecond_timerCallback(void *arg)
+{
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+/**
+ * @brief Chờ system time sang giây mới mà không spin: esp_timer one-shot tới đúng mốc giây đánh
+ *        thức task qua task notification (như ADS111x chờ conversion), không tốn CPU ở priority cao.
+ *
+ * @param[out] tv System time lúc thức dậy, tv_usec ngay sau mốc giây.
+ */
+static void wait_next_system_second(struct timeval *tv)
+{
+    esp_timer_handle_t timer = NULL;
+    const esp_timer_create_args_t args = {
+        .callback = systemSecond_timerCallback,
+        .arg = xTaskGetCurrentTaskHandle(),
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ds3231_second",
+    };
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+        timer = NULL;
+    }
+
+    gettimeofday(tv, NULL);
+    time_t second = tv->tv_sec + 1;
+    ulTaskNotifyTake(pdTRUE, 0);    // Bỏ notification cũ
+    while (tv->tv_sec < second)
+    {
+        if (tv->tv_sec + 1 < second) {
+            second = tv->tv_sec + 1;    // System time lùi trong lúc chờ (SNTP)
+        }
+        uint32_t remaining_us = 1000000 - (uint32_t)tv->tv_usec;
+        if (timer != NULL && esp_timer_start_once(timer, remaining_us) == ESP_OK)
+        {
+            // Notification khác (nếu có) chỉ làm vòng lặp kiểm tra lại thời gian
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(remaining_us / 1000) + 2);
+            esp_timer_stop(timer);
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(remaining_us / 1000) + 1);
+        }
+        gettimeofday(tv, NULL);
+    }
+
+    if (timer != NULL)
+    {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+        ulTaskNotifyTake(pdTRUE, 0);    // Give chạy đua với esp_timer_stop()
+    }
+}
+
 /**
  * @brief Set time from system time to DS3231 RTC
  */
@@ -547,30 +690,61 @@ static void smartConfig_task(void * parameter)
 static void set_ds3231_time_from_system(void)
 {
     struct tm timeinfo;
+    struct timeval tv;
     time_t now;
     
     // Get current system time
-    time(&now);
-    localtime_r(&now, &timeinfo);
+    gettimeofday(&tv, NULL);
     
     // Check if system time is valid (after 2020-01-01)
     // If system time is invalid, log warning and return (will be updated by SNTP later)
-    if (now < 1577836800) { // 2020-01-01 00:00:00 UTC
-        ESP_LOGW(TAG, "System time is invalid (%lld), waiting for SNTP sync...", (long long)now);
+    if (tv.tv_sec < 1577836800) { // 2020-01-01 00:00:00 UTC
+        ESP_LOGW(TAG, "System time is invalid (%lld), waiting for SNTP sync...", (long long)tv.tv_sec);
         return;
     }
     
+    // Ghi đúng lúc system time sang giây mới: ghi thanh ghi giây reset bộ đếm 1 s của DS3231,
+    // pha SQW khi đó trùng SNTP (sai số cỡ thời gian một lần ghi I2C)
+    wait_next_system_second(&tv);
+    now = tv.tv_sec;
+    localtime_r(&now, &timeinfo);
+    
     // Set time to DS3231 from system time
     esp_err_t ret = ds3231_setTime(&ds3231_device, &timeinfo);
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "DS3231 time set successfully from system: %02d/%02d/%04d %02d:%02d:%02d",
                  timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
                  timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+#if CONFIG_TIMEBASE_SQW_ENABLE
+        // Pha SQW vừa đổi: gán lại giây cho cạnh tiếp theo
+        if (timeBase_sqwRunning()) {
+            ESP_ERROR_CHECK_WITHOUT_ABORT(timeBase_labelSqw(&ds3231_device));
+        }
+#endif
     } else {
         ESP_LOGE(TAG, "Failed to set DS3231 time: %s", esp_err_to_name(ret));
     }
 }
 
+/**
+ * @brief Tên file của phiên đo (tháng, ngày, giờ, phút) theo timebase, không đọc DS3231 qua I2C.
+ *        Timebase chưa có thời gian thực: đọc DS3231 như trước.
+ */
+static void nameFile_fromTimeBase(void)
+{
+    int64_t now_us = timeBase_nowUs();
+    if (now_us == 0) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_convertTimeToString(&ds3231_device, nameFileSaveData, 14));
+        return;
+    }
+
+    struct tm timeinfo;
+    time_t now = (time_t)(now_us / 1000000);
+    localtime_r(&now, &timeinfo);
+    snprintf(nameFileSaveData, 14, "%.2d%.2d%.2d%.2d",
+             timeinfo.tm_mon + 1, timeinfo.tm_mday, timeinfo.tm_hour, timeinfo.tm_min);
+}
+
 static void sntp_syncTime_task(void *parameter)
 {
     ESP_LOGI(TAG, "========== SNTP SYNC TASK STARTED ==========");
@@ -606,7 +780,10 @@ static void sntp_syncTime_task(void *parameter)
         vTaskDelay(500 / portTICK_PERIOD_MS);
         
         // Set time to DS3231 RTC after SNTP sync
+        systemTime_fromRtc = false;
         set_ds3231_time_from_system();
+        // Timestamp của mẫu chuyển sang SNTP (chính xác tới µs thay vì 1 s của DS3231)
+        ESP_ERROR_CHECK_WITHOUT_ABORT(timeBase_anchorToSystemTime());
         
         // Log thời gian đã sync
         struct tm timeinfo;
@@ -622,21 +799,11 @@ static void sntp_syncTime_task(void *parameter)
         if (getDataFromSensorTask_handle != NULL) {
             ESP_LOGI(TAG, "SNTP sync completed! Creating new file with real-time...");
             
-            // Cập nhật tên file với thời gian thực từ DS3231 (đã được cập nhật từ system time)
-            ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_convertTimeToString(&ds3231_device, nameFileSaveData, 14));
+            // Cập nhật tên file với thời gian thực (timebase vừa được anchor theo SNTP)
+            nameFile_fromTimeBase();
             ESP_LOGI(TAG, "New file name with real-time: %s.csv", nameFileSaveData);
             
-            // Tạo header cho file CSV mới với thời gian thực
-            if (SDcard_semaphore != NULL) {
-                if (xSemaphoreTake(SDcard_semaphore, pdMS_TO_TICKS(5000)) == pdTRUE) {
-                    ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writeDataToFile(nameFileSaveData, "%s,%s,%s,%s,%s,%s,%s\n",
-                                                                          "STT", "Temperature", "Humidity", "Sensor1", "Sensor2", "Sensor3", "Sensor4"));
-                    ESP_LOGI(TAG, "✅ Created new file %s.csv with real-time after SNTP sync!", nameFileSaveData);
-                    xSemaphoreGive(SDcard_semaphore);
-                } else {
-                    ESP_LOGW(TAG, "Failed to get SD card semaphore to create new file");
-                }
-            }
+            // File mới (kèm header) được saveDataSensorToSDcard_task tạo khi nhận mẫu tiếp theo
         } else {
             ESP_LOGW(TAG, "getDataFromSensor_task not created yet, file will be created in next sampling cycle");
         }
@@ -1211,6 +1378,9 @@ void WIFI_initSTA(void)
              * However these modes are deprecated and not advisable to be used. Incase your Access point
              * doesn't support WPA2, these mode can be enabled by commenting below line */
             .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+#if CONFIG_POWER_SAVE_MODE_ENABLE
+            .listen_interval = CONFIG_WIFI_LISTEN_INTERVAL,
+#endif
             .pmf_cfg = {
                 .capable = true,
                 .required = false,
@@ -1220,6 +1390,11 @@ void WIFI_initSTA(void)
     ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_start());
+#if CONFIG_POWER_SAVE_MODE_ENABLE
+    // Modem sleep: bắt buộc để chip tự light sleep khi đang kết nối WiFi (WIFI_PS_NONE giữ khoá esp_pm)
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_set_inactive_time(WIFI_IF_STA, CONFIG_WIFI_BEACON_TIMEOUT));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_set_ps(WIFI_POWER_SAVE_MODE));
+#endif
 
     ESP_LOGI(__func__, "WIFI initialize STA finished.");
     
@@ -1293,12 +1468,20 @@ __attribute__((unused)) static IRAM_ATTR void button_Handle(void *parameters)
 
 /*------------------------------------ UART COMMAND HANDLER ------------------------------------ */
 
+static esp_err_t uart_trace_write(void *ctx, const char *text, size_t length)
+{
+    return uart_write_bytes(UART_NUM_0, text, length) < 0 ? ESP_FAIL : ESP_OK;
+}
+
 /**
  * @brief UART command handler task - listens for commands via serial port
  * Supported commands:
  *   - START: Start sensor sampling
  *   - STOP: Stop current sampling cycle (will complete current cycle)
  *   - STATUS: Get system status
+ *   - I2C: I2C scheduler statistics (queueing delay per class, bus utilization), then reset them
+ *   - I2CTRACE: dump the I2C transaction trace (CONFIG_I2CDEV_TRACE), see tools/i2c_trace.js
+ *   - POWER: duty cycle per pipeline stage and estimated charge per 1000 samples, then reset them
  */
 static void uart_command_task(void *pvParameters)
 {
@@ -1346,6 +1529,48 @@ static void uart_command_task(void *pvParameters)
                     "STATUS: System ready\nSampling: %s\n",
                     (sampling_control_event != NULL) ? "Waiting for command" : "Not initialized");
                 uart_write_bytes(UART_NUM_0, status_msg, msg_len);
+            } else if (strcmp((char *)data, "I2C") == 0) {
+                i2c_dev_scheduler_stats_t stats;
+                esp_err_t err = i2c_dev_scheduler_get_stats(CONFIG_ADS111X_I2C_PORT, &stats, true);
+                if (err != ESP_OK) {
+                    uart_write_bytes(UART_NUM_0, "ERROR: I2C scheduler not running\n", 33);
+                } else {
+                    char stats_msg[128];
+                    int msg_len = snprintf(stats_msg, sizeof(stats_msg), "I2C: %.1f s, bus busy %.1f %%, max depth %" PRIu32 "\n",
+                                           stats.window_us / 1e6, stats.window_us ? 100.0 * stats.busy_us / stats.window_us : 0.0,
+                                           stats.max_depth);
+                    uart_write_bytes(UART_NUM_0, stats_msg, msg_len);
+                    for (int p = 0; p < I2C_DEV_PRIORITY_MAX; p++) {
+                        uint32_t served = stats.count[p] + stats.expired[p];
+                        msg_len = snprintf(stats_msg, sizeof(stats_msg),
+                                           "  %-12s %6" PRIu32 " tx, %" PRIu32 " err, %" PRIu32 " late, wait avg %" PRIu32 " us max %" PRIu32 " us\n",
+                                           i2c_dev_priority_name(p), stats.count[p], stats.errors[p], stats.expired[p],
+                                           served ? (uint32_t)(stats.queue_total_us[p] / served) : 0, stats.queue_max_us[p]);
+                        uart_write_bytes(UART_NUM_0, stats_msg, msg_len);
+                    }
+                }
+            } else if (strcmp((char *)data, "POWER") == 0) {
+                powerManager_stats_st stats;
+                powerManager_stats(&stats, true);
+                double window_us = stats.window_us ? (double)stats.window_us : 1.0;
+                char stats_msg[128];
+                int msg_len = snprintf(stats_msg, sizeof(stats_msg), "POWER: %.1f s, %" PRIu32 " samples, %" PRIu32 " uAh, %" PRIu32 " uAh/1000 samples\n",
+                                       stats.window_us / 1e6, stats.samples, stats.charge_uAh, stats.uAhPer1000Samples);
+                uart_write_bytes(UART_NUM_0, stats_msg, msg_len);
+                for (int l = 0; l < POWER_LEVEL_MAX; l++) {
+                    msg_len = snprintf(stats_msg, sizeof(stats_msg), "  %-12s %5.1f %%\n",
+                                       powerManager_levelName(l), 100.0 * stats.levelTime_us[l] / window_us);
+                    uart_write_bytes(UART_NUM_0, stats_msg, msg_len);
+                }
+                for (int st = 0; st < POWER_STAGE_MAX; st++) {
+                    msg_len = snprintf(stats_msg, sizeof(stats_msg), "  %-12s %5.1f %%, %" PRIu32 " bursts\n",
+                                       powerManager_stageName(st), 100.0 * stats.stageActive_us[st] / window_us, stats.stageBursts[st]);
+                    uart_write_bytes(UART_NUM_0, stats_msg, msg_len);
+                }
+            } else if (strcmp((char *)data, "I2CTRACE") == 0) {
+                if (i2c_dev_trace_dump(0, uart_trace_write, NULL, NULL) == ESP_ERR_NOT_SUPPORTED) {
+                    uart_write_bytes(UART_NUM_0, "ERROR: I2C trace disabled\n", 26);
+                }
             } else {
                 ESP_LOGW(__func__, "Unknown command: %s", data);
                 uart_write_bytes(UART_NUM_0, "ERROR: Unknown command\n", 23);
@@ -1356,24 +1581,132 @@ static void uart_command_task(void *pvParameters)
 
 /*------------------------------------ GET DATA FROM SENSOR ------------------------------------ */
 
+#if CONFIG_ENV_SENSOR_USE
+/**
+ * @brief Đọc nhiệt độ/độ ẩm theo chu kỳ của cảm biến (envSensor_periodMs), không chặn luồng ADC.
+ *        Giá trị mới nhất được getDataFromSensor_task ghép vào mỗi frame.
+ */
+void getEnvironmentData_task(void *parameters)
+{
+    static envSensor_st environmentSensor;
+
+    ESP_ERROR_CHECK_WITHOUT_ABORT(envSensor_init(&environmentSensor, &envSensor_config));
+    const TickType_t period = pdMS_TO_TICKS(envSensor_periodMs(&environmentSensor));
+    TickType_t task_lastWakeTime = xTaskGetTickCount();
+
+    for (;;)
+    {
+        float temp = 0, hum = 0;
+        powerManager_begin(POWER_STAGE_ACQUISITION);
+        esp_err_t env_err = envSensor_read(&environmentSensor, &temp, &hum);
+        powerManager_end(POWER_STAGE_ACQUISITION);
+        if (env_err == ESP_OK) {
+            portENTER_CRITICAL(&environmentData_lock);
+            environmentData_temperature = temp;
+            environmentData_humidity = hum;
+            environmentData_valid = true;
+            portEXIT_CRITICAL(&environmentData_lock);
+            ESP_LOGD(__func__, "Temperature: %.1f, Humidity: %.1f", temp, hum);
+        } else if (env_err != ESP_ERR_NOT_FINISHED) {
+            if (environmentSensor.consecutiveErrors == 1) {
+                // Chỉ log lỗi đầu tiên của một chuỗi (SHT3x đọc đến 10 lần/s)
+                ESP_LOGW(__func__, "%s read failed: %s", envSensor_name(&environmentSensor), esp_err_to_name(env_err));
+            }
+            // Một lần lỗi vẫn dùng giá trị cũ, lỗi kéo dài thì giá trị cũ không còn đúng
+            if (environmentSensor.consecutiveErrors == ENVIRONMENT_DATA_MAX_ERRORS) {
+                portENTER_CRITICAL(&environmentData_lock);
+                environmentData_valid = false;
+                portEXIT_CRITICAL(&environmentData_lock);
+            }
+        }
+
+        vTaskDelayUntil(&task_lastWakeTime, period);
+    }
+}
+#endif
+
+#if CONFIG_ADS111X_AUTO_GAIN
+/**
+ * @brief Cuối frame: chọn gain của frame sau cho từng kênh. Trạng thái decimator và giá trị giữ lại của kênh
+ *        đổi gain được quy đổi sang gain mới, frame sau không lẫn code của hai gain.
+ */
+static void adcAutoGain_update(autoRange_st *autoRange, decimator_st *decimator, int16_t *adcScan, uint8_t *adcGain)
+{
+    uint32_t changed = autoRange_update(autoRange);
+    for (uint8_t i = 0; changed != 0 && i < ADC_CHANNEL_COUNT; i++)
+    {
+        if ((changed & (1UL << i)) == 0) {
+            continue;
+        }
+        changed &= ~(1UL << i);
+        uint8_t gain = autoRange->range[i];
+        decimator_scaleChannel(decimator, i, adcFullScale_mV[adcGain[i]], adcFullScale_mV[gain]);
+        adcScan[i] = autoRange_rescale(autoRange, adcScan[i], adcGain[i], gain);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_array_set_gain(&ads111x_sensorArray, i, (ads111x_gain_t)gain));
+        ESP_LOGI(__func__, "Channel %u: gain ±%.3f V -> ±%.3f V", (unsigned)i,
+                 ads111x_gain_values[adcGain[i]], ads111x_gain_values[gain]);
+        adcGain[i] = gain;
+    }
+}
+#endif
+
 void getDataFromSensor_task(void *parameters)
 {
-    struct dataSensor_st dataSensorTemp = {0};
-    TickType_t task_lastWakeTime;
     TickType_t finishTime;
+    static const ads111x_mux_t adcChannels[ADC_INPUTS_PER_DEVICE] = {
+        ADS111X_MUX_0_GND, ADS111X_MUX_1_GND, ADS111X_MUX_2_GND, ADS111X_MUX_3_GND
+    };
+    // Threshold để phát hiện khi không có cảm biến (ADC floating noise)
+    // Giá trị noise thường nằm trong khoảng 11000-11200 (0.6875V - 0.7V) khi không có tín hiệu
+    const int16_t ADC_NOISE_MIN = 11000;
+    const int16_t ADC_NOISE_MAX = 11200;
 
     getDataSensor_semaphore = xSemaphoreCreateMutex();
 
-
-  //Thay cho nay bang ham khoi tao dht11
-
-    //Set up ADS1115 (only 1 device)
+    //Set up ADS1115 array (CONFIG_ADS111X_DEVICE_COUNT devices)
     memset(ads111x_devices, 0, sizeof(ads111x_devices));
-    ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_init_desc(&ads111x_devices[0], addresses[0], CONFIG_ADS111X_I2C_PORT, CONFIG_ADS111X_I2C_MASTER_SDA, CONFIG_ADS111X_I2C_MASTER_SCL));
-    ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_set_mode(&ads111x_devices[0], ADS111X_MODE_CONTINUOUS));    // Continuous conversion mode
-    ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_set_data_rate(&ads111x_devices[0], ADS111X_DATA_RATE_128)); // 128 samples per second
-    ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_set_gain(&ads111x_devices[0], ads111x_gain_values[ADS111X_GAIN_2V048]));
-
+    for (size_t i = 0; i < CONFIG_ADS111X_DEVICE_COUNT; i++)
+    {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_init_desc(&ads111x_devices[i], addresses[i], CONFIG_ADS111X_I2C_PORT, CONFIG_ADS111X_I2C_MASTER_SDA, CONFIG_ADS111X_I2C_MASTER_SCL));
+        ads111x_devices[i].priority = I2C_DEV_PRIORITY_ACQUISITION;
+    }
+    // Single-shot + ALERT/RDY: các chip cùng chuyển đổi một kênh, chỉ chờ đúng thời gian chuyển đổi (thay cho vTaskDelay 50ms)
+    ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_array_init(&ads111x_sensorArray, ads111x_devices, CONFIG_ADS111X_DEVICE_COUNT,
+                                                     adcChannels, ADC_INPUTS_PER_DEVICE, (gpio_num_t)CONFIG_ADS111X_ALERT_RDY_GPIO,
+                                                     ADS111X_GAIN_IN_USE, ADS111X_DATA_RATE_IN_USE));
+
+    // ADC chạy liên tục theo nhịp chuyển đổi của ADS111x, CIC/boxcar (+ FIR tùy chọn) giảm xuống tốc độ frame
+    static decimator_st adcDecimator;
+    decimator_init(&adcDecimator, ADC_CHANNEL_COUNT, CONFIG_SIGNAL_DECIMATION_FACTOR, CONFIG_SIGNAL_CIC_ORDER);
+#if CONFIG_SIGNAL_FIR_TAPS > 0
+    {
+        int16_t firCoefficients[CONFIG_SIGNAL_FIR_TAPS];
+        decimator_designLowpass(firCoefficients, CONFIG_SIGNAL_FIR_TAPS, CONFIG_SIGNAL_FIR_CUTOFF_PERCENT / 100.0f);
+        decimator_setFir(&adcDecimator, firCoefficients, CONFIG_SIGNAL_FIR_TAPS);
+    }
+#endif
+    // Gain của frame đang tích lũy cho từng kênh (cố định ADS111X_GAIN_IN_USE khi không dùng auto gain)
+    uint8_t adcGain[ADC_CHANNEL_COUNT];
+    memset(adcGain, ADS111X_GAIN_IN_USE, sizeof(adcGain));
+#if CONFIG_ADS111X_AUTO_GAIN
+    static autoRange_st adcAutoRange;
+    const autoRange_config_st autoRangeConfig = {
+        .fullScale = adcFullScale_mV,
+        .rangeCount = sizeof(adcFullScale_mV) / sizeof(adcFullScale_mV[0]),
+        .initialRange = ADS111X_GAIN_IN_USE,
+        .downshiftPercent = CONFIG_ADS111X_AUTO_GAIN_DOWNSHIFT_PERCENT,
+        .upshiftPercent = CONFIG_ADS111X_AUTO_GAIN_UPSHIFT_PERCENT,
+        .holdFrames = CONFIG_ADS111X_AUTO_GAIN_HOLD_FRAMES,
+        .codeMax = ADS111X_MAX_VALUE,
+    };
+    bool autoGain = autoRange_init(&adcAutoRange, ADC_CHANNEL_COUNT, &autoRangeConfig);
+    if (!autoGain) {
+        ESP_LOGE(__func__, "Invalid auto gain thresholds (upshift must be below downshift), using fixed gain");
+    }
+#endif
+    ESP_LOGI(__func__, "ADC streaming: %d SPS aggregate, %u channels on %d ADS111x, decimation %d (order %d, FIR %d taps) -> 1 frame / %" PRIu32 " ms",
+             CONFIG_ADS111X_DEVICE_COUNT * 1000000 / (int)ads111x_conversion_time_us(ADS111X_DATA_RATE_IN_USE), ADC_CHANNEL_COUNT, CONFIG_ADS111X_DEVICE_COUNT,
+             CONFIG_SIGNAL_DECIMATION_FACTOR, CONFIG_SIGNAL_CIC_ORDER, CONFIG_SIGNAL_FIR_TAPS, ADC_FRAME_PERIOD_MS);
 
     // Button setup (disabled - no button on board)
     // Use HTTP API or UART command instead
@@ -1393,8 +1726,17 @@ void getDataFromSensor_task(void *parameters)
         ESP_LOGI(__func__, "⏱️  Sampling duration: %d minutes", sampling_minutes);
         ESP_LOGI(__func__, "========================================");
         
-        // Chờ start command từ HTTP API hoặc UART (blocking call)
+#if CONFIG_TIMEBASE_SQW_ENABLE
+        // Ngắt SQW không chạy trong light sleep (cạnh bị mất/trễ, esp_timer theo RTC slow clock):
+        // giữa hai chu kỳ dùng offset cuối của SQW, chu kỳ sau gán nhãn lại
+        if (powerManager_lightSleepEnabled()) {
+            ESP_ERROR_CHECK_WITHOUT_ABORT(timeBase_stopSqw());
+        }
+#endif
+        // Chờ start command từ HTTP API hoặc UART (blocking call), hoặc từ lịch đo (sampleSchedule_task)
+        xEventGroupSetBits(sampling_control_event, SAMPLING_IDLE_BIT);
         EventBits_t bits = xEventGroupWaitBits(sampling_control_event, START_SAMPLING_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+        xEventGroupClearBits(sampling_control_event, SAMPLING_IDLE_BIT);
         
         if (bits & START_SAMPLING_BIT) {
             ESP_LOGI(__func__, "✅ Start command received! Starting sensor sampling...");
@@ -1402,6 +1744,14 @@ void getDataFromSensor_task(void *parameters)
             ESP_LOGW(__func__, "⚠️  Unexpected event state");
             continue;
         }
+        // Cả chu kỳ: chip thức (ngắt ALERT/RDY của ADS111x không đánh thức được light sleep), clock tối thiểu
+        powerManager_begin(POWER_STAGE_ACQUISITION);
+#if CONFIG_TIMEBASE_SQW_ENABLE
+        if (powerManager_lightSleepEnabled() && !timeBase_sqwRunning() &&
+            timeBase_startSqw(&ds3231_device, (gpio_num_t)CONFIG_RTC_INT_GPIO) != ESP_OK) {
+            ESP_LOGW(__func__, "⚠️  DS3231 SQW not restarted, timebase uses SNTP/DS3231 offset");
+        }
+#endif
         
         // Kiểm tra và cập nhật DS3231 từ system time nếu SNTP đã sync thành công
         // Mỗi lần bắt đầu chu kỳ sampling, kiểm tra system time và cập nhật DS3231 nếu hợp lệ
@@ -1412,130 +1762,178 @@ void getDataFromSensor_task(void *parameters)
         
         // Nếu system time hợp lệ (sau 2020-01-01), cập nhật DS3231 từ system time
         // Điều này đảm bảo DS3231 luôn có thời gian thực nhất khi SNTP sync thành công
-        if (now >= 1577836800) { // 2020-01-01 00:00:00 UTC
-            ESP_LOGI(__func__, "System time is valid, updating DS3231 from system time: %02d/%02d/%04d %02d:%02d:%02d",
-                     timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
-                     timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-            set_ds3231_time_from_system();
-        } else {
+        if (now >= 1577836800 && !systemTime_fromRtc) { // 2020-01-01 00:00:00 UTC
+#if CONFIG_TIMEBASE_SQW_ENABLE
+            // Timebase theo SQW: chỉ ghi lại DS3231 khi lệch SNTP quá ngưỡng (không tốn I2C mỗi chu kỳ)
+            struct timeval tv;
+            gettimeofday(&tv, NULL);
+            int64_t rtcError_us = timeBase_nowUs() - ((int64_t)tv.tv_sec * 1000000 + tv.tv_usec);
+            if (timeBase_source() == TIMEBASE_SOURCE_RTC_SQW &&
+                llabs(rtcError_us) <= (int64_t)CONFIG_TIMEBASE_RTC_MAX_ERROR_MS * 1000)
+            {
+                ESP_LOGI(__func__, "DS3231 within %" PRId64 " us of system time, not rewritten", rtcError_us);
+            }
+            else
+#endif
+            {
+                ESP_LOGI(__func__, "System time is valid, updating DS3231 from system time: %02d/%02d/%04d %02d:%02d:%02d",
+                         timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
+                         timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+                set_ds3231_time_from_system();
+            }
+        } else if (now < 1577836800) {
             ESP_LOGW(__func__, "System time is invalid (%lld), using DS3231 time", (long long)now);
         }
+        // Epoch offset của timestamp: SQW nếu đang chạy, system time (SNTP) nếu có, nếu không đọc DS3231
+        if (timeBase_source() != TIMEBASE_SOURCE_RTC_SQW && timeBase_refresh(&ds3231_device) != ESP_OK) {
+            ESP_LOGW(__func__, "⚠️  No valid SNTP/DS3231 time, samples are stamped with time since boot");
+        }
         
+        // Driver chỉ ghi config register từ bản cache: kiểm tra các ADS111x không bị reset (mất ngưỡng ALERT/RDY)
+        // giữa hai chu kỳ, chip bị reset được cấu hình lại
+        if (ads111x_array_verify(&ads111x_sensorArray) != ESP_OK) {
+            ESP_LOGW(__func__, "⚠️  ADS111x array check failed, see driver log");
+        }
+
         // Tạo tên file mới theo thời gian thực mỗi lần bắt đầu chu kỳ sampling
-        ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_convertTimeToString(&ds3231_device, nameFileSaveData, 14));
+        nameFile_fromTimeBase();
         ESP_LOGI(__func__, "Creating new file with real-time name: %s.csv", nameFileSaveData);
         
-        // Tạo header cho file CSV mới
-        if (SDcard_semaphore != NULL) {
-            if (xSemaphoreTake(SDcard_semaphore, pdMS_TO_TICKS(5000)) == pdTRUE) {
-                ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writeDataToFile(nameFileSaveData, "%s,%s,%s,%s,%s,%s,%s\n",
-                                                                    "STT", "Temperature", "Humidity", "Sensor1", "Sensor2", "Sensor3", "Sensor4"));
-                xSemaphoreGive(SDcard_semaphore);
-            } else {
-                ESP_LOGW(__func__, "Failed to get SD card semaphore to create CSV header");
-            }
-        } else {
-            ESP_LOGW(__func__, "SDcard_semaphore is NULL, cannot safely write CSV header");
-        }
+        // File và header được saveDataSensorToSDcard_task tạo khi nhận mẫu đầu tiên của chu kỳ
         
         finishTime = xTaskGetTickCount() + SAMPLING_TIMME;
-        static int sample_counter = 0; // Biến static để đếm liên tục qua các chu kỳ
-        do
+        static RTC_DATA_ATTR int sample_counter = 0; // Đếm liên tục qua các chu kỳ (cả qua deep sleep theo lịch)
+        int16_t adcScan[ADC_CHANNEL_COUNT] = {0};   // Kênh đọc lỗi giữ giá trị tốt gần nhất
+        int16_t adcFrame[ADC_CHANNEL_COUNT];
+        int64_t scanMonotonic_us = 0;               // Thời điểm scan cuối cùng của frame
+        int64_t scanEpochOffset_us = 0;
+        uint32_t scanErrors = 0;
+        decimator_reset(&adcDecimator);
+
+        while (xTaskGetTickCount() < finishTime)
         {
-            task_lastWakeTime = xTaskGetTickCount();
-            sample_counter++; // Tăng counter trước
-            dataSensorTemp.timeStamp = sample_counter;
-            
             if (xSemaphoreTake(getDataSensor_semaphore, portMAX_DELAY))
             {
-                // Đọc cảm biến DHT (nếu bật)
-#if CONFIG_DHT_USE
-                {
-                    float temp = 0, hum = 0;
-                    esp_err_t dht_err = dht_read_float(DHT_GPIO, DHT_TYPE, &hum, &temp);
-                    if (dht_err == ESP_OK) {
-                        dataSensorTemp.temperature = temp;
-                        dataSensorTemp.humidity = hum;
-                    } else {
-                        ESP_LOGW(__func__, "DHT read failed: %s", esp_err_to_name(dht_err));
-                    }
+                // Các chip chuyển đổi song song, kênh kế tiếp được bắt đầu trong lúc đọc kết quả kênh trước (2 transaction/kênh):
+                // frame 16 kênh mất cùng thời gian với frame 4 kênh
+                uint32_t lostBefore = ads111x_array_lost_count(&ads111x_sensorArray);
+                ads111x_array_scan(&ads111x_sensorArray, adcScan);
+                timeBase_stamp(&scanMonotonic_us, &scanEpochOffset_us);
+                size_t failedChannels = ads111x_array_lost_count(&ads111x_sensorArray) - lostBefore;
+                xSemaphoreGive(getDataSensor_semaphore); // Give mutex
+
+                // Mất ADC (lỗi I2C trả về ngay): nhường CPU để không quay vòng ở priority cao
+                if (failedChannels == ADC_CHANNEL_COUNT) {
+                    vTaskDelay(1);
                 }
+                scanErrors += failedChannels;
+            }
+#if CONFIG_ADS111X_AUTO_GAIN
+            if (autoGain) {
+                autoRange_observe(&adcAutoRange, adcScan);
+            }
 #endif
 
-                ESP_LOGI(__func__, "Sample #%d - Temperature: %f, Humidity: %f", dataSensorTemp.timeStamp, dataSensorTemp.temperature, dataSensorTemp.humidity);
+            if (!decimator_push(&adcDecimator, adcScan, adcFrame)) {
+                continue;
+            }
 
-          // Read 4 channels from single ADS1115
-                // Threshold để phát hiện khi không có cảm biến (ADC floating noise)
-                // Giá trị noise thường nằm trong khoảng 11000-11200 (0.6875V - 0.7V) khi không có tín hiệu
-                const int16_t ADC_NOISE_MIN = 11000;
-                const int16_t ADC_NOISE_MAX = 11200;
-                bool all_channels_noise = true;
-                
-                for (size_t i = 0; i < 4; i++)
-                {
-                    ESP_ERROR_CHECK_WITHOUT_ABORT(ads111x_set_input_mux(&ads111x_devices[0], (ads111x_mux_t)(i + 4)));
-                    vTaskDelay(50 / portTICK_PERIOD_MS);
-                    int16_t ADC_rawData = 0;
-                    if (ads111x_get_value(&ads111x_devices[0], &ADC_rawData) == ESP_OK)
-                    {
-                        float voltage = ads111x_gain_values[ADS111X_GAIN_2V048] / ADS111X_MAX_VALUE * ADC_rawData;
-                        
-                        // Kiểm tra xem giá trị có nằm trong khoảng noise không
-                        if (ADC_rawData < ADC_NOISE_MIN || ADC_rawData > ADC_NOISE_MAX) {
-                            all_channels_noise = false;
-                        }
-                        
-                        ESP_LOGI(__func__, "Channel %d - Raw ADC value: %d, Voltage: %.04f Volts. %s", 
-                                i, ADC_rawData, voltage, 
-                                (ADC_rawData >= ADC_NOISE_MIN && ADC_rawData <= ADC_NOISE_MAX) ? "[NOISE?]" : "[SIGNAL]");
-                        dataSensorTemp.ADC_Value[i] = ADC_rawData;
-                    }
-                    else
-                    {
-                        ESP_LOGE(__func__, "Cannot read ADC value from channel %d.", i);
-                        all_channels_noise = false; // Nếu không đọc được, không phải noise
-                        dataSensorTemp.ADC_Value[i] = 0;
-                    }
+            // Ghi frame trực tiếp vào slot của ring (không copy), các sink đọc sau
+            powerManager_begin(POWER_STAGE_FORMAT);
+            struct dataSensor_st *dataSensorFrame = frameRing_reserve(&dataSensor_ring);
+            sample_counter++;
+            dataSensorFrame->timeStamp = sample_counter;
+            dataSensorFrame->monotonic_us = scanMonotonic_us;
+            dataSensorFrame->epochOffset_us = scanEpochOffset_us;
+            dataSensorFrame->pressure = 0;
+            portENTER_CRITICAL(&environmentData_lock);
+            const bool environmentValid = environmentData_valid;
+            dataSensorFrame->temperature = environmentValid ? environmentData_temperature : 0;
+            dataSensorFrame->humidity = environmentValid ? environmentData_humidity : 0;
+            portEXIT_CRITICAL(&environmentData_lock);
+
+            bool all_channels_noise = true;
+            dataSensorFrame->channelCount = ADC_CHANNEL_COUNT;
+            int32_t normalized[ADC_CHANNEL_COUNT];     // Code quy về dải ±2.048 V, so sánh được giữa các gain
+            for (size_t i = 0; i < ADC_CHANNEL_COUNT; i++)
+            {
+                dataSensorFrame->ADC_Value[i] = adcFrame[i];
+                dataSensorFrame->gain[i] = adcGain[i];
+                normalized[i] = binlog_normalizeCenti(adcFrame[i], adcGain[i]) / 100;
+                // Kiểm tra xem giá trị có nằm trong khoảng noise không
+                if (normalized[i] < ADC_NOISE_MIN || normalized[i] > ADC_NOISE_MAX) {
+                    all_channels_noise = false;
                 }
-                
-                // Cảnh báo nếu tất cả channel đều trong khoảng noise (có thể không có cảm biến)
-                if (all_channels_noise) {
-                    ESP_LOGW(__func__, "WARNING: All ADC channels show noise values (11000-11200). Sensors may not be connected!");
+                ESP_LOGD(__func__, "Channel %d - ADC value: %d, gain ±%.3f V, Voltage: %.05f Volts.", (int)i, adcFrame[i],
+                         ads111x_gain_values[adcGain[i]], ads111x_gain_values[adcGain[i]] / ADS111X_MAX_VALUE * adcFrame[i]);
+            }
+#if CONFIG_CALIBRATION_ENABLE
+            // Nồng độ theo bảng hiệu chuẩn (LUT số nguyên, vài trăm cycle cho cả frame), bù theo T/H của frame
+            calibrationStore_apply(normalized, ADC_CHANNEL_COUNT,
+                                   environmentValid ? (int32_t)lroundf(dataSensorFrame->temperature * 100) : CALIBRATION_VALUE_NONE,
+                                   environmentValid ? (int32_t)lroundf(dataSensorFrame->humidity * 100) : CALIBRATION_VALUE_NONE,
+                                   dataSensorFrame->concentration);
+            for (size_t i = 0; i < ADC_CHANNEL_COUNT; i++)
+            {
+                if (dataSensorFrame->concentration[i] != CALIBRATION_VALUE_NONE) {
+                    ESP_LOGD(__func__, "Channel %d - %.3f %s", (int)i, dataSensorFrame->concentration[i] / 1000.0, CONFIG_CALIBRATION_UNIT);
                 }
+            }
+#else
+            for (size_t i = 0; i < ADC_CHANNEL_COUNT; i++) {
+                dataSensorFrame->concentration[i] = CALIBRATION_VALUE_NONE;
+            }
+#endif
+#if CONFIG_ADS111X_AUTO_GAIN
+            // Frame đã ghi xong với gain cũ, gain mới áp dụng từ scan kế tiếp
+            if (autoGain) {
+                adcAutoGain_update(&adcAutoRange, &adcDecimator, adcScan, adcGain);
+            }
+#endif
 
-                xSemaphoreGive(getDataSensor_semaphore); // Give mutex
-                ESP_LOGI(__func__, "Read data from sensors completed!");
+            // Mỗi ADS111x một dòng log (4 kênh)
+            for (size_t d = 0; d < CONFIG_ADS111X_DEVICE_COUNT; d++)
+            {
+                const int32_t *adc = &normalized[d * ADC_INPUTS_PER_DEVICE];
+                ESP_LOGI(__func__, "Frame #%d @ %" PRId64 " us - T: %.2f, H: %.2f, ADC%u: %" PRId32 " %" PRId32 " %" PRId32 " %" PRId32,
+                         dataSensorFrame->timeStamp, dataSensor_timeUs(dataSensorFrame),
+                         dataSensorFrame->temperature, dataSensorFrame->humidity, (unsigned)d,
+                         adc[0], adc[1], adc[2], adc[3]);
+            }
+            if (scanErrors != 0) {
+                ESP_LOGE(__func__, "Cannot read ADC: %" PRIu32 " failed conversions in this frame.", scanErrors);
+                scanErrors = 0;
+            }
 
-                if (xQueueSendToBack(dataSensorSentToSD_queue, (void *)&dataSensorTemp, WAIT_10_TICK * 10) != pdPASS)
-                {
-                    ESP_LOGE(__func__, "Failed to post the data sensor to dataSensorMidleware Queue.");
-                }
-                else
-                {
-                    ESP_LOGI(__func__, "Success to post the data sensor to dataSensorMidleware Queue.");
-                }
-                
-                // Gửi dữ liệu đến dashboard queue (không cần SD card)
-#if CONFIG_DASHBOARD_ENABLED
-                if (dataSensorSentToDashboard_queue != NULL) {
-                    if (xQueueSendToBack(dataSensorSentToDashboard_queue, (void *)&dataSensorTemp, WAIT_10_TICK * 10) != pdPASS) {
-                        ESP_LOGW(__func__, "Failed to post data to dashboard queue.");
-                    }
-                }
-#endif
+            // Cảnh báo nếu tất cả channel đều trong khoảng noise (có thể không có cảm biến)
+            if (all_channels_noise) {
+                ESP_LOGW(__func__, "WARNING: All ADC channels show noise values (11000-11200). Sensors may not be connected!");
             }
-            
-            // Reset ADC values, giữ lại temperature/humidity
-            memset(dataSensorTemp.ADC_Value, 0, sizeof(dataSensorTemp.ADC_Value));
-            
-            vTaskDelayUntil(&task_lastWakeTime, PERIOD_GET_DATA_FROM_SENSOR);
-            
-        } while (task_lastWakeTime < finishTime);
-        
+
+            frameRing_publish(&dataSensor_ring);
+            powerManager_end(POWER_STAGE_FORMAT);
+            powerManager_countSamples(1);
+            // Theo kịp hiệu chỉnh của SNTP (không truy cập bus)
+            timeBase_poll();
+        }
+        powerManager_end(POWER_STAGE_ACQUISITION);
+
         ESP_LOGI(__func__, "========================================");
         ESP_LOGI(__func__, "✅ SAMPLING CYCLE COMPLETED!");
         ESP_LOGI(__func__, "📊 Total samples collected: %d", sample_counter);
         ESP_LOGI(__func__, "💾 Data saved to: %s.csv", nameFileSaveData);
+#if CONFIG_TIMEBASE_SQW_ENABLE
+        timeBase_sqwStats_st sqwStats;
+        timeBase_sqwStats(&sqwStats);
+        ESP_LOGI(__func__, "🕒 Timebase %s: %" PRIu32 " SQW edges, %" PRIu32 " missed, esp_timer %+" PRId32 " ppb",
+                 timeBase_sourceName(timeBase_source()), sqwStats.edges, sqwStats.missedEdges, sqwStats.ratePpb);
+#endif
+        powerManager_stats_st powerStats;
+        powerManager_stats(&powerStats, false);
+        ESP_LOGI(__func__, "🔋 Acquisition %.1f %%, max clock %.1f %%, estimated %" PRIu32 " uAh/1000 samples (UART: POWER)",
+                 powerStats.window_us ? 100.0 * powerStats.stageActive_us[POWER_STAGE_ACQUISITION] / powerStats.window_us : 0.0,
+                 powerStats.window_us ? 100.0 * powerStats.levelTime_us[POWER_LEVEL_MAX_CLOCK] / powerStats.window_us : 0.0,
+                 powerStats.uAhPer1000Samples);
         ESP_LOGI(__func__, "========================================");
         
         // Clear sampling control event để chờ lần đo tiếp theo
@@ -1548,75 +1946,471 @@ void getDataFromSensor_task(void *parameters)
 /*------------------------------------ SAVE DATA ------------------------------------ */
 
 
+#if CONFIG_DATALOG_WRITE_CSV
+static sdcard_writer_st csvWriter;
+#endif
+#if CONFIG_DATALOG_WRITE_BINARY
+static sdcard_writer_st binaryWriter;
+static binlog_codec_st binaryCodec;
+// Auto gain: mỗi record mang gain của từng kênh
+#if CONFIG_ADS111X_AUTO_GAIN
+#define DATALOG_BINLOG_GAIN_FLAG    BINLOG_FLAG_CHANNEL_GAIN
+#else
+#define DATALOG_BINLOG_GAIN_FLAG    0U
+#endif
+// Cờ quyết định layout của record: file cũ chỉ được nối tiếp khi các cờ này giống nhau
+#define DATALOG_BINLOG_LAYOUT_MASK  (BINLOG_FLAG_CHANNEL_GAIN | BINLOG_FLAG_SAMPLE_TIME)
+#define DATALOG_BINLOG_LAYOUT_FLAGS (DATALOG_BINLOG_GAIN_FLAG | BINLOG_FLAG_SAMPLE_TIME)
+#endif
+
+/**
+ * @brief Đóng file của phiên đo cũ và mở file của phiên đo mới (nameFileSaveData).
+ *        Header chỉ được ghi khi file mới được tạo, nên mở lại file cũ không làm lặp header.
+ *        File cũ có layout khác (header CSV khác, cờ binlog khác) không được nối tiếp: file đó bị tắt cho phiên.
+ *        Gọi khi đang giữ SDcard_semaphore.
+ *
+ * @return ESP_OK khi các file cần ghi đã mở (file không nối tiếp được thì bị tắt cho phiên, vẫn là ESP_OK),
+ *         lỗi của sdcard_writerOpen() nếu mở file thất bại (mở lại ở frame sau).
+ */
+static esp_err_t saveDataSensor_openSession(void)
+{
+    __attribute__((unused)) const sdcard_writerConfig_st writerConfig = SDCARD_WRITER_CONFIG_DEFAULT();
+    esp_err_t openError = ESP_OK;
+
+#if CONFIG_DATALOG_WRITE_CSV
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerClose(&csvWriter));
+
+    char csvPath[64];
+    snprintf(csvPath, sizeof(csvPath), "%s/%s.csv", mount_point, nameFileSaveData);
+    esp_err_t csvError = dataSensor_checkCsvHeader(csvPath, ADC_CHANNEL_COUNT);
+    if (csvError != ESP_OK && csvError != ESP_ERR_NOT_FOUND) {
+        ESP_LOGE(__func__, "Cannot append to %s (%s), CSV log disabled for this session.", csvPath, esp_err_to_name(csvError));
+    } else {
+        openError = sdcard_writerOpen(&csvWriter, nameFileSaveData, "csv", &writerConfig);
+    }
+    if (openError == ESP_OK && sdcard_writerIsOpen(&csvWriter) && csvWriter.endOffset == 0)
+    {
+        char csvHeader[DATA_SENSOR_CSV_HEADER_MAX_SIZE];
+        size_t length = dataSensor_formatCsvHeader(ADC_CHANNEL_COUNT, csvHeader, sizeof(csvHeader));
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerAppend(&csvWriter, csvHeader, length));
+    }
+#endif
+
+#if CONFIG_DATALOG_WRITE_BINARY
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerClose(&binaryWriter));
+
+    char pathFile[64];
+    snprintf(pathFile, sizeof(pathFile), "%s/%s.bin", mount_point, nameFileSaveData);
+    esp_err_t errorCode = dataSensor_resumeBinlog(pathFile, &binaryCodec);
+    if (errorCode == ESP_OK && (binaryCodec.channelCount != ADC_CHANNEL_COUNT ||
+                                (binaryCodec.flags & DATALOG_BINLOG_LAYOUT_MASK) != DATALOG_BINLOG_LAYOUT_FLAGS)) {
+        errorCode = ESP_ERR_INVALID_VERSION;
+    }
+    if (errorCode != ESP_OK && errorCode != ESP_ERR_NOT_FOUND)
+    {
+        ESP_LOGE(__func__, "Cannot append to %s (%s), binary log disabled for this session.", pathFile, esp_err_to_name(errorCode));
+        return openError;
+    }
+    esp_err_t binaryOpenError = sdcard_writerOpen(&binaryWriter, nameFileSaveData, "bin", &writerConfig);
+    if (binaryOpenError != ESP_OK) {
+        return binaryOpenError;
+    }
+
+    if (errorCode == ESP_ERR_NOT_FOUND)
+    {
+        binlog_header_st header = {
+            .channelCount = ADC_CHANNEL_COUNT,
+            .flags = DATALOG_BINLOG_LAYOUT_FLAGS
+#if CONFIG_ENV_SENSOR_USE
+                   | BINLOG_FLAG_ENVIRONMENT
+#endif
+            ,
+            .gain = ADS111X_GAIN_IN_USE,
+            .dataRate = ADS111X_DATA_RATE_IN_USE,
+            .sampleInterval_ms = ADC_FRAME_PERIOD_MS,
+            .startTime = time(NULL) >= 1577836800 ? (int64_t)time(NULL) : 0,
+        };
+        strncpy(header.deviceName, CONFIG_NAME_DEVICE, sizeof(header.deviceName) - 1);
+
+        uint8_t headerBuffer[BINLOG_HEADER_SIZE];
+        size_t length = binlog_encodeHeader(&header, headerBuffer, sizeof(headerBuffer));
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerAppend(&binaryWriter, headerBuffer, length));
+        binlog_codecInit(&binaryCodec, &header);
+    }
+#endif
+    return openError;
+}
+
+// Reader của SD task, lịch đo (sampleSchedule_task) đọc số frame chưa ghi trước khi ngủ
+static frameRing_reader_st dataSensor_sdReader;
+
 /**
- * @brief Save data from SD queue to SD card
+ * @brief Save data from the sample ring to SD card
+ *
+ * Đọc frame trực tiếp trong dataSensor_ring (reader riêng, không copy). File được mở một lần cho mỗi chu kỳ sampling (session writer), các dòng dữ liệu được gom
+ * trong RAM và ghi + fsync theo lô (số dòng / số byte / thời gian, xem menu "SD Card menu").
+ * Tùy menu "Data Manager", mỗi mẫu được ghi vào <name>.csv và/hoặc <name>.bin.
  * 
  * @param parameters 
  */
 void saveDataSensorToSDcard_task(void *parameters)
 {
-    UBaseType_t message_stored = 0;
-    struct dataSensor_st dataSensorReceiveFromQueue;
+    static char nameFileOpened[sizeof(nameFileSaveData)] = "";
+    uint32_t overrunsReported = 0;
+
+    ESP_ERROR_CHECK_WITHOUT_ABORT(frameRing_readerAttach(&dataSensor_sdReader, &dataSensor_ring));
 
     for (;;)
     {
-        message_stored = uxQueueMessagesWaiting(dataSensorSentToSD_queue);
-
-        if (message_stored != 0) // Check if dataSensorSentToSD_queue not empty
+        const struct dataSensor_st *dataSensorFrame = frameRing_peek(&dataSensor_sdReader, PERIOD_SAVE_DATA_SENSOR_TO_SDCARD * 20);
+        if (dataSensorFrame != NULL)
         {
-            if (xQueueReceive(dataSensorSentToSD_queue, (void *)&dataSensorReceiveFromQueue, WAIT_10_TICK * 50) == pdPASS) // Get data sesor from queue
+            powerManager_begin(POWER_STAGE_FORMAT);
+#if CONFIG_DATALOG_WRITE_CSV
+            // Create data string follow format (không malloc, không printf số thực)
+            char csvRow[DATA_SENSOR_CSV_ROW_MAX_SIZE];
+            size_t csvLength = dataSensor_formatCsvRow(dataSensorFrame, csvRow, sizeof(csvRow));
+#endif
+#if CONFIG_DATALOG_WRITE_BINARY
+            binlog_record_st record;
+            dataSensor_toBinlogRecord(dataSensorFrame, &record);
+#endif
+            powerManager_end(POWER_STAGE_FORMAT);
+            // Frame bị ghi đè trong lúc đọc (SD task bị chậm quá capacity frame): bỏ
+            if (!frameRing_commit(&dataSensor_sdReader)) {
+                continue;
+            }
+            if (dataSensor_sdReader.overruns != overrunsReported)
             {
-                ESP_LOGI(__func__, "Receiving data from queue successfully.");
+                ESP_LOGW(__func__, "SD card sink fell behind, %" PRIu32 " frames lost.", dataSensor_sdReader.overruns - overrunsReported);
+                overrunsReported = dataSensor_sdReader.overruns;
+            }
 
-                if (xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) == pdTRUE)
+            if (xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) == pdTRUE)
+            {
+                __attribute__((unused)) static esp_err_t errorCode_t;
+                powerManager_begin(POWER_STAGE_STORAGE);
+
+                // Chu kỳ sampling mới -> đóng file cũ (commit phần còn lại) và mở file mới
+                // Mở thất bại thì không ghi nhận tên file: frame sau thử mở lại
+                if (strcmp(nameFileOpened, nameFileSaveData) != 0 && saveDataSensor_openSession() == ESP_OK) {
+                    strcpy(nameFileOpened, nameFileSaveData);
+                }
+
+#if CONFIG_DATALOG_WRITE_CSV
+                if (sdcard_writerIsOpen(&csvWriter))
                 {
-                    static esp_err_t errorCode_t;
-                    // Create data string follow format
-                    //dataSensorTemp.timeStamp +=1;        
-                    errorCode_t = sdcard_writeDataToFile(nameFileSaveData, dataSensor_templateSaveToSDCard,
-                                                        dataSensorReceiveFromQueue.timeStamp,
-                                                        dataSensorReceiveFromQueue.temperature,
-                                                        dataSensorReceiveFromQueue.humidity,
-                                                        dataSensorReceiveFromQueue.ADC_Value[0],
-                                                        dataSensorReceiveFromQueue.ADC_Value[1],
-                                                        dataSensorReceiveFromQueue.ADC_Value[2],
-                                                        dataSensorReceiveFromQueue.ADC_Value[3]);
-                    ESP_LOGI(TAG, "Save task received mutex!");
-                    xSemaphoreGive(SDcard_semaphore);
+                    errorCode_t = sdcard_writerAppend(&csvWriter, csvRow, csvLength);
                     if (errorCode_t != ESP_OK)
                     {
-                        ESP_LOGE(__func__, "sdcard_writeDataToFile(...) function returned error: 0x%.4X", errorCode_t);
+                        ESP_LOGE(__func__, "sdcard_writerAppend(...) function returned error: 0x%.4X", errorCode_t);
                     }
                 }
+#endif
+#if CONFIG_DATALOG_WRITE_BINARY
+                if (sdcard_writerIsOpen(&binaryWriter))
+                {
+                    uint8_t recordBuffer[BINLOG_RECORD_MAX_SIZE];
+                    size_t length = binlog_encodeRecord(&binaryCodec, &record, recordBuffer, sizeof(recordBuffer));
+                    errorCode_t = sdcard_writerAppend(&binaryWriter, recordBuffer, length);
+                    if (errorCode_t != ESP_OK)
+                    {
+                        ESP_LOGE(__func__, "sdcard_writerAppend(...) function returned error: 0x%.4X", errorCode_t);
+                    }
+                }
+#endif
+                powerManager_end(POWER_STAGE_STORAGE);
+                xSemaphoreGive(SDcard_semaphore);
             }
-            else
+        }
+        else if (nameFileOpened[0] != '\0')
+        {
+            // Không có dữ liệu mới: commit nếu dòng cũ nhất đã quá thời gian cho phép
+            if (xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) == pdTRUE)
             {
-                ESP_LOGI(__func__, "Receiving data from queue failed.");
-                continue;
+                powerManager_begin(POWER_STAGE_STORAGE);
+#if CONFIG_DATALOG_WRITE_CSV
+                ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerPoll(&csvWriter));
+#endif
+#if CONFIG_DATALOG_WRITE_BINARY
+                ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerPoll(&binaryWriter));
+#endif
+                powerManager_end(POWER_STAGE_STORAGE);
+                xSemaphoreGive(SDcard_semaphore);
             }
         }
-
-        vTaskDelay(PERIOD_SAVE_DATA_SENSOR_TO_SDCARD);
     }
 };
 
-#if CONFIG_DASHBOARD_ENABLED
+/*------------------------------------ SCHEDULED SAMPLING ------------------------------------ */
+
+#if CONFIG_SLEEP_SCHEDULE_ENABLE
+#define SAMPLE_SCHEDULE_DRAIN_TIMEOUT_MS    2000U
+#define SAMPLE_SCHEDULE_RETAINED_MAGIC      0x53434844UL    // "SCHD"
+
+#if CONFIG_SLEEP_SCHEDULE_DEEP
 /**
- * @brief HTTP event handler for dashboard POST requests
+ * @brief Trạng thái giữ qua deep sleep (RTC slow memory): giờ alarm đã hẹn, file của phiên đo
+ *        và các frame SD task chưa kịp ghi.
  */
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+typedef struct sampleSchedule_retained
 {
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGD(TAG, "HTTP_EVENT_ERROR");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
-            break;
-        case HTTP_EVENT_ON_HEADER:
+    uint32_t magic;
+    int64_t wake_s;
+    char fileName[sizeof(nameFileSaveData)];
+    uint32_t frameCount;
+    struct dataSensor_st frames[CONFIG_SLEEP_SCHEDULE_RETAINED_FRAMES];
+} sampleSchedule_retained_st;
+
+static RTC_DATA_ATTR sampleSchedule_retained_st sampleSchedule_retained;
+#endif
+
+/**
+ * @brief Chờ SD task ghi hết các frame đã publish (tối đa SAMPLE_SCHEDULE_DRAIN_TIMEOUT_MS) rồi commit file.
+ *
+ * @return Số frame SD task còn chưa đọc.
+ */
+static uint32_t sampleSchedule_flushStorage(void)
+{
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(SAMPLE_SCHEDULE_DRAIN_TIMEOUT_MS);
+    uint32_t pending;
+
+    while ((pending = frameRing_pending(&dataSensor_sdReader)) != 0 && xTaskGetTickCount() < deadline) {
+        vTaskDelay(WAIT_10_TICK);
+    }
+    if (xSemaphoreTake(SDcard_semaphore, pdMS_TO_TICKS(SAMPLE_SCHEDULE_DRAIN_TIMEOUT_MS)) == pdTRUE)
+    {
+        // Commit có fsync: file trên thẻ đầy đủ kể cả khi deep sleep/mất nguồn trong lúc ngủ
+#if CONFIG_DATALOG_WRITE_CSV
+        if (sdcard_writerIsOpen(&csvWriter)) {
+            ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerCommit(&csvWriter));
+        }
+#endif
+#if CONFIG_DATALOG_WRITE_BINARY
+        if (sdcard_writerIsOpen(&binaryWriter)) {
+            ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerCommit(&binaryWriter));
+        }
+#endif
+        xSemaphoreGive(SDcard_semaphore);
+    }
+    return pending;
+}
+
+/**
+ * @brief Sau khi thức: mốc thời gian theo alarm (hoặc đọc DS3231 nếu thức do backup timer) và
+ *        đặt lại system time, vốn chỉ được RTC slow clock giữ trong lúc ngủ.
+ *
+ * @param alarm_s          Giờ alarm đã kích, 0 nếu không thức do alarm.
+ * @param wakeMonotonic_us esp_timer lúc thức.
+ */
+static void sampleSchedule_onWake(time_t alarm_s, int64_t wakeMonotonic_us)
+{
+    if (alarm_s != 0) {
+        // Alarm kích đúng lúc DS3231 sang giây alarm_s: mốc thời gian không cần đọc I2C
+        timeBase_anchorToRtcEdge(alarm_s, wakeMonotonic_us);
+    } else {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(timeBase_anchorToRtc(&ds3231_device));
+    }
+
+    int64_t now_us = timeBase_nowUs();
+    if (now_us != 0)
+    {
+        struct timeval tv = {.tv_sec = (time_t)(now_us / 1000000), .tv_usec = (suseconds_t)(now_us % 1000000)};
+        settimeofday(&tv, NULL);
+        systemTime_fromRtc = true;
+    }
+}
+
+#if CONFIG_SLEEP_SCHEDULE_DEEP
+/**
+ * @brief Gọi trong app_main sau khi khởi tạo DS3231 (và đặt TZ).
+ *
+ * @return true nếu boot này là thức dậy từ deep sleep theo lịch.
+ */
+static bool sampleSchedule_resume(void)
+{
+    bool byAlarm = false;
+
+    if (!sleepSchedule_resume((gpio_num_t)CONFIG_RTC_INT_GPIO, &byAlarm)) {
+        sampleSchedule_retained.magic = 0;
+        return false;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sleepSchedule_disarm(&ds3231_device));
+    bool valid = (sampleSchedule_retained.magic == SAMPLE_SCHEDULE_RETAINED_MAGIC);
+    // esp_timer đếm từ lúc boot: mốc trễ bằng thời gian chạy bootloader, SQW sửa lại sau khi gán nhãn một cạnh
+    sampleSchedule_onWake((byAlarm && valid) ? (time_t)sampleSchedule_retained.wake_s : 0, 0);
+    ESP_LOGI(TAG, "⏰ Woken from deep sleep by %s", byAlarm ? "DS3231 alarm" : "backup timer");
+    return valid;
+}
+
+/**
+ * @brief Publish lại các frame giữ trong RTC memory (chưa có producer nào chạy) vào file của phiên đo cũ.
+ */
+static void sampleSchedule_restoreFrames(void)
+{
+    uint32_t count = sampleSchedule_retained.frameCount;
+
+    sampleSchedule_retained.magic = 0;
+    sampleSchedule_retained.frameCount = 0;
+    if (count == 0) {
+        return;
+    }
+    strlcpy(nameFileSaveData, sampleSchedule_retained.fileName, sizeof(nameFileSaveData));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        memcpy(frameRing_reserve(&dataSensor_ring), &sampleSchedule_retained.frames[i], sizeof(struct dataSensor_st));
+        frameRing_publish(&dataSensor_ring);
+    }
+    sampleSchedule_flushStorage();
+    ESP_LOGI(TAG, "Restored %" PRIu32 " frames kept across deep sleep to %s", count, nameFileSaveData);
+}
+#endif
+
+/**
+ * @brief Ngủ tới đầu cửa sổ đo @p wake_s.
+ *
+ * @return true nếu tới giờ bắt đầu chu kỳ đo, false nếu bị hủy vì đã có START trong lúc chuẩn bị ngủ.
+ *         Deep sleep không trở về.
+ */
+static bool sampleSchedule_sleepUntil(time_t wake_s)
+{
+    const gpio_num_t intGpio = (gpio_num_t)CONFIG_RTC_INT_GPIO;
+    __attribute__((unused)) uint32_t pending = sampleSchedule_flushStorage();
+
+#if CONFIG_TIMEBASE_SQW_ENABLE
+    // INT/SQW dùng chung: tắt ngắt SQW trước khi bật alarm
+    ESP_ERROR_CHECK_WITHOUT_ABORT(timeBase_stopSqw());
+#endif
+    bool armed = (sleepSchedule_arm(&ds3231_device, wake_s) == ESP_OK);
+    EventBits_t bits = xEventGroupGetBits(sampling_control_event);
+    bool cancelled = (bits & START_SAMPLING_BIT) || !(bits & SAMPLING_IDLE_BIT);
+
+    if (armed && !cancelled)
+    {
+#if CONFIG_SLEEP_SCHEDULE_DEEP
+        sampleSchedule_retained.wake_s = wake_s;
+        strlcpy(sampleSchedule_retained.fileName, nameFileSaveData, sizeof(sampleSchedule_retained.fileName));
+        sampleSchedule_retained.frameCount = frameRing_copyPending(&dataSensor_sdReader, sampleSchedule_retained.frames,
+                                                                   CONFIG_SLEEP_SCHEDULE_RETAINED_FRAMES);
+        sampleSchedule_retained.magic = SAMPLE_SCHEDULE_RETAINED_MAGIC;
+        if (pending > sampleSchedule_retained.frameCount) {
+            ESP_LOGW(TAG, "⚠️  %" PRIu32 " frames not written to SD card are lost in deep sleep",
+                     pending - sampleSchedule_retained.frameCount);
+        }
+#if CONFIG_USING_WIFI
+        ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_stop());
+#endif
+        sleepSchedule_deepSleep(intGpio, wake_s);
+#else
+#if CONFIG_USING_WIFI
+        ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_stop());
+#endif
+        int64_t wakeMonotonic_us;
+        bool byAlarm = sleepSchedule_lightSleep(intGpio, wake_s, &wakeMonotonic_us);
+        sampleSchedule_onWake(byAlarm ? wake_s : 0, wakeMonotonic_us);
+#endif
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sleepSchedule_disarm(&ds3231_device));
+
+    if (!armed && !cancelled)
+    {
+        // Không hẹn được alarm (mất DS3231): thức chờ tới đầu cửa sổ
+        int64_t idle_us = (int64_t)wake_s * 1000000 - timeBase_nowUs();
+        if (idle_us > 0) {
+            vTaskDelay(pdMS_TO_TICKS(idle_us / 1000));
+        }
+    }
+#if CONFIG_USING_WIFI && CONFIG_SLEEP_SCHEDULE_LIGHT
+    if (armed && !cancelled) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_start());
+    }
+#endif
+    return !cancelled;
+}
+
+/**
+ * @brief Lịch đo: mỗi CONFIG_SLEEP_SCHEDULE_PERIOD_MIN phút một chu kỳ, ngủ (alarm DS3231) giữa các chu kỳ.
+ *        START thủ công (UART/HTTP) vẫn dùng được, lịch chỉ ngủ khi getDataFromSensor_task đang rảnh.
+ *
+ * @param parameters (bool) true nếu boot này là thức dậy từ deep sleep theo lịch: bắt đầu đo ngay.
+ */
+static void sampleSchedule_task(void *parameters)
+{
+    const uint32_t period_s = CONFIG_SLEEP_SCHEDULE_PERIOD_MIN * 60U;
+    bool startWindow = (bool)(uintptr_t)parameters;
+
+#if CONFIG_SLEEP_SCHEDULE_DEEP
+    ESP_LOGI(__func__, "⏰ Scheduled sampling every %d min, deep sleep between windows", CONFIG_SLEEP_SCHEDULE_PERIOD_MIN);
+#else
+    ESP_LOGI(__func__, "⏰ Scheduled sampling every %d min, light sleep between windows", CONFIG_SLEEP_SCHEDULE_PERIOD_MIN);
+#endif
+#if CONFIG_SLEEP_SCHEDULE_DEEP
+    if (startWindow) {
+        sampleSchedule_restoreFrames();
+    }
+#endif
+
+    for (;;)
+    {
+        if (startWindow)
+        {
+            startWindow = false;
+            xEventGroupClearBits(sampling_control_event, SAMPLING_IDLE_BIT);
+            xEventGroupSetBits(sampling_control_event, START_SAMPLING_BIT);
+            ESP_LOGI(__func__, "⏰ Sampling window started");
+        }
+#if CONFIG_TIMEBASE_SQW_ENABLE
+        // SQW bị tắt khi hẹn alarm: các frame đầu được stamp theo mốc alarm, SQW tiếp quản sau khi gán nhãn một cạnh (~1 s)
+        // Với light sleep tự động, getDataFromSensor_task bật lại SQW khi bắt đầu chu kỳ
+        if (!powerManager_lightSleepEnabled() && !timeBase_sqwRunning() &&
+            timeBase_startSqw(&ds3231_device, (gpio_num_t)CONFIG_RTC_INT_GPIO) != ESP_OK) {
+            ESP_LOGW(__func__, "⚠️  DS3231 SQW not restarted after the alarm");
+        }
+#endif
+
+        // Chờ chu kỳ đo hiện tại kết thúc
+        xEventGroupWaitBits(sampling_control_event, SAMPLING_IDLE_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+
+        int64_t now_us = timeBase_nowUs();
+        if (now_us == 0)
+        {
+            ESP_LOGW(__func__, "⚠️  No SNTP/DS3231 time, scheduled sampling waits for a valid clock");
+            vTaskDelay(pdMS_TO_TICKS(10000));
+            continue;
+        }
+        time_t wake_s = sleepSchedule_nextWindow((time_t)(now_us / 1000000), period_s, 1);
+        int64_t idle_us = (int64_t)wake_s * 1000000 - now_us;
+
+        if (idle_us < (int64_t)CONFIG_SLEEP_SCHEDULE_MIN_SLEEP_S * 1000000)
+        {
+            // Khoảng nghỉ ngắn: không đáng ngủ, chờ tới đầu cửa sổ
+            vTaskDelay(pdMS_TO_TICKS(idle_us / 1000));
+            startWindow = (xEventGroupGetBits(sampling_control_event) & SAMPLING_IDLE_BIT) != 0;
+            continue;
+        }
+        ESP_LOGI(__func__, "💤 Next sampling window in %" PRId64 " s", idle_us / 1000000);
+        startWindow = sampleSchedule_sleepUntil(wake_s);
+    }
+}
+#endif // CONFIG_SLEEP_SCHEDULE_ENABLE
+
+#if CONFIG_DASHBOARD_ENABLED
+/**
+ * @brief HTTP event handler for dashboard POST requests
+ */
+static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+{
+    switch (evt->event_id) {
+        case HTTP_EVENT_ERROR:
+            ESP_LOGD(TAG, "HTTP_EVENT_ERROR");
+            break;
+        case HTTP_EVENT_ON_CONNECTED:
+            ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
+            break;
+        case HTTP_EVENT_HEADER_SENT:
+            ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
+            break;
+        case HTTP_EVENT_ON_HEADER:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
             break;
         case HTTP_EVENT_ON_DATA:
@@ -1636,18 +2430,209 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
+// Kích thước tối đa của một object JSON mẫu (dataSensor_formatDashboardJson) và của một batch
+#if CONFIG_CALIBRATION_ENABLE
+#define DASHBOARD_SAMPLE_JSON_MAX_SIZE  (192U + 48U * ADC_CHANNEL_COUNT)  // + "ConcN" của kênh đã hiệu chuẩn
+#else
+#define DASHBOARD_SAMPLE_JSON_MAX_SIZE  (192U + 24U * ADC_CHANNEL_COUNT)
+#endif
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED && (CONFIG_DASHBOARD_BACKLOG_BATCH_RECORDS > CONFIG_DASHBOARD_BATCH_MAX_SAMPLES)
+#define DASHBOARD_BATCH_RECORDS_MAX     CONFIG_DASHBOARD_BACKLOG_BATCH_RECORDS
+#else
+#define DASHBOARD_BATCH_RECORDS_MAX     CONFIG_DASHBOARD_BATCH_MAX_SAMPLES
+#endif
+#define DASHBOARD_BATCH_BUFFER_SIZE     (DASHBOARD_BATCH_RECORDS_MAX * DASHBOARD_SAMPLE_JSON_MAX_SIZE + 2U)
+// Frame được POST lên /api/esp32/data (0: dashboard chỉ nhận event, xem EVENT_UPLOAD_FRAMES)
+#define DASHBOARD_UPLOAD_FRAMES         (!CONFIG_EVENT_DETECTOR_ENABLE || CONFIG_EVENT_UPLOAD_FRAMES)
+
+/**
+ * @brief Một mẫu chờ gửi lên dashboard: dữ liệu + thời điểm lấy mẫu (epoch µs, thời điểm nhận nếu timebase chưa có anchor).
+ *        Cũng là record của backlog trên thẻ SD (UPLOAD.JNL), nên giữ kích thước cố định
+ *        (journal có record size khác, ví dụ firmware cũ với dataSensor_st 4 kênh, được tạo lại).
+ */
+typedef struct
+{
+    int64_t time_us;
+    struct dataSensor_st sample;
+} dashboard_record_st;
+
+/**
+ * @brief Ghép các record thành một JSON array, IP (nếu có) chỉ gửi kèm record đầu tiên.
+ *
+ * @return Độ dài chuỗi, 0 nếu không đủ chỗ.
+ */
+static size_t dashboard_formatBatch(const dashboard_record_st *records, size_t count, const char *ip_str,
+                                    char *buffer, size_t size)
+{
+    size_t length = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        char time_str[64];
+        struct tm timeinfo;
+        time_t time = (time_t)(records[i].time_us / 1000000);
+        localtime_r(&time, &timeinfo);
+        size_t time_length = strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", &timeinfo);
+        snprintf(time_str + time_length, sizeof(time_str) - time_length, ".%03dZ", (int)(records[i].time_us / 1000 % 1000));
+
+        // '[' hoặc ',' đứng trước, chừa 1 byte cho ']'; không malloc, không printf số thực
+        if (size < length + 3) {
+            return 0;
+        }
+        size_t json_length = dataSensor_formatDashboardJson(&records[i].sample, time_str, (i == 0) ? ip_str : "",
+                                                            buffer + length + 1, size - length - 2);
+        if (json_length == 0) {
+            return 0;
+        }
+        buffer[length] = (i == 0) ? '[' : ',';
+        length += 1 + json_length;
+    }
+    buffer[length++] = ']';
+    buffer[length] = '\0';
+    return length;
+}
+
+static void dashboard_getIpString(char *ip_str, size_t size)
+{
+    esp_netif_ip_info_t ip_info;
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+
+    ip_str[0] = '\0';
+    if (netif != NULL) {
+        if (esp_netif_get_ip_info(netif, &ip_info) == ESP_OK && ip_info.ip.addr != 0) {
+            snprintf(ip_str, size, IPSTR, IP2STR(&ip_info.ip));
+        }
+    }
+}
+
+/**
+ * @brief Đăng ký lại IP với dashboard khi không kết nối được
+ *        (có thể IP đã thay đổi hoặc server mới online)
+ */
+static void dashboard_reRegister(const char *host, int port)
+{
+    esp_netif_ip_info_t ip_info;
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (netif == NULL || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.ip.addr == 0) {
+        return;
+    }
+
+    char retry_register_url[128];
+    char retry_register_payload[128];
+    snprintf(retry_register_url, sizeof(retry_register_url), "http://%s:%d/api/esp32/register", host, port);
+    snprintf(retry_register_payload, sizeof(retry_register_payload),
+             "{\"ip\":\"" IPSTR "\"}", IP2STR(&ip_info.ip));
+
+    esp_http_client_config_t retry_config = {
+        .url = retry_register_url,
+        .event_handler = http_event_handler,
+        .timeout_ms = 5000,
+    };
+    esp_http_client_handle_t retry_client = esp_http_client_init(&retry_config);
+    if (retry_client != NULL) {
+        esp_http_client_set_method(retry_client, HTTP_METHOD_POST);
+        esp_http_client_set_header(retry_client, "Content-Type", "application/json");
+        esp_http_client_set_post_field(retry_client, retry_register_payload, strlen(retry_register_payload));
+        esp_err_t retry_err = esp_http_client_perform(retry_client);
+        if (retry_err == ESP_OK) {
+            ESP_LOGI(TAG, "✅ IP re-registration successful during data send");
+        }
+        esp_http_client_cleanup(retry_client);
+    }
+}
+
+/**
+ * @brief POST một batch trên client keep-alive.
+ *        Socket giữ nguyên giữa các lần gửi; nếu server đã đóng kết nối nhàn rỗi thì đóng và thử lại một lần.
+ */
+static esp_err_t dashboard_postBatch(esp_http_client_handle_t client, const char *body, size_t length, int *status_code)
+{
+    esp_err_t err = ESP_FAIL;
+
+    powerManager_begin(POWER_STAGE_NETWORK);
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        esp_http_client_set_post_field(client, body, (int)length);
+        err = esp_http_client_perform(client);
+        if (err == ESP_OK) {
+            *status_code = esp_http_client_get_status_code(client);
+            break;
+        }
+        esp_http_client_close(client);
+        if (err == ESP_ERR_HTTP_CONNECT) {
+            break;  // Server không mở: không cần thử lại ngay
+        }
+    }
+    powerManager_end(POWER_STAGE_NETWORK);
+    return err;
+}
+
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED
+static sdcard_journal_st dashboard_backlog;
+
+/**
+ * @brief Lưu các record gửi thất bại vào backlog trên thẻ SD (nếu có)
+ */
+static void dashboard_storeBacklog(const dashboard_record_st *records, size_t count)
+{
+    if (!sdcard_journalIsOpen(&dashboard_backlog)) {
+        ESP_LOGW(TAG, "⚠️ No SD card backlog, %u samples dropped", (unsigned)count);
+        return;
+    }
+    if (xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) == pdTRUE)
+    {
+        uint32_t dropped = dashboard_backlog.dropped;
+        esp_err_t err = sdcard_journalAppend(&dashboard_backlog, records, count);
+        xSemaphoreGive(SDcard_semaphore);
+        if (err == ESP_OK) {
+            ESP_LOGW(TAG, "📦 %u samples stored to backlog (pending %" PRIu32 ")", (unsigned)count, sdcard_journalPending(&dashboard_backlog));
+        } else {
+            ESP_LOGE(TAG, "❌ Backlog append failed (0x%x), %u samples dropped", err, (unsigned)count);
+        }
+        if (dashboard_backlog.dropped != dropped) {
+            ESP_LOGW(TAG, "⚠️ Backlog full, %" PRIu32 " oldest samples dropped", dashboard_backlog.dropped - dropped);
+        }
+    }
+}
+#endif
+
 /**
  * @brief Task để gửi dữ liệu sensor đến dashboard qua HTTP POST
- * Không cần SD card, gửi trực tiếp qua WiFi
+ * Không cần SD card, gửi trực tiếp qua WiFi.
+ *
+ * Giữ một HTTP client keep-alive cho cả task (không bắt tay TCP/DNS cho mỗi mẫu) và gom các mẫu
+ * thành một JSON array: POST khi đủ CONFIG_DASHBOARD_BATCH_MAX_SAMPLES mẫu hoặc khi mẫu cũ nhất
+ * đã chờ CONFIG_DASHBOARD_BATCH_MAX_LATENCY_MS. IP của ESP32 chỉ gửi kèm mẫu đầu tiên của batch.
+ *
+ * Khi POST thất bại, batch được lưu vào backlog trên thẻ SD (CONFIG_DASHBOARD_BACKLOG_ENABLED).
+ * Backlog được gửi bù theo lô lớn (header "X-Backlog: 1"), tối đa một request mỗi
+ * CONFIG_DASHBOARD_BACKLOG_DRAIN_INTERVAL_MS, song song với dữ liệu live. Request gửi bù cũng là
+ * phép thử dashboard: backlog vẫn được gửi khi đã dừng đo, hoặc khi dashboard chỉ nhận event
+ * (DASHBOARD_UPLOAD_FRAMES = 0, task chỉ gửi bù backlog).
  */
 static void sendDataToDashboard_task(void *parameters)
 {
-    struct dataSensor_st dataSensorReceiveFromQueue;
+    static frameRing_reader_st dataSensorReader;
+    static char batch[DASHBOARD_BATCH_BUFFER_SIZE];
+    static dashboard_record_st batchRecords[CONFIG_DASHBOARD_BATCH_MAX_SAMPLES];
+    const int64_t batchLatency_us = (int64_t)CONFIG_DASHBOARD_BATCH_MAX_LATENCY_MS * 1000;
+    uint32_t overrunsReported = 0;
+    uint32_t batchCount = 0;
+    int64_t batchOldest_us = 0;
+    int64_t batchArrivalSum_us = 0;
+    uint32_t totalSamples = 0;
+    uint32_t totalRequests = 0;
     char url[128];
-    char json_payload[512];
-    struct tm timeinfo;
-    time_t now;
-    char time_str[64];
+    char ip_str[16];
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED
+    static dashboard_record_st backlogRecords[CONFIG_DASHBOARD_BACKLOG_BATCH_RECORDS];
+    const int64_t drainInterval_us = (int64_t)CONFIG_DASHBOARD_BACKLOG_DRAIN_INTERVAL_MS * 1000;
+    int64_t nextDrain_us = 0;
+    bool dashboardOnline = false;   // POST (live hoặc backlog) gần nhất thành công, chỉ dùng cho log
+#endif
     
     // Load dashboard config từ NVS (hoặc dùng CONFIG default)
     char dashboard_host_temp[64];
@@ -1658,146 +2643,597 @@ static void sendDataToDashboard_task(void *parameters)
     snprintf(url, sizeof(url), "http://%s:%d/api/esp32/data", 
              dashboard_host_temp, dashboard_port_temp);
     
-    ESP_LOGI(TAG, "Dashboard HTTP POST task started. URL: %s", url);
+    // Một client cho cả task: kết nối TCP được giữ lại giữa các batch (HTTP/1.1 keep-alive)
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = http_event_handler,
+        .timeout_ms = 10000, // Tăng timeout lên 10 giây
+        .skip_cert_common_name_check = true,
+        .keep_alive_enable = true,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    while (client == NULL)
+    {
+        ESP_LOGE(TAG, "❌ Failed to initialize HTTP client, retrying...");
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        client = esp_http_client_init(&config);
+    }
+    esp_http_client_set_header(client, "User-Agent", "ESP32-Client/1.0");
+    esp_http_client_set_method(client, HTTP_METHOD_POST);
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED
+    // Mở (hoặc tiếp tục) backlog còn lại từ lần chạy trước
+    if (sdcard_mounted && xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) == pdTRUE)
+    {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_journalOpen(&dashboard_backlog, "UPLOAD", "JNL", sizeof(dashboard_record_st),
+                                                         CONFIG_DASHBOARD_BACKLOG_MAX_RECORDS));
+        xSemaphoreGive(SDcard_semaphore);
+    }
+#endif
+    
+#if DASHBOARD_UPLOAD_FRAMES
+    ESP_LOGI(TAG, "Dashboard HTTP POST task started. URL: %s (batch %d samples / %d ms)", url,
+             CONFIG_DASHBOARD_BATCH_MAX_SAMPLES, CONFIG_DASHBOARD_BATCH_MAX_LATENCY_MS);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(frameRing_readerAttach(&dataSensorReader, &dataSensor_ring));
+#else
+    ESP_LOGI(TAG, "Dashboard backlog task started. URL: %s", url);
+#endif
     
     for (;;)
     {
-        // Đợi dữ liệu từ queue
-        if (xQueueReceive(dataSensorSentToDashboard_queue, (void *)&dataSensorReceiveFromQueue, 
-                         pdMS_TO_TICKS(1000)) == pdPASS)
+        // Đợi frame mới trong ring (HTTP chậm chỉ làm dashboard mất frame, không ảnh hưởng SD card).
+        // Khi batch đang mở, chỉ đợi tới hạn latency của mẫu cũ nhất; khi còn backlog, tới lượt gửi bù kế tiếp
+        int64_t deadline_us = INT64_MAX;
+        if (batchCount != 0) {
+            deadline_us = batchOldest_us + batchLatency_us;
+        }
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED
+        if (sdcard_journalPending(&dashboard_backlog) != 0 && nextDrain_us < deadline_us) {
+            deadline_us = nextDrain_us;
+        }
+#endif
+        TickType_t wait = pdMS_TO_TICKS(1000);
+        if (deadline_us != INT64_MAX)
         {
-            // Lấy thời gian hiện tại
-            time(&now);
-            localtime_r(&now, &timeinfo);
-            strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
-            
-            // Lấy IP của ESP32 để gửi kèm trong payload (giúp server lưu IP)
-            esp_netif_ip_info_t ip_info;
-            esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-            char ip_str[16] = "";
-            if (netif != NULL) {
-                if (esp_netif_get_ip_info(netif, &ip_info) == ESP_OK && ip_info.ip.addr != 0) {
-                    snprintf(ip_str, sizeof(ip_str), IPSTR, IP2STR(&ip_info.ip));
-                }
+            int64_t left_us = deadline_us - esp_timer_get_time();
+            wait = (left_us > 0) ? MIN(pdMS_TO_TICKS(left_us / 1000) + 1, wait) : NO_WAIT;
+        }
+
+#if DASHBOARD_UPLOAD_FRAMES
+        const struct dataSensor_st *dataSensorFrame = frameRing_peek(&dataSensorReader, wait);
+#else
+        const struct dataSensor_st *dataSensorFrame = NULL;
+        vTaskDelay(wait);
+#endif
+        if (dataSensorFrame != NULL)
+        {
+            dashboard_record_st *record = &batchRecords[batchCount];
+            record->sample = *dataSensorFrame;
+            if (!frameRing_commit(&dataSensorReader)) {
+                continue;   // Frame bị ghi đè trong lúc đọc
             }
-            
-            // Tạo JSON payload (bao gồm IP nếu có)
-            if (strlen(ip_str) > 0) {
-                snprintf(json_payload, sizeof(json_payload),
-                    "{"
-                    "\"Time\":\"%s\","
-                    "\"Temperature\":%.2f,"
-                    "\"Humidity\":%.2f,"
-                    "\"Pressure\":0,"
-                    "\"EtOH1\":%d,"
-                    "\"EtOH2\":%d,"
-                    "\"EtOH3\":%d,"
-                    "\"EtOH4\":%d,"
-                    "\"ip\":\"%s\""
-                    "}",
-                    time_str,
-                    dataSensorReceiveFromQueue.temperature,
-                    dataSensorReceiveFromQueue.humidity,
-                    dataSensorReceiveFromQueue.ADC_Value[0],
-                    dataSensorReceiveFromQueue.ADC_Value[1],
-                    dataSensorReceiveFromQueue.ADC_Value[2],
-                    dataSensorReceiveFromQueue.ADC_Value[3],
-                    ip_str);
-            } else {
-                snprintf(json_payload, sizeof(json_payload),
-                    "{"
-                    "\"Time\":\"%s\","
-                    "\"Temperature\":%.2f,"
-                    "\"Humidity\":%.2f,"
-                    "\"Pressure\":0,"
-                    "\"EtOH1\":%d,"
-                    "\"EtOH2\":%d,"
-                    "\"EtOH3\":%d,"
-                    "\"EtOH4\":%d"
-                    "}",
-                    time_str,
-                    dataSensorReceiveFromQueue.temperature,
-                    dataSensorReceiveFromQueue.humidity,
-                    dataSensorReceiveFromQueue.ADC_Value[0],
-                    dataSensorReceiveFromQueue.ADC_Value[1],
-                    dataSensorReceiveFromQueue.ADC_Value[2],
-                    dataSensorReceiveFromQueue.ADC_Value[3]);
+            if (dataSensorReader.overruns != overrunsReported) {
+                ESP_LOGW(TAG, "Dashboard sink fell behind, %" PRIu32 " frames skipped.", dataSensorReader.overruns - overrunsReported);
+                overrunsReported = dataSensorReader.overruns;
             }
-            
-            // Cấu hình HTTP client
-            esp_http_client_config_t config = {
-                .url = url,
-                .event_handler = http_event_handler,
-                .timeout_ms = 10000, // Tăng timeout lên 10 giây
-                .skip_cert_common_name_check = true,
-            };
-            esp_http_client_handle_t client = esp_http_client_init(&config);
-            
-            if (client != NULL) {
-                // Set headers
-                esp_http_client_set_header(client, "User-Agent", "ESP32-Client/1.0");
-                esp_http_client_set_method(client, HTTP_METHOD_POST);
-                esp_http_client_set_header(client, "Content-Type", "application/json");
-                esp_http_client_set_post_field(client, json_payload, strlen(json_payload));
-                
-                // Thực hiện POST request
-                esp_err_t err = esp_http_client_perform(client);
-                
-                if (err == ESP_OK) {
-                    int status_code = esp_http_client_get_status_code(client);
-                    int content_length = esp_http_client_get_content_length(client);
-                    
+
+            // Thời điểm lấy mẫu (không phải lúc gửi), trước khi có SNTP/DS3231 thì lấy thời gian hiện tại
+            record->time_us = (record->sample.epochOffset_us != 0) ? dataSensor_timeUs(&record->sample)
+                                                                   : (int64_t)time(NULL) * 1000000;
+            int64_t arrival_us = esp_timer_get_time();
+            if (batchCount == 0) {
+                batchOldest_us = arrival_us;
+            }
+            batchArrivalSum_us += arrival_us;
+            batchCount++;
+        }
+
+        if (batchCount != 0)
+        {
+            bool batchFull = batchCount >= CONFIG_DASHBOARD_BATCH_MAX_SAMPLES;
+            bool batchDue = (esp_timer_get_time() - batchOldest_us >= batchLatency_us) &&
+                            (batchLatency_us != 0 || frameRing_pending(&dataSensorReader) == 0);
+            if (batchFull || batchDue)
+            {
+                // Lấy IP của ESP32 để gửi kèm trong payload (giúp server lưu IP)
+                dashboard_getIpString(ip_str, sizeof(ip_str));
+                powerManager_begin(POWER_STAGE_FORMAT);
+                size_t batchLength = dashboard_formatBatch(batchRecords, batchCount, ip_str, batch, sizeof(batch));
+                powerManager_end(POWER_STAGE_FORMAT);
+
+                int status_code = 0;
+                esp_err_t err = (batchLength != 0) ? dashboard_postBatch(client, batch, batchLength, &status_code) : ESP_ERR_INVALID_SIZE;
+                int64_t done_us = esp_timer_get_time();
+
+                if (err == ESP_OK && status_code < 500) {
+                    totalRequests++;
+                    totalSamples += batchCount;
                     if (status_code == 200 || status_code == 201) {
-                        ESP_LOGI(TAG, "✅ Dashboard POST success: Status=%d, Length=%d", status_code, content_length);
+                        // Latency end-to-end: từ lúc frame có trong ring tới khi server trả lời
+                        ESP_LOGI(TAG, "✅ Dashboard POST success: Status=%d, %" PRIu32 " samples, %u bytes, latency avg %" PRId64 " ms / max %" PRId64 " ms, %.2f requests/sample",
+                                 status_code, batchCount, (unsigned)batchLength,
+                                 (done_us * batchCount - batchArrivalSum_us) / batchCount / 1000, (done_us - batchOldest_us) / 1000,
+                                 (double)totalRequests / totalSamples);
                     } else {
                         ESP_LOGW(TAG, "⚠️ Dashboard POST warning: Status=%d", status_code);
                     }
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED
+                    if (!dashboardOnline && sdcard_journalPending(&dashboard_backlog) != 0) {
+                        ESP_LOGI(TAG, "🌐 Dashboard reachable again, draining %" PRIu32 " backlog samples", sdcard_journalPending(&dashboard_backlog));
+                    }
+                    dashboardOnline = true;
+#endif
+                } else if (err == ESP_ERR_INVALID_SIZE) {
+                    ESP_LOGE(TAG, "Dashboard JSON payload does not fit in %u bytes.", (unsigned)sizeof(batch));
                 } else {
-                    ESP_LOGE(TAG, "❌ Dashboard POST failed: %s (0x%x)", esp_err_to_name(err), err);
+                    if (err == ESP_OK) {
+                        ESP_LOGE(TAG, "❌ Dashboard POST failed: Status=%d", status_code);
+                    } else {
+                        ESP_LOGE(TAG, "❌ Dashboard POST failed: %s (0x%x)", esp_err_to_name(err), err);
+                    }
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED
+                    dashboardOnline = false;
+                    dashboard_storeBacklog(batchRecords, batchCount);
+#else
+                    ESP_LOGE(TAG, "   → %" PRIu32 " samples dropped", batchCount);
+#endif
                     if (err == ESP_ERR_HTTP_CONNECT) {
                         ESP_LOGE(TAG, "   → Cannot connect to dashboard server");
                         ESP_LOGE(TAG, "   → Will retry registration on next data send");
-                        
-                        // Thử đăng ký lại IP khi gửi data thất bại
-                        // (có thể IP đã thay đổi hoặc server mới online)
-                        esp_netif_ip_info_t ip_info;
-                        esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-                        if (netif != NULL && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK && ip_info.ip.addr != 0) {
-                            char retry_register_url[128];
-                            char retry_register_payload[128];
-                            snprintf(retry_register_url, sizeof(retry_register_url), "http://%s:%d/api/esp32/register", 
-                                     dashboard_host_temp, dashboard_port_temp);
-                            snprintf(retry_register_payload, sizeof(retry_register_payload),
-                                     "{\"ip\":\"" IPSTR "\"}", IP2STR(&ip_info.ip));
-                            
-                            esp_http_client_config_t retry_config = {
-                                .url = retry_register_url,
-                                .event_handler = http_event_handler,
-                                .timeout_ms = 5000,
-                            };
-                            esp_http_client_handle_t retry_client = esp_http_client_init(&retry_config);
-                            if (retry_client != NULL) {
-                                esp_http_client_set_method(retry_client, HTTP_METHOD_POST);
-                                esp_http_client_set_header(retry_client, "Content-Type", "application/json");
-                                esp_http_client_set_post_field(retry_client, retry_register_payload, strlen(retry_register_payload));
-                                esp_err_t retry_err = esp_http_client_perform(retry_client);
-                                if (retry_err == ESP_OK) {
-                                    ESP_LOGI(TAG, "✅ IP re-registration successful during data send");
-                                }
-                                esp_http_client_cleanup(retry_client);
-                            }
-                        }
+                        dashboard_reRegister(dashboard_host_temp, dashboard_port_temp);
                     }
                 }
-                
-                esp_http_client_cleanup(client);
-            } else {
-                ESP_LOGE(TAG, "❌ Failed to initialize HTTP client");
+
+                batchCount = 0;
+                batchArrivalSum_us = 0;
+            }
+        }
+
+#if CONFIG_DASHBOARD_BACKLOG_ENABLED
+        // Gửi bù backlog: một lô lớn mỗi drain interval, không phụ thuộc frame live (request này cũng là phép thử dashboard)
+        if (sdcard_journalPending(&dashboard_backlog) != 0 && esp_timer_get_time() >= nextDrain_us)
+        {
+            size_t count = 0;
+            if (xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) == pdTRUE)
+            {
+                ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_journalRead(&dashboard_backlog, backlogRecords, CONFIG_DASHBOARD_BACKLOG_BATCH_RECORDS, &count));
+                xSemaphoreGive(SDcard_semaphore);
+            }
+
+            powerManager_begin(POWER_STAGE_FORMAT);
+            size_t backlogLength = dashboard_formatBatch(backlogRecords, count, "", batch, sizeof(batch));
+            powerManager_end(POWER_STAGE_FORMAT);
+            int status_code = 0;
+            esp_err_t err = ESP_ERR_INVALID_SIZE;
+            if (backlogLength != 0)
+            {
+                esp_http_client_set_header(client, "X-Backlog", "1");
+                err = dashboard_postBatch(client, batch, backlogLength, &status_code);
+                esp_http_client_delete_header(client, "X-Backlog");
+            }
+
+            // Lỗi phía thiết bị (record hỏng) hoặc server từ chối (4xx): bỏ lô này để backlog không bị kẹt
+            bool consume = (count != 0) && ((err == ESP_OK && status_code < 500) || err == ESP_ERR_INVALID_SIZE);
+            if (consume)
+            {
+                if (xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) == pdTRUE)
+                {
+                    ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_journalConsume(&dashboard_backlog, count));
+                    xSemaphoreGive(SDcard_semaphore);
+                }
+                if (err == ESP_OK && (status_code == 200 || status_code == 201)) {
+                    if (!dashboardOnline) {
+                        ESP_LOGI(TAG, "🌐 Dashboard reachable again, draining %" PRIu32 " backlog samples", sdcard_journalPending(&dashboard_backlog) + (uint32_t)count);
+                        dashboardOnline = true;
+                    }
+                    ESP_LOGI(TAG, "📤 Backlog: sent %u samples, %" PRIu32 " remaining", (unsigned)count, sdcard_journalPending(&dashboard_backlog));
+                } else {
+                    ESP_LOGW(TAG, "⚠️ Backlog: %u samples discarded (%s, status %d)", (unsigned)count, esp_err_to_name(err), status_code);
+                }
+            }
+            else
+            {
+                if (dashboardOnline) {
+                    ESP_LOGW(TAG, "⚠️ Backlog POST failed (%s, status %d), will retry", esp_err_to_name(err), status_code);
+                }
+                dashboardOnline = false;
+            }
+            // Dashboard không trả lời: thử lại ít nhất mỗi giây dù drain interval = 0
+            nextDrain_us = esp_timer_get_time() + ((consume || drainInterval_us >= 1000000) ? drainInterval_us : 1000000);
+        }
+#endif
+    }
+}
+
+#if CONFIG_DASHBOARD_WEBSOCKET_ENABLED
+#define DASHBOARD_WS_FRAMES_PER_MESSAGE     8U
+#define DASHBOARD_WS_FRAME_SIZE             DATA_SENSOR_STREAM_FRAME_SIZE(ADC_CHANNEL_COUNT)
+#define DASHBOARD_WS_BACKOFF_MIN_MS         1000U
+#define DASHBOARD_WS_CONNECTED_BIT          BIT0
+#define DASHBOARD_WS_DOWN_BIT               BIT1
+
+static EventGroupHandle_t dashboard_wsEvents;
+
+static void dashboard_websocketEventHandler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    switch (event_id)
+    {
+    case WEBSOCKET_EVENT_CONNECTED:
+        ESP_LOGI(TAG, "🔌 Dashboard WebSocket connected");
+        xEventGroupClearBits(dashboard_wsEvents, DASHBOARD_WS_DOWN_BIT);
+        xEventGroupSetBits(dashboard_wsEvents, DASHBOARD_WS_CONNECTED_BIT);
+        break;
+    case WEBSOCKET_EVENT_DISCONNECTED:
+    case WEBSOCKET_EVENT_CLOSED:
+    case WEBSOCKET_EVENT_ERROR:
+        xEventGroupClearBits(dashboard_wsEvents, DASHBOARD_WS_CONNECTED_BIT);
+        xEventGroupSetBits(dashboard_wsEvents, DASHBOARD_WS_DOWN_BIT);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Task đẩy mẫu realtime lên dashboard qua một kết nối WebSocket dài hạn.
+ *
+ * Mỗi frame của ring được mã hoá thành binary frame 16 + 2 x số kênh byte (dataSensor_encodeStreamFrame) và gửi
+ * ngay, các frame đang chờ được gộp tối đa DASHBOARD_WS_FRAMES_PER_MESSAGE frame mỗi message.
+ * Kết nối do task tự mở lại với backoff lũy thừa (1 s .. CONFIG_DASHBOARD_WEBSOCKET_BACKOFF_MAX_MS);
+ * ping/pong của client phát hiện kết nối chết. Khi mất kết nối frame bị bỏ qua (không lưu),
+ * dữ liệu vẫn được lưu qua sendDataToDashboard_task.
+ */
+static void streamDataToDashboard_task(void *parameters)
+{
+    static frameRing_reader_st dataSensorReader;
+    static uint8_t message[DASHBOARD_WS_FRAMES_PER_MESSAGE * DASHBOARD_WS_FRAME_SIZE];
+    char uri[96];
+    char registerMessage[96];
+    char ip_str[16];
+    uint32_t overrunsReported = 0;
+    uint32_t backoff_ms = DASHBOARD_WS_BACKOFF_MIN_MS;
+    int64_t nextConnect_us = 0;
+    bool started = false;
+    bool registered = false;
+    uint32_t framesSent = 0;
+    uint32_t framesDropped = 0;
+    uint32_t reconnects = 0;
+
+    char dashboard_host_temp[64];
+    int dashboard_port_temp;
+    get_dashboard_config(dashboard_host_temp, sizeof(dashboard_host_temp), &dashboard_port_temp);
+    snprintf(uri, sizeof(uri), "ws://%s:%d", dashboard_host_temp, CONFIG_DASHBOARD_WEBSOCKET_PORT);
+
+    esp_websocket_client_config_t config = {
+        .uri = uri,
+        .disable_auto_reconnect = true,     // Reconnect do task quản lý (backoff)
+        .ping_interval_sec = CONFIG_DASHBOARD_WEBSOCKET_PING_INTERVAL_S,
+        .pingpong_timeout_sec = CONFIG_DASHBOARD_WEBSOCKET_PING_INTERVAL_S * 3,
+        .network_timeout_ms = 5000,
+        .buffer_size = 512,
+    };
+    dashboard_wsEvents = xEventGroupCreate();
+    esp_websocket_client_handle_t client = esp_websocket_client_init(&config);
+    while (dashboard_wsEvents == NULL || client == NULL)
+    {
+        ESP_LOGE(TAG, "❌ Failed to initialize WebSocket client, retrying...");
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (dashboard_wsEvents == NULL) {
+            dashboard_wsEvents = xEventGroupCreate();
+        }
+        if (client == NULL) {
+            client = esp_websocket_client_init(&config);
+        }
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_websocket_register_events(client, WEBSOCKET_EVENT_ANY, dashboard_websocketEventHandler, NULL));
+
+    ESP_LOGI(TAG, "Dashboard WebSocket stream task started. URI: %s", uri);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(frameRing_readerAttach(&dataSensorReader, &dataSensor_ring));
+
+    for (;;)
+    {
+        EventBits_t bits = xEventGroupGetBits(dashboard_wsEvents);
+        bool connected = (bits & DASHBOARD_WS_CONNECTED_BIT) != 0;
+
+        if (!connected)
+        {
+            if (registered)
+            {
+                ESP_LOGW(TAG, "⚠️ Dashboard WebSocket lost (%" PRIu32 " frames sent, %" PRIu32 " dropped)", framesSent, framesDropped);
+                registered = false;
+            }
+            // Chỉ mở lại khi lần kết nối trước đã kết thúc hẳn và hết thời gian backoff
+            if ((!started || (bits & DASHBOARD_WS_DOWN_BIT) != 0) && esp_timer_get_time() >= nextConnect_us)
+            {
+                if (started) {
+                    esp_websocket_client_stop(client);
+                    reconnects++;
+                }
+                xEventGroupClearBits(dashboard_wsEvents, DASHBOARD_WS_DOWN_BIT);
+                started = esp_websocket_client_start(client) == ESP_OK;
+                nextConnect_us = esp_timer_get_time() + (int64_t)backoff_ms * 1000;
+                backoff_ms = MIN(backoff_ms * 2, (uint32_t)CONFIG_DASHBOARD_WEBSOCKET_BACKOFF_MAX_MS);
+            }
+        }
+        else if (!registered)
+        {
+            dashboard_getIpString(ip_str, sizeof(ip_str));
+            int registerLength = snprintf(registerMessage, sizeof(registerMessage),
+                                  "{\"type\":\"register\",\"clientType\":\"esp32\",\"ip\":\"%s\"}", ip_str);
+            if (esp_websocket_client_send_text(client, registerMessage, registerLength, pdMS_TO_TICKS(1000)) == registerLength)
+            {
+                registered = true;
+                backoff_ms = DASHBOARD_WS_BACKOFF_MIN_MS;
+                ESP_LOGI(TAG, "✅ Dashboard WebSocket stream registered (reconnects: %" PRIu32 ")", reconnects);
+            }
+        }
+
+        const struct dataSensor_st *dataSensorFrame = frameRing_peek(&dataSensorReader, pdMS_TO_TICKS(1000));
+        size_t length = 0;
+        bool encoding = (dataSensorFrame != NULL);
+        if (encoding) {
+            powerManager_begin(POWER_STAGE_FORMAT);
+        }
+        while (dataSensorFrame != NULL)
+        {
+            struct dataSensor_st sample = *dataSensorFrame;
+            if (frameRing_commit(&dataSensorReader))
+            {
+                if (registered) {
+                    int64_t time_us = dataSensor_timeUs(&sample);
+                    if (sample.epochOffset_us == 0) {
+                        struct timeval tv;
+                        gettimeofday(&tv, NULL);
+                        time_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+                    }
+                    length += dataSensor_encodeStreamFrame(&sample, time_us / 1000, &message[length]);
+                } else {
+                    framesDropped++;
+                }
+            }
+            if (length >= sizeof(message)) {
+                break;
+            }
+            dataSensorFrame = frameRing_peek(&dataSensorReader, NO_WAIT);
+        }
+        if (encoding) {
+            powerManager_end(POWER_STAGE_FORMAT);
+        }
+        if (dataSensorReader.overruns != overrunsReported) {
+            ESP_LOGW(TAG, "WebSocket sink fell behind, %" PRIu32 " frames skipped.", dataSensorReader.overruns - overrunsReported);
+            overrunsReported = dataSensorReader.overruns;
+        }
+
+        if (length != 0)
+        {
+            powerManager_begin(POWER_STAGE_NETWORK);
+            bool sent = (esp_websocket_client_send_bin(client, (const char *)message, length, pdMS_TO_TICKS(1000)) == (int)length);
+            powerManager_end(POWER_STAGE_NETWORK);
+            if (sent)
+            {
+                framesSent += length / DASHBOARD_WS_FRAME_SIZE;
+            }
+            else
+            {
+                // Gửi lỗi/timeout: coi như mất kết nối, mở lại theo backoff
+                framesDropped += length / DASHBOARD_WS_FRAME_SIZE;
+                xEventGroupClearBits(dashboard_wsEvents, DASHBOARD_WS_CONNECTED_BIT);
+                xEventGroupSetBits(dashboard_wsEvents, DASHBOARD_WS_DOWN_BIT);
             }
         }
-        
-        // Đợi một chút trước khi kiểm tra lại
-        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+}
+#endif
+#endif
+
+/*------------------------------------ EVENT DETECTION ------------------------------------ */
+
+#if CONFIG_EVENT_DETECTOR_ENABLE
+// Khoảng trống giữa hai frame lớn hơn ngưỡng này = chu kỳ đo mới (hoặc thức dậy sau sleep): học lại baseline
+#define EVENT_DETECTOR_GAP_US   ((int64_t)ADC_FRAME_PERIOD_MS * 4000)
+
+static sdcard_writer_st eventWriter;
+
+/**
+ * @brief Ghi một event vào <name>.evt của phiên đo hiện tại (mở file khi phiên đổi, header khi file mới).
+ */
+static void detectEvents_save(const char *row, size_t length)
+{
+    static char nameFileOpened[sizeof(nameFileSaveData)] = "";
+
+    if (!sdcard_mounted || xSemaphoreTake(SDcard_semaphore, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    powerManager_begin(POWER_STAGE_STORAGE);
+    if (strcmp(nameFileOpened, nameFileSaveData) != 0)
+    {
+        const sdcard_writerConfig_st writerConfig = SDCARD_WRITER_CONFIG_DEFAULT();
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerClose(&eventWriter));
+        // Mở thất bại thì không ghi nhận tên file: event sau thử mở lại
+        if (sdcard_writerOpen(&eventWriter, nameFileSaveData, "evt", &writerConfig) == ESP_OK)
+        {
+            if (eventWriter.endOffset == 0)
+            {
+                char header[EVENT_FORMAT_CSV_HEADER_MAX_SIZE];
+                size_t headerLength = eventFormat_csvHeader(ADC_CHANNEL_COUNT, header, sizeof(header));
+                ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerAppend(&eventWriter, header, headerLength));
+            }
+            strcpy(nameFileOpened, nameFileSaveData);
+        }
+    }
+    if (sdcard_writerIsOpen(&eventWriter))
+    {
+        // Event hiếm và là kết quả chính: commit ngay, không chờ lô
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerAppend(&eventWriter, row, length));
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerCommit(&eventWriter));
+    }
+    powerManager_end(POWER_STAGE_STORAGE);
+    xSemaphoreGive(SDcard_semaphore);
+}
+
+/**
+ * @brief Phát hiện event hơi thở/phơi nhiễm trên frame đã decimate (eventdetector.h).
+ *
+ * Đọc dataSensor_ring (reader riêng), đưa giá trị chuẩn hoá ±2.048 V của mọi kênh vào detector. Mỗi event kết thúc
+ * thành một record đặc trưng (baseline, peak Δ, rise time, time-to-peak, area, recovery slope của từng kênh):
+ * một dòng trong <name>.evt trên thẻ SD và một POST /api/esp32/event lên dashboard, vài giây sau khi thổi.
+ */
+static void detectEvents_task(void *parameters)
+{
+    static frameRing_reader_st dataSensorReader;
+    static eventDetector_st detector;
+    static eventDetector_event_st event;
+    static char text[MAX(EVENT_FORMAT_CSV_ROW_MAX_SIZE, EVENT_FORMAT_JSON_MAX_SIZE)];
+    const eventDetector_config_st detectorConfig = {
+        .channelCount = ADC_CHANNEL_COUNT,
+        .baselineShift = CONFIG_EVENT_BASELINE_SHIFT,
+        .onsetThreshold = CONFIG_EVENT_ONSET_THRESHOLD,
+        .onsetFrames = CONFIG_EVENT_ONSET_FRAMES,
+        .recoveryPercent = CONFIG_EVENT_RECOVERY_PERCENT,
+        .recoveryFrames = CONFIG_EVENT_RECOVERY_FRAMES,
+        .maxFrames = (uint16_t)MIN(UINT16_MAX, MAX(2U, CONFIG_EVENT_MAX_DURATION_S * 1000U / ADC_FRAME_PERIOD_MS)),
+        .settleFrames = CONFIG_EVENT_SETTLE_FRAMES,
+    };
+    int32_t values[ADC_CHANNEL_COUNT];
+    int64_t previous_us = 0;
+    uint32_t overrunsReported = 0;
+
+    if (!eventDetector_init(&detector, &detectorConfig))
+    {
+        ESP_LOGE(__func__, "Invalid event detector configuration, task stopped.");
+        vTaskDelete(NULL);
+        return;
+    }
+
+#if CONFIG_DASHBOARD_ENABLED
+    char url[128];
+    char ip_str[16];
+    char dashboard_host_temp[64];
+    int dashboard_port_temp;
+    get_dashboard_config(dashboard_host_temp, sizeof(dashboard_host_temp), &dashboard_port_temp);
+    snprintf(url, sizeof(url), "http://%s:%d/api/esp32/event", dashboard_host_temp, dashboard_port_temp);
+
+    // Client keep-alive riêng: event không phải chờ batch của sendDataToDashboard_task
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = http_event_handler,
+        .timeout_ms = 5000,
+        .skip_cert_common_name_check = true,
+        .keep_alive_enable = true,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client != NULL)
+    {
+        esp_http_client_set_header(client, "User-Agent", "ESP32-Client/1.0");
+        esp_http_client_set_method(client, HTTP_METHOD_POST);
+        esp_http_client_set_header(client, "Content-Type", "application/json");
+    }
+    else
+    {
+        ESP_LOGE(__func__, "❌ Failed to initialize HTTP client, events are only saved to SD card");
+    }
+#endif
+
+    ESP_LOGI(__func__, "Event detector started: threshold %d codes, baseline 2^-%d, max %u frames",
+             CONFIG_EVENT_ONSET_THRESHOLD, CONFIG_EVENT_BASELINE_SHIFT, (unsigned)detectorConfig.maxFrames);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(frameRing_readerAttach(&dataSensorReader, &dataSensor_ring));
+
+    for (;;)
+    {
+        const struct dataSensor_st *dataSensorFrame = frameRing_peek(&dataSensorReader, portMAX_DELAY);
+        if (dataSensorFrame == NULL) {
+            continue;
+        }
+        int64_t frame_us = dataSensorFrame->monotonic_us;
+        int64_t epochOffset_us = dataSensorFrame->epochOffset_us;
+        for (size_t i = 0; i < ADC_CHANNEL_COUNT; i++) {
+            values[i] = binlog_normalizeCenti(dataSensorFrame->ADC_Value[i], dataSensorFrame->gain[i]) / 100;
+        }
+        if (!frameRing_commit(&dataSensorReader)) {
+            continue;   // Frame bị ghi đè trong lúc đọc
+        }
+        if (dataSensorReader.overruns != overrunsReported)
+        {
+            ESP_LOGW(__func__, "Event detector fell behind, %" PRIu32 " frames skipped.", dataSensorReader.overruns - overrunsReported);
+            overrunsReported = dataSensorReader.overruns;
+        }
+
+        // Chu kỳ mới hoặc esp_timer bắt đầu lại (deep sleep): cảm biến có thể đã trôi, học lại baseline
+        if (frame_us < previous_us || frame_us - previous_us > EVENT_DETECTOR_GAP_US)
+        {
+            if (eventDetector_active(&detector)) {
+                ESP_LOGW(__func__, "Event in progress dropped (sampling stopped)");
+            }
+            eventDetector_reset(&detector);
+        }
+        previous_us = frame_us;
+
+        powerManager_begin(POWER_STAGE_FORMAT);
+        bool ended = eventDetector_push(&detector, values, frame_us, &event);
+        powerManager_end(POWER_STAGE_FORMAT);
+        if (!ended) {
+            continue;
+        }
+
+        // Mốc thời gian như Time_us của CSV (offset của frame kết thúc event)
+        int64_t start_us = event.start_us + epochOffset_us;
+        ESP_LOGI(__func__, "🌬️  Event #%" PRIu32 ": %" PRIu32 " ms, channels 0x%04x%s",
+                 event.sequence, event.duration_ms, (unsigned)event.triggerMask, event.truncated ? " (truncated)" : "");
+        for (size_t i = 0; i < event.channelCount; i++)
+        {
+            const eventDetector_features_st *features = &event.channel[i];
+            ESP_LOGI(__func__, "   Sensor%u: baseline %" PRId32 ", peak %+" PRId32 ", rise %" PRId32 " ms, peak after %" PRId32 " ms, area %" PRId32 ", slope %" PRId32 "/s",
+                     (unsigned)(i + 1), features->baseline, features->peakDelta, features->riseTime_ms,
+                     features->timeToPeak_ms, features->area, features->recoverySlope);
+        }
+
+        const classifier_result_st *classification = NULL;  // Chỉ gửi dashboard, .evt giữ đặc trưng thô để huấn luyện lại
+        (void)classification;
+#if CONFIG_CLASSIFIER_ENABLE
+        static classifier_result_st classifierResult;
+        powerManager_begin(POWER_STAGE_FORMAT);
+        int64_t classifyStart_us = esp_timer_get_time();
+        esp_err_t classifyError = classifierStore_classify(&event, &classifierResult);
+        int64_t classify_us = esp_timer_get_time() - classifyStart_us;
+        powerManager_end(POWER_STAGE_FORMAT);
+        if (classifyError == ESP_OK)
+        {
+            classification = &classifierResult;
+            ESP_LOGI(__func__, "🧪 Event #%" PRIu32 ": %s (class %u, %u%%), %lld us",
+                     event.sequence, classifierResult.label, classifierResult.classIndex, classifierResult.confidence,
+                     (long long)classify_us);
+        }
+        else if (classifyError == ESP_ERR_INVALID_SIZE)
+        {
+            ESP_LOGW(__func__, "Classifier model does not match the %u channels, event not classified", (unsigned)event.channelCount);
+        }
+#endif
+
+        powerManager_begin(POWER_STAGE_FORMAT);
+        size_t length = eventFormat_csvRow(&event, start_us, text, sizeof(text));
+        powerManager_end(POWER_STAGE_FORMAT);
+        if (length != 0) {
+            detectEvents_save(text, length);
+        }
+
+#if CONFIG_DASHBOARD_ENABLED
+        if (client == NULL) {
+            continue;
+        }
+        dashboard_getIpString(ip_str, sizeof(ip_str));
+        powerManager_begin(POWER_STAGE_FORMAT);
+        length = eventFormat_json(&event, (epochOffset_us != 0) ? start_us : (int64_t)time(NULL) * 1000000, ip_str, classification, text, sizeof(text));
+        powerManager_end(POWER_STAGE_FORMAT);
+
+        int status_code = 0;
+        esp_err_t err = (length != 0) ? dashboard_postBatch(client, text, length, &status_code) : ESP_ERR_INVALID_SIZE;
+        if (err == ESP_OK && (status_code == 200 || status_code == 201)) {
+            ESP_LOGI(__func__, "✅ Event #%" PRIu32 " sent to dashboard", event.sequence);
+        } else {
+            ESP_LOGW(__func__, "⚠️ Event #%" PRIu32 " not sent (%s, status %d), kept on SD card", event.sequence, esp_err_to_name(err), status_code);
+        }
+#endif
     }
 }
 #endif
@@ -1817,6 +3253,27 @@ static void initialize_nvs(void)
     ESP_ERROR_CHECK_WITHOUT_ABORT(error);
 }
 
+/**
+ * @brief DFS giữa CONFIG_MIN_CPU_FREQ_MHZ và CONFIG_MAX_CPU_FREQ_MHZ, tự light sleep khi rảnh
+ *        (CONFIG_FREERTOS_USE_TICKLESS_IDLE). Các stage của pipeline giữ khoá esp_pm trong lúc chạy.
+ */
+static void initialize_powerManagement(void)
+{
+#if CONFIG_PM_ENABLE
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    // UART0 không nhận khi đang ngủ: vài ký tự đầu của lệnh chỉ đánh thức chip, gửi lại lệnh nếu bị mất
+    ESP_ERROR_CHECK_WITHOUT_ABORT(uart_set_wakeup_threshold(UART_NUM_0, 3));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_sleep_enable_uart_wakeup(UART_NUM_0));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(powerManager_init(CONFIG_MAX_CPU_FREQ_MHZ, CONFIG_MIN_CPU_FREQ_MHZ, true));
+#else
+    ESP_ERROR_CHECK_WITHOUT_ABORT(powerManager_init(CONFIG_MAX_CPU_FREQ_MHZ, CONFIG_MIN_CPU_FREQ_MHZ, false));
+#endif
+#else
+    // Không có esp_pm: chỉ chạy bộ đếm (CPU luôn ở clock mặc định), làm mốc so sánh
+    powerManager_init(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, false);
+#endif
+}
+
 void app_main(void)
 {
     // esp_log_level_set("*", ESP_LOG_NONE);
@@ -1850,6 +3307,13 @@ void app_main(void)
     // Initialize nvs partition
     ESP_LOGI(__func__, "Initialize nvs partition.");
     initialize_nvs();
+#if CONFIG_CALIBRATION_ENABLE
+    // Bảng hiệu chuẩn trong NVS (không có thì mọi kênh chưa hiệu chuẩn, không phải lỗi)
+    esp_err_t calibrationError = calibrationStore_init();
+    if (calibrationError != ESP_ERR_NOT_FOUND) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(calibrationError);
+    }
+#endif
     ESP_ERROR_CHECK_WITHOUT_ABORT(esp_netif_init());
     ESP_ERROR_CHECK_WITHOUT_ABORT(esp_event_loop_create_default());
     // Wait a second for memory initialization
@@ -1867,6 +3331,7 @@ void app_main(void)
     ESP_ERROR_CHECK_WITHOUT_ABORT(uart_driver_install(UART_NUM_0, 1024, 0, 0, NULL, 0));
     ESP_ERROR_CHECK_WITHOUT_ABORT(uart_param_config(UART_NUM_0, &uart_config));
     ESP_LOGI(__func__, "✅ UART initialized for command interface");
+    initialize_powerManagement();
     
     // Create UART command handler task
     xTaskCreate(uart_command_task, "UART_Command", (1024 * 4), NULL, 10, NULL);
@@ -1886,6 +3351,15 @@ void app_main(void)
     ESP_LOGI(__func__, "SD CARD TEST MODE ENABLED - Starting SD card test...");
     start_sdcard_test();
     
+    // Giữ task chạy
+    while (1) {
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    }
+#elif defined(ENABLE_BENCHMARK_TEST_MODE)
+    // ========== CHẠY BENCHMARK ==========
+    ESP_LOGI(__func__, "BENCHMARK MODE ENABLED - Starting benchmark...");
+    start_benchmark_test();
+    
     // Giữ task chạy
     while (1) {
         vTaskDelay(1000 / portTICK_PERIOD_MS);
@@ -1908,10 +3382,33 @@ void app_main(void)
 
 #endif // CONFIG_USING_SDCARD
 
+#if CONFIG_CLASSIFIER_ENABLE
+    // Model phân loại: thẻ SD trước (thay được không cần nạp lại firmware), sau đó SPIFFS.
+    // Mỗi lần nạp (cả POST /api/classifier/reload) đọc thẻ trong SDcard_semaphore nếu thẻ đang mount
+    esp_err_t classifierError = classifierStore_init(base_path, SDcard_semaphore, sdcard_isMounted);
+    if (classifierError != ESP_ERR_NOT_FOUND) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(classifierError);
+    }
+#endif
+
     ESP_ERROR_CHECK_WITHOUT_ABORT(i2cdev_init());
+#if CONFIG_I2CDEV_SCHEDULER
+    // Task scheduler giữ bus: đọc ADC (acquisition) không phải xếp hàng sau RTC (housekeeping)
+    ESP_ERROR_CHECK_WITHOUT_ABORT(i2c_dev_scheduler_start(CONFIG_ADS111X_I2C_PORT));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(i2c_dev_scheduler_start(CONFIG_RTC_I2C_PORT));
+#endif
     
     // Initialize DS3231 RTC
     ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_initialize(&ds3231_device, CONFIG_RTC_I2C_PORT, CONFIG_RTC_PIN_NUM_SDA, CONFIG_RTC_PIN_NUM_SCL));
+    ds3231_device.priority = I2C_DEV_PRIORITY_HOUSEKEEPING;
+#if CONFIG_SLEEP_SCHEDULE_DEEP
+    // Thức dậy từ deep sleep theo lịch: thời gian lấy theo alarm DS3231 (giờ địa phương, cần TZ),
+    // system time giữ bởi RTC slow clock trong lúc ngủ không được ghi vào DS3231
+    sntp_setTimmeZoneToVN();
+    bool scheduledWake = sampleSchedule_resume();
+#else
+    __attribute__((unused)) bool scheduledWake = false;
+#endif
     
     // ========== SET THỜI GIAN CHO DS3231 ==========
     // System time của ESP32 mặc định là epoch 0 (1970), sẽ được cập nhật từ SNTP sau khi WiFi kết nối
@@ -1920,48 +3417,59 @@ void app_main(void)
     struct tm timeinfo;
     time(&now);
     localtime_r(&now, &timeinfo);
-    if (now >= 1577836800) { // Nếu system time hợp lệ (sau 2020-01-01)
+    if (now >= 1577836800 && !systemTime_fromRtc) { // Nếu system time hợp lệ (sau 2020-01-01)
         ESP_LOGI(TAG, "System time is valid, updating DS3231 from system time");
         set_ds3231_time_from_system();
-    } else {
+    } else if (now < 1577836800) {
         ESP_LOGW(TAG, "System time is invalid, waiting for SNTP sync...");
     }
     
     // Thời gian sẽ được cập nhật tự động sau khi SNTP sync thành công (nếu có WiFi)
     // Xem hàm sntp_syncTime_task() để biết chi tiết
+
+    // Timestamp của mẫu: esp_timer + epoch offset. DS3231 lưu giờ Việt Nam nên đặt TZ trước khi đọc
+    sntp_setTimmeZoneToVN();
+    if (timeBase_refresh(&ds3231_device) == ESP_OK) {
+        ESP_LOGI(TAG, "Sample timebase anchored to %s", timeBase_sourceName(timeBase_source()));
+    }
+#if CONFIG_TIMEBASE_SQW_ENABLE
+    // SQW 1 Hz: thời gian thực của mẫu và tên file không cần đọc DS3231 nữa
+    if (timeBase_startSqw(&ds3231_device, CONFIG_RTC_INT_GPIO) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️  DS3231 SQW not available on GPIO%d, timebase uses SNTP/DS3231 reads", CONFIG_RTC_INT_GPIO);
+    }
+#endif
     
-    // Create dataSensorQueue
-    dataSensorSentToSD_queue = xQueueCreate(QUEUE_SIZE, sizeof(struct dataSensor_st));
-    while (dataSensorSentToSD_queue == NULL)
+    // Create sample ring (thay cho dataSensorSentToSD/Dashboard queue)
+    while (frameRing_init(&dataSensor_ring, sizeof(struct dataSensor_st), CONFIG_FRAME_RING_CAPACITY) != ESP_OK)
     {
-        ESP_LOGE(__func__, "Create dataSensorSentToSD Queue failed.");
-        ESP_LOGI(__func__, "Retry to create dataSensorSentToSD Queue...");
+        ESP_LOGE(__func__, "Create dataSensor ring failed.");
+        ESP_LOGI(__func__, "Retry to create dataSensor ring...");
         vTaskDelay(500 / portTICK_PERIOD_MS);
-        dataSensorSentToSD_queue = xQueueCreate(QUEUE_SIZE, sizeof(struct dataSensor_st));
     };
-    ESP_LOGI(__func__, "Create dataSensorSentToSD Queue success.");
+    ESP_LOGI(__func__, "Create dataSensor ring success (%" PRIu32 " frames).", dataSensor_ring.capacity);
 
 #if CONFIG_DASHBOARD_ENABLED
-    // Create queue để gửi dữ liệu đến dashboard
-    dataSensorSentToDashboard_queue = xQueueCreate(QUEUE_SIZE, sizeof(struct dataSensor_st));
-    while (dataSensorSentToDashboard_queue == NULL)
-    {
-        ESP_LOGE(__func__, "Create dataSensorSentToDashboard Queue failed.");
-        ESP_LOGI(__func__, "Retry to create dataSensorSentToDashboard Queue...");
-        vTaskDelay(500 / portTICK_PERIOD_MS);
-        dataSensorSentToDashboard_queue = xQueueCreate(QUEUE_SIZE, sizeof(struct dataSensor_st));
-    };
-    ESP_LOGI(__func__, "Create dataSensorSentToDashboard Queue success.");
     
     // Load dashboard config từ NVS khi khởi động
     char dashboard_host_temp[64];
     int dashboard_port_temp;
     get_dashboard_config(dashboard_host_temp, sizeof(dashboard_host_temp), &dashboard_port_temp);
     
-    // Create task để gửi dữ liệu đến dashboard qua HTTP POST (không cần SD card)
+#if DASHBOARD_UPLOAD_FRAMES || CONFIG_DASHBOARD_BACKLOG_ENABLED
+    // Create task để gửi dữ liệu đến dashboard qua HTTP POST (không cần SD card), khi chỉ gửi event thì task chỉ gửi bù backlog
     xTaskCreate(sendDataToDashboard_task, "SendDataToDashboard", (1024 * 8), NULL, 15, NULL);
     ESP_LOGI(__func__, "Dashboard HTTP POST task created. Target: http://%s:%d/api/esp32/data", 
              dashboard_host_temp, dashboard_port_temp);
+#else
+    (void)sendDataToDashboard_task;
+#endif
+#if !DASHBOARD_UPLOAD_FRAMES
+    ESP_LOGI(__func__, "Dashboard receives events only: http://%s:%d/api/esp32/event", dashboard_host_temp, dashboard_port_temp);
+#endif
+#if CONFIG_DASHBOARD_WEBSOCKET_ENABLED
+    // Stream realtime qua WebSocket, song song với HTTP POST (lưu trữ)
+    xTaskCreate(streamDataToDashboard_task, "StreamToDashboard", (1024 * 6), NULL, 16, NULL);
+#endif
 #endif
 
     // Khởi tạo sampling control event trước khi tạo task
@@ -1971,10 +3479,23 @@ void app_main(void)
     // Create task to get data from sensor (32Kb stack memory| priority 25(max))
     // Period 5000ms
     xTaskCreate(getDataFromSensor_task, "GetDataSensor", (1024 * 32), NULL, 24, &getDataFromSensorTask_handle);
+#if CONFIG_ENV_SENSOR_USE
+    // Nhiệt độ/độ ẩm đọc theo chu kỳ riêng của cảm biến, tách khỏi luồng ADC
+    xTaskCreate(getEnvironmentData_task, "GetEnvironment", (1024 * 4), NULL, 20, &getEnvironmentDataTask_handle);
+#endif
 
     // Create task to save data from sensor read by getDataFromSensor_task() to SD card (16Kb stack memory| priority 10)
     // Period 5000ms
     xTaskCreate(saveDataSensorToSDcard_task, "SaveDataSensor", (1024 * 16), NULL, (UBaseType_t)19, &saveDataSensorToSDcardTask_handle);
+#if CONFIG_EVENT_DETECTOR_ENABLE
+    // Event detector: reader thứ tư của ring, record đặc trưng lên thẻ SD và dashboard
+    xTaskCreate(detectEvents_task, "DetectEvents", (1024 * 6), NULL, 17, NULL);
+#endif
+
+#if CONFIG_SLEEP_SCHEDULE_ENABLE
+    // Lịch đo theo alarm DS3231, chạy sau các sink để frame giữ qua deep sleep được ghi trước chu kỳ mới
+    xTaskCreate(sampleSchedule_task, "SampleSchedule", (1024 * 4), (void *)(uintptr_t)scheduledWake, 18, NULL);
+#endif
 
 #if CONFIG_USING_WIFI
     WIFI_initSTA();
@@ -0,0 +1,545 @@
+/**
+ * @file test_benchmark.c
+ * @brief Benchmark hiệu năng trên thiết bị thật (thẻ SD, CPU).
+ *
+ * SD card: so sánh ghi từng dòng bằng sdcard_writeDataToFile() (open/fsync/close mỗi dòng)
+ * với session writer (mở file một lần, commit theo lô). Kết quả: rows/s và số fsync mỗi dòng.
+ *
+ * Serializer: so sánh đường snprintf cũ (CSV: vsnprintf + malloc, JSON: snprintf "%.2f") với
+ * dataSensor_formatCsvRow()/dataSensor_formatDashboardJson(). Kết quả: ns/record và số lần
+ * cấp phát heap mỗi record (cần bật CONFIG_HEAP_USE_HOOKS để đếm).
+ *
+ * Calibration: calibration_apply() (lookup table số nguyên) trên frame 16 kênh so với tính
+ * đường cong log-log bằng số thực (powf). Kết quả: cycle/frame.
+ *
+ * Classifier: classifier_run() (đặc trưng + MLP int8) trên event 4 và 16 kênh với model lớn nhất
+ * (32 neuron ẩn, 8 lớp). Kết quả: µs và cycle mỗi event.
+ *
+ * Frame ring: stress test một producer / nhiều consumer (một nhanh, một chậm, khác core).
+ * Kiểm tra thứ tự sequence và checksum từng frame, kết quả: frames/s, số frame mất
+ * (overrun) và số frame bị ghi đè trong lúc đọc (torn) của mỗi consumer.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "sdcard.h"
+#include "datamanager.h"
+#include "framering.h"
+#include "calibration.h"
+#include "classifier.h"
+#include "test_benchmark.h"
+
+static const char *TAG = "BENCHMARK";
+
+#define BENCHMARK_SD_ROWS           256U
+#define BENCHMARK_SERIALIZER_RECORDS 2000U
+#define BENCHMARK_CALIBRATION_FRAMES 10000U
+#define BENCHMARK_CLASSIFIER_EVENTS 2000U
+#define BENCHMARK_RING_FRAMES       200000U
+#define BENCHMARK_RING_CONSUMERS    2U
+
+#if CONFIG_HEAP_USE_HOOKS
+static volatile uint32_t benchmark_allocCount = 0;
+
+// Hook của heap component, được gọi cho mọi lần cấp phát trên hệ thống
+void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    benchmark_allocCount++;
+}
+
+void esp_heap_trace_free_hook(void *ptr)
+{
+}
+#define BENCHMARK_ALLOC_COUNT() (benchmark_allocCount)
+#else
+#define BENCHMARK_ALLOC_COUNT() (0U)
+#endif
+
+uint32_t benchmark_allocationCount(void)
+{
+    return BENCHMARK_ALLOC_COUNT();
+}
+
+static void benchmark_fillSample(struct dataSensor_st *sample, uint32_t index)
+{
+    sample->timeStamp = (int)index;
+    sample->monotonic_us = 5000000 + (int64_t)index * 100000;
+    sample->epochOffset_us = 1760000000000000;
+    sample->temperature = 25.0f + (float)(index % 50) / 10.0f;
+    sample->humidity = 60.0f + (float)(index % 30) / 10.0f;
+    sample->pressure = 0;
+    sample->channelCount = 4;   // Cùng layout với dataSensor_templateSaveToSDCard
+    for (size_t i = 0; i < 4; i++) {
+        sample->ADC_Value[i] = (int16_t)(11000 + index * 7 + i * 1000);
+        sample->gain[i] = BINLOG_REFERENCE_GAIN;
+        sample->concentration[i] = CALIBRATION_VALUE_NONE;
+    }
+}
+
+static void benchmark_report(const char *name, uint32_t rows, uint32_t syncs, int64_t elapsed_us)
+{
+    double seconds = (double)elapsed_us / 1e6;
+    ESP_LOGI(TAG, "%-24s rows=%" PRIu32 " time=%.3f s  %.1f rows/s  %.3f fsync/row",
+             name, rows, seconds, seconds > 0 ? rows / seconds : 0.0, rows ? (double)syncs / rows : 0.0);
+}
+
+/**
+ * @brief Đường format CSV cũ của sdcard_writeDataToFile(): đo độ dài, malloc, format, free
+ */
+static size_t benchmark_legacyCsvRow(char *out, size_t size, const char *format, ...)
+{
+    va_list argumentsList;
+    va_list argumentsList_copy;
+    va_start(argumentsList, format);
+    va_copy(argumentsList_copy, argumentsList);
+    int length = vsnprintf(NULL, 0, format, argumentsList_copy);
+    va_end(argumentsList_copy);
+
+    char *dataString = (char *)malloc((size_t)length + 1);
+    if (dataString != NULL)
+    {
+        vsnprintf(dataString, (size_t)length + 1, format, argumentsList);
+        strlcpy(out, dataString, size);
+        free(dataString);
+    }
+    va_end(argumentsList);
+    return (size_t)length;
+}
+
+static void benchmark_reportSerializer(const char *name, int64_t elapsed_us, uint32_t allocations, size_t bytes)
+{
+    ESP_LOGI(TAG, "%-24s %6" PRIu32 " ns/record  %.2f alloc/record  %u bytes/record", name,
+             (uint32_t)(elapsed_us * 1000 / BENCHMARK_SERIALIZER_RECORDS),
+#if CONFIG_HEAP_USE_HOOKS
+             (double)allocations / BENCHMARK_SERIALIZER_RECORDS,
+#else
+             -1.0,
+#endif
+             (unsigned)(bytes / BENCHMARK_SERIALIZER_RECORDS));
+}
+
+/**
+ * @brief So sánh các đường format CSV/JSON (chỉ CPU, không ghi thẻ)
+ */
+static void benchmark_serializer(void)
+{
+    struct dataSensor_st sample;
+    char buffer[512];
+    size_t bytes;
+    int64_t start;
+    uint32_t allocations;
+
+#if !CONFIG_HEAP_USE_HOOKS
+    ESP_LOGW(TAG, "CONFIG_HEAP_USE_HOOKS is disabled, alloc/record is not measured (-1).");
+#endif
+
+    bytes = 0;
+    allocations = BENCHMARK_ALLOC_COUNT();
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < BENCHMARK_SERIALIZER_RECORDS; i++)
+    {
+        benchmark_fillSample(&sample, i);
+        bytes += benchmark_legacyCsvRow(buffer, sizeof(buffer), dataSensor_templateSaveToSDCard,
+                                        sample.timeStamp, sample.temperature, sample.humidity,
+                                        sample.ADC_Value[0], sample.ADC_Value[1],
+                                        sample.ADC_Value[2], sample.ADC_Value[3]);
+    }
+    benchmark_reportSerializer("CSV vsnprintf+malloc", esp_timer_get_time() - start, BENCHMARK_ALLOC_COUNT() - allocations, bytes);
+
+    bytes = 0;
+    allocations = BENCHMARK_ALLOC_COUNT();
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < BENCHMARK_SERIALIZER_RECORDS; i++)
+    {
+        benchmark_fillSample(&sample, i);
+        bytes += dataSensor_formatCsvRow(&sample, buffer, sizeof(buffer));
+    }
+    benchmark_reportSerializer("CSV dataSensor_format", esp_timer_get_time() - start, BENCHMARK_ALLOC_COUNT() - allocations, bytes);
+
+    bytes = 0;
+    allocations = BENCHMARK_ALLOC_COUNT();
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < BENCHMARK_SERIALIZER_RECORDS; i++)
+    {
+        benchmark_fillSample(&sample, i);
+        bytes += (size_t)snprintf(buffer, sizeof(buffer),
+                                  "{\"Time\":\"%s\",\"Temperature\":%.2f,\"Humidity\":%.2f,\"Pressure\":0,"
+                                  "\"EtOH1\":%d,\"EtOH2\":%d,\"EtOH3\":%d,\"EtOH4\":%d,\"ip\":\"%s\"}",
+                                  "2024-01-01T00:00:00Z", sample.temperature, sample.humidity,
+                                  sample.ADC_Value[0], sample.ADC_Value[1], sample.ADC_Value[2], sample.ADC_Value[3],
+                                  "192.168.1.100");
+    }
+    benchmark_reportSerializer("JSON snprintf", esp_timer_get_time() - start, BENCHMARK_ALLOC_COUNT() - allocations, bytes);
+
+    bytes = 0;
+    allocations = BENCHMARK_ALLOC_COUNT();
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < BENCHMARK_SERIALIZER_RECORDS; i++)
+    {
+        benchmark_fillSample(&sample, i);
+        bytes += dataSensor_formatDashboardJson(&sample, "2024-01-01T00:00:00Z", "192.168.1.100", buffer, sizeof(buffer));
+    }
+    benchmark_reportSerializer("JSON dataSensor_format", esp_timer_get_time() - start, BENCHMARK_ALLOC_COUNT() - allocations, bytes);
+}
+
+/**
+ * @brief Chi phí chuyển một frame 16 kênh sang nồng độ: LUT số nguyên so với công thức số thực
+ */
+static void benchmark_calibration(void)
+{
+    static calibration_table_st table;
+    static calibration_engine_st engine;
+    int32_t codes[CALIBRATION_CHANNEL_MAX];
+    int32_t values[CALIBRATION_CHANNEL_MAX];
+    volatile int32_t sink = 0;
+
+    table.channelCount = CALIBRATION_CHANNEL_MAX;
+    for (uint8_t i = 0; i < CALIBRATION_CHANNEL_MAX; i++)
+    {
+        table.curve[i] = (calibration_curve_st){
+            .type = CALIBRATION_CURVE_LOGLOG, .pointCount = 3, .tRef_centi = 2500, .hRef_centi = 5000,
+            .tempCoeff_ppm = -3000, .humCoeff_ppm = 1000,
+            .point = {{11500, 50}, {14000, 250}, {20000, 1500}},
+        };
+    }
+    if (!calibration_build(&engine, &table))
+    {
+        ESP_LOGE(TAG, "calibration_build failed");
+        return;
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint32_t f = 0; f < BENCHMARK_CALIBRATION_FRAMES; f++)
+    {
+        for (uint8_t i = 0; i < CALIBRATION_CHANNEL_MAX; i++) {
+            codes[i] = (int32_t)(11000 + (f * 7 + i * 613) % 10000);
+        }
+        calibration_apply(&engine, codes, CALIBRATION_CHANNEL_MAX, 2730, 4500, values);
+        sink += values[f % CALIBRATION_CHANNEL_MAX];
+    }
+    uint32_t lutCycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (uint32_t f = 0; f < BENCHMARK_CALIBRATION_FRAMES; f++)
+    {
+        for (uint8_t i = 0; i < CALIBRATION_CHANNEL_MAX; i++)
+        {
+            // Đoạn giữa của đường cong, tính trực tiếp mỗi frame
+            float code = (float)(11000 + (f * 7 + i * 613) % 10000);
+            float value = 250.0f * powf(code / 14000.0f, 5.0227f);
+            values[i] = (int32_t)(value * (1.0f - 0.003f * 2.30f + 0.001f * -5.0f));
+        }
+        sink += values[f % CALIBRATION_CHANNEL_MAX];
+    }
+    uint32_t floatCycles = esp_cpu_get_cycle_count() - start;
+
+    // Cả hai vòng gồm cả phần tạo code giả lập
+    ESP_LOGI(TAG, "%-24s %6" PRIu32 " cycles/frame (%u channels)", "Calibration LUT",
+             lutCycles / BENCHMARK_CALIBRATION_FRAMES, (unsigned)CALIBRATION_CHANNEL_MAX);
+    ESP_LOGI(TAG, "%-24s %6" PRIu32 " cycles/frame (%u channels)", "Calibration powf",
+             floatCycles / BENCHMARK_CALIBRATION_FRAMES, (unsigned)CALIBRATION_CHANNEL_MAX);
+    (void)sink;
+}
+
+/**
+ * @brief Chi phí phân loại một event, model kích thước tối đa với trọng số giả ngẫu nhiên
+ */
+static void benchmark_classifier(uint8_t channelCount)
+{
+    static classifier_model_st model;
+    static eventDetector_event_st events[4];
+    classifier_result_st result;
+    uint32_t seed = 1;
+    volatile uint32_t sink = 0;
+
+    memset(&model, 0, sizeof(model));
+    model.channelCount = channelCount;
+    model.inputCount = CLASSIFIER_INPUTS(channelCount);
+    model.hiddenCount = CLASSIFIER_HIDDEN_MAX;
+    model.classCount = CLASSIFIER_CLASS_MAX;
+    model.hiddenShift = 8;
+    model.minConfidence = 60;
+    model.logitScaleQ16 = 256;
+    for (uint8_t c = 0; c < CLASSIFIER_CLASS_MAX; c++)
+    {
+        snprintf(model.label[c], CLASSIFIER_LABEL_SIZE, "class%u", c);
+        for (uint8_t h = 0; h < CLASSIFIER_HIDDEN_MAX; h++) {
+            model.outputWeight[c][h] = (int8_t)((seed = seed * 1103515245U + 12345U) >> 24);
+        }
+    }
+    for (uint8_t i = 0; i < model.inputCount; i++)
+    {
+        model.inputOffset[i] = 100;
+        model.inputScaleQ16[i] = 65536 / 8;
+        for (uint8_t h = 0; h < CLASSIFIER_HIDDEN_MAX; h++) {
+            model.hiddenWeight[h][i] = (int8_t)((seed = seed * 1103515245U + 12345U) >> 24);
+        }
+    }
+    if (!classifier_validate(&model))
+    {
+        ESP_LOGE(TAG, "classifier model invalid");
+        return;
+    }
+    for (uint8_t e = 0; e < sizeof(events) / sizeof(events[0]); e++)
+    {
+        memset(&events[e], 0, sizeof(events[e]));
+        events[e].channelCount = channelCount;
+        events[e].duration_ms = 15000 + e * 1000;
+        for (uint8_t i = 0; i < channelCount; i++)
+        {
+            events[e].channel[i] = (eventDetector_features_st){
+                .baseline = 12000, .peakDelta = 400 + 150 * ((i + e) % 5), .onsetDelay_ms = 200 * i,
+                .riseTime_ms = 3000 + 100 * i, .timeToPeak_ms = 4000 + 100 * e, .area = 3000 + 700 * i, .recoverySlope = -40,
+            };
+        }
+    }
+
+    uint32_t startCycles = esp_cpu_get_cycle_count();
+    int64_t start = esp_timer_get_time();
+    for (uint32_t n = 0; n < BENCHMARK_CLASSIFIER_EVENTS; n++)
+    {
+        classifier_run(&model, &events[n % (sizeof(events) / sizeof(events[0]))], &result);
+        sink += result.classIndex;
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+    uint32_t cycles = esp_cpu_get_cycle_count() - startCycles;
+
+    ESP_LOGI(TAG, "%-24s %7.2f us/event  %6" PRIu32 " cycles/event (%u channels, %u inputs, %u hidden, %u classes)",
+             "Classifier MLP int8", (double)elapsed_us / BENCHMARK_CLASSIFIER_EVENTS, cycles / BENCHMARK_CLASSIFIER_EVENTS,
+             channelCount, model.inputCount, model.hiddenCount, model.classCount);
+    (void)sink;
+}
+
+/**
+ * @brief Ghi từng dòng: mỗi dòng là một lần fopen + fsync + fclose
+ */
+static void benchmark_sdcardPerRow(void)
+{
+    struct dataSensor_st sample;
+    sdcard_removeFile("BENCH1");
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < BENCHMARK_SD_ROWS; i++)
+    {
+        benchmark_fillSample(&sample, i);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writeDataToFile("BENCH1", dataSensor_templateSaveToSDCard,
+                                                             sample.timeStamp, sample.temperature, sample.humidity,
+                                                             sample.ADC_Value[0], sample.ADC_Value[1],
+                                                             sample.ADC_Value[2], sample.ADC_Value[3]));
+    }
+    benchmark_report("sdcard_writeDataToFile", BENCHMARK_SD_ROWS, BENCHMARK_SD_ROWS, esp_timer_get_time() - start);
+}
+
+/**
+ * @brief Ghi qua session writer với policy mặc định từ menuconfig
+ */
+static void benchmark_sdcardWriter(void)
+{
+    struct dataSensor_st sample;
+    sdcard_writer_st writer;
+    sdcard_removeFile("BENCH2");
+
+    int64_t start = esp_timer_get_time();
+    if (sdcard_writerOpen(&writer, "BENCH2", "csv", NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot open session writer.");
+        return;
+    }
+    for (uint32_t i = 0; i < BENCHMARK_SD_ROWS; i++)
+    {
+        benchmark_fillSample(&sample, i);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerPrintf(&writer, dataSensor_templateSaveToSDCard,
+                                                          sample.timeStamp, sample.temperature, sample.humidity,
+                                                          sample.ADC_Value[0], sample.ADC_Value[1],
+                                                          sample.ADC_Value[2], sample.ADC_Value[3]));
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sdcard_writerClose(&writer));
+    benchmark_report("sdcard_writer", writer.totalRows, writer.totalSyncs, esp_timer_get_time() - start);
+}
+
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t payload[6];
+    uint32_t check;
+} benchmark_ringFrame_st;
+
+typedef struct
+{
+    uint32_t stallEvery;        /*!< Consumer chậm: dừng 1 tick mỗi stallEvery frame, 0 = không dừng */
+    uint32_t consumed;
+    uint32_t overruns;
+    uint32_t torn;
+    uint32_t orderErrors;
+} benchmark_ringConsumer_st;
+
+static frameRing_st benchmark_ring;
+static volatile bool benchmark_ringDone = false;
+static SemaphoreHandle_t benchmark_ringSemaphore = NULL;
+
+static uint32_t benchmark_ringChecksum(const benchmark_ringFrame_st *frame)
+{
+    uint32_t check = frame->sequence;
+    for (size_t i = 0; i < 6; i++) {
+        check ^= frame->payload[i] + (uint32_t)i;
+    }
+    return check;
+}
+
+static void benchmark_ringConsumerTask(void *pvParameters)
+{
+    benchmark_ringConsumer_st *consumer = (benchmark_ringConsumer_st *)pvParameters;
+    frameRing_reader_st reader;
+    bool first = true;
+    uint32_t last = 0;
+
+    ESP_ERROR_CHECK_WITHOUT_ABORT(frameRing_readerAttach(&reader, &benchmark_ring));
+    xSemaphoreGive(benchmark_ringSemaphore);
+
+    for (;;)
+    {
+        const benchmark_ringFrame_st *peeked = frameRing_peek(&reader, 1);
+        if (peeked == NULL)
+        {
+            if (benchmark_ringDone && frameRing_pending(&reader) == 0) {
+                break;
+            }
+            continue;
+        }
+
+        benchmark_ringFrame_st frame = *peeked;
+        if (consumer->stallEvery != 0 && frame.sequence % consumer->stallEvery == 0) {
+            vTaskDelay(1);
+        }
+        if (!frameRing_commit(&reader)) {
+            consumer->torn++;
+            continue;
+        }
+        if (benchmark_ringChecksum(&frame) != frame.check || (!first && frame.sequence <= last)) {
+            consumer->orderErrors++;
+        }
+        first = false;
+        last = frame.sequence;
+        consumer->consumed++;
+    }
+
+    consumer->overruns = reader.overruns;
+    frameRing_readerDetach(&reader);
+    xSemaphoreGive(benchmark_ringSemaphore);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Stress test frame ring: producer ghi liên tục, consumer nhanh và consumer chậm đọc song song
+ */
+static void benchmark_frameRing(void)
+{
+    static benchmark_ringConsumer_st consumers[BENCHMARK_RING_CONSUMERS];
+
+    if (frameRing_init(&benchmark_ring, sizeof(benchmark_ringFrame_st), 32) != ESP_OK) {
+        ESP_LOGE(TAG, "⚠️ Cannot allocate frame ring, skip ring benchmark.");
+        return;
+    }
+    benchmark_ringSemaphore = xSemaphoreCreateCounting(BENCHMARK_RING_CONSUMERS, 0);
+    benchmark_ringDone = false;
+    memset(consumers, 0, sizeof(consumers));
+    consumers[1].stallEvery = 1000;
+
+    for (size_t i = 0; i < BENCHMARK_RING_CONSUMERS; i++)
+    {
+        xTaskCreatePinnedToCore(benchmark_ringConsumerTask, "ring_consumer", 4096, &consumers[i], 6, NULL,
+                                (BaseType_t)((i + 1) % portNUM_PROCESSORS));
+    }
+    for (size_t i = 0; i < BENCHMARK_RING_CONSUMERS; i++) {
+        xSemaphoreTake(benchmark_ringSemaphore, portMAX_DELAY);
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t sequence = 0; sequence < BENCHMARK_RING_FRAMES; sequence++)
+    {
+        benchmark_ringFrame_st *frame = frameRing_reserve(&benchmark_ring);
+        frame->sequence = sequence;
+        for (size_t i = 0; i < 6; i++) {
+            frame->payload[i] = sequence * 2654435761U + (uint32_t)i;
+        }
+        frame->check = benchmark_ringChecksum(frame);
+        frameRing_publish(&benchmark_ring);
+        if ((sequence & 15U) == 0) {
+            taskYIELD();
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+    benchmark_ringDone = true;
+
+    for (size_t i = 0; i < BENCHMARK_RING_CONSUMERS; i++) {
+        xSemaphoreTake(benchmark_ringSemaphore, portMAX_DELAY);
+    }
+
+    ESP_LOGI(TAG, "frame_ring producer       %" PRIu32 " frames  %.1f kframes/s", BENCHMARK_RING_FRAMES,
+             elapsed_us > 0 ? BENCHMARK_RING_FRAMES * 1000.0 / elapsed_us : 0.0);
+    for (size_t i = 0; i < BENCHMARK_RING_CONSUMERS; i++)
+    {
+        benchmark_ringConsumer_st *consumer = &consumers[i];
+        ESP_LOGI(TAG, "frame_ring consumer %u (%s) consumed=%" PRIu32 " overruns=%" PRIu32 " torn=%" PRIu32 " orderErrors=%" PRIu32 " %s",
+                 (unsigned)i, consumer->stallEvery ? "slow" : "fast", consumer->consumed, consumer->overruns,
+                 consumer->torn, consumer->orderErrors,
+                 (consumer->orderErrors == 0 && consumer->consumed + consumer->overruns == BENCHMARK_RING_FRAMES) ? "✅" : "❌");
+    }
+
+    vSemaphoreDelete(benchmark_ringSemaphore);
+    frameRing_deinit(&benchmark_ring);
+}
+
+static void benchmark_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "---- Benchmark ----");
+
+    benchmark_serializer();
+    benchmark_calibration();
+    benchmark_classifier(4);
+    benchmark_classifier(EVENT_DETECTOR_CHANNEL_MAX);
+    benchmark_frameRing();
+
+    esp_vfs_fat_mount_config_t mount_config = MOUNT_CONFIG_DEFAULT();
+    spi_bus_config_t bus_config = SPI_BUS_CONFIG_DEFAULT();
+    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
+    sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
+    sdmmc_card_t *card = NULL;
+
+    if (sdcard_initialize(&mount_config, &card, &host, &bus_config, &slot_config) == ESP_OK)
+    {
+        // Tắt log INFO của FileManager để không đo thời gian in log
+        esp_log_level_set("sdcard_writeDataToFile", ESP_LOG_WARN);
+        esp_log_level_set("SDcard", ESP_LOG_WARN);
+        esp_log_level_set("sdcard_writerCommit", ESP_LOG_WARN);
+
+        benchmark_sdcardPerRow();
+        benchmark_sdcardWriter();
+
+        sdcard_removeFile("BENCH1");
+        sdcard_removeFile("BENCH2");
+        sdcard_deinitialize(mount_point, card, &host);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "⚠️ SD card not available, skip SD benchmark.");
+    }
+
+    ESP_LOGI(TAG, "Benchmark done.");
+    vTaskDelete(NULL);
+}
+
+void start_benchmark_test(void)
+{
+    xTaskCreate(benchmark_task, "benchmark_task", 8192, NULL, 5, NULL);
+    ESP_LOGI(TAG, "Benchmark task created");
+}
@@ -0,0 +1,29 @@
+/**
+ * @file test_benchmark.h
+ * @brief Benchmark hiệu năng các đường ghi/xử lý dữ liệu trên thiết bị
+ */
+
+#ifndef TEST_BENCHMARK_H
+#define TEST_BENCHMARK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bắt đầu benchmark (tạo task riêng), kết quả in ra log
+ */
+void start_benchmark_test(void);
+
+/**
+ * @brief Số lần cấp phát heap trên toàn hệ thống từ lúc khởi động (cần CONFIG_HEAP_USE_HOOKS, không có thì luôn 0)
+ */
+uint32_t benchmark_allocationCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_BENCHMARK_H */
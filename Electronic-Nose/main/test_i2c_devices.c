@@ -7,12 +7,16 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <inttypes.h>
 
 #include "sdkconfig.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 #include "driver/i2c.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -20,8 +24,10 @@
 #include "DS3231Time.h"
 #include "ds3231.h"
 #include "ADS111x.h"
+#include "envsensor.h"
 #include "i2cdev.h"
 #include "test_i2c_devices.h"
+#include "test_benchmark.h"
 
 static const char *TAG = "I2C_TEST";
 
@@ -49,27 +55,18 @@ void i2c_scan_bus(void)
     ESP_LOGI(TAG, "SDA: GPIO%d, SCL: GPIO%d", I2C_SDA_PIN, I2C_SCL_PIN);
     ESP_LOGI(TAG, "========================================");
     
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_SDA_PIN,
-        .scl_io_num = I2C_SCL_PIN,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = 100000,  // 100kHz để scan an toàn
+    // Scan qua i2c_dev_probe: chạy được với cả hai backend của i2cdev (legacy / i2c_master)
+    i2c_dev_t probe = {
+        .port = I2C_PORT,
+        .cfg = {
+            .sda_io_num = I2C_SDA_PIN,
+            .scl_io_num = I2C_SCL_PIN,
+            .sda_pullup_en = GPIO_PULLUP_ENABLE,
+            .scl_pullup_en = GPIO_PULLUP_ENABLE,
+            .master.clk_speed = 100000,  // 100kHz để scan an toàn
+        },
     };
     
-    esp_err_t ret = i2c_param_config(I2C_PORT, &conf);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "i2c_param_config failed: %s", esp_err_to_name(ret));
-        return;
-    }
-    
-    ret = i2c_driver_install(I2C_PORT, I2C_MODE_MASTER, 0, 0, 0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "i2c_driver_install failed: %s", esp_err_to_name(ret));
-        return;
-    }
-    
     uint8_t address;
     int devices_found = 0;
     
@@ -82,13 +79,8 @@ void i2c_scan_bus(void)
             printf("\n%02x:", address);
         }
         
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_stop(cmd);
-        
-        esp_err_t ret = i2c_master_cmd_begin(I2C_PORT, cmd, pdMS_TO_TICKS(50));
-        i2c_cmd_link_delete(cmd);
+        probe.addr = address;
+        esp_err_t ret = i2c_dev_probe(&probe, I2C_DEV_WRITE);
         
         if (ret == ESP_OK) {
             printf(" %02x", address);
@@ -121,7 +113,6 @@ void i2c_scan_bus(void)
     }
     ESP_LOGI(TAG, "========================================\n");
     
-    i2c_driver_delete(I2C_PORT);
     vTaskDelay(500 / portTICK_PERIOD_MS);
 }
 
@@ -245,6 +236,524 @@ esp_err_t test_ads111x(void)
     return ESP_OK;
 }
 
+/**
+ * @brief Test đọc ADS111x theo ALERT/RDY: quét 4 kênh ở 128 SPS và 860 SPS, in tốc độ quét
+ *        và số lần timeout (GPIO cấu hình bằng CONFIG_ADS111X_ALERT_RDY_GPIO, -1 = poll OS bit)
+ */
+esp_err_t test_ads111x_conversion_ready(void)
+{
+    static const ads111x_mux_t channels[4] = {ADS111X_MUX_0_GND, ADS111X_MUX_1_GND, ADS111X_MUX_2_GND, ADS111X_MUX_3_GND};
+    static const ads111x_data_rate_t rates[] = {ADS111X_DATA_RATE_128, ADS111X_DATA_RATE_860};
+    const int scans = 100;
+    ads111x_rdy_t acquisition;
+    esp_err_t ret = ESP_OK;
+
+    ESP_LOGI(TAG, "----------------------------------------");
+    ESP_LOGI(TAG, "TESTING ADS111x CONVERSION-READY (ALERT/RDY GPIO %d)", CONFIG_ADS111X_ALERT_RDY_GPIO);
+    ESP_LOGI(TAG, "----------------------------------------");
+
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]) && ret == ESP_OK; r++)
+    {
+        ret = ads111x_rdy_init(&acquisition, &ads111x_device, (gpio_num_t)CONFIG_ADS111X_ALERT_RDY_GPIO,
+                               ADS111X_GAIN_2V048, rates[r]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "ads111x_rdy_init FAILED: %s", esp_err_to_name(ret));
+            break;
+        }
+
+        int16_t values[4] = {0};
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < scans; i++) {
+            ads111x_rdy_scan(&acquisition, channels, 4, values);
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        ESP_LOGI(TAG, "Rate %" PRIu32 " us/conv: %d scans x 4 ch in %lld ms -> %.1f scans/s, %" PRIu32 " conversions, %" PRIu32 " timeouts",
+                 ads111x_conversion_time_us(rates[r]), scans, (long long)(elapsed / 1000),
+                 scans * 1e6 / (double)elapsed, acquisition.conversions, acquisition.timeouts);
+        ESP_LOGI(TAG, "Last scan: %6d %6d %6d %6d", values[0], values[1], values[2], values[3]);
+        if (acquisition.timeouts != 0) {
+            ret = ESP_ERR_TIMEOUT;
+        }
+        ads111x_rdy_free(&acquisition);
+    }
+
+    // Trả ADS111x về continuous mode cho vòng test phía sau
+    ads111x_set_comp_queue(&ads111x_device, ADS111X_COMP_QUEUE_DISABLED);
+    ads111x_set_mode(&ads111x_device, ADS111X_MODE_CONTINUOUS);
+
+    ESP_LOGI(TAG, "ADS111x conversion-ready test: %s\n", ret == ESP_OK ? "PASSED" : "FAILED");
+    return ret;
+}
+
+/**
+ * @brief Test config register cache của driver: đếm I2C transaction mỗi kênh (set_input_mux +
+ *        start_conversion + get_value, ads111x_convert_next, ads111x_rdy_scan), getter không tạo
+ *        traffic, và ads111x_verify_config phát hiện config bị ghi bên ngoài cache
+ */
+esp_err_t test_ads111x_config_shadow(void)
+{
+    static const ads111x_mux_t channels[4] = {ADS111X_MUX_0_GND, ADS111X_MUX_1_GND, ADS111X_MUX_2_GND, ADS111X_MUX_3_GND};
+    const int scans = 50;
+    esp_err_t ret = ESP_OK;
+    uint32_t transactions;
+    int64_t start;
+
+    ESP_LOGI(TAG, "----------------------------------------");
+    ESP_LOGI(TAG, "TESTING ADS111x CONFIG SHADOW");
+    ESP_LOGI(TAG, "----------------------------------------");
+
+    ads111x_sync_config(&ads111x_device);
+    ads111x_set_mode(&ads111x_device, ADS111X_MODE_SINGLE_SHOT);
+    ads111x_set_data_rate(&ads111x_device, ADS111X_DATA_RATE_860);
+    ads111x_set_gain(&ads111x_device, ADS111X_GAIN_2V048);
+
+    // Cách cũ: mỗi kênh đổi mux, bắt đầu chuyển đổi, chờ, đọc
+    transactions = ads111x_get_transaction_count();
+    start = esp_timer_get_time();
+    for (int i = 0; i < scans; i++) {
+        for (size_t c = 0; c < 4; c++) {
+            int16_t value;
+            ads111x_set_input_mux(&ads111x_device, channels[c]);
+            ads111x_start_conversion(&ads111x_device);
+            esp_rom_delay_us(ads111x_conversion_time_us(ADS111X_DATA_RATE_860) + 100);
+            ads111x_get_value(&ads111x_device, &value);
+        }
+    }
+    uint32_t legacy = ads111x_get_transaction_count() - transactions;
+    ESP_LOGI(TAG, "set_input_mux + start_conversion + get_value: %.2f transactions/channel, %lld us/scan",
+             legacy / (scans * 4.0), (long long)((esp_timer_get_time() - start) / scans));
+    if (legacy != (uint32_t)scans * 4 * 3) {   // Trước khi có cache: 5 (2 read-modify-write + 1 read)
+        ret = ESP_FAIL;
+    }
+
+    // Đổi mux + bắt đầu + đọc kết quả trước trong một lần giữ mutex
+    transactions = ads111x_get_transaction_count();
+    start = esp_timer_get_time();
+    for (int i = 0; i < scans; i++) {
+        for (size_t c = 0; c < 4; c++) {
+            int16_t previous;
+            ads111x_convert_next(&ads111x_device, channels[c], &previous);
+            esp_rom_delay_us(ads111x_conversion_time_us(ADS111X_DATA_RATE_860) + 100);
+        }
+    }
+    uint32_t combined = ads111x_get_transaction_count() - transactions;
+    ESP_LOGI(TAG, "convert_next: %.2f transactions/channel, %lld us/scan",
+             combined / (scans * 4.0), (long long)((esp_timer_get_time() - start) / scans));
+    if (combined != (uint32_t)scans * 4 * 2) {
+        ret = ESP_FAIL;
+    }
+
+    // Getter đọc từ cache
+    ads111x_gain_t gain;
+    ads111x_data_rate_t rate;
+    transactions = ads111x_get_transaction_count();
+    ads111x_get_gain(&ads111x_device, &gain);
+    ads111x_get_data_rate(&ads111x_device, &rate);
+    ESP_LOGI(TAG, "get_gain + get_data_rate: %" PRIu32 " transactions (gain %d, rate %d)",
+             ads111x_get_transaction_count() - transactions, gain, rate);
+    if (ads111x_get_transaction_count() != transactions || gain != ADS111X_GAIN_2V048 || rate != ADS111X_DATA_RATE_860) {
+        ret = ESP_FAIL;
+    }
+
+    // Config bị đổi ngoài cache (giả lập device reset): verify phải phát hiện rồi đồng bộ lại
+    if (ads111x_verify_config(&ads111x_device) != ESP_OK) {
+        ESP_LOGE(TAG, "verify_config mismatch right after sync");
+        ret = ESP_FAIL;
+    }
+    uint8_t reset_config[2] = {0x85, 0x83}; // Giá trị mặc định sau power-on
+    I2C_DEV_TAKE_MUTEX(&ads111x_device);
+    I2C_DEV_CHECK(&ads111x_device, i2c_dev_write_reg(&ads111x_device, 1, reset_config, sizeof(reset_config)));
+    I2C_DEV_GIVE_MUTEX(&ads111x_device);
+    if (ads111x_verify_config(&ads111x_device) != ESP_ERR_INVALID_STATE || ads111x_verify_config(&ads111x_device) != ESP_OK) {
+        ESP_LOGE(TAG, "verify_config did not detect the external write");
+        ret = ESP_FAIL;
+    }
+
+    // Scan pipeline ALERT/RDY: 2 transaction/kênh (+ poll OS bit nếu không nối ALERT/RDY)
+    ads111x_rdy_t acquisition;
+    if (ads111x_rdy_init(&acquisition, &ads111x_device, (gpio_num_t)CONFIG_ADS111X_ALERT_RDY_GPIO,
+                         ADS111X_GAIN_2V048, ADS111X_DATA_RATE_860) == ESP_OK) {
+        int16_t values[4] = {0};
+        transactions = ads111x_get_transaction_count();
+        start = esp_timer_get_time();
+        for (int i = 0; i < scans; i++) {
+            ads111x_rdy_scan(&acquisition, channels, 4, values);
+        }
+        ESP_LOGI(TAG, "rdy_scan: %.2f transactions/channel, %lld us/scan, %" PRIu32 " timeouts, %" PRIu32 " errors",
+                 (ads111x_get_transaction_count() - transactions) / (scans * 4.0),
+                 (long long)((esp_timer_get_time() - start) / scans), acquisition.timeouts, acquisition.errors);
+        if (acquisition.timeouts != 0 || acquisition.errors != 0) {
+            ret = ESP_FAIL;
+        }
+        ads111x_rdy_free(&acquisition);
+    } else {
+        ret = ESP_FAIL;
+    }
+
+    ads111x_set_comp_queue(&ads111x_device, ADS111X_COMP_QUEUE_DISABLED);
+    ads111x_set_mode(&ads111x_device, ADS111X_MODE_CONTINUOUS);
+
+    ESP_LOGI(TAG, "ADS111x config shadow test: %s\n", ret == ESP_OK ? "PASSED" : "FAILED");
+    return ret;
+}
+
+/**
+ * @brief Test mảng ADS111x: tìm các chip ở 0x48..0x4B, so sánh thời gian một frame khi quét
+ *        song song (ads111x_array_scan) và khi quét lần lượt từng chip (ads111x_rdy_scan), rồi kiểm tra gain riêng từng kênh
+ */
+esp_err_t test_ads111x_array(void)
+{
+    static const uint8_t array_addresses[ADS111X_ARRAY_MAX_DEVICES] = {ADS111X_ADDR_GND, ADS111X_ADDR_VCC, ADS111X_ADDR_SDA, ADS111X_ADDR_SCL};
+    static const ads111x_mux_t channels[4] = {ADS111X_MUX_0_GND, ADS111X_MUX_1_GND, ADS111X_MUX_2_GND, ADS111X_MUX_3_GND};
+    static i2c_dev_t devices[ADS111X_ARRAY_MAX_DEVICES];
+    static ads111x_array_t array;
+    const int scans = 50;
+    size_t count = 0;
+    esp_err_t ret = ESP_OK;
+
+    ESP_LOGI(TAG, "----------------------------------------");
+    ESP_LOGI(TAG, "TESTING ADS111x ARRAY (PARALLEL SCAN)");
+    ESP_LOGI(TAG, "----------------------------------------");
+
+    // Chip 0x48 dùng descriptor của các test trước (mutex đã tạo)
+    for (size_t i = 0; i < ADS111X_ARRAY_MAX_DEVICES; i++) {
+        i2c_dev_t probe = {0};
+        if (array_addresses[i] == ADS111X_ADDRESS) {
+            devices[count++] = ads111x_device;
+            continue;
+        }
+        if (ads111x_init_desc(&probe, array_addresses[i], I2C_PORT, I2C_SDA_PIN, I2C_SCL_PIN) != ESP_OK) {
+            continue;
+        }
+        if (i2c_dev_probe(&probe, I2C_DEV_WRITE) == ESP_OK) {
+            devices[count++] = probe;
+            ESP_LOGI(TAG, "ADS111x found at 0x%02x", array_addresses[i]);
+        } else {
+            ads111x_free_desc(&probe);
+        }
+    }
+    ESP_LOGI(TAG, "%u ADS111x on the bus -> %u channels", (unsigned)count, (unsigned)count * 4);
+
+    ret = ads111x_array_init(&array, devices, count, channels, 4, (gpio_num_t)CONFIG_ADS111X_ALERT_RDY_GPIO,
+                             ADS111X_GAIN_2V048, ADS111X_DATA_RATE_860);
+    if (ret == ESP_OK) {
+        int16_t values[ADS111X_ARRAY_MAX_DEVICES * 4] = {0};
+
+        // Lần lượt từng chip: thời gian tăng theo số chip
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < scans; i++) {
+            for (size_t d = 0; d < count; d++) {
+                ads111x_rdy_scan(&array.devices[d], channels, 4, &values[d * 4]);
+            }
+        }
+        int64_t serial_us = (esp_timer_get_time() - start) / scans;
+
+        // Song song: các chip cùng chuyển đổi một kênh
+        uint32_t lost = ads111x_array_lost_count(&array);
+        start = esp_timer_get_time();
+        for (int i = 0; i < scans; i++) {
+            ads111x_array_scan(&array, values);
+        }
+        int64_t parallel_us = (esp_timer_get_time() - start) / scans;
+        lost = ads111x_array_lost_count(&array) - lost;
+
+        ESP_LOGI(TAG, "%u channels: serial %lld us/frame, parallel %lld us/frame, single device %" PRIu32 " us (4 x conversion), %" PRIu32 " lost",
+                 (unsigned)ads111x_array_channel_count(&array), (long long)serial_us, (long long)parallel_us,
+                 4 * ads111x_conversion_time_us(ADS111X_DATA_RATE_860), lost);
+        for (size_t d = 0; d < count; d++) {
+            ESP_LOGI(TAG, "ADS111x 0x%02x: %6d %6d %6d %6d", devices[d].addr,
+                     values[d * 4], values[d * 4 + 1], values[d * 4 + 2], values[d * 4 + 3]);
+        }
+        // Song song phải gần bằng một chip: cho phép thêm 25% cho I2C của các chip còn lại
+        if (lost != 0 || parallel_us > (int64_t)(4 * ads111x_conversion_time_us(ADS111X_DATA_RATE_860)) * 5 / 4 + 1000) {
+            ret = ESP_FAIL;
+        }
+
+        // Gain riêng từng kênh (auto gain): đọc lại ở ±4.096 V, giá trị quy về ±2.048 V phải khớp với lần quét trước
+        int16_t wide[ADS111X_ARRAY_MAX_DEVICES * 4] = {0};
+        for (size_t c = 0; c < ads111x_array_channel_count(&array); c++) {
+            ads111x_array_set_gain(&array, c, ADS111X_GAIN_4V096);
+        }
+        ads111x_array_scan(&array, wide);
+        for (size_t c = 0; c < ads111x_array_channel_count(&array); c++) {
+            int32_t normalized = (int32_t)wide[c] * 2;
+            if (abs(normalized - values[c]) > 50 + abs(values[c]) / 50) {
+                ESP_LOGE(TAG, "Channel %u: %d at ±2.048 V but %" PRId32 " from ±4.096 V", (unsigned)c, values[c], normalized);
+                ret = ESP_FAIL;
+            }
+        }
+        ads111x_array_free(&array);
+    } else {
+        ESP_LOGE(TAG, "ads111x_array_init FAILED: %s", esp_err_to_name(ret));
+    }
+
+    for (size_t d = 0; d < count; d++) {
+        ads111x_set_comp_queue(&devices[d], ADS111X_COMP_QUEUE_DISABLED);
+        ads111x_set_mode(&devices[d], ADS111X_MODE_CONTINUOUS);
+        if (devices[d].addr != ADS111X_ADDRESS) {
+            ads111x_free_desc(&devices[d]);
+        }
+    }
+
+    ESP_LOGI(TAG, "ADS111x array test: %s\n", ret == ESP_OK ? "PASSED" : "FAILED");
+    return ret;
+}
+
+/**
+ * @brief Test SHT3x ở periodic mode 10 Hz qua envSensor: gọi envSensor_read() mỗi 10 ms trong 2 s,
+ *        phải nhận ~20 kết quả, không lỗi, mỗi lần fetch chỉ là một giao dịch I2C (không chờ đo)
+ */
+esp_err_t test_sht3x_periodic(void)
+{
+    static const uint8_t addresses[] = {SHT3X_I2C_ADDR_GND, SHT3X_I2C_ADDR_VDD};
+    static envSensor_st sensor;
+    uint8_t address = 0;
+    esp_err_t ret = ESP_OK;
+
+    ESP_LOGI(TAG, "----------------------------------------");
+    ESP_LOGI(TAG, "TESTING SHT3x PERIODIC MODE");
+    ESP_LOGI(TAG, "----------------------------------------");
+
+    for (size_t i = 0; i < sizeof(addresses) && address == 0; i++) {
+        i2c_dev_t probe = {.port = I2C_PORT, .addr = addresses[i]};
+        probe.cfg.sda_io_num = I2C_SDA_PIN;
+        probe.cfg.scl_io_num = I2C_SCL_PIN;
+        probe.cfg.master.clk_speed = I2C_FREQ_HZ;
+        if (i2c_dev_create_mutex(&probe) == ESP_OK) {
+            if (i2c_dev_probe(&probe, I2C_DEV_WRITE) == ESP_OK) address = addresses[i];
+            i2c_dev_delete_mutex(&probe);
+        }
+    }
+    if (address == 0) {
+        ESP_LOGW(TAG, "No SHT3x at 0x44/0x45, test skipped\n");
+        return ESP_OK;
+    }
+
+    const envSensor_config_st config = {
+        .backend = ENV_SENSOR_BACKEND_SHT3X,
+        .sht3x = {
+            .port = I2C_PORT, .address = address, .sda = I2C_SDA_PIN, .scl = I2C_SCL_PIN,
+            .mode = SHT3X_PERIODIC_10MPS, .repeatability = SHT3X_HIGH,
+        },
+    };
+    ret = envSensor_init(&sensor, &config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "envSensor_init FAILED: %s", esp_err_to_name(ret));
+        envSensor_free(&sensor);
+        return ret;
+    }
+
+    uint32_t results = 0, notFinished = 0;
+    int64_t maxFetch_us = 0;
+    float temperature = 0, humidity = 0;
+    int64_t end = esp_timer_get_time() + 2000000;
+    while (esp_timer_get_time() < end) {
+        int64_t start = esp_timer_get_time();
+        esp_err_t err = envSensor_read(&sensor, &temperature, &humidity);
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (err == ESP_OK) {
+            results++;
+            if (elapsed > maxFetch_us) maxFetch_us = elapsed;
+        } else if (err == ESP_ERR_NOT_FINISHED) {
+            notFinished++;
+        }
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+
+    ESP_LOGI(TAG, "SHT3x 0x%02x: %.2f C, %.2f %%RH, %" PRIu32 " results in 2 s, %" PRIu32 " skipped polls, %" PRIu32 " errors, fetch max %lld us",
+             address, temperature, humidity, results, notFinished, sensor.errorCount, (long long)maxFetch_us);
+    if (results < 15 || sensor.errorCount != 0 || maxFetch_us > 2000) {
+        ret = ESP_FAIL;
+    }
+    envSensor_free(&sensor);
+
+    ESP_LOGI(TAG, "SHT3x periodic test: %s\n", ret == ESP_OK ? "PASSED" : "FAILED");
+    return ret;
+}
+
+/**
+ * @brief Microbenchmark tốc độ giao dịch của i2cdev trên ADS111x (1 MHz): đọc thanh ghi config
+ *        (ghi 1 + đọc 2 byte), ghi lại chính giá trị đó (3 byte) và probe địa chỉ.
+ *        In µs/giao dịch, phần vượt thời gian trên dây và số lần cấp phát heap mỗi giao dịch
+ *        (cần CONFIG_HEAP_USE_HOOKS). Lỗi nếu có giao dịch hỏng hoặc có cấp phát.
+ */
+esp_err_t test_i2c_transaction_rate(void)
+{
+    const int transactions = 1000;
+    // Bit trên dây: start/stop + 9 bit mỗi byte (kể cả ACK)
+    const uint32_t read_bits = 1 + 9 + 9 + 1 + 9 + 18 + 1;
+    const uint32_t write_bits = 1 + 9 * 4 + 1;
+    const uint32_t clk_hz = ads111x_device.cfg.master.clk_speed;
+    uint8_t config[2];
+    uint32_t failures = 0;
+    esp_err_t ret = ESP_OK;
+
+    ESP_LOGI(TAG, "----------------------------------------");
+    ESP_LOGI(TAG, "I2C TRANSACTION RATE (%s backend, %" PRIu32 " Hz)", I2CDEV_MASTER_BUS ? "i2c_master" : "legacy", clk_hz);
+    ESP_LOGI(TAG, "----------------------------------------");
+
+    ret = i2c_dev_read_reg(&ads111x_device, 0x01, config, sizeof(config));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot read ADS111x config: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    config[0] &= 0x7F;  // OS = 0: ghi lại config không khởi động chuyển đổi
+
+    struct {
+        const char *name;
+        uint32_t bits;
+        int64_t elapsed_us;
+        uint32_t allocations;
+    } results[3] = {{"read reg (1+2 B)", read_bits}, {"write reg (3 B)", write_bits}, {"probe", 1 + 9 + 1}};
+
+    for (int kind = 0; kind < 3; kind++) {
+        uint8_t value[2];
+        uint32_t allocations = benchmark_allocationCount();
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < transactions; i++) {
+            esp_err_t err;
+            if (kind == 0) {
+                err = i2c_dev_read_reg(&ads111x_device, 0x01, value, sizeof(value));
+            } else if (kind == 1) {
+                err = i2c_dev_write_reg(&ads111x_device, 0x01, config, sizeof(config));
+            } else {
+                err = i2c_dev_probe(&ads111x_device, I2C_DEV_WRITE);
+            }
+            if (err != ESP_OK) failures++;
+        }
+        results[kind].elapsed_us = esp_timer_get_time() - start;
+        results[kind].allocations = benchmark_allocationCount() - allocations;
+    }
+
+    for (int kind = 0; kind < 3; kind++) {
+        double per_transaction = (double)results[kind].elapsed_us / transactions;
+        double wire_us = results[kind].bits * 1e6 / clk_hz;
+        ESP_LOGI(TAG, "%-18s %7.1f us  %7.0f/s  wire %5.1f us  overhead %6.1f us  %.2f alloc",
+                 results[kind].name, per_transaction, 1e6 / per_transaction, wire_us, per_transaction - wire_us,
+                 (double)results[kind].allocations / transactions);
+        if (results[kind].allocations != 0) {
+            ret = ESP_FAIL;
+        }
+    }
+    if (failures != 0) {
+        ESP_LOGE(TAG, "%" PRIu32 " transactions failed", failures);
+        ret = ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "I2C transaction rate test: %s\n", ret == ESP_OK ? "PASSED" : "FAILED");
+    return ret;
+}
+
+typedef struct {
+    i2c_dev_t device;           // Bản sao descriptor với priority housekeeping
+    uint8_t reg;
+    size_t length;
+    volatile bool running;
+    TaskHandle_t owner;
+} scheduler_load_st;
+
+static void test_i2c_housekeeping_task(void *arg)
+{
+    scheduler_load_st *load = arg;
+    uint8_t buffer[8];
+    while (load->running) {
+        i2c_dev_read_reg(&load->device, load->reg, buffer, load->length);
+    }
+    xTaskNotifyGive(load->owner);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Scheduler I2C: một task housekeeping đọc DS3231 (hoặc ADS111x nếu không có RTC) liên tục
+ *        trong khi task này đọc ADS111x ở lớp acquisition trong 1 s.
+ *        Thời gian chờ tối đa của acquisition phải chỉ cỡ một giao dịch housekeeping (~0.3 ms) cộng
+ *        chuyển task; giao dịch có deadline đã qua bị bỏ (ESP_ERR_TIMEOUT) mà không ra bus.
+ *        Scheduler tiếp tục chạy cho các test sau.
+ */
+esp_err_t test_i2c_scheduler(bool rtc_present)
+{
+    const uint32_t acquisition_max_wait_us = 2000;
+    esp_err_t ret = ESP_OK;
+
+    ESP_LOGI(TAG, "----------------------------------------");
+    ESP_LOGI(TAG, "I2C SCHEDULER (acquisition vs %s housekeeping)", rtc_present ? "DS3231" : "ADS111x");
+    ESP_LOGI(TAG, "----------------------------------------");
+
+    esp_err_t err = i2c_dev_scheduler_start(I2C_PORT);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "CONFIG_I2CDEV_SCHEDULER disabled, skipped");
+        return ESP_OK;
+    } else if (err != ESP_OK) {
+        return err;
+    }
+
+    static scheduler_load_st load;
+    load.device = rtc_present ? ds3231_device : ads111x_device;
+    load.device.priority = I2C_DEV_PRIORITY_HOUSEKEEPING;
+    load.reg = 0x00;                    // DS3231: giờ/ngày (7 byte), ADS111x: conversion (2 byte)
+    load.length = rtc_present ? 7 : 2;
+    load.running = true;
+    load.owner = xTaskGetCurrentTaskHandle();
+
+    i2c_dev_t acquisition = ads111x_device;
+    acquisition.priority = I2C_DEV_PRIORITY_ACQUISITION;
+
+    i2c_dev_scheduler_stats_t stats;
+    i2c_dev_scheduler_get_stats(I2C_PORT, &stats, true);
+    if (xTaskCreate(test_i2c_housekeeping_task, "i2c_hk_load", 3072, &load, uxTaskPriorityGet(NULL), NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t end = esp_timer_get_time() + 1000000;
+    while (esp_timer_get_time() < end) {
+        uint8_t value[2];
+        i2c_dev_read_reg(&acquisition, 0x00, value, sizeof(value));
+        esp_rom_delay_us(200);      // Nhịp đọc ADC, để housekeeping có khe bus
+    }
+    load.running = false;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+
+    // Deadline đã qua: không được ra bus
+    uint8_t value[2];
+    uint8_t reg = 0x00;
+    i2c_dev_transaction_t late = {
+        .dev = &acquisition,
+        .op = I2C_DEV_OP_READ,
+        .out_data = &reg,
+        .out_size = 1,
+        .in_data = value,
+        .in_size = sizeof(value),
+        .priority = I2C_DEV_PRIORITY_ACQUISITION,
+        .deadline_us = esp_timer_get_time() - 1,
+    };
+    err = i2c_dev_transfer(&late);
+
+    i2c_dev_scheduler_get_stats(I2C_PORT, &stats, true);
+    ESP_LOGI(TAG, "%.2f s, bus busy %.1f %%, max depth %" PRIu32, stats.window_us / 1e6,
+             100.0 * stats.busy_us / stats.window_us, stats.max_depth);
+    for (int p = 0; p < I2C_DEV_PRIORITY_MAX; p++) {
+        uint32_t served = stats.count[p] + stats.expired[p];
+        ESP_LOGI(TAG, "%-12s %6" PRIu32 " tx %3" PRIu32 " err %3" PRIu32 " late  wait avg %5" PRIu32 " us max %5" PRIu32 " us",
+                 i2c_dev_priority_name(p), stats.count[p], stats.errors[p], stats.expired[p],
+                 served ? (uint32_t)(stats.queue_total_us[p] / served) : 0, stats.queue_max_us[p]);
+        if (stats.errors[p] != 0) ret = ESP_FAIL;
+    }
+    if (err != ESP_ERR_TIMEOUT || stats.expired[I2C_DEV_PRIORITY_ACQUISITION] != 1) {
+        ESP_LOGE(TAG, "Late transaction: %s, expected ESP_ERR_TIMEOUT without bus access", esp_err_to_name(err));
+        ret = ESP_FAIL;
+    }
+    if (stats.count[I2C_DEV_PRIORITY_HOUSEKEEPING] == 0 ||
+        stats.queue_max_us[I2C_DEV_PRIORITY_ACQUISITION] > acquisition_max_wait_us) {
+        ESP_LOGE(TAG, "Acquisition waited up to %" PRIu32 " us (limit %" PRIu32 ")",
+                 stats.queue_max_us[I2C_DEV_PRIORITY_ACQUISITION], acquisition_max_wait_us);
+        ret = ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "I2C scheduler test: %s\n", ret == ESP_OK ? "PASSED" : "FAILED");
+    return ret;
+}
+
 /**
  * @brief Test task - chạy test liên tục
  */
@@ -270,6 +779,7 @@ void test_i2c_devices_task(void *pvParameters)
     
     // Step 2: Test DS3231
     ret = test_ds3231();
+    bool rtc_present = ret == ESP_OK;
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "DS3231 test FAILED!");
     }
@@ -279,6 +789,25 @@ void test_i2c_devices_task(void *pvParameters)
     ret = test_ads111x();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "ADS111x test FAILED!");
+    } else {
+        if (test_i2c_transaction_rate() != ESP_OK) {
+            ESP_LOGE(TAG, "I2C transaction rate test FAILED!");
+        }
+        if (test_ads111x_conversion_ready() != ESP_OK) {
+            ESP_LOGE(TAG, "ADS111x conversion-ready test FAILED!");
+        }
+        if (test_ads111x_config_shadow() != ESP_OK) {
+            ESP_LOGE(TAG, "ADS111x config shadow test FAILED!");
+        }
+        if (test_ads111x_array() != ESP_OK) {
+            ESP_LOGE(TAG, "ADS111x array test FAILED!");
+        }
+        if (test_i2c_scheduler(rtc_present) != ESP_OK) {
+            ESP_LOGE(TAG, "I2C scheduler test FAILED!");
+        }
+    }
+    if (test_sht3x_periodic() != ESP_OK) {
+        ESP_LOGE(TAG, "SHT3x periodic test FAILED!");
     }
     vTaskDelay(1000 / portTICK_PERIOD_MS);
     
@@ -0,0 +1,504 @@
+/**
+ * @file ads111x_test.c
+ * @brief Host test of the ADS111x driver (component/ADS111x/ADS111x.c) against a simulated ADS1115
+ *        register model: counts the I2C transactions of every access path and checks the values.
+ *
+ * Build and run (from Electronic-Nose/tools):
+ *   gcc -O2 -Wall -Ihost_include -I../component/ADS111x ads111x_test.c ../component/ADS111x/ADS111x.c -o ads111x_test
+ *   ./ads111x_test                 exit status 1 on failure
+ *
+ * The simulated device keeps the four registers, starts a single-shot conversion when OS is
+ * written, reports OS = 0 until the conversion time (nominal + 5 %) has elapsed on a fake clock,
+ * then latches the code of the converted input: (device + 1) x 1000 + mux x 100 + PGA.
+ * Every I2C transaction costs I2C_TRANSACTION_US on the clock; esp_rom_delay_us() is counted
+ * separately (time spent spinning), the one-shot esp_timer sleeps are not.
+ *
+ * Checks (the on-device counterpart is test_ads111x_config_shadow() in main/test_i2c_devices.c):
+ *   - setters write the config register once without reading it (cache), and not at all when
+ *     the field does not change
+ *   - set_input_mux + start_conversion + get_value = 3 transactions, convert_next = 2
+ *   - getters of configuration fields do not touch the bus
+ *   - verify_config detects a config register changed behind the cache (device reset)
+ *   - rdy_scan/array_scan: one config write per input, pipelined results in the right order with
+ *     the gain of each channel, at most 3 OS polls per conversion, no timeout, no spinning
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "ADS111x.h"
+#include "esp_rom_sys.h"
+
+#define I2C_TRANSACTION_US      60      // 3-4 bytes at 400 kHz + overhead
+#define FAKE_DEVICE_COUNT       4
+#define FAKE_CONFIG_RESET       0x8583U
+
+#define EXPECT(condition, ...) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "FAIL %s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            failures++; \
+        } \
+    } while (0)
+
+static int failures = 0;
+
+/* Fake clock */
+
+static int64_t fakeNow_us = 0;
+static int64_t fakeSpun_us = 0;
+
+int64_t esp_timer_get_time(void)
+{
+    return fakeNow_us;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    fakeNow_us += us;
+    fakeSpun_us += us;
+}
+
+/* Simulated ADS1115 (ADDR to GND, VCC, SDA, SCL) */
+
+typedef struct
+{
+    uint16_t config;            // Without OS
+    uint16_t conversion;
+    uint16_t thresholdLow;
+    uint16_t thresholdHigh;
+    int64_t readyAt_us;         // End of the running conversion, 0 = idle
+    uint16_t converting;        // Config of the running conversion
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t configReads;
+    uint32_t configWrites;
+} fakeAds_st;
+
+static fakeAds_st fakeAds[FAKE_DEVICE_COUNT];
+
+static uint32_t fakeAds_transactions(void)
+{
+    uint32_t total = 0;
+    for (size_t d = 0; d < FAKE_DEVICE_COUNT; d++) {
+        total += fakeAds[d].reads + fakeAds[d].writes;
+    }
+    return total;
+}
+
+static int16_t fakeAds_code(size_t device, uint16_t config)
+{
+    return (int16_t)((device + 1) * 1000 + ((config >> 12) & 7U) * 100 + ((config >> 9) & 7U));
+}
+
+static void fakeAds_reset(void)
+{
+    memset(fakeAds, 0, sizeof(fakeAds));
+    for (size_t d = 0; d < FAKE_DEVICE_COUNT; d++)
+    {
+        fakeAds[d].config = FAKE_CONFIG_RESET & 0x7FFFU;
+        fakeAds[d].thresholdLow = 0x8000U;
+        fakeAds[d].thresholdHigh = 0x7FFFU;
+    }
+}
+
+static fakeAds_st *fakeAds_get(const i2c_dev_t *dev, size_t *device)
+{
+    if (dev->addr < ADS111X_ADDR_GND || dev->addr >= ADS111X_ADDR_GND + FAKE_DEVICE_COUNT) {
+        return NULL;
+    }
+    *device = dev->addr - ADS111X_ADDR_GND;
+    fakeAds_st *ads = &fakeAds[*device];
+    if (ads->readyAt_us != 0 && fakeNow_us >= ads->readyAt_us)
+    {
+        ads->conversion = (uint16_t)fakeAds_code(*device, ads->converting);
+        ads->readyAt_us = 0;
+    }
+    return ads;
+}
+
+esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
+{
+    size_t device;
+    fakeAds_st *ads = fakeAds_get(dev, &device);
+    if (ads == NULL || in_size != 2 || reg > 3) {
+        return ESP_FAIL;
+    }
+    fakeNow_us += I2C_TRANSACTION_US;
+    ads->reads++;
+
+    uint16_t value = 0;
+    switch (reg)
+    {
+    case 0: value = ads->conversion; break;
+    case 1:
+        ads->configReads++;
+        value = ads->config | ((ads->readyAt_us == 0) ? 0x8000U : 0);
+        break;
+    case 2: value = ads->thresholdLow; break;
+    case 3: value = ads->thresholdHigh; break;
+    }
+    ((uint8_t *)in_data)[0] = (uint8_t)(value >> 8);
+    ((uint8_t *)in_data)[1] = (uint8_t)value;
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size)
+{
+    size_t device;
+    fakeAds_st *ads = fakeAds_get(dev, &device);
+    if (ads == NULL || out_size != 2 || reg > 3) {
+        return ESP_FAIL;
+    }
+    fakeNow_us += I2C_TRANSACTION_US;
+    ads->writes++;
+
+    uint16_t value = (uint16_t)((((const uint8_t *)out_data)[0] << 8) | ((const uint8_t *)out_data)[1]);
+    switch (reg)
+    {
+    case 0: break;  // Read only
+    case 1:
+        ads->configWrites++;
+        ads->config = value & 0x7FFFU;
+        // OS = 1 in single-shot mode (MODE = 1) starts a conversion, a running one is restarted
+        if ((value & 0x8000U) && (value & 0x0100U))
+        {
+            ads->converting = value;
+            ads->readyAt_us = fakeNow_us + ads111x_conversion_time_us((ads111x_data_rate_t)((value >> 5) & 7U)) * 105 / 100;
+        }
+        break;
+    case 2: ads->thresholdLow = value; break;
+    case 3: ads->thresholdHigh = value; break;
+    }
+    return ESP_OK;
+}
+
+/* FreeRTOS, esp_timer, GPIO, i2cdev mutex */
+
+struct host_semaphore
+{
+    int count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return calloc(1, sizeof(struct host_semaphore));
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t semaphore = xSemaphoreCreateBinary();
+    if (semaphore) {
+        semaphore->count = 1;
+    }
+    return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    if (semaphore->count > 0)
+    {
+        semaphore->count--;
+        return pdTRUE;
+    }
+    // Single task: nobody can give it while waiting
+    if (ticks != 0) {
+        fakeNow_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    }
+    return pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->count > 0) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    free(semaphore);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)&fakeNow_us;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    fakeNow_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    return 0;   // No ALERT/RDY line in the simulation
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    fakeNow_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void *arg;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    *handle = calloc(1, sizeof(struct esp_timer));
+    if (*handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*handle)->callback = args->callback;
+    (*handle)->arg = args->arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    // The caller blocks right after starting the timer: elapse the time and fire now
+    fakeNow_us += (int64_t)timeout_us;
+    timer->callback(timer->arg);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    free(timer);
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config) { return ESP_OK; }
+esp_err_t gpio_install_isr_service(int flags) { return ESP_OK; }
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg) { return ESP_OK; }
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio) { return ESP_OK; }
+
+esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev)
+{
+    dev->mutex = xSemaphoreCreateMutex();
+    return dev->mutex ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t i2c_dev_delete_mutex(i2c_dev_t *dev)
+{
+    vSemaphoreDelete(dev->mutex);
+    dev->mutex = NULL;
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev)
+{
+    // Not recursive: a nested take is a driver bug
+    return xSemaphoreTake(dev->mutex, 0) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev)
+{
+    return xSemaphoreGive(dev->mutex) ? ESP_OK : ESP_FAIL;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    static char name[16];
+    snprintf(name, sizeof(name), "0x%x", code);
+    return name;
+}
+
+/* Tests */
+
+static const ads111x_mux_t inputs[4] = {ADS111X_MUX_0_GND, ADS111X_MUX_1_GND, ADS111X_MUX_2_GND, ADS111X_MUX_3_GND};
+
+static void test_configCache(i2c_dev_t *dev)
+{
+    uint32_t driverStart = ads111x_get_transaction_count();
+    uint32_t start = fakeAds_transactions();
+
+    EXPECT(ads111x_sync_config(dev) == ESP_OK, "sync_config");
+    EXPECT(fakeAds[0].configReads == 1, "sync_config: %" PRIu32 " config reads", fakeAds[0].configReads);
+
+    // Reset value: single-shot, 128 SPS, ±2.048 V. A setter that changes nothing does not write
+    EXPECT(ads111x_set_mode(dev, ADS111X_MODE_SINGLE_SHOT) == ESP_OK, "set_mode");
+    EXPECT(ads111x_set_data_rate(dev, ADS111X_DATA_RATE_860) == ESP_OK, "set_data_rate");
+    EXPECT(ads111x_set_gain(dev, ADS111X_GAIN_2V048) == ESP_OK, "set_gain");
+    EXPECT(fakeAds[0].configReads == 1 && fakeAds[0].configWrites == 1,
+           "setters: %" PRIu32 " reads, %" PRIu32 " writes (expected 0 reads, 1 write)",
+           fakeAds[0].configReads - 1, fakeAds[0].configWrites);
+    EXPECT(fakeAds[0].config == ((ADS111X_GAIN_2V048 << 9) | (ADS111X_MODE_SINGLE_SHOT << 8) | (ADS111X_DATA_RATE_860 << 5) | 0x03U),
+           "config register 0x%04x", fakeAds[0].config);
+
+    // Getters read the cache
+    ads111x_gain_t gain;
+    ads111x_data_rate_t rate;
+    ads111x_mode_t mode;
+    uint32_t before = fakeAds_transactions();
+    EXPECT(ads111x_get_gain(dev, &gain) == ESP_OK && ads111x_get_data_rate(dev, &rate) == ESP_OK &&
+           ads111x_get_mode(dev, &mode) == ESP_OK, "getters");
+    EXPECT(fakeAds_transactions() == before, "getters: %" PRIu32 " transactions", fakeAds_transactions() - before);
+    EXPECT(gain == ADS111X_GAIN_2V048 && rate == ADS111X_DATA_RATE_860 && mode == ADS111X_MODE_SINGLE_SHOT,
+           "getters: gain %d rate %d mode %d", gain, rate, mode);
+
+    EXPECT(ads111x_get_transaction_count() - driverStart == fakeAds_transactions() - start,
+           "driver counted %" PRIu32 " transactions, bus saw %" PRIu32,
+           ads111x_get_transaction_count() - driverStart, fakeAds_transactions() - start);
+}
+
+static void test_channelPaths(i2c_dev_t *dev)
+{
+    const uint32_t waitUs = ads111x_conversion_time_us(ADS111X_DATA_RATE_860) * 2;
+
+    // set_input_mux + start_conversion + get_value: 3 transactions (5 with read-modify-write)
+    uint32_t start = fakeAds_transactions();
+    for (size_t c = 0; c < 4; c++)
+    {
+        int16_t value = 0;
+        ads111x_set_input_mux(dev, inputs[c]);
+        ads111x_start_conversion(dev);
+        esp_rom_delay_us(waitUs);
+        ads111x_get_value(dev, &value);
+        EXPECT(value == fakeAds_code(0, (uint16_t)((inputs[c] << 12) | (ADS111X_GAIN_2V048 << 9))),
+               "input %u: %d", (unsigned)c, value);
+    }
+    EXPECT(fakeAds_transactions() - start == 4 * 3, "set_input_mux + start_conversion + get_value: %.2f transactions/channel",
+           (fakeAds_transactions() - start) / 4.0);
+
+    // convert_next: config write + read of the previous result
+    start = fakeAds_transactions();
+    int16_t previous = 0;
+    for (size_t c = 0; c < 4; c++)
+    {
+        ads111x_convert_next(dev, inputs[c], &previous);
+        if (c > 0) {
+            EXPECT(previous == fakeAds_code(0, (uint16_t)((inputs[c - 1] << 12) | (ADS111X_GAIN_2V048 << 9))),
+                   "convert_next %u returned %d", (unsigned)c, previous);
+        }
+        esp_rom_delay_us(waitUs);
+    }
+    EXPECT(fakeAds_transactions() - start == 4 * 2, "convert_next: %.2f transactions/channel", (fakeAds_transactions() - start) / 4.0);
+}
+
+static void test_verifyConfig(i2c_dev_t *dev)
+{
+    EXPECT(ads111x_verify_config(dev) == ESP_OK, "verify right after the setters");
+
+    // Power-on reset behind the cache
+    fakeAds[0].config = FAKE_CONFIG_RESET & 0x7FFFU;
+    EXPECT(ads111x_verify_config(dev) == ESP_ERR_INVALID_STATE, "external write not detected");
+    EXPECT(ads111x_verify_config(dev) == ESP_OK, "cache not resynchronized by verify");
+}
+
+static void test_rdyScan(i2c_dev_t *dev)
+{
+    const int scans = 50;
+    ads111x_rdy_t acquisition;
+
+    EXPECT(ads111x_rdy_init(&acquisition, dev, GPIO_NUM_NC, ADS111X_GAIN_4V096, ADS111X_DATA_RATE_860) == ESP_OK, "rdy_init");
+
+    uint32_t writes = fakeAds[0].configWrites;
+    uint32_t reads = fakeAds[0].reads;
+    uint32_t configReads = fakeAds[0].configReads;
+    int64_t spun = fakeSpun_us;
+    int64_t begin = fakeNow_us;
+    for (int s = 0; s < scans; s++)
+    {
+        int16_t values[4] = {0};
+        EXPECT(ads111x_rdy_scan(&acquisition, inputs, 4, values) == ESP_OK, "rdy_scan %d", s);
+        for (size_t c = 0; c < 4; c++) {
+            EXPECT(values[c] == fakeAds_code(0, (uint16_t)((inputs[c] << 12) | (ADS111X_GAIN_4V096 << 9))),
+                   "scan %d input %u: %d", s, (unsigned)c, values[c]);
+        }
+    }
+    uint32_t polls = fakeAds[0].configReads - configReads;
+    EXPECT(fakeAds[0].configWrites - writes == (uint32_t)scans * 4, "rdy_scan: %.2f config writes/channel",
+           (fakeAds[0].configWrites - writes) / (scans * 4.0));
+    EXPECT(fakeAds[0].reads - reads - polls == (uint32_t)scans * 4, "rdy_scan: %.2f result reads/channel",
+           (fakeAds[0].reads - reads - polls) / (scans * 4.0));
+    EXPECT(polls <= (uint32_t)scans * 4 * 3, "rdy_scan: %.2f OS polls/channel", polls / (scans * 4.0));
+    EXPECT(acquisition.timeouts == 0 && acquisition.errors == 0, "%" PRIu32 " timeouts, %" PRIu32 " errors",
+           acquisition.timeouts, acquisition.errors);
+    EXPECT(fakeSpun_us == spun, "rdy_scan spun %" PRId64 " us", fakeSpun_us - spun);
+    printf("rdy_scan: %.2f transactions/channel (%.2f OS polls), %" PRId64 " us/scan\n",
+           (fakeAds[0].configWrites - writes + fakeAds[0].reads - reads) / (scans * 4.0), polls / (scans * 4.0),
+           (fakeNow_us - begin) / scans);
+
+    EXPECT(ads111x_rdy_free(&acquisition) == ESP_OK && acquisition.sleep_timer == NULL, "rdy_free");
+}
+
+static void test_arrayScan(void)
+{
+    static ads111x_array_t array;
+    i2c_dev_t devs[2];
+    memset(devs, 0, sizeof(devs));
+
+    fakeAds_reset();
+    for (size_t d = 0; d < 2; d++) {
+        EXPECT(ads111x_init_desc(&devs[d], ADS111X_ADDR_GND + d, 0, GPIO_NUM_0, GPIO_NUM_0) == ESP_OK, "init_desc %u", (unsigned)d);
+    }
+    EXPECT(ads111x_array_init(&array, devs, 2, inputs, 4, GPIO_NUM_NC, ADS111X_GAIN_2V048, ADS111X_DATA_RATE_475) == ESP_OK, "array_init");
+    // Channel = device x inputs + input
+    EXPECT(ads111x_array_set_gain(&array, 5, ADS111X_GAIN_0V512) == ESP_OK, "array_set_gain");
+
+    int16_t values[8] = {0};
+    uint32_t writes = fakeAds[0].configWrites + fakeAds[1].configWrites;
+    int64_t spun = fakeSpun_us;
+    EXPECT(ads111x_array_scan(&array, values) == ESP_OK, "array_scan");
+    for (size_t d = 0; d < 2; d++)
+    {
+        for (size_t c = 0; c < 4; c++)
+        {
+            ads111x_gain_t gain = (d * 4 + c == 5) ? ADS111X_GAIN_0V512 : ADS111X_GAIN_2V048;
+            EXPECT(values[d * 4 + c] == fakeAds_code(d, (uint16_t)((inputs[c] << 12) | (gain << 9))),
+                   "device %u input %u: %d", (unsigned)d, (unsigned)c, values[d * 4 + c]);
+        }
+    }
+    EXPECT(fakeAds[0].configWrites + fakeAds[1].configWrites - writes == 8, "array_scan: %" PRIu32 " config writes",
+           fakeAds[0].configWrites + fakeAds[1].configWrites - writes);
+    EXPECT(fakeSpun_us == spun, "array_scan spun %" PRId64 " us", fakeSpun_us - spun);
+
+    // A reset device is reconfigured by array_verify
+    fakeAds[1].config = FAKE_CONFIG_RESET & 0x7FFFU;
+    fakeAds[1].thresholdHigh = 0x7FFFU;
+    EXPECT(ads111x_array_verify(&array) == ESP_ERR_INVALID_STATE, "array_verify did not report the reset");
+    EXPECT(fakeAds[1].thresholdHigh == 0x8000U, "array_verify did not restore ALERT/RDY thresholds");
+    EXPECT(ads111x_array_scan(&array, values) == ESP_OK && values[4] == fakeAds_code(1, (uint16_t)(inputs[0] << 12 | ADS111X_GAIN_2V048 << 9)),
+           "scan after array_verify: %d", values[4]);
+
+    ads111x_array_free(&array);
+    for (size_t d = 0; d < 2; d++) {
+        ads111x_free_desc(&devs[d]);
+    }
+}
+
+int main(void)
+{
+    i2c_dev_t dev;
+    memset(&dev, 0, sizeof(dev));
+    fakeAds_reset();
+
+    if (ads111x_init_desc(&dev, ADS111X_ADDR_GND, 0, GPIO_NUM_0, GPIO_NUM_0) != ESP_OK)
+    {
+        fprintf(stderr, "init_desc failed\n");
+        return 1;
+    }
+    test_configCache(&dev);
+    test_channelPaths(&dev);
+    test_verifyConfig(&dev);
+    test_rdyScan(&dev);
+    ads111x_free_desc(&dev);
+    test_arrayScan();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file binlog2csv.cpp
+ * @brief Convert a binary sampling log (<name>.bin, see component/DataManager/binlog.h)
+ *        back to the CSV layout written by the firmware (<name>.csv).
+ *
+ * Build (from Electronic-Nose/tools):
+ *   gcc -O2 -c ../component/DataManager/binlog.c -o binlog.o
+ *   g++ -std=c++17 -O2 -I../component/DataManager binlog2csv.cpp binlog.o -o binlog2csv
+ *
+ * Usage:
+ *   binlog2csv <input.bin> [output.csv]     (stdout when no output file is given)
+ *   binlog2csv --info <input.bin>            (print header only)
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "binlog.h"
+
+static const char *gainName(uint8_t gain)
+{
+    static const char *names[] = {"+-6.144V", "+-4.096V", "+-2.048V", "+-1.024V",
+                                  "+-0.512V", "+-0.256V", "+-0.256V", "+-0.256V"};
+    return gain < 8 ? names[gain] : "?";
+}
+
+static int dataRateValue(uint8_t dataRate)
+{
+    static const int values[] = {8, 16, 32, 64, 128, 250, 475, 860};
+    return dataRate < 8 ? values[dataRate] : -1;
+}
+
+int main(int argc, char **argv)
+{
+    bool infoOnly = false;
+    int argi = 1;
+    if (argi < argc && std::strcmp(argv[argi], "--info") == 0)
+    {
+        infoOnly = true;
+        argi++;
+    }
+    if (argi >= argc)
+    {
+        std::cerr << "usage: " << argv[0] << " [--info] <input.bin> [output.csv]\n";
+        return 2;
+    }
+
+    std::ifstream input(argv[argi], std::ios::binary);
+    if (!input)
+    {
+        std::cerr << "cannot open " << argv[argi] << "\n";
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    binlog_header_st header;
+    binlog_codec_st codec;
+    size_t position = binlog_decodeHeader(&header, &codec, data.data(), data.size());
+    if (position == 0)
+    {
+        std::cerr << argv[argi] << ": not a binary log (version " << BINLOG_VERSION_MIN << ".." << BINLOG_VERSION << ")\n";
+        return 1;
+    }
+
+    const bool hasTime = (header.flags & BINLOG_FLAG_SAMPLE_TIME) != 0;
+    std::fprintf(stderr, "device=%s version=%u channels=%u gain=%s%s rate=%dSPS interval=%ums start=%lld env=%s time=%s\n",
+                 header.deviceName, header.version, header.channelCount, gainName(header.gain),
+                 (header.flags & BINLOG_FLAG_CHANNEL_GAIN) ? " (auto, per record)" : "", dataRateValue(header.dataRate),
+                 (unsigned)header.sampleInterval_ms, (long long)header.startTime,
+                 (header.flags & BINLOG_FLAG_ENVIRONMENT) ? "yes" : "no", hasTime ? "per record" : "no");
+    if (infoOnly) {
+        return 0;
+    }
+
+    FILE *output = stdout;
+    if (argi + 1 < argc)
+    {
+        output = std::fopen(argv[argi + 1], "w");
+        if (output == nullptr)
+        {
+            std::cerr << "cannot create " << argv[argi + 1] << "\n";
+            return 1;
+        }
+    }
+
+    // Giữ đúng layout CSV của firmware: STT,Time_us,Temperature,Humidity,Sensor1..SensorN (giá trị chuẩn hóa về ±2.048 V),
+    // log chưa có thời điểm lấy mẫu thì không có cột Time_us
+    std::fprintf(output, "STT,%sTemperature,Humidity", hasTime ? "Time_us," : "");
+    for (unsigned i = 0; i < header.channelCount; i++) {
+        std::fprintf(output, ",Sensor%u", i + 1);
+    }
+    std::fprintf(output, "\n");
+
+    size_t records = 0;
+    binlog_record_st record;
+    while (position < data.size())
+    {
+        size_t consumed = binlog_decodeRecord(&codec, &record, data.data() + position, data.size() - position);
+        if (consumed == 0)
+        {
+            std::fprintf(stderr, "warning: %zu trailing bytes are not a complete record (cut log?)\n",
+                         data.size() - position);
+            break;
+        }
+        position += consumed;
+        records++;
+
+        std::fprintf(output, "%d,", (int)record.timeStamp);
+        if (hasTime) {
+            std::fprintf(output, "%lld,", (long long)binlog_recordTimeUs(&record));
+        }
+        std::fprintf(output, "%.2f,%.2f", record.temperature_c / 100.0, record.humidity_c / 100.0);
+        for (unsigned i = 0; i < header.channelCount; i++) {
+            char value[BINLOG_NORMALIZED_TEXT_MAX_SIZE];
+            binlog_formatNormalized(record.ADC_Value[i], record.gain[i], value, sizeof(value));
+            std::fprintf(output, ",%s", value);
+        }
+        std::fprintf(output, "\n");
+    }
+
+    if (output != stdout) {
+        std::fclose(output);
+    }
+    std::fprintf(stderr, "%zu records, %zu bytes (%.1f bytes/record)\n", records, data.size(),
+                 records ? (double)(data.size() - BINLOG_HEADER_SIZE) / records : 0.0);
+    return 0;
+}
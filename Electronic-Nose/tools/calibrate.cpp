@@ -0,0 +1,438 @@
+/**
+ * @file calibrate.cpp
+ * @brief Build the calibration table blob uploaded to the device (POST /api/calibration, see
+ *        component/Calibration/calibration.h) and apply it to archived logs with the firmware code.
+ *
+ * Build (from Electronic-Nose/tools):
+ *   gcc -O2 -c ../component/DataManager/binlog.c -o binlog.o
+ *   gcc -O2 -c ../component/Calibration/calibration.c -o calibration.o
+ *   g++ -std=c++17 -O2 -I../component/DataManager -I../component/Calibration calibrate.cpp binlog.o calibration.o -lm -o calibrate
+ *
+ * Usage:
+ *   calibrate --build <curves.txt> <table.cal>           (text curves -> blob)
+ *   calibrate --info <table.cal>                         (print the curves of a blob)
+ *   calibrate <table.cal> <input.csv|input.bin> [output.csv]
+ *                                                         (log + Conc1..ConcN columns, stdout when no output file)
+ *   curl --data-binary @table.cal -H "Content-Type: application/octet-stream" http://<device>/api/calibration
+ *
+ * curves.txt, one channel per line ('#' starts a comment, channels not listed have no curve):
+ *   <channel 1..16> <linear|loglog> <tRef °C> <hRef %RH> <tempCoeff ppm/°C> <humCoeff ppm/%RH> <code>:<value> ...
+ *   e.g.  3 loglog 25 50 -3000 1000 11500:0.050 14000:0.250 20000:1.500
+ * Codes are normalized to ±2.048 V (the Sensor columns of the CSV), values in the unit of the
+ * device (CONFIG_CALIBRATION_UNIT), 3 decimals.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "binlog.h"
+#include "calibration.h"
+
+static bool readFile(const char *path, std::vector<uint8_t> &data)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool loadTable(const char *path, calibration_table_st &table)
+{
+    std::vector<uint8_t> data;
+    if (!readFile(path, data))
+    {
+        std::cerr << "cannot open " << path << "\n";
+        return false;
+    }
+    if (!calibration_decode(&table, data.data(), data.size()))
+    {
+        std::cerr << path << ": not a calibration table (bad magic, version " << CALIBRATION_VERSION << " or CRC)\n";
+        return false;
+    }
+    return true;
+}
+
+static int32_t toFixed(double value, double scale)
+{
+    return (int32_t)std::llround(value * scale);
+}
+
+static int buildTable(const char *curvesPath, const char *tablePath)
+{
+    std::ifstream input(curvesPath);
+    if (!input)
+    {
+        std::cerr << "cannot open " << curvesPath << "\n";
+        return 1;
+    }
+
+    calibration_table_st table;
+    std::memset(&table, 0, sizeof(table));
+    std::string line;
+    for (unsigned lineNumber = 1; std::getline(input, line); lineNumber++)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        unsigned channel;
+        std::string type;
+        double tRef, hRef, tempCoeff, humCoeff;
+        if (!(fields >> channel)) {
+            continue;   // dòng trống / chú thích
+        }
+        if (!(fields >> type >> tRef >> hRef >> tempCoeff >> humCoeff) || channel < 1 || channel > CALIBRATION_CHANNEL_MAX)
+        {
+            std::cerr << curvesPath << ":" << lineNumber << ": expected <channel> <type> <tRef> <hRef> <tempCoeff> <humCoeff> <code>:<value>...\n";
+            return 1;
+        }
+
+        calibration_curve_st &curve = table.curve[channel - 1];
+        if (curve.type != CALIBRATION_CURVE_NONE)
+        {
+            std::cerr << curvesPath << ":" << lineNumber << ": channel " << channel << " defined twice\n";
+            return 1;
+        }
+        curve.type = CALIBRATION_CURVE_NONE;
+        for (uint8_t t = CALIBRATION_CURVE_LINEAR; t < CALIBRATION_CURVE_MAX; t++)
+        {
+            if (type == calibration_curveName(t)) {
+                curve.type = t;
+            }
+        }
+        curve.tRef_centi = (int16_t)toFixed(tRef, 100);
+        curve.hRef_centi = (int16_t)toFixed(hRef, 100);
+        curve.tempCoeff_ppm = toFixed(tempCoeff, 1);
+        curve.humCoeff_ppm = toFixed(humCoeff, 1);
+
+        std::string point;
+        while (fields >> point)
+        {
+            double code, value;
+            char separator;
+            std::istringstream pair(point);
+            if (curve.pointCount == CALIBRATION_POINT_MAX || !(pair >> code >> separator >> value) || separator != ':')
+            {
+                std::cerr << curvesPath << ":" << lineNumber << ": bad point '" << point << "' (max "
+                          << CALIBRATION_POINT_MAX << " points <code>:<value>)\n";
+                return 1;
+            }
+            curve.point[curve.pointCount].code = toFixed(code, 1);
+            curve.point[curve.pointCount].value = toFixed(value, 1000);
+            curve.pointCount++;
+        }
+        if (curve.type == CALIBRATION_CURVE_NONE || !calibration_validateCurve(&curve))
+        {
+            std::cerr << curvesPath << ":" << lineNumber << ": invalid curve (type linear|loglog, 2.." << CALIBRATION_POINT_MAX
+                      << " points, increasing codes, loglog needs codes and values > 0)\n";
+            return 1;
+        }
+        // Round trip như firmware: bảng dựng từ đường cong phải cho lại đúng giá trị tại mỗi điểm
+        calibration_table_st single;
+        std::memset(&single, 0, sizeof(single));
+        single.channelCount = 1;
+        single.curve[0] = curve;
+        static calibration_engine_st engine;
+        if (!calibration_build(&engine, &single))
+        {
+            std::cerr << curvesPath << ":" << lineNumber << ": the lookup table does not reproduce the points of channel "
+                      << channel << "\n";
+            return 1;
+        }
+        if (channel > table.channelCount) {
+            table.channelCount = (uint8_t)channel;
+        }
+    }
+    if (table.channelCount == 0)
+    {
+        std::cerr << curvesPath << ": no curve\n";
+        return 1;
+    }
+
+    uint8_t blob[CALIBRATION_BLOB_MAX_SIZE];
+    size_t size = calibration_encode(&table, blob, sizeof(blob));
+    FILE *output = std::fopen(tablePath, "wb");
+    if (size == 0 || output == nullptr || std::fwrite(blob, 1, size, output) != size)
+    {
+        std::cerr << "cannot write " << tablePath << "\n";
+        if (output != nullptr) {
+            std::fclose(output);
+        }
+        return 1;
+    }
+    std::fclose(output);
+    std::fprintf(stderr, "%s: %u channels, %zu bytes\n", tablePath, table.channelCount, size);
+    return 0;
+}
+
+static int printTable(const calibration_table_st &table)
+{
+    for (unsigned i = 0; i < table.channelCount; i++)
+    {
+        const calibration_curve_st &curve = table.curve[i];
+        if (curve.type == CALIBRATION_CURVE_NONE) {
+            continue;
+        }
+        std::printf("%u %s %.2f %.2f %d %d", i + 1, calibration_curveName(curve.type), curve.tRef_centi / 100.0,
+                    curve.hRef_centi / 100.0, (int)curve.tempCoeff_ppm, (int)curve.humCoeff_ppm);
+        for (unsigned p = 0; p < curve.pointCount; p++) {
+            std::printf(" %d:%.3f", (int)curve.point[p].code, curve.point[p].value / 1000.0);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
+
+/**
+ * @brief Một dòng log: các cột gốc (text) và các giá trị cần cho calibration_apply().
+ */
+struct Row
+{
+    std::string text;
+    int32_t temperatureCenti;
+    int32_t humidityCenti;
+    std::vector<int32_t> codes;
+};
+
+static void writeRow(FILE *output, const calibration_engine_st &engine, const Row &row)
+{
+    std::vector<int32_t> values(row.codes.size());
+    calibration_apply(&engine, row.codes.data(), (uint8_t)row.codes.size(), row.temperatureCenti, row.humidityCenti,
+                      values.data());
+    std::fprintf(output, "%s", row.text.c_str());
+    for (int32_t value : values)
+    {
+        if (value == CALIBRATION_VALUE_NONE) {
+            std::fprintf(output, ",");
+        } else {
+            std::fprintf(output, ",%.3f", value / 1000.0);
+        }
+    }
+    std::fprintf(output, "\n");
+}
+
+static void writeHeader(FILE *output, const std::string &columns, size_t channelCount)
+{
+    std::fprintf(output, "%s", columns.c_str());
+    for (size_t i = 0; i < channelCount; i++) {
+        std::fprintf(output, ",Conc%zu", i + 1);
+    }
+    std::fprintf(output, "\n");
+}
+
+/**
+ * @brief Số thập phân của CSV -> 0.01 đơn vị, làm tròn như firmware ghi (2 chữ số).
+ *        Trống hoặc không phải số -> CALIBRATION_VALUE_NONE.
+ */
+static int32_t parseCenti(const std::string &field)
+{
+    char *end = nullptr;
+    double value = std::strtod(field.c_str(), &end);
+    if (field.empty() || end == field.c_str() || !std::isfinite(value) || std::fabs(value) > 2.0e7) {
+        return CALIBRATION_VALUE_NONE;
+    }
+    return (int32_t)std::llround(value * 100.0);
+}
+
+/**
+ * @brief Như firmware: không có số đo T/H hợp lệ thì frame ghi 0.00/0.00 và không bù T/H.
+ */
+static void environmentCenti(int32_t &temperatureCenti, int32_t &humidityCenti)
+{
+    if (temperatureCenti == CALIBRATION_VALUE_NONE || humidityCenti == CALIBRATION_VALUE_NONE ||
+        (temperatureCenti == 0 && humidityCenti == 0))
+    {
+        temperatureCenti = CALIBRATION_VALUE_NONE;
+        humidityCenti = CALIBRATION_VALUE_NONE;
+    }
+}
+
+static std::vector<std::string> splitCsv(const std::string &line)
+{
+    std::vector<std::string> fields;
+    std::istringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+static int applyCsv(const calibration_engine_st &engine, const std::vector<uint8_t> &data, FILE *output)
+{
+    std::istringstream input(std::string(data.begin(), data.end()));
+    std::string line;
+    if (!std::getline(input, line))
+    {
+        std::cerr << "empty CSV\n";
+        return 1;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+
+    // Cột theo tên: STT,[Time_us,]Temperature,Humidity,Sensor1..SensorN
+    std::vector<std::string> columns = splitCsv(line);
+    int temperatureColumn = -1, humidityColumn = -1;
+    std::vector<size_t> sensorColumns;
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        if (columns[c] == "Temperature") {
+            temperatureColumn = (int)c;
+        } else if (columns[c] == "Humidity") {
+            humidityColumn = (int)c;
+        } else if (columns[c].rfind("Sensor", 0) == 0) {
+            sensorColumns.push_back(c);
+        }
+    }
+    if (sensorColumns.empty() || sensorColumns.size() > CALIBRATION_CHANNEL_MAX)
+    {
+        std::cerr << "CSV header has no Sensor1..SensorN columns (max " << CALIBRATION_CHANNEL_MAX << ")\n";
+        return 1;
+    }
+    writeHeader(output, line, sensorColumns.size());
+
+    size_t rows = 0;
+    Row row;
+    row.codes.resize(sensorColumns.size());
+    while (std::getline(input, line))
+    {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::vector<std::string> fields = splitCsv(line);
+        if (fields.size() < columns.size()) {
+            continue;   // dòng cuối bị cắt khi mất điện
+        }
+        row.text = line;
+        row.temperatureCenti = (temperatureColumn >= 0) ? parseCenti(fields[temperatureColumn]) : CALIBRATION_VALUE_NONE;
+        row.humidityCenti = (humidityColumn >= 0) ? parseCenti(fields[humidityColumn]) : CALIBRATION_VALUE_NONE;
+        environmentCenti(row.temperatureCenti, row.humidityCenti);
+        for (size_t i = 0; i < sensorColumns.size(); i++) {
+            // Như firmware: binlog_normalizeCenti() / 100
+            row.codes[i] = parseCenti(fields[sensorColumns[i]]) / 100;
+        }
+        writeRow(output, engine, row);
+        rows++;
+    }
+    std::fprintf(stderr, "%zu rows\n", rows);
+    return 0;
+}
+
+static int applyBinlog(const calibration_engine_st &engine, const std::vector<uint8_t> &data, FILE *output)
+{
+    binlog_header_st header;
+    binlog_codec_st codec;
+    size_t position = binlog_decodeHeader(&header, &codec, data.data(), data.size());
+    if (position == 0 || header.channelCount > CALIBRATION_CHANNEL_MAX) {
+        return -1;
+    }
+
+    const bool hasTime = (header.flags & BINLOG_FLAG_SAMPLE_TIME) != 0;
+    const bool hasEnvironment = (header.flags & BINLOG_FLAG_ENVIRONMENT) != 0;
+    std::string columns = hasTime ? "STT,Time_us,Temperature,Humidity" : "STT,Temperature,Humidity";
+    for (unsigned i = 0; i < header.channelCount; i++) {
+        columns += ",Sensor" + std::to_string(i + 1);
+    }
+    writeHeader(output, columns, header.channelCount);
+
+    size_t rows = 0;
+    Row row;
+    row.codes.resize(header.channelCount);
+    binlog_record_st record;
+    while (position < data.size())
+    {
+        size_t consumed = binlog_decodeRecord(&codec, &record, data.data() + position, data.size() - position);
+        if (consumed == 0)
+        {
+            std::fprintf(stderr, "warning: %zu trailing bytes are not a complete record (cut log?)\n",
+                         data.size() - position);
+            break;
+        }
+        position += consumed;
+
+        char text[64];
+        std::snprintf(text, sizeof(text), "%d,", (int)record.timeStamp);
+        row.text = text;
+        if (hasTime)
+        {
+            std::snprintf(text, sizeof(text), "%lld,", (long long)binlog_recordTimeUs(&record));
+            row.text += text;
+        }
+        std::snprintf(text, sizeof(text), "%.2f,%.2f", record.temperature_c / 100.0, record.humidity_c / 100.0);
+        row.text += text;
+        row.temperatureCenti = hasEnvironment ? record.temperature_c : CALIBRATION_VALUE_NONE;
+        row.humidityCenti = hasEnvironment ? record.humidity_c : CALIBRATION_VALUE_NONE;
+        environmentCenti(row.temperatureCenti, row.humidityCenti);
+        for (unsigned i = 0; i < header.channelCount; i++)
+        {
+            char value[BINLOG_NORMALIZED_TEXT_MAX_SIZE];
+            binlog_formatNormalized(record.ADC_Value[i], record.gain[i], value, sizeof(value));
+            row.text += ",";
+            row.text += value;
+            row.codes[i] = binlog_normalizeCenti(record.ADC_Value[i], record.gain[i]) / 100;
+        }
+        writeRow(output, engine, row);
+        rows++;
+    }
+    std::fprintf(stderr, "%zu records\n", rows);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && std::strcmp(argv[1], "--build") == 0) {
+        return buildTable(argv[2], argv[3]);
+    }
+    if (argc == 3 && std::strcmp(argv[1], "--info") == 0)
+    {
+        calibration_table_st table;
+        return loadTable(argv[2], table) ? printTable(table) : 1;
+    }
+    if (argc < 3 || argc > 4 || argv[1][0] == '-')
+    {
+        std::cerr << "usage: " << argv[0] << " --build <curves.txt> <table.cal>\n"
+                  << "       " << argv[0] << " --info <table.cal>\n"
+                  << "       " << argv[0] << " <table.cal> <input.csv|input.bin> [output.csv]\n";
+        return 2;
+    }
+
+    calibration_table_st table;
+    static calibration_engine_st engine;
+    if (!loadTable(argv[1], table) || !calibration_build(&engine, &table)) {
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    if (!readFile(argv[2], data))
+    {
+        std::cerr << "cannot open " << argv[2] << "\n";
+        return 1;
+    }
+
+    FILE *output = stdout;
+    if (argc == 4)
+    {
+        output = std::fopen(argv[3], "w");
+        if (output == nullptr)
+        {
+            std::cerr << "cannot create " << argv[3] << "\n";
+            return 1;
+        }
+    }
+    int result = applyBinlog(engine, data, output);
+    if (result < 0) {
+        result = applyCsv(engine, data, output);
+    }
+    if (output != stdout) {
+        std::fclose(output);
+    }
+    return result;
+}
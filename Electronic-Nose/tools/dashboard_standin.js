@@ -0,0 +1,189 @@
+#!/usr/bin/env node
+/**
+ * @file dashboard_standin.js
+ * @brief Stand-in cho POST /api/esp32/data của EMPortableServer, đo chi phí upload của firmware.
+ *
+ * Server mode (trỏ DASHBOARD_HOST/PORT của ESP32 về máy chạy script):
+ *   node dashboard_standin.js [--port 3000] [--delay ms] [--close]
+ *     --delay  giả lập server chậm (ms mỗi request)
+ *     --close  trả "Connection: close" (hành vi của một client không keep-alive)
+ *   In mỗi 10 s và khi Ctrl+C: requests, samples, requests/sample, TCP connections,
+ *   requests/connection, kích thước batch, số mẫu gửi bù từ backlog (header X-Backlog).
+ *   Tắt/bật script để giả lập dashboard mất kết nối. Latency end-to-end do firmware in ra
+ *   (log "Dashboard POST success ... latency avg/max").
+ *
+ * Simulate mode (không cần ESP32, chạy server + client giả lập trong cùng process):
+ *   node dashboard_standin.js --simulate [--samples 60] [--period 200] [--batch 8] [--latency 1000] [--channels 4]
+ *     --channels  số kênh cảm biến mỗi mẫu (EtOH1..EtOHn, 4 x số ADS111x, tối đa 16)
+ *     --batch 1 --no-keepalive   tương đương firmware cũ (một kết nối + một request mỗi mẫu)
+ *   In requests/sample, connections và latency end-to-end (lúc tạo mẫu -> server trả lời).
+ */
+
+'use strict';
+
+const http = require('http');
+
+function parseArgs(argv) {
+  const options = {
+    port: 3000, delay: 0, close: false, simulate: false,
+    samples: 60, period: 200, batch: 8, latency: 1000, keepAlive: true, channels: 4,
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    const next = () => Number(argv[++i]);
+    if (arg === '--port') options.port = next();
+    else if (arg === '--delay') options.delay = next();
+    else if (arg === '--close') options.close = true;
+    else if (arg === '--simulate') options.simulate = true;
+    else if (arg === '--samples') options.samples = next();
+    else if (arg === '--period') options.period = next();
+    else if (arg === '--batch') options.batch = Math.max(1, next());
+    else if (arg === '--latency') options.latency = next();
+    else if (arg === '--no-keepalive') options.keepAlive = false;
+    else if (arg === '--channels') options.channels = Math.min(16, Math.max(1, next()));
+    else {
+      console.error(`Unknown option: ${arg}`);
+      process.exit(2);
+    }
+  }
+  return options;
+}
+
+function createStats() {
+  return { requests: 0, samples: 0, backlogSamples: 0, connections: 0, bytes: 0, maxBatch: 0, errors: 0 };
+}
+
+function printStats(stats, label) {
+  const perSample = stats.samples ? (stats.requests / stats.samples).toFixed(3) : '-';
+  const perConnection = stats.connections ? (stats.requests / stats.connections).toFixed(1) : '-';
+  console.log(`[${label}] requests=${stats.requests} samples=${stats.samples} requests/sample=${perSample} ` +
+              `connections=${stats.connections} requests/connection=${perConnection} ` +
+              `avg batch=${stats.requests ? (stats.samples / stats.requests).toFixed(1) : '-'} max batch=${stats.maxBatch} ` +
+              `bytes/sample=${stats.samples ? Math.round(stats.bytes / stats.samples) : '-'} backlog samples=${stats.backlogSamples} errors=${stats.errors}`);
+}
+
+function startServer(options, stats) {
+  const server = http.createServer((req, res) => {
+    if (req.method !== 'POST' || req.url !== '/api/esp32/data') {
+      res.writeHead(404).end();
+      return;
+    }
+    const chunks = [];
+    req.on('data', (chunk) => chunks.push(chunk));
+    req.on('end', () => {
+      const body = Buffer.concat(chunks);
+      let samples;
+      try {
+        const parsed = JSON.parse(body.toString());
+        samples = Array.isArray(parsed) ? parsed : [parsed];
+      } catch (error) {
+        stats.errors++;
+        res.writeHead(400, { 'Content-Type': 'application/json' });
+        res.end(JSON.stringify({ success: false, message: error.message }));
+        return;
+      }
+      stats.requests++;
+      stats.samples += samples.length;
+      if (req.headers['x-backlog'] === '1') stats.backlogSamples += samples.length;
+      stats.bytes += body.length;
+      stats.maxBatch = Math.max(stats.maxBatch, samples.length);
+
+      setTimeout(() => {
+        const headers = { 'Content-Type': 'application/json' };
+        if (options.close) headers.Connection = 'close';
+        res.writeHead(200, headers);
+        res.end(JSON.stringify({ success: true, samples: samples.length }));
+      }, options.delay);
+    });
+  });
+  server.on('connection', () => stats.connections++);
+  server.keepAliveTimeout = 65000;
+  server.headersTimeout = 66000;
+  return server;
+}
+
+function post(agent, port, body) {
+  return new Promise((resolve, reject) => {
+    const req = http.request({
+      host: '127.0.0.1', port, path: '/api/esp32/data', method: 'POST', agent,
+      headers: { 'Content-Type': 'application/json', 'Content-Length': Buffer.byteLength(body) },
+    }, (res) => {
+      res.resume();
+      res.on('end', () => resolve(res.statusCode));
+    });
+    req.on('error', reject);
+    req.end(body);
+  });
+}
+
+/**
+ * Client giả lập cùng logic batch với sendDataToDashboard_task: POST khi đủ --batch mẫu
+ * hoặc khi mẫu cũ nhất đã chờ --latency ms.
+ */
+async function simulate(options, stats) {
+  const agent = new http.Agent({ keepAlive: options.keepAlive, maxSockets: 1 });
+  const latencies = [];
+  let batch = [];
+  let timer = null;
+  let sending = Promise.resolve();
+
+  const flush = () => {
+    if (timer) { clearTimeout(timer); timer = null; }
+    if (batch.length === 0) return;
+    const pending = batch;
+    batch = [];
+    const body = JSON.stringify(pending.length === 1 && options.batch === 1 ? pending[0].json : pending.map((s) => s.json));
+    sending = sending.then(() => post(agent, options.port, body)).then(() => {
+      const done = process.hrtime.bigint();
+      pending.forEach((sample) => latencies.push(Number(done - sample.created) / 1e6));
+    }).catch(() => { stats.errors++; });
+  };
+
+  for (let i = 0; i < options.samples; i++) {
+    const json = { Time: new Date().toISOString(), Temperature: 25.5, Humidity: 60.25, Pressure: 0 };
+    for (let channel = 1; channel <= options.channels; channel++) {
+      json[`EtOH${channel}`] = 10000 + channel * 1000 + i;
+    }
+    if (batch.length === 0) json.ip = '192.168.1.50';
+    batch.push({ json, created: process.hrtime.bigint() });
+    if (batch.length >= options.batch) {
+      flush();
+    } else if (!timer) {
+      timer = setTimeout(flush, options.latency);
+    }
+    await new Promise((resolve) => setTimeout(resolve, options.period));
+  }
+  flush();
+  await sending;
+  agent.destroy();
+
+  latencies.sort((a, b) => a - b);
+  const avg = latencies.reduce((sum, value) => sum + value, 0) / (latencies.length || 1);
+  const p95 = latencies[Math.min(latencies.length - 1, Math.floor(latencies.length * 0.95))] || 0;
+  console.log(`[simulate] batch=${options.batch} latency=${options.latency} ms keep-alive=${options.keepAlive} channels=${options.channels} ` +
+              `e2e latency avg=${avg.toFixed(1)} ms p95=${p95.toFixed(1)} ms max=${(latencies[latencies.length - 1] || 0).toFixed(1)} ms`);
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  const stats = createStats();
+  const server = startServer(options, stats);
+
+  await new Promise((resolve) => server.listen(options.port, '0.0.0.0', resolve));
+
+  if (options.simulate) {
+    await simulate(options, stats);
+    printStats(stats, 'simulate');
+    server.close();
+    return;
+  }
+
+  console.log(`Stand-in dashboard listening on :${options.port} (POST /api/esp32/data)`);
+  setInterval(() => printStats(stats, new Date().toISOString()), 10000).unref();
+  process.on('SIGINT', () => {
+    printStats(stats, 'total');
+    process.exit(0);
+  });
+}
+
+main();
@@ -0,0 +1,225 @@
+/**
+ * @file dht_decode.c
+ * @brief Decode DHT11/DHT22 pulse trains on the host with the firmware decoder (component/dht/dht_decoder.c).
+ *
+ * Build (from Electronic-Nose/tools):
+ *   gcc -O2 -Wall -I../component/dht dht_decode.c ../component/dht/dht_decoder.c -o dht_decode
+ *
+ * Usage:
+ *   dht_decode [--dht11] <pulses.txt|->   one train per line, "L80 H80 L50 H27 ...". Text before
+ *                                         "pulses:" is ignored, so the firmware debug log
+ *                                         ("dht: pulses: L80 ...") can be piped in as is.
+ *   dht_decode --self-test                decode synthetic trains (timing jitter, RMT artifacts,
+ *                                         corrupted frames), exit status 1 on failure.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "dht_decoder.h"
+
+static size_t parsePulses(const char *text, dht_pulse_t *pulses, size_t size)
+{
+    const char *start = strstr(text, "pulses:");
+    const char *p = start ? start + strlen("pulses:") : text;
+    size_t count = 0;
+
+    while (*p && count < size) {
+        while (*p && !(toupper((unsigned char)*p) == 'L' || toupper((unsigned char)*p) == 'H')) p++;
+        if (!*p) break;
+        char level = (char)toupper((unsigned char)*p++);
+        char *end;
+        unsigned long duration = strtoul(p, &end, 10);
+        if (end == p) continue;
+        pulses[count].level = level == 'H';
+        pulses[count].duration_us = duration > 0xFFFF ? 0xFFFF : (uint16_t)duration;
+        count++;
+        p = end;
+    }
+    return count;
+}
+
+static int decodeFile(FILE *input, dht_type_t type)
+{
+    char line[4096];
+    dht_pulse_t pulses[256];
+    int trains = 0, failures = 0;
+
+    while (fgets(line, sizeof(line), input)) {
+        size_t count = parsePulses(line, pulses, sizeof(pulses) / sizeof(pulses[0]));
+        if (count == 0) continue;
+        trains++;
+
+        uint8_t data[DHT_DATA_BYTES];
+        float humidity = 0, temperature = 0;
+        dht_decode_result_t result = dht_decode_pulses(pulses, count, data);
+        printf("#%d %zu pulses: %s, bytes %02X %02X %02X %02X %02X", trains, count,
+               dht_decode_result_name(result), data[0], data[1], data[2], data[3], data[4]);
+        if (result == DHT_DECODE_OK && dht_convert(type, data, &humidity, &temperature)) {
+            printf(", %.1f %%RH %.1f C\n", humidity, temperature);
+        } else {
+            printf("%s\n", result == DHT_DECODE_OK ? ", out of range" : "");
+            failures++;
+        }
+    }
+    printf("%d trains, %d failed\n", trains, failures);
+    return failures ? 1 : 0;
+}
+
+/*------------------------------------ Self test ------------------------------------ */
+
+typedef struct
+{
+    int responseLow, responseHigh, bitLow, zeroHigh, oneHigh, jitter;
+    bool hostLow;       /* train starts with the tail of the host start pulse */
+    bool rmtEnd;        /* end low followed by a zero length symbol, as RMT reports the idle line */
+} trainShape_t;
+
+static unsigned testSeed = 1;
+
+static int jitter(int amount)
+{
+    testSeed = testSeed * 1103515245U + 12345U;
+    return amount ? (int)((testSeed >> 16) % (unsigned)(2 * amount + 1)) - amount : 0;
+}
+
+static size_t buildTrain(const uint8_t data[DHT_DATA_BYTES], const trainShape_t *shape, dht_pulse_t *pulses)
+{
+    size_t count = 0;
+#define PUSH(lvl, us) do { pulses[count].level = (lvl); pulses[count].duration_us = (uint16_t)((us) + jitter(shape->jitter)); count++; } while (0)
+    if (shape->hostLow) PUSH(0, 900);
+    PUSH(1, 30);
+    PUSH(0, shape->responseLow);
+    PUSH(1, shape->responseHigh);
+    for (size_t bit = 0; bit < DHT_DATA_BITS; bit++) {
+        PUSH(0, shape->bitLow);
+        PUSH(1, (data[bit / 8] & (0x80 >> (bit % 8))) ? shape->oneHigh : shape->zeroHigh);
+    }
+    PUSH(0, 50);
+    if (shape->rmtEnd) {
+        pulses[count].level = 1;
+        pulses[count].duration_us = 0;
+        count++;
+    }
+#undef PUSH
+    return count;
+}
+
+static int failures = 0;
+
+static void expect(const char *name, dht_decode_result_t result, dht_decode_result_t expected)
+{
+    if (result != expected) {
+        printf("FAIL %s: %s, expected %s\n", name, dht_decode_result_name(result), dht_decode_result_name(expected));
+        failures++;
+    } else {
+        printf("ok   %s: %s\n", name, dht_decode_result_name(result));
+    }
+}
+
+static void expectValues(const char *name, dht_type_t type, const uint8_t data[DHT_DATA_BYTES], float humidity, float temperature)
+{
+    float h = 0, t = 0;
+    if (!dht_convert(type, data, &h, &t) || h < humidity - 0.01f || h > humidity + 0.01f ||
+        t < temperature - 0.01f || t > temperature + 0.01f) {
+        printf("FAIL %s: %.1f %%RH %.1f C, expected %.1f %.1f\n", name, h, t, humidity, temperature);
+        failures++;
+    }
+}
+
+static int selfTest(void)
+{
+    const trainShape_t nominal = {80, 80, 50, 27, 70, 0, false, false};
+    const trainShape_t rmt = {80, 80, 50, 27, 70, 6, true, true};
+    const trainShape_t slowSensor = {95, 90, 60, 35, 78, 4, false, true};
+    const trainShape_t fastSensor = {70, 72, 45, 22, 62, 4, false, true};
+    /* 65.2 %RH, 23.4 C; -10.1 C; DHT11 55 %RH 24 C */
+    const uint8_t dht22[DHT_DATA_BYTES] = {0x02, 0x8C, 0x00, 0xEA, 0x78};
+    const uint8_t dht22Negative[DHT_DATA_BYTES] = {0x01, 0xF4, 0x80, 0x65, 0xDA};
+    const uint8_t dht11[DHT_DATA_BYTES] = {55, 0, 24, 0, 79};
+    dht_pulse_t pulses[DHT_PULSES_MAX + 8];
+    uint8_t data[DHT_DATA_BYTES];
+    size_t count;
+
+    count = buildTrain(dht22, &nominal, pulses);
+    expect("dht22 nominal", dht_decode_pulses(pulses, count, data), DHT_DECODE_OK);
+    expectValues("dht22 nominal", DHT_TYPE_DHT22, data, 65.2f, 23.4f);
+
+    int run;
+    for (run = 0; run < 200; run++) {
+        const trainShape_t *shapes[] = {&rmt, &slowSensor, &fastSensor};
+        count = buildTrain(dht22, shapes[run % 3], pulses);
+        if (dht_decode_pulses(pulses, count, data) != DHT_DECODE_OK || memcmp(data, dht22, sizeof(data)) != 0) {
+            printf("FAIL jitter run %d\n", run);
+            failures++;
+            break;
+        }
+    }
+    if (run == 200) printf("ok   200 trains with timing jitter\n");
+
+    count = buildTrain(dht22Negative, &rmt, pulses);
+    expect("dht22 negative", dht_decode_pulses(pulses, count, data), DHT_DECODE_OK);
+    expectValues("dht22 negative", DHT_TYPE_DHT22, data, 50.0f, -10.1f);
+
+    count = buildTrain(dht11, &rmt, pulses);
+    expect("dht11", dht_decode_pulses(pulses, count, data), DHT_DECODE_OK);
+    expectValues("dht11", DHT_TYPE_DHT11, data, 55.0f, 24.0f);
+
+    /* RMT có thể tách một mức thành nhiều symbol */
+    count = buildTrain(dht22, &nominal, pulses);
+    memmove(&pulses[12], &pulses[11], (count - 11) * sizeof(pulses[0]));
+    pulses[11].duration_us = 30;
+    pulses[12].duration_us = (uint16_t)(pulses[12].duration_us - 30);
+    expect("split pulse", dht_decode_pulses(pulses, count + 1, data), DHT_DECODE_OK);
+
+    uint8_t corrupted[DHT_DATA_BYTES];
+    memcpy(corrupted, dht22, sizeof(corrupted));
+    corrupted[1] ^= 0x01;
+    count = buildTrain(corrupted, &rmt, pulses);
+    expect("checksum", dht_decode_pulses(pulses, count, data), DHT_DECODE_CHECKSUM);
+
+    count = buildTrain(dht22, &nominal, pulses);
+    expect("truncated", dht_decode_pulses(pulses, count - 10, data), DHT_DECODE_TRUNCATED);
+    expect("no response", dht_decode_pulses(pulses + 3, count - 3, data), DHT_DECODE_NO_RESPONSE);
+    expect("empty", dht_decode_pulses(pulses, 0, data), DHT_DECODE_NO_RESPONSE);
+    pulses[20].duration_us = 300;
+    expect("stuck bit", dht_decode_pulses(pulses, count, data), DHT_DECODE_BAD_TIMING);
+
+    /* vòng text: dht_format_pulses -> parsePulses */
+    char text[1024];
+    dht_pulse_t parsed[DHT_PULSES_MAX + 8];
+    count = buildTrain(dht22, &rmt, pulses);
+    dht_format_pulses(pulses, count, text, sizeof(text));
+    size_t parsedCount = parsePulses(text, parsed, sizeof(parsed) / sizeof(parsed[0]));
+    expect("text round trip", dht_decode_pulses(parsed, parsedCount, data), DHT_DECODE_OK);
+
+    printf("%s\n", failures ? "SELF TEST FAILED" : "self test passed");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    dht_type_t type = DHT_TYPE_DHT22;
+    int argi = 1;
+
+    if (argc > 1 && strcmp(argv[1], "--self-test") == 0) return selfTest();
+    if (argi < argc && strcmp(argv[argi], "--dht11") == 0) {
+        type = DHT_TYPE_DHT11;
+        argi++;
+    }
+    if (argi >= argc) {
+        fprintf(stderr, "Usage: %s [--dht11] <pulses.txt|->\n       %s --self-test\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    FILE *input = strcmp(argv[argi], "-") == 0 ? stdin : fopen(argv[argi], "r");
+    if (!input) {
+        perror(argv[argi]);
+        return 2;
+    }
+    int status = decodeFile(input, type);
+    if (input != stdin) fclose(input);
+    return status;
+}
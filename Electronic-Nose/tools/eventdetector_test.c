@@ -0,0 +1,402 @@
+/**
+ * @file eventdetector_test.c
+ * @brief Host test of the exposure event detector (component/SignalProcessing/eventdetector.c):
+ *        feeds synthetic frame sequences of a 2-channel array and checks the event features.
+ *
+ * Build and run (from Electronic-Nose/tools):
+ *   gcc -O2 -Wall -I../component/SignalProcessing eventdetector_test.c ../component/SignalProcessing/eventdetector.c -o eventdetector_test
+ *   ./eventdetector_test           exit status 1 on failure
+ *
+ * Frames are FRAME_US apart, channel 0 around BASE0 and channel 1 around BASE1. Expected values
+ * are worked out by hand from the profiles; area and trace start at the frame that triggers the
+ * event, so the rise/area profiles use onsetFrames = 1 to keep them exact.
+ *
+ * Checks:
+ *   - invalid configurations are rejected
+ *   - onset: start time back-dated to the first frame over the threshold, onset delay per channel,
+ *     trigger mask, end after recoveryFrames frames back within recoveryPercent of the peak
+ *   - settle: no detection for settleFrames frames after init and after each event
+ *   - 10-90 % rise time interpolated between trace points, time to peak, area, recovery slope
+ *   - sign flip: signed peak, rise time and slope of a channel going negative
+ *   - truncated event after maxFrames
+ *   - reset after a sampling gap: event in progress dropped, baselines relearnt at the new level
+ *   - trace halving on a long event keeps the 10-90 % crossing exact on a linear ramp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "eventdetector.h"
+
+#define FRAME_US        100000      // 10 Hz decimated frames
+#define BASE0           1000
+#define BASE1           2000
+
+#define EXPECT(condition, ...) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "FAIL %s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            failures++; \
+        } \
+    } while (0)
+
+#define EXPECT_EQ(actual, expected) \
+    EXPECT((int64_t)(actual) == (int64_t)(expected), "%s = %" PRId64 ", expected %" PRId64, \
+           #actual, (int64_t)(actual), (int64_t)(expected))
+
+static int failures = 0;
+
+/* Bench: one detector, a frame clock and the last completed event */
+
+typedef struct
+{
+    eventDetector_st detector;
+    eventDetector_event_st event;
+    int64_t now_us;
+    uint32_t events;
+} bench_st;
+
+static const eventDetector_config_st benchConfig = {
+    .channelCount = 2,
+    .baselineShift = 4,
+    .onsetThreshold = 100,
+    .onsetFrames = 1,
+    .recoveryPercent = 20,
+    .recoveryFrames = 3,
+    .maxFrames = 1000,
+    .settleFrames = 5,
+};
+
+static void bench_init(bench_st *bench, const eventDetector_config_st *config)
+{
+    memset(bench, 0, sizeof(*bench));
+    bench->now_us = 1000000;
+    if (!eventDetector_init(&bench->detector, config))
+    {
+        fprintf(stderr, "eventDetector_init failed\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Push one frame of deviations from BASE0/BASE1, advance the clock.
+ *
+ * @return true when an event ended with this frame (copied to bench->event).
+ */
+static bool bench_push(bench_st *bench, int32_t delta0, int32_t delta1)
+{
+    const int32_t values[2] = { BASE0 + delta0, BASE1 + delta1 };
+    bool ended = eventDetector_push(&bench->detector, values, bench->now_us, &bench->event);
+    bench->now_us += FRAME_US;
+    bench->events += ended ? 1 : 0;
+    return ended;
+}
+
+/**
+ * @brief Push @p frames quiet frames, none may start an event.
+ */
+static void bench_quiet(bench_st *bench, uint32_t frames)
+{
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        bench_push(bench, 0, 0);
+        EXPECT(!eventDetector_active(&bench->detector), "event on quiet frame %" PRIu32, f);
+    }
+}
+
+/**
+ * @brief Push quiet frames until the event in progress ends, at most @p frames.
+ *
+ * @return Frames pushed, 0 if the event did not end.
+ */
+static uint32_t bench_recover(bench_st *bench, uint32_t frames)
+{
+    for (uint32_t f = 1; f <= frames; f++)
+    {
+        if (bench_push(bench, 0, 0)) {
+            return f;
+        }
+    }
+    return 0;
+}
+
+static void test_config(void)
+{
+    eventDetector_st detector;
+    eventDetector_config_st config = benchConfig;
+
+    EXPECT(eventDetector_init(&detector, &config), "valid configuration rejected");
+    config.channelCount = 0;
+    EXPECT(!eventDetector_init(&detector, &config), "channelCount 0 accepted");
+    config = benchConfig;
+    config.channelCount = EVENT_DETECTOR_CHANNEL_MAX + 1;
+    EXPECT(!eventDetector_init(&detector, &config), "too many channels accepted");
+    config = benchConfig;
+    config.baselineShift = 16;
+    EXPECT(!eventDetector_init(&detector, &config), "baselineShift 16 accepted");
+    config = benchConfig;
+    config.onsetThreshold = 0;
+    EXPECT(!eventDetector_init(&detector, &config), "onsetThreshold 0 accepted");
+    config = benchConfig;
+    config.recoveryPercent = 100;
+    EXPECT(!eventDetector_init(&detector, &config), "recoveryPercent 100 accepted");
+    config = benchConfig;
+    config.maxFrames = 1;
+    EXPECT(!eventDetector_init(&detector, &config), "maxFrames 1 accepted");
+}
+
+/**
+ * Channel 0 steps +500 at t0, channel 1 steps +300 one frame later; onsetFrames = 2 triggers
+ * on the second frame, the event starts at t0. Both step back at k = 8, recovered at k = 10.
+ * Then a step during the settle frames is ignored.
+ */
+static void test_onsetRecoverySettle(void)
+{
+    bench_st bench;
+    eventDetector_config_st config = benchConfig;
+    config.onsetFrames = 2;
+    bench_init(&bench, &config);
+
+    // Frame đầu chỉ học baseline, 5 frame settle: bước lớn cũng không tạo event
+    bench_push(&bench, 0, 0);
+    for (int k = 0; k < 5; k++)
+    {
+        bench_push(&bench, 3000, 0);
+        EXPECT(!eventDetector_active(&bench.detector), "event during the initial settle (frame %d)", k);
+    }
+    bench_init(&bench, &config);
+    bench_quiet(&bench, 10);
+
+    const int64_t t0 = bench.now_us;
+    bench_push(&bench, 500, 0);
+    EXPECT(!eventDetector_active(&bench.detector), "started after 1 of 2 onset frames");
+    bench_push(&bench, 500, 300);
+    EXPECT(eventDetector_active(&bench.detector), "not started after 2 onset frames");
+    for (int k = 2; k < 8; k++) {
+        EXPECT(!bench_push(&bench, 500, 300), "ended at k = %d", k);
+    }
+    EXPECT_EQ(bench_recover(&bench, 10), 3);
+
+    const eventDetector_event_st *event = &bench.event;
+    EXPECT_EQ(bench.events, 1);
+    EXPECT_EQ(event->sequence, 0);
+    EXPECT_EQ(event->start_us, t0);
+    EXPECT_EQ(event->frames, 10);
+    EXPECT_EQ(event->duration_ms, 1000);
+    EXPECT_EQ(event->triggerMask, 0x3);
+    EXPECT_EQ(event->channelCount, 2);
+    EXPECT(!event->truncated, "recovered event marked truncated");
+    EXPECT_EQ(event->channel[0].baseline, BASE0);
+    EXPECT_EQ(event->channel[1].baseline, BASE1);
+    EXPECT_EQ(event->channel[0].peakDelta, 500);
+    EXPECT_EQ(event->channel[1].peakDelta, 300);
+    EXPECT_EQ(event->channel[0].onsetDelay_ms, 0);
+    EXPECT_EQ(event->channel[1].onsetDelay_ms, 100);
+    EXPECT_EQ(event->channel[1].area, 300 * 7 / 10);    // k = 1..7, kênh 1 vượt ngưỡng đúng frame trigger
+
+    // Settle sau event: 5 frame không phát hiện, sau đó bước lớn tạo event mới
+    for (int k = 0; k < 5; k++)
+    {
+        bench_push(&bench, 500, 0);
+        EXPECT(!eventDetector_active(&bench.detector), "event during the settle frames (frame %d)", k);
+    }
+    bench_push(&bench, 3000, 0);
+    bench_push(&bench, 3000, 0);
+    EXPECT(eventDetector_active(&bench.detector), "no event after the settle frames");
+}
+
+/**
+ * Channel 0 ramps 200, 600, ... 3800, 4000 (k = 0..10), holds 4000 until k = 14, then drops to
+ * the baseline: 10 % (400) at 50 ms, 90 % (3600) at 850 ms, peak at 1000 ms, recovered at k = 17.
+ */
+static void test_riseAreaSlope(void)
+{
+    bench_st bench;
+    bench_init(&bench, &benchConfig);
+    bench_quiet(&bench, 10);
+
+    const int64_t t0 = bench.now_us;
+    for (int k = 0; k <= 14; k++)
+    {
+        int32_t delta = 200 + 400 * k;
+        EXPECT(!bench_push(&bench, (delta > 4000) ? 4000 : delta, 0), "ended at k = %d", k);
+    }
+    EXPECT_EQ(bench_recover(&bench, 10), 3);
+
+    const eventDetector_event_st *event = &bench.event;
+    const eventDetector_features_st *ramp = &event->channel[0];
+    const eventDetector_features_st *idle = &event->channel[1];
+    EXPECT_EQ(event->start_us, t0);
+    EXPECT_EQ(event->frames, 18);
+    EXPECT_EQ(event->duration_ms, 1700);
+    EXPECT_EQ(event->triggerMask, 0x1);
+    EXPECT_EQ(ramp->peakDelta, 4000);
+    EXPECT_EQ(ramp->onsetDelay_ms, 0);
+    EXPECT_EQ(ramp->riseTime_ms, 850 - 50);
+    EXPECT_EQ(ramp->timeToPeak_ms, 1000);
+    EXPECT_EQ(ramp->area, 4000);                        // (20000 + 5 x 4000) x 0.1 s
+    EXPECT_EQ(ramp->recoverySlope, -4000 * 1000 / 700);
+
+    // Kênh không vượt ngưỡng vẫn có feature (bằng 0) trên cửa sổ event
+    EXPECT_EQ(idle->baseline, BASE1);
+    EXPECT_EQ(idle->peakDelta, 0);
+    EXPECT_EQ(idle->onsetDelay_ms, -1);
+    EXPECT_EQ(idle->riseTime_ms, 0);
+    EXPECT_EQ(idle->timeToPeak_ms, 0);
+    EXPECT_EQ(idle->area, 0);
+    EXPECT_EQ(idle->recoverySlope, 0);
+}
+
+/**
+ * Channel 0 goes +300 for 3 frames then -800 for 3 frames, channel 1 steps to -600 for 6 frames.
+ * The peak keeps its sign, rise time and recovery use the direction of the peak.
+ */
+static void test_signFlip(void)
+{
+    bench_st bench;
+    bench_init(&bench, &benchConfig);
+    bench_quiet(&bench, 10);
+
+    for (int k = 0; k < 6; k++) {
+        EXPECT(!bench_push(&bench, (k < 3) ? 300 : -800, -600), "ended at k = %d", k);
+    }
+    EXPECT_EQ(bench_recover(&bench, 10), 3);
+
+    const eventDetector_event_st *event = &bench.event;
+    const eventDetector_features_st *flip = &event->channel[0];
+    const eventDetector_features_st *down = &event->channel[1];
+    EXPECT_EQ(event->triggerMask, 0x3);
+    EXPECT_EQ(event->frames, 9);
+    EXPECT_EQ(flip->peakDelta, -800);
+    EXPECT_EQ(flip->timeToPeak_ms, 300);
+    // Trace theo chiều peak: -300, -300, -300, 800 → 80 tại 200 + 100 x 380 / 1100, 720 tại 200 + 100 x 1020 / 1100
+    EXPECT_EQ(flip->riseTime_ms, (200 + 102000 / 1100) - (200 + 38000 / 1100));
+    EXPECT_EQ(flip->area, (3 * 300 - 3 * 800) / 10);
+    EXPECT_EQ(flip->recoverySlope, 800 * 1000 / 500);
+    EXPECT_EQ(down->peakDelta, -600);
+    EXPECT_EQ(down->riseTime_ms, 0);
+    EXPECT_EQ(down->timeToPeak_ms, 0);
+    EXPECT_EQ(down->area, -6 * 600 / 10);
+    EXPECT_EQ(down->recoverySlope, 600 * 1000 / 800);
+}
+
+/**
+ * A step held longer than maxFrames ends as a truncated event on frame maxFrames.
+ */
+static void test_truncated(void)
+{
+    bench_st bench;
+    eventDetector_config_st config = benchConfig;
+    config.maxFrames = 20;
+    bench_init(&bench, &config);
+    bench_quiet(&bench, 10);
+
+    const int64_t t0 = bench.now_us;
+    uint32_t endFrame = 0;
+    for (uint32_t k = 1; k <= 30 && endFrame == 0; k++) {
+        endFrame = bench_push(&bench, 500, 0) ? k : 0;
+    }
+    EXPECT_EQ(endFrame, 20);
+
+    const eventDetector_event_st *event = &bench.event;
+    EXPECT(event->truncated, "event longer than maxFrames not truncated");
+    EXPECT_EQ(event->start_us, t0);
+    EXPECT_EQ(event->frames, 20);
+    EXPECT_EQ(event->duration_ms, 1900);
+    EXPECT_EQ(event->channel[0].peakDelta, 500);
+    EXPECT_EQ(event->channel[0].area, 500 * 20 / 10);
+    EXPECT_EQ(event->channel[0].recoverySlope, 0);
+    EXPECT(!eventDetector_active(&bench.detector), "still active after the truncated event");
+}
+
+/**
+ * Sampling stops for 10 minutes in the middle of an event and restarts with drifted sensors:
+ * eventDetector_reset() drops the event, the baselines are relearnt at the new level and the
+ * gap never shows up in an event.
+ */
+static void test_resetAfterGap(void)
+{
+    bench_st bench;
+    bench_init(&bench, &benchConfig);
+    bench_quiet(&bench, 10);
+
+    bench_push(&bench, 500, 0);
+    EXPECT_EQ(bench_recover(&bench, 10), 3);
+    EXPECT_EQ(bench.events, 1);
+    bench_quiet(&bench, benchConfig.settleFrames);
+
+    bench_push(&bench, 500, 500);
+    bench_push(&bench, 500, 500);
+    EXPECT(eventDetector_active(&bench.detector), "second event not started");
+    eventDetector_reset(&bench.detector);
+    EXPECT(!eventDetector_active(&bench.detector), "event still active after reset");
+
+    bench.now_us += 600LL * 1000000;
+    for (int k = 0; k < 30; k++)
+    {
+        bench_push(&bench, 3000, 1000);
+        EXPECT(!eventDetector_active(&bench.detector), "drifted level taken as an event (frame %d)", k);
+    }
+
+    const int64_t t0 = bench.now_us;
+    bench_push(&bench, 3500, 1000);
+    bench_push(&bench, 3500, 1000);
+    uint32_t endFrame = 0;
+    for (uint32_t k = 1; k <= 10 && endFrame == 0; k++) {
+        endFrame = bench_push(&bench, 3000, 1000) ? k : 0;
+    }
+    EXPECT_EQ(endFrame, 3);
+
+    const eventDetector_event_st *event = &bench.event;
+    EXPECT_EQ(bench.events, 2);
+    EXPECT_EQ(event->sequence, 1);                      // Event bị reset không được đánh số
+    EXPECT_EQ(event->start_us, t0);
+    EXPECT_EQ(event->duration_ms, 400);
+    EXPECT_EQ(event->triggerMask, 0x1);
+    EXPECT_EQ(event->channel[0].baseline, BASE0 + 3000);
+    EXPECT_EQ(event->channel[1].baseline, BASE1 + 1000);
+    EXPECT_EQ(event->channel[0].peakDelta, 500);
+    EXPECT_EQ(event->channel[0].area, 2 * 500 / 10);
+}
+
+/**
+ * Ramp of 100 per frame to 15000 (k = 0..148), 20 frames at the peak, then back: 172 frames, the
+ * trace is halved twice (stride 4). 10 % (1500) at k = 13 and 90 % (13500) at k = 133 fall
+ * between two kept points and are interpolated exactly on the ramp.
+ */
+static void test_traceHalving(void)
+{
+    bench_st bench;
+    bench_init(&bench, &benchConfig);
+    bench_quiet(&bench, 10);
+
+    for (int k = 0; k < 149 + 20; k++) {
+        EXPECT(!bench_push(&bench, (k < 149) ? 100 * (k + 2) : 15000, 0), "ended at k = %d", k);
+    }
+    EXPECT_EQ(bench_recover(&bench, 10), 3);
+
+    const eventDetector_event_st *event = &bench.event;
+    EXPECT_EQ(event->frames, 172);
+    EXPECT_EQ(bench.detector.traceStride, 4);
+    EXPECT(bench.detector.traceCount <= EVENT_DETECTOR_TRACE_MAX, "trace overflow (%u points)", bench.detector.traceCount);
+    EXPECT_EQ(event->channel[0].peakDelta, 15000);
+    EXPECT_EQ(event->channel[0].riseTime_ms, 13300 - 1300);
+    EXPECT_EQ(event->channel[0].timeToPeak_ms, 14800);
+}
+
+int main(void)
+{
+    test_config();
+    test_onsetRecoverySettle();
+    test_riseAreaSlope();
+    test_signFlip();
+    test_truncated();
+    test_resetAfterGap();
+    test_traceHalving();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,398 @@
+/**
+ * @file framering_test.c
+ * @brief Host stress test of the frame ring (component/FrameRing/framering.c) with pthreads:
+ *        one producer, consumers at different speeds, seqlock and overrun accounting.
+ *
+ * Build and run (from Electronic-Nose/tools):
+ *   gcc -O2 -Wall -pthread -Ihost_include -I../component/FrameRing framering_test.c ../component/FrameRing/framering.c -o framering_test
+ *   ./framering_test [frames]      exit status 1 on failure, default 2000000 frames
+ *
+ * FreeRTOS is replaced by pthreads: portENTER_CRITICAL() takes one global mutex, every thread
+ * has a notification counter (mutex + condvar) for xTaskNotifyGive()/ulTaskNotifyTake().
+ *
+ * Checks:
+ *   - single thread: a reader lapped by the producer skips to the oldest frame in the ring and
+ *     counts the lost frames, frameRing_commit() rejects a frame whose slot is being rewritten
+ *   - stress: frames accepted by frameRing_commit() are never torn (sequence and payload of
+ *     the copy agree) and arrive in strictly increasing order at the sequence of reader->tail;
+ *     at the end consumed + overruns = published for every reader; the slow reader (sleeps
+ *     in the middle of its copy) sees torn frames rejected
+ * Reports producer and consumer throughput (frames/s) and the losses of each reader.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "framering.h"
+
+#define RING_CAPACITY           8U
+#define FRAME_WORDS             32U
+#define CONSUMER_COUNT          3U
+#define DEFAULT_FRAMES          2000000U
+
+#define EXPECT(condition, ...) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "FAIL %s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            failures++; \
+        } \
+    } while (0)
+
+static int failures = 0;
+
+/* FreeRTOS stand-in */
+
+typedef struct host_task
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t count;
+} host_task_st;
+
+static pthread_mutex_t criticalLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread host_task_st *currentTask = NULL;
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    pthread_mutex_lock(&criticalLock);
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    pthread_mutex_unlock(&criticalLock);
+}
+
+static void hostTask_begin(host_task_st *task)
+{
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    task->count = 0;
+    currentTask = task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return currentTask;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    host_task_st *task = handle;
+    pthread_mutex_lock(&task->lock);
+    task->count++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    host_task_st *task = currentTask;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL;
+    deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+    deadline.tv_nsec = (long)(ns % 1000000000ULL);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->count == 0)
+    {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&task->cond, &task->lock);
+        } else if (pthread_cond_timedwait(&task->cond, &task->lock, &deadline) != 0) {
+            break;
+        }
+    }
+    uint32_t count = task->count;
+    task->count = (clear || count == 0) ? 0 : count - 1;
+    pthread_mutex_unlock(&task->lock);
+    return count;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    (void)woken;
+    xTaskNotifyGive(task);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep(ticks * portTICK_PERIOD_MS * 1000U);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return (code == ESP_OK) ? "ESP_OK" : "ESP_ERR";
+}
+
+/* Frames: the payload is derived from the sequence, first and last word repeat it */
+
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t payload[FRAME_WORDS];
+    uint32_t sequenceEnd;
+} testFrame_st;
+
+static uint32_t testFrame_word(uint32_t sequence, uint32_t i)
+{
+    return sequence * 2654435761U + i;
+}
+
+static void testFrame_fill(testFrame_st *frame, uint32_t sequence)
+{
+    frame->sequence = sequence;
+    for (uint32_t i = 0; i < FRAME_WORDS; i++) {
+        frame->payload[i] = testFrame_word(sequence, i);
+    }
+    frame->sequenceEnd = sequence;
+}
+
+static bool testFrame_consistent(const testFrame_st *frame)
+{
+    if (frame->sequence != frame->sequenceEnd) {
+        return false;
+    }
+    for (uint32_t i = 0; i < FRAME_WORDS; i++)
+    {
+        if (frame->payload[i] != testFrame_word(frame->sequence, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void produce(frameRing_st *ring, uint32_t sequence)
+{
+    testFrame_fill(frameRing_reserve(ring), sequence);
+    frameRing_publish(ring);
+}
+
+static double seconds(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/* Single thread */
+
+static void test_overrun(void)
+{
+    static host_task_st task;
+    frameRing_st ring;
+    frameRing_reader_st reader;
+    hostTask_begin(&task);
+
+    EXPECT(frameRing_init(&ring, sizeof(testFrame_st), RING_CAPACITY - 1) == ESP_OK, "init failed");
+    EXPECT(ring.capacity == RING_CAPACITY, "capacity %" PRIu32 " not rounded up to %u", ring.capacity, RING_CAPACITY);
+    EXPECT(frameRing_readerAttach(&reader, &ring) == ESP_OK, "attach failed");
+    EXPECT(frameRing_peek(&reader, 0) == NULL, "frame in an empty ring");
+
+    for (uint32_t s = 0; s < 20; s++) {
+        produce(&ring, s);
+    }
+    EXPECT(frameRing_pending(&reader) == 20, "pending %" PRIu32 ", expected 20", frameRing_pending(&reader));
+
+    // Bị bỏ 12 frame: đọc tiếp từ frame cũ nhất còn trong ring
+    uint32_t expected = 20 - RING_CAPACITY;
+    const testFrame_st *frame;
+    while ((frame = frameRing_peek(&reader, 0)) != NULL)
+    {
+        EXPECT(frame->sequence == expected, "read %" PRIu32 ", expected %" PRIu32, frame->sequence, expected);
+        EXPECT(frameRing_commit(&reader), "frame %" PRIu32 " rejected without writer", expected);
+        expected++;
+    }
+    EXPECT(reader.overruns == 20 - RING_CAPACITY, "overruns %" PRIu32 ", expected %u", reader.overruns, 20 - RING_CAPACITY);
+    EXPECT(reader.consumed == RING_CAPACITY, "consumed %" PRIu32 ", expected %u", reader.consumed, RING_CAPACITY);
+
+    frameRing_readerDetach(&reader);
+    frameRing_deinit(&ring);
+}
+
+static void test_tornCommit(void)
+{
+    static host_task_st task;
+    frameRing_st ring;
+    frameRing_reader_st reader;
+    hostTask_begin(&task);
+
+    EXPECT(frameRing_init(&ring, sizeof(testFrame_st), RING_CAPACITY) == ESP_OK, "init failed");
+    EXPECT(frameRing_readerAttach(&reader, &ring) == ESP_OK, "attach failed");
+
+    // Ring đầy, producer chưa ghi lại slot nào: frame 0 hợp lệ
+    for (uint32_t s = 0; s < RING_CAPACITY; s++) {
+        produce(&ring, s);
+    }
+    EXPECT(frameRing_peek(&reader, 0) != NULL, "no frame");
+    EXPECT(frameRing_commit(&reader), "full ring: oldest frame rejected");
+
+    // Frame 8 ghi vào slot của frame 0 (đã đọc): frame 1 vẫn hợp lệ
+    produce(&ring, RING_CAPACITY);
+    EXPECT(frameRing_peek(&reader, 0) != NULL, "no frame");
+    // Producer bắt đầu ghi frame 9 vào slot của frame 1 trong lúc reader đang đọc nó
+    testFrame_fill(frameRing_reserve(&ring), RING_CAPACITY + 1);
+    EXPECT(!frameRing_commit(&reader), "frame overwritten while read was accepted");
+    frameRing_publish(&ring);
+    EXPECT(reader.consumed == 1 && reader.overruns == 1, "consumed %" PRIu32 ", overruns %" PRIu32 ", expected 1/1",
+           reader.consumed, reader.overruns);
+
+    frameRing_readerDetach(&reader);
+    frameRing_deinit(&ring);
+}
+
+/* Stress */
+
+typedef struct
+{
+    const char *name;
+    frameRing_st *ring;
+    pthread_barrier_t *ready;
+    volatile bool *done;
+    uint32_t readDelay_us;      // Ngủ giữa hai nửa của bản copy: mở rộng cửa sổ frame bị ghi đè
+    uint32_t frameDelay_us;     // Ngủ sau mỗi frame
+    uint32_t consumed;
+    uint32_t overruns;
+    uint32_t rejected;
+    uint32_t torn;
+    uint32_t outOfOrder;
+    double elapsed_s;
+} consumer_st;
+
+static void *consumer_task(void *parameters)
+{
+    consumer_st *consumer = parameters;
+    host_task_st task;
+    frameRing_reader_st reader;
+    struct timespec start, end;
+    int64_t previous = -1;
+
+    hostTask_begin(&task);
+    if (frameRing_readerAttach(&reader, consumer->ring) != ESP_OK) {
+        fprintf(stderr, "%s: attach failed\n", consumer->name);
+        exit(1);
+    }
+    pthread_barrier_wait(consumer->ready);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;)
+    {
+        const testFrame_st *frame = frameRing_peek(&reader, 1);
+        if (frame == NULL)
+        {
+            if (*consumer->done && frameRing_pending(&reader) == 0) {
+                break;
+            }
+            continue;
+        }
+
+        uint32_t sequence = reader.tail;
+        testFrame_st copy;
+        memcpy(&copy, frame, offsetof(testFrame_st, payload[FRAME_WORDS / 2]));
+        if (consumer->readDelay_us != 0) {
+            usleep(consumer->readDelay_us);
+        }
+        memcpy((uint8_t *)&copy + offsetof(testFrame_st, payload[FRAME_WORDS / 2]),
+               (const uint8_t *)frame + offsetof(testFrame_st, payload[FRAME_WORDS / 2]),
+               sizeof(copy) - offsetof(testFrame_st, payload[FRAME_WORDS / 2]));
+
+        if (!frameRing_commit(&reader)) {
+            consumer->rejected++;
+        }
+        else
+        {
+            consumer->torn += testFrame_consistent(&copy) ? 0 : 1;
+            consumer->outOfOrder += (copy.sequence == sequence && (int64_t)sequence > previous) ? 0 : 1;
+            previous = sequence;
+        }
+        if (consumer->frameDelay_us != 0) {
+            usleep(consumer->frameDelay_us);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    consumer->elapsed_s = seconds(&start, &end);
+    consumer->consumed = reader.consumed;
+    consumer->overruns = reader.overruns;
+    frameRing_readerDetach(&reader);
+    return NULL;
+}
+
+static void test_stress(uint32_t frames)
+{
+    static host_task_st task;
+    frameRing_st ring;
+    pthread_barrier_t ready;
+    volatile bool done = false;
+    pthread_t threads[CONSUMER_COUNT];
+    consumer_st consumers[CONSUMER_COUNT] = {
+        { .name = "fast" },
+        { .name = "medium", .frameDelay_us = 1 },
+        { .name = "slow", .readDelay_us = 50 },
+    };
+    struct timespec start, end;
+
+    hostTask_begin(&task);
+    EXPECT(frameRing_init(&ring, sizeof(testFrame_st), RING_CAPACITY) == ESP_OK, "init failed");
+    pthread_barrier_init(&ready, NULL, CONSUMER_COUNT + 1);
+    for (uint32_t c = 0; c < CONSUMER_COUNT; c++)
+    {
+        consumers[c].ring = &ring;
+        consumers[c].ready = &ready;
+        consumers[c].done = &done;
+        pthread_create(&threads[c], NULL, consumer_task, &consumers[c]);
+    }
+    pthread_barrier_wait(&ready);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t s = 0; s < frames; s++) {
+        produce(&ring, s);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    done = true;
+    for (uint32_t c = 0; c < CONSUMER_COUNT; c++) {
+        pthread_join(threads[c], NULL);
+    }
+
+    double produce_s = seconds(&start, &end);
+    printf("producer: %" PRIu32 " frames of %zu B in %.3f s, %.0f frames/s\n",
+           frames, sizeof(testFrame_st), produce_s, frames / produce_s);
+    for (uint32_t c = 0; c < CONSUMER_COUNT; c++)
+    {
+        const consumer_st *consumer = &consumers[c];
+        printf("%-8s consumed %9" PRIu32 " (%.0f frames/s), overruns %9" PRIu32 " (%" PRIu32 " torn rejected)\n",
+               consumer->name, consumer->consumed, consumer->consumed / consumer->elapsed_s,
+               consumer->overruns, consumer->rejected);
+        EXPECT(consumer->torn == 0, "%s: %" PRIu32 " torn frames accepted", consumer->name, consumer->torn);
+        EXPECT(consumer->outOfOrder == 0, "%s: %" PRIu32 " frames out of order", consumer->name, consumer->outOfOrder);
+        EXPECT(consumer->consumed + consumer->overruns == frames, "%s: consumed + overruns = %" PRIu32 ", published %" PRIu32,
+               consumer->name, consumer->consumed + consumer->overruns, frames);
+    }
+    EXPECT(consumers[CONSUMER_COUNT - 1].rejected != 0, "slow reader: no torn frame rejected by frameRing_commit()");
+
+    pthread_barrier_destroy(&ready);
+    frameRing_deinit(&ring);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_FRAMES;
+    if (frames == 0)
+    {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 2;
+    }
+
+    test_overrun();
+    test_tornCommit();
+    test_stress(frames);
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
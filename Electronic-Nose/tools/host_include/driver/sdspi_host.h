@@ -0,0 +1,17 @@
+#ifndef __HOST_DRIVER_SDSPI_HOST_H__
+#define __HOST_DRIVER_SDSPI_HOST_H__
+
+#include "driver/spi_common.h"
+
+typedef struct
+{
+    spi_host_device_t slot;
+} sdmmc_host_t;
+
+typedef struct
+{
+    spi_host_device_t host_id;
+    int gpio_cs;
+} sdspi_device_config_t;
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __HOST_DRIVER_SPI_COMMON_H__
+#define __HOST_DRIVER_SPI_COMMON_H__
+
+#include "esp_err.h"
+
+typedef int spi_host_device_t;
+
+typedef struct
+{
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma);
+esp_err_t spi_bus_free(spi_host_device_t host);
+
+#endif
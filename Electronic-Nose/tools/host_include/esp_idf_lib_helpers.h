@@ -0,0 +1,6 @@
+#ifndef __HOST_ESP_IDF_LIB_HELPERS_H__
+#define __HOST_ESP_IDF_LIB_HELPERS_H__
+
+#define HELPER_TARGET_IS_ESP32 1
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef __HOST_ESP_LOG_H__
+#define __HOST_ESP_LOG_H__
+
+#include <stdio.h>
+#include "sdkconfig.h"
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W (%s) " format "\n", tag, ##__VA_ARGS__)
+// I/D: compiled (arguments are used) but not printed
+#define ESP_LOGI(tag, format, ...) do { if (0) fprintf(stdout, "I (%s) " format "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, format, ...) do { if (0) fprintf(stdout, "D (%s) " format "\n", tag, ##__VA_ARGS__); } while (0)
+
+#endif
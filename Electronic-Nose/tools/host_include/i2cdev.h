@@ -0,0 +1,60 @@
+/**
+ * @file i2cdev.h
+ * @brief Host declaration of the i2cdev API used by the drivers (descriptor, mutex, register
+ *        access). The test provides the functions over a simulated device.
+ */
+#ifndef __I2CDEV_H__
+#define __I2CDEV_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+typedef int i2c_port_t;
+#define I2C_NUM_MAX 2
+
+typedef struct
+{
+    gpio_num_t sda_io_num;
+    gpio_num_t scl_io_num;
+    struct { uint32_t clk_speed; } master;
+} i2c_config_t;
+
+typedef struct
+{
+    i2c_port_t port;
+    i2c_config_t cfg;
+    uint8_t addr;
+    SemaphoreHandle_t mutex;
+    uint32_t timeout_ticks;
+} i2c_dev_t;
+
+esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev);
+esp_err_t i2c_dev_delete_mutex(i2c_dev_t *dev);
+esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev);
+esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev);
+esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size);
+esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size);
+
+#define I2C_DEV_TAKE_MUTEX(dev) do { \
+        esp_err_t __ = i2c_dev_take_mutex(dev); \
+        if (__ != ESP_OK) return __;\
+    } while (0)
+
+#define I2C_DEV_GIVE_MUTEX(dev) do { \
+        esp_err_t __ = i2c_dev_give_mutex(dev); \
+        if (__ != ESP_OK) return __;\
+    } while (0)
+
+#define I2C_DEV_CHECK(dev, X) do { \
+        esp_err_t ___ = X; \
+        if (___ != ESP_OK) { \
+            I2C_DEV_GIVE_MUTEX(dev); \
+            return ___; \
+        } \
+    } while (0)
+
+#endif
@@ -0,0 +1,12 @@
+/* Kconfig defaults of the options used by the sources built on the host (as the IDF
+ * sdkconfig.h, included through esp_log.h) */
+#ifndef __HOST_SDKCONFIG_H__
+#define __HOST_SDKCONFIG_H__
+
+#define CONFIG_PIN_NUM_CS                       5
+#define CONFIG_SDCARD_WRITER_BUFFER_SIZE        4096
+#define CONFIG_SDCARD_WRITER_COMMIT_ROWS        32
+#define CONFIG_SDCARD_WRITER_COMMIT_BYTES       2048
+#define CONFIG_SDCARD_WRITER_COMMIT_INTERVAL_MS 10000
+
+#endif
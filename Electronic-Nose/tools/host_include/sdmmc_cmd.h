@@ -0,0 +1,10 @@
+#ifndef __HOST_SDMMC_CMD_H__
+#define __HOST_SDMMC_CMD_H__
+
+#include <stdio.h>
+
+typedef struct sdmmc_card sdmmc_card_t;
+
+void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card);
+
+#endif
@@ -0,0 +1,338 @@
+#!/usr/bin/env node
+/**
+ * @file i2c_trace.js
+ * @brief Phân tích I2C trace của firmware (CONFIG_I2CDEV_TRACE, xem i2c_dev_trace_dump() trong i2cdev.h):
+ *        histogram latency theo từng device và duty cycle của từng bus.
+ *
+ * Dump đã lưu (lệnh UART "I2CTRACE", log serial monitor dán vào file; các dòng log khác bị bỏ qua):
+ *   node i2c_trace.js <dump.txt|->
+ *
+ * Đọc trực tiếp từ ESP32 (GET /api/i2c/trace?since=<next>, chỉ lấy record mới mỗi lần):
+ *   node i2c_trace.js --url http://<esp32>/api/i2c/trace [--follow 5]
+ *     --follow  poll mỗi N giây, in lại kết quả tích luỹ; Ctrl+C để dừng
+ *
+ * Tuỳ chọn chung:
+ *   --window ms   cửa sổ tính duty cycle lớn nhất (mặc định 100 ms)
+ *   --self-test   kiểm tra parser và thống kê với dump giả lập, exit status 1 nếu lỗi
+ *
+ * Kết quả:
+ *   bus     span, thời gian bận (hợp các khoảng start..end), duty cycle trung bình và lớn nhất theo cửa sổ
+ *   device  số giao dịch, lỗi (ESP_ERR_TIMEOUT: quá deadline hoặc bus timeout), byte, latency min/p50/p95/p99/max,
+ *           thời gian chờ trong queue, histogram latency log2 (µs)
+ *   class   thời gian chờ theo priority (control/acquisition/housekeeping)
+ * Record bị ghi đè trước khi được đọc ("lost") được cộng dồn và in ra: tăng CONFIG_I2CDEV_TRACE_ENTRIES
+ * hoặc poll nhanh hơn nếu lost > 0.
+ */
+
+'use strict';
+
+const http = require('http');
+const fs = require('fs');
+
+const COLUMNS = ['seq', 'start_us', 'end_us', 'wait_us', 'port', 'addr', 'op', 'priority',
+                 'out_bytes', 'in_bytes', 'result'];
+
+function parseArgs(argv) {
+  const options = { input: null, url: null, follow: 0, window: 100, selfTest: false };
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    const next = () => argv[++i];
+    if (arg === '--url') options.url = next();
+    else if (arg === '--follow') options.follow = Number(next());
+    else if (arg === '--window') options.window = Math.max(1, Number(next()));
+    else if (arg === '--self-test') options.selfTest = true;
+    else if (!arg.startsWith('--') && options.input === null) options.input = arg;
+    else {
+      console.error(`Unknown option: ${arg}`);
+      process.exit(2);
+    }
+  }
+  return options;
+}
+
+function createTrace() {
+  return { records: new Map(), lost: 0, headerLost: 0, next: 0, dumps: 0 };
+}
+
+/**
+ * Thêm một dump vào trace tích luỹ. Record trùng seq (dump chồng lên nhau) chỉ được tính một lần.
+ * Dòng không thuộc dump (log ESP-IDF, prompt...) bị bỏ qua.
+ */
+function parseDump(text, trace) {
+  for (const rawLine of text.split(/\r?\n/)) {
+    const line = rawLine.trim();
+    let match;
+    if ((match = /# i2c trace: seq (\d+)\.\.(\d+), lost (\d+)/.exec(line))) {
+      // "lost" của dòng cuối là tổng của cả dump (gồm cả số ở header), header chỉ dùng khi dump bị cắt
+      trace.dumps++;
+      trace.headerLost = Number(match[3]);
+      trace.lost += trace.headerLost;
+      continue;
+    }
+    if ((match = /# next (\d+), lost (\d+)/.exec(line))) {
+      trace.next = Number(match[1]);
+      trace.lost += Number(match[2]) - trace.headerLost;
+      trace.headerLost = 0;
+      continue;
+    }
+    const fields = line.split(',');
+    if (fields.length !== COLUMNS.length || !/^\d+$/.test(fields[0])) continue;
+    const record = {
+      seq: Number(fields[0]),
+      start: Number(fields[1]),
+      end: Number(fields[2]),
+      wait: Number(fields[3]),
+      port: Number(fields[4]),
+      addr: fields[5],
+      op: fields[6],
+      priority: fields[7],
+      outBytes: Number(fields[8]),
+      inBytes: Number(fields[9]),
+      result: fields[10],
+    };
+    if ([record.start, record.end, record.wait, record.port].some(Number.isNaN)) continue;
+    trace.records.set(record.seq, record);
+  }
+  return trace;
+}
+
+function percentile(sorted, fraction) {
+  if (!sorted.length) return 0;
+  return sorted[Math.min(sorted.length - 1, Math.ceil(fraction * sorted.length) - 1)];
+}
+
+function summarize(values) {
+  const sorted = values.slice().sort((a, b) => a - b);
+  const sum = sorted.reduce((total, value) => total + value, 0);
+  return {
+    count: sorted.length,
+    min: sorted.length ? sorted[0] : 0,
+    p50: percentile(sorted, 0.5),
+    p95: percentile(sorted, 0.95),
+    p99: percentile(sorted, 0.99),
+    max: sorted.length ? sorted[sorted.length - 1] : 0,
+    avg: sorted.length ? sum / sorted.length : 0,
+  };
+}
+
+/* Bucket log2: [0,1] [2,3] [4,7] ... µs */
+function histogram(values) {
+  const buckets = [];
+  for (const value of values) {
+    const bucket = value <= 1 ? 0 : Math.floor(Math.log2(value));
+    buckets[bucket] = (buckets[bucket] || 0) + 1;
+  }
+  for (let i = 0; i < buckets.length; i++) buckets[i] = buckets[i] || 0;
+  return buckets;
+}
+
+/**
+ * Thời gian bận của bus = hợp các khoảng [start, end] (các giao dịch trên một port không chồng nhau,
+ * nhưng record của direct path và scheduler có thể sát nhau), và duty cycle lớn nhất theo cửa sổ.
+ */
+function busUsage(records, windowUs) {
+  const intervals = records.map((r) => [r.start, Math.max(r.start, r.end)]).sort((a, b) => a[0] - b[0]);
+  const merged = [];
+  for (const interval of intervals) {
+    const last = merged[merged.length - 1];
+    if (last && interval[0] <= last[1]) last[1] = Math.max(last[1], interval[1]);
+    else merged.push(interval.slice());
+  }
+  const first = merged.length ? merged[0][0] : 0;
+  const last = merged.length ? merged[merged.length - 1][1] : 0;
+  const busy = merged.reduce((total, [start, end]) => total + end - start, 0);
+
+  const windows = new Map();
+  for (const [start, end] of merged) {
+    for (let w = Math.floor((start - first) / windowUs); first + w * windowUs < end; w++) {
+      const windowStart = first + w * windowUs;
+      const overlap = Math.min(end, windowStart + windowUs) - Math.max(start, windowStart);
+      windows.set(w, (windows.get(w) || 0) + overlap);
+    }
+  }
+  const fullWindows = Math.floor((last - first) / windowUs);
+  let maxWindow = 0;
+  for (const [w, value] of windows) {
+    if (w < fullWindows || fullWindows === 0) maxWindow = Math.max(maxWindow, value);
+  }
+  return { span: last - first, busy, duty: last > first ? busy / (last - first) : 0,
+           maxDuty: Math.min(1, maxWindow / windowUs) };
+}
+
+function analyze(trace, windowMs) {
+  const records = [...trace.records.values()].sort((a, b) => a.seq - b.seq);
+  const ports = new Map();
+  const devices = new Map();
+  const classes = new Map();
+  const group = (map, key, record) => {
+    if (!map.has(key)) map.set(key, []);
+    map.get(key).push(record);
+  };
+  for (const record of records) {
+    group(ports, record.port, record);
+    group(devices, `${record.port}/${record.addr}`, record);
+    group(classes, record.priority, record);
+  }
+
+  const result = { records: records.length, lost: trace.lost, next: trace.next, ports: [], devices: [], classes: [] };
+  for (const [port, list] of [...ports].sort((a, b) => a[0] - b[0])) {
+    result.ports.push({ port, count: list.length, ...busUsage(list, windowMs * 1000) });
+  }
+  for (const [key, list] of [...devices].sort()) {
+    const latencies = list.map((r) => r.end - r.start);
+    result.devices.push({
+      key,
+      count: list.length,
+      errors: list.filter((r) => r.result !== 'ESP_OK').length,
+      timeouts: list.filter((r) => r.result === 'ESP_ERR_TIMEOUT').length,
+      bytes: list.reduce((total, r) => total + r.outBytes + r.inBytes, 0),
+      ops: [...new Set(list.map((r) => r.op))].join('/'),
+      latency: summarize(latencies),
+      wait: summarize(list.map((r) => r.wait)),
+      histogram: histogram(latencies),
+    });
+  }
+  for (const [priority, list] of [...classes].sort()) {
+    result.classes.push({ priority, wait: summarize(list.map((r) => r.wait)) });
+  }
+  return result;
+}
+
+function printReport(report, windowMs) {
+  console.log(`${report.records} records, lost ${report.lost}, next ${report.next}` +
+              (report.lost ? '  (tăng CONFIG_I2CDEV_TRACE_ENTRIES hoặc poll nhanh hơn)' : ''));
+  for (const bus of report.ports) {
+    console.log(`port ${bus.port}: ${bus.count} tx, span ${(bus.span / 1000).toFixed(1)} ms, ` +
+                `busy ${(bus.busy / 1000).toFixed(1)} ms, duty ${(bus.duty * 100).toFixed(1)} %, ` +
+                `max ${(bus.maxDuty * 100).toFixed(1)} % / ${windowMs} ms`);
+  }
+  for (const device of report.devices) {
+    const l = device.latency;
+    console.log(`\n${device.key} (${device.ops}): ${device.count} tx, ${device.errors} errors (${device.timeouts} timeouts), ` +
+                `${device.bytes} bytes`);
+    console.log(`  latency us  min ${l.min}  p50 ${l.p50}  p95 ${l.p95}  p99 ${l.p99}  max ${l.max}`);
+    console.log(`  wait us     avg ${device.wait.avg.toFixed(0)}  max ${device.wait.max}`);
+    const peak = Math.max(...device.histogram, 1);
+    device.histogram.forEach((count, bucket) => {
+      if (!count) return;
+      const low = bucket === 0 ? 0 : 2 ** bucket;
+      const label = `${low}..${2 ** (bucket + 1) - 1}`.padStart(13);
+      console.log(`  ${label} ${String(count).padStart(6)} ${'#'.repeat(Math.max(1, Math.round(count / peak * 40)))}`);
+    });
+  }
+  console.log('');
+  for (const entry of report.classes) {
+    const w = entry.wait;
+    console.log(`${entry.priority.padEnd(12)} ${String(w.count).padStart(6)} tx, wait us avg ${w.avg.toFixed(0)} ` +
+                `p95 ${w.p95} p99 ${w.p99} max ${w.max}`);
+  }
+}
+
+function fetchDump(url, since) {
+  const target = new URL(url);
+  target.searchParams.set('since', String(since));
+  return new Promise((resolve, reject) => {
+    http.get(target, (res) => {
+      const chunks = [];
+      res.on('data', (chunk) => chunks.push(chunk));
+      res.on('end', () => {
+        const body = Buffer.concat(chunks).toString();
+        if (res.statusCode !== 200) reject(new Error(`HTTP ${res.statusCode}: ${body.trim()}`));
+        else resolve(body);
+      });
+    }).on('error', reject);
+  });
+}
+
+async function runUrl(options) {
+  const trace = createTrace();
+  for (;;) {
+    parseDump(await fetchDump(options.url, trace.next), trace);
+    printReport(analyze(trace, options.window), options.window);
+    if (!options.follow) return;
+    await new Promise((resolve) => setTimeout(resolve, options.follow * 1000));
+    console.log(`\n---------------- ${new Date().toISOString()} ----------------`);
+  }
+}
+
+/*------------------------------------ Self test ------------------------------------ */
+
+function selfTest() {
+  let failures = 0;
+  const expect = (name, actual, expected) => {
+    const ok = Math.abs(actual - expected) < 1e-6;
+    console.log(`${ok ? 'ok  ' : 'FAIL'} ${name}: ${actual}${ok ? '' : `, expected ${expected}`}`);
+    if (!ok) failures++;
+  };
+
+  /* Port 0: ADS 200 µs mỗi 1 ms (duty 20 %), RTC 600 µs mỗi 10 ms; một giao dịch quá deadline */
+  const lines = ['I (1234) main: noise before the dump', '# i2c trace: seq 0..40, lost 0, now_us 100000',
+                 COLUMNS.join(',')];
+  let seq = 0;
+  for (let i = 0; i < 36; i++) {
+    const start = 10000 + i * 1000;
+    lines.push(`${seq++},${start},${start + 200},${i % 2 ? 300 : 100},0,0x48,read,acquisition,1,2,ESP_OK`);
+  }
+  for (let i = 0; i < 3; i++) {
+    const start = 10400 + i * 10000;
+    lines.push(`${seq++},${start},${start + 600},50,0,0x68,read,housekeeping,1,7,${i === 2 ? 'ESP_FAIL' : 'ESP_OK'}`);
+  }
+  lines.push(`${seq++},47000,47000,2000,0,0x48,read,acquisition,1,2,ESP_ERR_TIMEOUT`);
+  lines.push('# next 40, lost 0');
+
+  const trace = parseDump(lines.join('\n'), createTrace());
+  /* dump thứ hai chồng lên dump đầu (since cũ), mất 5 record trước dump và 2 trong lúc dump */
+  parseDump(['# i2c trace: seq 35..41, lost 5, now_us 200000', COLUMNS.join(','),
+             lines[3 + 35], '40,48000,48100,10,1,0x40,write,control,3,0,ESP_OK', '# next 41, lost 7'].join('\r\n'), trace);
+  const report = analyze(trace, 10);
+
+  expect('records', report.records, 41);
+  expect('lost', report.lost, 7);
+  expect('next', report.next, 41);
+  expect('ports', report.ports.length, 2);
+  const bus = report.ports[0];
+  expect('port 0 busy us', bus.busy, 36 * 200 + 3 * 600);
+  expect('port 0 span us', bus.span, 47000 - 10000);
+  expect('port 0 max duty (10 ms window)', bus.maxDuty, (10 * 200 + 600) / 10000);
+  const ads = report.devices.find((d) => d.key === '0/0x48');
+  expect('ads count', ads.count, 37);
+  expect('ads errors', ads.errors, 1);
+  expect('ads timeouts', ads.timeouts, 1);
+  expect('ads p50 latency', ads.latency.p50, 200);
+  expect('ads min latency', ads.latency.min, 0);
+  expect('ads wait max', ads.wait.max, 2000);
+  expect('ads histogram 128..255', ads.histogram[7], 36);
+  const rtc = report.devices.find((d) => d.key === '0/0x68');
+  expect('rtc errors', rtc.errors, 1);
+  expect('rtc bytes', rtc.bytes, 3 * 8);
+  expect('rtc latency max', rtc.latency.max, 600);
+  const control = report.classes.find((c) => c.priority === 'control');
+  expect('control count', control.wait.count, 1);
+
+  console.log(failures ? 'SELF TEST FAILED' : 'self test passed');
+  return failures ? 1 : 0;
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  if (options.selfTest) process.exit(selfTest());
+  if (options.url) return runUrl(options);
+  if (!options.input) {
+    console.error('Usage: node i2c_trace.js [--window ms] <dump.txt|->\n' +
+                  '       node i2c_trace.js --url http://<esp32>/api/i2c/trace [--follow s] [--window ms]\n' +
+                  '       node i2c_trace.js --self-test');
+    process.exit(2);
+  }
+  const text = fs.readFileSync(options.input === '-' ? 0 : options.input, 'utf8');
+  const trace = parseDump(text, createTrace());
+  if (!trace.records.size) {
+    console.error('No trace records found (CONFIG_I2CDEV_TRACE enabled?)');
+    process.exit(1);
+  }
+  printReport(analyze(trace, options.window), options.window);
+}
+
+main().catch((error) => {
+  console.error(error.message);
+  process.exit(1);
+});
@@ -0,0 +1,204 @@
+/**
+ * @file sdcard_bench.c
+ * @brief Host benchmark of the SD card log paths (component/FileManager/sdcard.c) on a POSIX
+ *        filesystem: one open/fsync/close per row vs the session writer.
+ *
+ * Build and run (from Electronic-Nose/tools):
+ *   gcc -O2 -Wall -Ihost_include -I../component/FileManager -DMOUNT_POINT='"sdcard"' sdcard_bench.c ../component/FileManager/sdcard.c -o sdcard_bench
+ *   ./sdcard_bench [rows] [directory]      default 2000 rows in ".", exit status 1 on failure
+ *
+ * MOUNT_POINT is relative: the files are written to <directory>/sdcard/BENCHn.csv (created and
+ * removed by the benchmark). Run it on a real disk or on the SD card in a card reader; on tmpfs
+ * fsync() costs nothing and only the open/close overhead remains.
+ *
+ * Rows are the firmware CSV rows (dataSensor_templateSaveToSDCard of datamanager.h, 4 channels).
+ * Reports rows/s and fsync() per row of:
+ *   - sdcard_writeDataToFile(): fopen + fprintf + fflush + fsync + fclose for every row
+ *   - sdcard_writerPrintf() with the writer policy committing every row
+ *   - sdcard_writerPrintf() with the default policy (CONFIG_SDCARD_WRITER_*, host_include/sdkconfig.h)
+ * and checks that the three files are identical.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sdcard.h"
+
+#define DEFAULT_ROWS    2000U
+
+// Như dataSensor_templateSaveToSDCard (datamanager.h)
+static const char benchRowFormat[] = "%d,%.2f,%.2f,%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 "\n";
+
+/* ESP-IDF stand-in */
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    static char name[16];
+    snprintf(name, sizeof(name), "0x%x", (unsigned)code);
+    return name;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma) { return ESP_FAIL; }
+esp_err_t spi_bus_free(spi_host_device_t host) { return ESP_FAIL; }
+esp_err_t esp_vfs_fat_sdspi_mount(const char *base_path, const sdmmc_host_t *host, const sdspi_device_config_t *slot,
+                                  const esp_vfs_fat_mount_config_t *mount_config, sdmmc_card_t **out_card) { return ESP_FAIL; }
+esp_err_t esp_vfs_fat_sdcard_unmount(const char *base_path, sdmmc_card_t *card) { return ESP_FAIL; }
+void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card) { }
+
+/* Benchmark */
+
+typedef struct
+{
+    int timeStamp;
+    float temperature;
+    float humidity;
+    int32_t adc[4];
+} benchRow_st;
+
+static void benchRow_fill(benchRow_st *row, uint32_t i)
+{
+    row->timeStamp = (int)i;
+    row->temperature = 25.0f + (float)(i % 100) * 0.01f;
+    row->humidity = 55.0f + (float)(i % 37) * 0.1f;
+    for (int c = 0; c < 4; c++) {
+        row->adc[c] = (int32_t)(12000 + 97 * c + (i * 13) % 500);
+    }
+}
+
+static void bench_report(const char *name, uint32_t rows, uint32_t syncs, int64_t elapsed_us)
+{
+    printf("%-30s %7" PRIu32 " rows in %8.3f s  %10.0f rows/s  %6.3f fsync/row\n", name, rows, elapsed_us / 1e6,
+           elapsed_us > 0 ? rows * 1e6 / elapsed_us : 0.0, rows ? (double)syncs / rows : 0.0);
+}
+
+static void bench_remove(const char *nameFile)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s.csv", MOUNT_POINT, nameFile);
+    remove(path);
+}
+
+static int bench_perRow(uint32_t rows)
+{
+    benchRow_st row;
+    bench_remove("BENCH1");
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        benchRow_fill(&row, i);
+        if (sdcard_writeDataToFile("BENCH1", benchRowFormat, row.timeStamp, row.temperature, row.humidity,
+                                   row.adc[0], row.adc[1], row.adc[2], row.adc[3]) != ESP_OK) {
+            return 1;
+        }
+    }
+    bench_report("sdcard_writeDataToFile", rows, rows, esp_timer_get_time() - start);
+    return 0;
+}
+
+static int bench_writer(const char *name, const char *nameFile, const sdcard_writerConfig_st *config, uint32_t rows)
+{
+    benchRow_st row;
+    sdcard_writer_st writer;
+    bench_remove(nameFile);
+
+    int64_t start = esp_timer_get_time();
+    if (sdcard_writerOpen(&writer, nameFile, "csv", config) != ESP_OK) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        benchRow_fill(&row, i);
+        if (sdcard_writerPrintf(&writer, benchRowFormat, row.timeStamp, row.temperature, row.humidity,
+                                row.adc[0], row.adc[1], row.adc[2], row.adc[3]) != ESP_OK) {
+            sdcard_writerClose(&writer);
+            return 1;
+        }
+    }
+    if (sdcard_writerClose(&writer) != ESP_OK) {
+        return 1;
+    }
+    bench_report(name, writer.totalRows, writer.totalSyncs, esp_timer_get_time() - start);
+    return 0;
+}
+
+static bool bench_sameFile(const char *nameA, const char *nameB)
+{
+    char pathA[64], pathB[64];
+    snprintf(pathA, sizeof(pathA), "%s/%s.csv", MOUNT_POINT, nameA);
+    snprintf(pathB, sizeof(pathB), "%s/%s.csv", MOUNT_POINT, nameB);
+    FILE *a = fopen(pathA, "rb");
+    FILE *b = fopen(pathB, "rb");
+    bool same = (a != NULL && b != NULL);
+    while (same)
+    {
+        int ca = fgetc(a), cb = fgetc(b);
+        same = (ca == cb);
+        if (ca == EOF || cb == EOF) {
+            break;
+        }
+    }
+    if (a != NULL) fclose(a);
+    if (b != NULL) fclose(b);
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rows = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_ROWS;
+    const char *directory = (argc > 2) ? argv[2] : ".";
+    if (rows == 0 || argc > 3)
+    {
+        fprintf(stderr, "usage: %s [rows] [directory]\n", argv[0]);
+        return 2;
+    }
+    if (chdir(directory) != 0 || (mkdir(MOUNT_POINT, 0777) != 0 && errno != EEXIST))
+    {
+        fprintf(stderr, "cannot use %s/%s (errno %d)\n", directory, MOUNT_POINT, errno);
+        return 1;
+    }
+
+    const sdcard_writerConfig_st everyRow = { .bufferSize = CONFIG_SDCARD_WRITER_BUFFER_SIZE, .commitRows = 1 };
+    const sdcard_writerConfig_st defaultPolicy = SDCARD_WRITER_CONFIG_DEFAULT();
+    int failed = bench_perRow(rows);
+    failed |= bench_writer("sdcard_writer (commit 1 row)", "BENCH2", &everyRow, rows);
+    failed |= bench_writer("sdcard_writer (default policy)", "BENCH3", &defaultPolicy, rows);
+    if (!failed && !(bench_sameFile("BENCH1", "BENCH2") && bench_sameFile("BENCH1", "BENCH3")))
+    {
+        fprintf(stderr, "FAIL: the three logs differ\n");
+        failed = 1;
+    }
+
+    bench_remove("BENCH1");
+    bench_remove("BENCH2");
+    bench_remove("BENCH3");
+    rmdir(MOUNT_POINT);     // Chỉ xoá được khi thư mục trống (không phải thư mục có sẵn của người dùng)
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file serializer_bench.c
+ * @brief Host benchmark of the sample serializers of component/DataManager/datamanager.c:
+ *        dataSensor_formatCsvRow() and dataSensor_formatDashboardJson() vs the old printf paths
+ *        (CSV: vsnprintf to measure + malloc + vsnprintf + free, JSON: snprintf with "%.2f").
+ *
+ * Build and run (from Electronic-Nose/tools):
+ *   gcc -O2 -Wall -Ihost_include -I../component/DataManager -I../component/Calibration serializer_bench.c ../component/DataManager/datamanager.c ../component/DataManager/binlog.c -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc -lm -o serializer_bench
+ *   ./serializer_bench [records]          default 200000, exit status 1 on failure
+ *
+ * Reports ns/record, heap allocations per record and bytes per record of each path. Allocations
+ * are counted by the --wrap'ed malloc/calloc/realloc, i.e. calls from the firmware sources and
+ * from this file (the C library's own allocations are not seen). On the device the same numbers
+ * come from main/test_benchmark.c, whose allocation count needs CONFIG_HEAP_USE_HOOKS.
+ *
+ * Also checks that the integer formatting matches printf: STT, Time_us, "%.2f" temperature and
+ * humidity of every CSV row and JSON object.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "datamanager.h"
+
+#define DEFAULT_RECORDS     200000U
+
+#define EXPECT(condition, ...) do { \
+        if (!(condition)) { failures++; if (failures <= 10) { printf("FAIL %s:%d: ", __func__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } \
+    } while (0)
+
+static int failures = 0;
+static uint32_t allocationCount = 0;
+
+/* Allocation counter (-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc) */
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocationCount++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocationCount++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocationCount++;
+    return __real_realloc(ptr, size);
+}
+
+static int64_t bench_nowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Như benchmark_fillSample() của main/test_benchmark.c
+static void bench_fillSample(struct dataSensor_st *sample, uint32_t index)
+{
+    sample->timeStamp = (int)index;
+    sample->monotonic_us = 5000000 + (int64_t)index * 100000;
+    sample->epochOffset_us = 1760000000000000;
+    sample->temperature = 25.0f + (float)(index % 50) / 10.0f;
+    sample->humidity = 60.0f + (float)(index % 30) / 10.0f;
+    sample->pressure = 0;
+    sample->channelCount = 4;
+    for (size_t i = 0; i < 4; i++) {
+        sample->ADC_Value[i] = (int16_t)(11000 + index * 7 + i * 1000);
+        sample->gain[i] = BINLOG_REFERENCE_GAIN;
+        sample->concentration[i] = CALIBRATION_VALUE_NONE;
+    }
+}
+
+/**
+ * @brief Đường format CSV cũ của sdcard_writeDataToFile(): đo độ dài, malloc, format, free
+ */
+static size_t bench_legacyCsvRow(char *out, size_t size, const char *format, ...)
+{
+    va_list argumentsList;
+    va_list argumentsList_copy;
+    va_start(argumentsList, format);
+    va_copy(argumentsList_copy, argumentsList);
+    int length = vsnprintf(NULL, 0, format, argumentsList_copy);
+    va_end(argumentsList_copy);
+
+    char *dataString = (char *)malloc((size_t)length + 1);
+    if (dataString != NULL)
+    {
+        vsnprintf(dataString, (size_t)length + 1, format, argumentsList);
+        snprintf(out, size, "%s", dataString);
+        free(dataString);
+    }
+    va_end(argumentsList);
+    return (size_t)length;
+}
+
+static size_t bench_legacyJson(char *out, size_t size, const struct dataSensor_st *sample)
+{
+    return (size_t)snprintf(out, size,
+                            "{\"Time\":\"%s\",\"Temperature\":%.2f,\"Humidity\":%.2f,\"Pressure\":0,"
+                            "\"EtOH1\":%d,\"EtOH2\":%d,\"EtOH3\":%d,\"EtOH4\":%d,\"ip\":\"%s\"}",
+                            "2024-01-01T00:00:00Z", sample->temperature, sample->humidity,
+                            sample->ADC_Value[0], sample->ADC_Value[1], sample->ADC_Value[2], sample->ADC_Value[3],
+                            "192.168.1.100");
+}
+
+typedef enum
+{
+    BENCH_CSV_LEGACY,
+    BENCH_CSV_FORMAT,
+    BENCH_JSON_LEGACY,
+    BENCH_JSON_FORMAT,
+} bench_path_t;
+
+static const char *const bench_pathNames[] = {"CSV vsnprintf+malloc", "CSV dataSensor_format", "JSON snprintf", "JSON dataSensor_format"};
+
+static void bench_run(bench_path_t path, uint32_t records)
+{
+    struct dataSensor_st sample;
+    char buffer[512];
+    size_t bytes = 0;
+
+    uint32_t allocations = allocationCount;
+    int64_t start = bench_nowNs();
+    for (uint32_t i = 0; i < records; i++)
+    {
+        bench_fillSample(&sample, i);
+        switch (path)
+        {
+        case BENCH_CSV_LEGACY:
+            bytes += bench_legacyCsvRow(buffer, sizeof(buffer), dataSensor_templateSaveToSDCard,
+                                        sample.timeStamp, sample.temperature, sample.humidity,
+                                        (int32_t)sample.ADC_Value[0], (int32_t)sample.ADC_Value[1],
+                                        (int32_t)sample.ADC_Value[2], (int32_t)sample.ADC_Value[3]);
+            break;
+        case BENCH_CSV_FORMAT:
+            bytes += dataSensor_formatCsvRow(&sample, buffer, sizeof(buffer));
+            break;
+        case BENCH_JSON_LEGACY:
+            bytes += bench_legacyJson(buffer, sizeof(buffer), &sample);
+            break;
+        case BENCH_JSON_FORMAT:
+            bytes += dataSensor_formatDashboardJson(&sample, "2024-01-01T00:00:00Z", "192.168.1.100", buffer, sizeof(buffer));
+            break;
+        }
+    }
+    int64_t elapsed = bench_nowNs() - start;
+
+    printf("%-24s %8.1f ns/record  %5.2f alloc/record  %4u bytes/record\n", bench_pathNames[path],
+           (double)elapsed / records, (double)(allocationCount - allocations) / records, (unsigned)(bytes / records));
+}
+
+/**
+ * @brief Số nguyên và "%.2f" của các serializer phải giống hệt printf
+ */
+static void test_matchesPrintf(uint32_t records)
+{
+    struct dataSensor_st sample;
+    char buffer[512];
+    char expected[128];
+
+    for (uint32_t i = 0; i < records; i++)
+    {
+        bench_fillSample(&sample, i);
+        sample.temperature = -40.0f + (float)(i % 12500) * 0.01f + (float)(i % 7) * 0.001f;
+        sample.humidity = (float)(i % 10000) * 0.01f + 0.005f;
+
+        snprintf(expected, sizeof(expected), "%d,%" PRId64 ",%.2f,%.2f,", sample.timeStamp,
+                 dataSensor_timeUs(&sample), sample.temperature, sample.humidity);
+        size_t length = dataSensor_formatCsvRow(&sample, buffer, sizeof(buffer));
+        EXPECT(length != 0 && strncmp(buffer, expected, strlen(expected)) == 0, "CSV \"%s\" expected prefix \"%s\"", buffer, expected);
+
+        snprintf(expected, sizeof(expected), "{\"Time\":\"T\",\"Time_us\":%" PRId64 ",\"Temperature\":%.2f,\"Humidity\":%.2f,",
+                 dataSensor_timeUs(&sample), sample.temperature, sample.humidity);
+        length = dataSensor_formatDashboardJson(&sample, "T", NULL, buffer, sizeof(buffer));
+        EXPECT(length != 0 && strncmp(buffer, expected, strlen(expected)) == 0, "JSON \"%s\" expected prefix \"%s\"", buffer, expected);
+    }
+
+    // Buffer thiếu 1 byte: trả 0, không ghi quá
+    bench_fillSample(&sample, 1);
+    size_t length = dataSensor_formatCsvRow(&sample, buffer, sizeof(buffer));
+    EXPECT(dataSensor_formatCsvRow(&sample, buffer, length) == 0 && buffer[0] == '\0', "CSV in a %u byte buffer", (unsigned)length);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t records = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_RECORDS;
+    if (records == 0 || argc > 2)
+    {
+        fprintf(stderr, "usage: %s [records]\n", argv[0]);
+        return 2;
+    }
+
+    test_matchesPrintf(records);
+    for (bench_path_t path = BENCH_CSV_LEGACY; path <= BENCH_JSON_FORMAT; path++) {
+        bench_run(path, records);
+    }
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,534 @@
+/**
+ * @file train_classifier.cpp
+ * @brief Train the event classifier (component/Classifier/classifier.h) on labelled event logs
+ *        (<name>.evt of the SD card) and export the fixed-point model loaded by the device.
+ *
+ * Build (from Electronic-Nose/tools):
+ *   gcc -O2 -I../component/SignalProcessing -c ../component/Classifier/classifier.c -o classifier.o
+ *   g++ -std=c++17 -O2 -I../component/SignalProcessing -I../component/Classifier train_classifier.cpp classifier.o -lm -o train_classifier
+ *
+ * Usage:
+ *   train_classifier [options] <MODEL.ENM> <label>=<events.evt> [<label>=<events.evt> ...]
+ *     --hidden N          hidden neurons, 0 = linear model (default 16, max 32)
+ *     --epochs N          full-batch Adam epochs (default 3000)
+ *     --holdout P         % of the events of each label kept out of training for validation (default 20)
+ *     --min-confidence P  below P % the device reports "unknown" (default 60)
+ *   train_classifier --eval <MODEL.ENM> <label>=<events.evt> ...   (accuracy of an existing model)
+ *
+ * Record the sessions of one substance per .evt file (e.g. ethanol=S01.EVT acetone=S02.EVT
+ * air=S03.EVT), several files may share a label. The accuracy printed after export is computed
+ * with the quantized model and the firmware code (classifier_run()), i.e. what the device does.
+ * Copy MODEL.ENM to the SD card root (or upload it, then POST /api/classifier/reload), or put it
+ * in the SPIFFS image of the "data" partition.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "classifier.h"
+
+struct Sample
+{
+    eventDetector_event_st event;
+    std::vector<int32_t> features;
+    int label;
+    bool holdout;
+};
+
+static std::vector<std::string> splitCsv(const std::string &line)
+{
+    std::vector<std::string> fields;
+    std::istringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+/**
+ * @brief Đọc các event của một file .evt (cột theo tên, xem eventFormat_csvHeader(), component/Classifier/eventformat.h).
+ */
+static bool readEvents(const std::string &path, int label, std::vector<Sample> &samples, unsigned &channelCount)
+{
+    static const char *const columns[] = {"Baseline", "Peak", "Onset", "Rise", "TimeToPeak", "Area", "Slope"};
+    std::ifstream input(path);
+    std::string line;
+    if (!input || !std::getline(input, line))
+    {
+        std::cerr << "cannot read " << path << "\n";
+        return false;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+
+    std::map<std::string, size_t> index;
+    std::vector<std::string> header = splitCsv(line);
+    for (size_t c = 0; c < header.size(); c++) {
+        index[header[c]] = c;
+    }
+    unsigned channels = 0;
+    while (channels < EVENT_DETECTOR_CHANNEL_MAX && index.count("Peak" + std::to_string(channels + 1))) {
+        channels++;
+    }
+    if (channels == 0 || !index.count("Duration_ms") || !index.count("Frames") || !index.count("Mask"))
+    {
+        std::cerr << path << ": not an event log (Event,Time_us,Duration_ms,...,Peak1,...)\n";
+        return false;
+    }
+    if (channelCount != 0 && channels != channelCount)
+    {
+        std::cerr << path << ": " << channels << " channels, other logs have " << channelCount << "\n";
+        return false;
+    }
+    channelCount = channels;
+
+    size_t count = 0;
+    while (std::getline(input, line))
+    {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::vector<std::string> fields = splitCsv(line);
+        if (fields.size() < header.size()) {
+            continue;   // dòng cuối bị cắt khi mất điện
+        }
+        auto value = [&](const std::string &name) { return std::strtoll(fields[index[name]].c_str(), nullptr, 10); };
+
+        Sample sample{};
+        eventDetector_event_st &event = sample.event;
+        event.sequence = (uint32_t)value("Event");
+        event.duration_ms = (uint32_t)value("Duration_ms");
+        event.frames = (uint32_t)value("Frames");
+        event.triggerMask = (uint16_t)value("Mask");
+        event.truncated = value("Truncated") != 0;
+        event.channelCount = (uint8_t)channels;
+        for (unsigned i = 0; i < channels; i++)
+        {
+            int32_t values[7];
+            for (size_t c = 0; c < 7; c++)
+            {
+                std::string name = columns[c] + std::to_string(i + 1);
+                values[c] = index.count(name) ? (int32_t)value(name) : 0;
+            }
+            event.channel[i] = {values[0], values[1], values[2], values[3], values[4], values[5], values[6]};
+        }
+        sample.features.resize(CLASSIFIER_INPUTS(channels));
+        classifier_features(&event, sample.features.data());
+        sample.label = label;
+        samples.push_back(sample);
+        count++;
+    }
+    std::fprintf(stderr, "%s: %zu events\n", path.c_str(), count);
+    return true;
+}
+
+/**
+ * @brief Độ chính xác và ma trận nhầm lẫn của model đã lượng tử hoá, tính bằng code firmware.
+ */
+static void evaluate(const classifier_model_st &model, const std::vector<Sample> &samples, bool holdout, const char *title)
+{
+    std::vector<std::vector<unsigned>> confusion(model.classCount, std::vector<unsigned>(model.classCount + 1, 0));
+    unsigned total = 0, correct = 0;
+    for (const Sample &sample : samples)
+    {
+        if (sample.holdout != holdout || sample.label >= model.classCount) {
+            continue;
+        }
+        classifier_result_st result;
+        classifier_run(&model, &sample.event, &result);
+        confusion[sample.label][result.known ? result.classIndex : model.classCount]++;
+        correct += (result.known && result.classIndex == sample.label) ? 1 : 0;
+        total++;
+    }
+    if (total == 0) {
+        return;
+    }
+
+    std::printf("%s: %u/%u correct (%.1f %%)\n%16s", title, correct, total, 100.0 * correct / total, "true \\ device");
+    for (unsigned c = 0; c < model.classCount; c++) {
+        std::printf(" %10.10s", model.label[c]);
+    }
+    std::printf(" %10s\n", "unknown");
+    for (unsigned t = 0; t < model.classCount; t++)
+    {
+        std::printf("%16.16s", model.label[t]);
+        for (unsigned c = 0; c <= model.classCount; c++) {
+            std::printf(" %10u", confusion[t][c]);
+        }
+        std::printf("\n");
+    }
+}
+
+static int32_t clampInt32(double value)
+{
+    return (int32_t)std::llround(std::max(std::min(value, (double)INT32_MAX), (double)-INT32_MAX));
+}
+
+static int8_t quantize8(double value)
+{
+    return (int8_t)std::lround(std::max(std::min(value, 127.0), -127.0));
+}
+
+struct Options
+{
+    unsigned hidden = 16;
+    unsigned epochs = 3000;
+    unsigned holdout = 20;
+    unsigned minConfidence = 60;
+};
+
+/**
+ * @brief Chuẩn hoá đầu vào (offset, scale: 1 độ lệch chuẩn = 32 mức int8), huấn luyện MLP số thực trên đúng
+ *        đầu vào int8 mà thiết bị thấy, rồi lượng tử hoá trọng số về int8 với thang đo theo từng lớp.
+ */
+static void train(classifier_model_st &model, std::vector<Sample> &samples, const Options &options)
+{
+    const unsigned inputs = model.inputCount, hidden = options.hidden, classes = model.classCount;
+    constexpr double inputUnit = 32.0;
+
+    // Offset/scale trên tập huấn luyện
+    std::vector<double> mean(inputs, 0.0), deviation(inputs, 0.0);
+    unsigned trainCount = 0;
+    for (const Sample &sample : samples)
+    {
+        if (sample.holdout) {
+            continue;
+        }
+        trainCount++;
+        for (unsigned i = 0; i < inputs; i++) {
+            mean[i] += sample.features[i];
+        }
+    }
+    for (unsigned i = 0; i < inputs; i++) {
+        mean[i] /= trainCount;
+    }
+    for (const Sample &sample : samples)
+    {
+        for (unsigned i = 0; !sample.holdout && i < inputs; i++) {
+            deviation[i] += (sample.features[i] - mean[i]) * (sample.features[i] - mean[i]);
+        }
+    }
+    for (unsigned i = 0; i < inputs; i++)
+    {
+        deviation[i] = std::sqrt(deviation[i] / trainCount);
+        model.inputOffset[i] = clampInt32(mean[i]);
+        // Đặc trưng không đổi: scale 0, đầu vào luôn 0
+        model.inputScaleQ16[i] = (deviation[i] > 1e-9) ? clampInt32(inputUnit * 65536.0 / deviation[i]) : 0;
+    }
+
+    // Đầu vào int8 như classifier_runFeatures()
+    std::vector<std::vector<double>> x;
+    std::vector<int> y;
+    for (const Sample &sample : samples)
+    {
+        if (sample.holdout) {
+            continue;
+        }
+        std::vector<double> row(inputs);
+        for (unsigned i = 0; i < inputs; i++)
+        {
+            int64_t scaled = ((int64_t)sample.features[i] - model.inputOffset[i]) * model.inputScaleQ16[i];
+            row[i] = std::max<int64_t>(-127, std::min<int64_t>(127, (scaled + 32768) >> 16)) / inputUnit;
+        }
+        x.push_back(row);
+        y.push_back(sample.label);
+    }
+
+    // Tham số số thực: w1 [hidden][inputs], w2 [classes][width]
+    const unsigned width = hidden ? hidden : inputs;
+    std::mt19937 random(12345);
+    std::vector<double> parameters(hidden * inputs + hidden + classes * width + classes);
+    {
+        std::normal_distribution<double> first(0.0, std::sqrt(2.0 / inputs));
+        std::normal_distribution<double> second(0.0, std::sqrt(1.0 / width));
+        for (unsigned k = 0; k < hidden * inputs; k++) {
+            parameters[k] = first(random);
+        }
+        for (unsigned k = 0; k < classes * width; k++) {
+            parameters[hidden * inputs + hidden + k] = second(random);
+        }
+    }
+    double *w1 = parameters.data(), *b1 = w1 + hidden * inputs, *w2 = b1 + hidden, *b2 = w2 + classes * width;
+
+    std::vector<double> gradient(parameters.size()), moment1(parameters.size(), 0.0), moment2(parameters.size(), 0.0);
+    std::vector<double> activation(width), logits(classes), delta(width);
+    const double rate = 0.01, decay = 1e-3;
+    for (unsigned epoch = 1; epoch <= options.epochs; epoch++)
+    {
+        std::fill(gradient.begin(), gradient.end(), 0.0);
+        double loss = 0.0;
+        for (size_t n = 0; n < x.size(); n++)
+        {
+            for (unsigned h = 0; h < width; h++)
+            {
+                if (hidden == 0) {
+                    activation[h] = x[n][h];
+                    continue;
+                }
+                double sum = b1[h];
+                for (unsigned i = 0; i < inputs; i++) {
+                    sum += w1[h * inputs + i] * x[n][i];
+                }
+                activation[h] = std::max(sum, 0.0);
+            }
+            double largest = -1e300;
+            for (unsigned c = 0; c < classes; c++)
+            {
+                logits[c] = b2[c];
+                for (unsigned h = 0; h < width; h++) {
+                    logits[c] += w2[c * width + h] * activation[h];
+                }
+                largest = std::max(largest, logits[c]);
+            }
+            double total = 0.0;
+            for (unsigned c = 0; c < classes; c++) {
+                total += std::exp(logits[c] - largest);
+            }
+            loss -= logits[y[n]] - largest - std::log(total);
+
+            std::fill(delta.begin(), delta.end(), 0.0);
+            for (unsigned c = 0; c < classes; c++)
+            {
+                double error = std::exp(logits[c] - largest) / total - (c == (unsigned)y[n] ? 1.0 : 0.0);
+                gradient[hidden * inputs + hidden + classes * width + c] += error;
+                for (unsigned h = 0; h < width; h++)
+                {
+                    gradient[hidden * inputs + hidden + c * width + h] += error * activation[h];
+                    delta[h] += error * w2[c * width + h];
+                }
+            }
+            for (unsigned h = 0; h < hidden; h++)
+            {
+                if (activation[h] <= 0.0) {
+                    continue;
+                }
+                gradient[hidden * inputs + h] += delta[h];
+                for (unsigned i = 0; i < inputs; i++) {
+                    gradient[h * inputs + i] += delta[h] * x[n][i];
+                }
+            }
+        }
+
+        // Adam, L2 trên trọng số
+        for (size_t k = 0; k < parameters.size(); k++)
+        {
+            double g = gradient[k] / x.size() + decay * parameters[k];
+            moment1[k] = 0.9 * moment1[k] + 0.1 * g;
+            moment2[k] = 0.999 * moment2[k] + 0.001 * g * g;
+            double m = moment1[k] / (1.0 - std::pow(0.9, epoch));
+            double v = moment2[k] / (1.0 - std::pow(0.999, epoch));
+            parameters[k] -= rate * m / (std::sqrt(v) + 1e-8);
+        }
+        if (epoch == 1 || epoch % 500 == 0 || epoch == options.epochs) {
+            std::fprintf(stderr, "epoch %5u  loss %.4f\n", epoch, loss / x.size());
+        }
+    }
+
+    // Lớp ẩn: a = w1 (x_q / 32) + b1, acc = w1q x_q + b1q ~ a s1, h_q = acc >> shift ~ a sh
+    double hiddenScale = inputUnit;   // h_q / h (đơn vị của đầu vào lớp ra), = 32 khi không có lớp ẩn
+    model.hiddenCount = (uint8_t)hidden;
+    model.hiddenShift = 0;
+    if (hidden != 0)
+    {
+        double largestWeight = 1e-12;
+        for (unsigned k = 0; k < hidden * inputs; k++) {
+            largestWeight = std::max(largestWeight, std::fabs(w1[k]) / inputUnit);
+        }
+        double s1 = 127.0 / largestWeight;
+        double largestActivation = 1e-12;
+        for (size_t n = 0; n < x.size(); n++)
+        {
+            for (unsigned h = 0; h < hidden; h++)
+            {
+                double sum = b1[h];
+                for (unsigned i = 0; i < inputs; i++) {
+                    sum += w1[h * inputs + i] * x[n][i];
+                }
+                largestActivation = std::max(largestActivation, sum);
+            }
+        }
+        while (model.hiddenShift < 31 && largestActivation * s1 / std::ldexp(1.0, model.hiddenShift) > 127.0) {
+            model.hiddenShift++;
+        }
+        for (unsigned h = 0; h < hidden; h++)
+        {
+            model.hiddenBias[h] = clampInt32(b1[h] * s1);
+            for (unsigned i = 0; i < inputs; i++) {
+                model.hiddenWeight[h][i] = quantize8(w1[h * inputs + i] / inputUnit * s1);
+            }
+        }
+        hiddenScale = s1 / std::ldexp(1.0, model.hiddenShift);
+    }
+
+    // Lớp ra: z = w2 (h_q / hiddenScale) + b2, logit = w2q h_q + b2q ~ z s2
+    double largestWeight = 1e-12;
+    for (unsigned k = 0; k < classes * width; k++) {
+        largestWeight = std::max(largestWeight, std::fabs(w2[k]) / hiddenScale);
+    }
+    double s2 = 127.0 / largestWeight;
+    for (unsigned c = 0; c < classes; c++)
+    {
+        model.outputBias[c] = clampInt32(b2[c] * s2);
+        for (unsigned h = 0; h < width; h++) {
+            model.outputWeight[c][h] = quantize8(w2[c * width + h] / hiddenScale * s2);
+        }
+    }
+    model.logitScaleQ16 = std::max<int32_t>(1, clampInt32(65536.0 / s2));
+}
+
+static bool parseLabelled(int argc, char **argv, int argi, classifier_model_st &model, std::vector<Sample> &samples,
+                          std::vector<std::string> &labels)
+{
+    unsigned channelCount = model.channelCount;
+    for (; argi < argc; argi++)
+    {
+        const char *separator = std::strchr(argv[argi], '=');
+        if (separator == nullptr || separator == argv[argi])
+        {
+            std::cerr << "expected <label>=<events.evt>, got " << argv[argi] << "\n";
+            return false;
+        }
+        std::string label(argv[argi], (size_t)(separator - argv[argi]));
+        auto known = std::find(labels.begin(), labels.end(), label);
+        if (known == labels.end())
+        {
+            if (labels.size() == CLASSIFIER_CLASS_MAX || label.size() >= CLASSIFIER_LABEL_SIZE)
+            {
+                std::cerr << "at most " << CLASSIFIER_CLASS_MAX << " labels of " << CLASSIFIER_LABEL_SIZE - 1 << " characters\n";
+                return false;
+            }
+            labels.push_back(label);
+            known = labels.end() - 1;
+        }
+        if (!readEvents(separator + 1, (int)(known - labels.begin()), samples, channelCount)) {
+            return false;
+        }
+    }
+    model.channelCount = (uint8_t)channelCount;
+    return !samples.empty();
+}
+
+static bool loadModel(const char *path, classifier_model_st &model)
+{
+    std::ifstream input(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (!input || !classifier_decode(&model, data.data(), data.size()))
+    {
+        std::cerr << path << ": not a classifier model (magic, version " << CLASSIFIER_VERSION << ", CRC)\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    static classifier_model_st model;
+    std::vector<Sample> samples;
+    std::vector<std::string> labels;
+    Options options;
+
+    if (argc >= 4 && std::strcmp(argv[1], "--eval") == 0)
+    {
+        if (!loadModel(argv[2], model)) {
+            return 1;
+        }
+        // Label theo thứ tự của model: nhãn không có trong model bị bỏ qua
+        for (unsigned c = 0; c < model.classCount; c++) {
+            labels.push_back(model.label[c]);
+        }
+        unsigned channelCount = model.channelCount;
+        classifier_model_st parsed = model;
+        if (!parseLabelled(argc, argv, 3, parsed, samples, labels) || parsed.channelCount != channelCount)
+        {
+            std::cerr << "events do not match the model (" << channelCount << " channels)\n";
+            return 1;
+        }
+        evaluate(model, samples, false, "evaluation");
+        return 0;
+    }
+
+    int argi = 1;
+    for (; argi + 1 < argc && std::strncmp(argv[argi], "--", 2) == 0; argi += 2)
+    {
+        unsigned value = (unsigned)std::strtoul(argv[argi + 1], nullptr, 10);
+        if (std::strcmp(argv[argi], "--hidden") == 0) {
+            options.hidden = value;
+        } else if (std::strcmp(argv[argi], "--epochs") == 0) {
+            options.epochs = value;
+        } else if (std::strcmp(argv[argi], "--holdout") == 0) {
+            options.holdout = value;
+        } else if (std::strcmp(argv[argi], "--min-confidence") == 0) {
+            options.minConfidence = value;
+        } else {
+            break;
+        }
+    }
+    if (argc - argi < 3 || options.hidden > CLASSIFIER_HIDDEN_MAX || options.holdout >= 100 || options.minConfidence > 100 ||
+        options.epochs == 0)
+    {
+        std::cerr << "usage: " << argv[0] << " [--hidden N] [--epochs N] [--holdout P] [--min-confidence P] <MODEL.ENM> <label>=<events.evt> ...\n"
+                  << "       " << argv[0] << " --eval <MODEL.ENM> <label>=<events.evt> ...\n";
+        return 2;
+    }
+    const char *modelPath = argv[argi];
+    if (!parseLabelled(argc, argv, argi + 1, model, samples, labels)) {
+        return 1;
+    }
+    if (labels.size() < 2)
+    {
+        std::cerr << "need events of at least 2 labels\n";
+        return 1;
+    }
+
+    // Validation: mỗi nhãn giữ lại holdout % event, rải đều theo thời gian (không ngẫu nhiên, chạy lại cho cùng kết quả)
+    std::vector<unsigned> seen(labels.size(), 0);
+    for (Sample &sample : samples)
+    {
+        unsigned n = seen[sample.label]++;
+        sample.holdout = options.holdout != 0 && (n * options.holdout) / 100 != ((n + 1) * options.holdout) / 100;
+    }
+
+    model.inputCount = (uint8_t)CLASSIFIER_INPUTS(model.channelCount);
+    model.classCount = (uint8_t)labels.size();
+    model.minConfidence = (uint8_t)options.minConfidence;
+    for (unsigned c = 0; c < labels.size(); c++) {
+        std::snprintf(model.label[c], CLASSIFIER_LABEL_SIZE, "%s", labels[c].c_str());
+    }
+    train(model, samples, options);
+
+    uint8_t blob[CLASSIFIER_BLOB_MAX_SIZE];
+    size_t size = classifier_encode(&model, blob, sizeof(blob));
+    if (size == 0)
+    {
+        std::cerr << "invalid model (labels: letters, digits, '_', '-', '.')\n";
+        return 1;
+    }
+    FILE *output = std::fopen(modelPath, "wb");
+    if (output == nullptr || std::fwrite(blob, 1, size, output) != size)
+    {
+        std::cerr << "cannot write " << modelPath << "\n";
+        if (output != nullptr) {
+            std::fclose(output);
+        }
+        return 1;
+    }
+    std::fclose(output);
+    std::fprintf(stderr, "%s: %u channels, %u inputs, %u hidden (shift %u), %u classes, %zu bytes\n", modelPath,
+                 model.channelCount, model.inputCount, model.hiddenCount, model.hiddenShift, model.classCount, size);
+
+    evaluate(model, samples, false, "training (device, int8)");
+    evaluate(model, samples, true, "validation (device, int8)");
+    return 0;
+}
@@ -10,6 +10,50 @@ const http = require('http');
 const app = express();
 
 let TemperatureValue = 50, HumidityValue = 0, EtOH1Value = 0, EtOH2Value = 0, EtOH3Value = 0, EtOH4Value = 0, Time = "";
+// Tất cả kênh cảm biến của mẫu mới nhất (ESP32 có thể có tới 4 ADS1115 x 4 kênh), EtOH1..4 = 4 kênh đầu
+let SensorValues = [];
+const SENSOR_CHANNEL_MAX = 16;
+
+// EtOH1..EtOHn (hoặc ADC1..n / ADC_Value[]) của một mẫu -> mảng, luôn có ít nhất 4 kênh
+function readSensorValues(data) {
+  const values = [];
+  for (let i = 1; i <= SENSOR_CHANNEL_MAX; i++) {
+    const value = data[`EtOH${i}`] ?? data[`ADC${i}`] ?? data.ADC_Value?.[i - 1];
+    if (value === undefined && i > 4) {
+      break;
+    }
+    values.push(Number(parseFloat(value ?? 0)));
+  }
+  return values;
+}
+
+// Conc1..Concn (nồng độ theo bảng hiệu chuẩn của ESP32, /api/calibration) -> mảng, null cho kênh chưa hiệu chuẩn,
+// undefined khi mẫu không có kênh nào được hiệu chuẩn
+function readConcentrations(data) {
+  const values = [];
+  let calibrated = false;
+  for (let i = 1; i <= SENSOR_CHANNEL_MAX; i++) {
+    const value = data[`Conc${i}`];
+    calibrated ||= (value !== undefined);
+    values.push(value === undefined ? null : Number(parseFloat(value)));
+  }
+  if (!calibrated) {
+    return undefined;
+  }
+  while (values[values.length - 1] === null) {
+    values.pop();
+  }
+  return values;
+}
+
+// Cột Time_us của CSV ESP32: epoch µs khi đã có SNTP/DS3231, µs từ lúc khởi động trước đó (bỏ qua)
+function csvTimeUsToIso(timeUs) {
+  const value = Number(timeUs);
+  if (!Number.isFinite(value) || value < 1577836800e6) {
+    return '';
+  }
+  return new Date(value / 1000).toISOString();
+}
 const {
   getAllVersions,
   getDataFirmware,
@@ -417,16 +461,16 @@ app.get('/api/csv/read/:filename', (req, res) => {
     fs.createReadStream(filePath)
       .pipe(csv())
       .on('data', (data) => {
-        // Parse dữ liệu từ CSV (format: STT,Temperature,Humidity,Sensor1,Sensor2,Sensor3,Sensor4)
+        // Parse dữ liệu từ CSV (format: STT[,Time_us],Temperature,Humidity,Sensor1,Sensor2,Sensor3,Sensor4)
         const row = {
           STT: parseInt(data.STT) || 0,
           Temperature: parseFloat(data.Temperature) || 0,
           Humidity: parseFloat(data.Humidity) || 0,
-          EtOH1: parseInt(data.Sensor1 || data.ADC0 || data.EtOH1) || 0,
-          EtOH2: parseInt(data.Sensor2 || data.ADC1 || data.EtOH2) || 0,
-          EtOH3: parseInt(data.Sensor3 || data.ADC2 || data.EtOH3) || 0,
-          EtOH4: parseInt(data.Sensor4 || data.ADC3 || data.EtOH4) || 0,
-          Timestamp: data.Timestamp || data.Time || ''
+          EtOH1: parseFloat(data.Sensor1 || data.ADC0 || data.EtOH1) || 0,
+          EtOH2: parseFloat(data.Sensor2 || data.ADC1 || data.EtOH2) || 0,
+          EtOH3: parseFloat(data.Sensor3 || data.ADC2 || data.EtOH3) || 0,
+          EtOH4: parseFloat(data.Sensor4 || data.ADC3 || data.EtOH4) || 0,
+          Timestamp: data.Timestamp || data.Time || csvTimeUsToIso(data.Time_us)
         };
         results.push(row);
       })
@@ -498,11 +542,11 @@ app.post('/api/csv/send-to-dashboard/:filename', (req, res) => {
           STT: parseInt(data.STT) || 0,
           Temperature: parseFloat(data.Temperature) || 0,
           Humidity: parseFloat(data.Humidity) || 0,
-          EtOH1: parseInt(data.Sensor1 || data.ADC0 || data.EtOH1) || 0,
-          EtOH2: parseInt(data.Sensor2 || data.ADC1 || data.EtOH2) || 0,
-          EtOH3: parseInt(data.Sensor3 || data.ADC2 || data.EtOH3) || 0,
-          EtOH4: parseInt(data.Sensor4 || data.ADC3 || data.EtOH4) || 0,
-          Timestamp: data.Timestamp || data.Time || ''
+          EtOH1: parseFloat(data.Sensor1 || data.ADC0 || data.EtOH1) || 0,
+          EtOH2: parseFloat(data.Sensor2 || data.ADC1 || data.EtOH2) || 0,
+          EtOH3: parseFloat(data.Sensor3 || data.ADC2 || data.EtOH3) || 0,
+          EtOH4: parseFloat(data.Sensor4 || data.ADC3 || data.EtOH4) || 0,
+          Timestamp: data.Timestamp || data.Time || csvTimeUsToIso(data.Time_us)
         };
         results.push(row);
       })
@@ -575,16 +619,25 @@ app.post('/api/esp32/register', express.json(), (req, res) => {
 
 // ========== HTTP POST ENDPOINT FOR ESP32 DATA ==========
 // Endpoint để ESP32 gửi dữ liệu sensor qua HTTP POST (không cần SD card)
-app.post('/api/esp32/data', express.json(), (req, res) => {
+// Body là một mẫu (object) hoặc một batch mẫu (JSON array, theo thứ tự thời gian).
+// Trong batch, IP của ESP32 chỉ có ở mẫu đầu tiên.
+// Header "X-Backlog: 1": mẫu gửi bù sau khi mất kết nối (cũ) -> chỉ lưu database,
+// không cập nhật giá trị hiện tại và không đẩy lên dashboard realtime.
+app.post('/api/esp32/data', express.json({ limit: '1mb' }), (req, res) => {
   try {
-    const data = req.body;
+    const samples = Array.isArray(req.body) ? req.body : [req.body];
+    const isBacklog = req.get('X-Backlog') === '1';
+    if (samples.length === 0 || samples.some((sample) => sample === null || typeof sample !== 'object')) {
+      return res.status(400).json({ success: false, message: 'Expected a sample object or an array of samples' });
+    }
     
     // Lưu IP của ESP32 từ HTTP request (ESP32 không dùng WebSocket)
     // Ưu tiên IP từ body nếu ESP32 gửi, nếu không thì lấy từ request
     let clientIP = null;
-    if (data.ip) {
+    const sampleWithIP = samples.find((sample) => sample.ip);
+    if (sampleWithIP) {
       // ESP32 có thể gửi IP trong body
-      clientIP = data.ip;
+      clientIP = sampleWithIP.ip;
       console.log(`📡 ESP32 IP from message body: ${clientIP}`);
     } else {
       // Lấy IP từ request headers/socket
@@ -609,67 +662,158 @@ app.post('/api/esp32/data', express.json(), (req, res) => {
       console.warn(`⚠️  Could not determine ESP32 IP from request. IP: ${clientIP}`);
     }
     
-    console.log('📥 Received data from ESP32:', data);
-    
-    // Parse dữ liệu từ ESP32
-    const receivedTime = data.Time || new Date().toISOString();
-    const receivedTemp = Number(parseFloat(data.Temperature ?? 0));
-    const receivedHum = Number(parseFloat(data.Humidity ?? 0));
-    const receivedEtOH1 = Number(parseFloat(data.EtOH1 ?? data.ADC1 ?? data.ADC_Value?.[0] ?? 0));
-    const receivedEtOH2 = Number(parseFloat(data.EtOH2 ?? data.ADC2 ?? data.ADC_Value?.[1] ?? 0));
-    const receivedEtOH3 = Number(parseFloat(data.EtOH3 ?? data.ADC3 ?? data.ADC_Value?.[2] ?? 0));
-    const receivedEtOH4 = Number(parseFloat(data.EtOH4 ?? data.ADC4 ?? data.ADC_Value?.[3] ?? 0));
+    console.log(`📥 Received ${samples.length} ${isBacklog ? 'backlog ' : ''}sample(s) from ESP32:`, samples.length === 1 ? samples[0] : '');
     
-    // Cập nhật giá trị global
-    TemperatureValue = receivedTemp;
-    HumidityValue = receivedHum;
-    EtOH1Value = receivedEtOH1;
-    EtOH2Value = receivedEtOH2;
-    EtOH3Value = receivedEtOH3;
-    EtOH4Value = receivedEtOH4;
-    Time = receivedTime;
+    if (isBacklog) {
+      samples.forEach((data) => {
+        const sensors = readSensorValues(data);
+        const DataBacklog = {
+          ID: "Data",
+          Time: data.Time || new Date().toISOString(),
+          Temperature: Number(parseFloat(data.Temperature ?? 0)),
+          Humidity: Number(parseFloat(data.Humidity ?? 0)),
+          EtOH1: sensors[0],
+          EtOH2: sensors[1],
+          EtOH3: sensors[2],
+          EtOH4: sensors[3],
+          Sensors: sensors,
+          Concentrations: readConcentrations(data)
+        };
+        saveRealTimeData(JSON.stringify(DataBacklog));
+      });
+      console.log(`✅ Stored ${samples.length} backlog sample(s), ${samples[0].Time} .. ${samples[samples.length - 1].Time}`);
+      return res.json({ success: true, message: 'Backlog stored', samples: samples.length });
+    }
     
-    // Gửi dữ liệu đến tất cả frontend clients qua WebSocket
-    const fullStatus = {
-      type: "status-all",
-      data: {
+    samples.forEach((data) => {
+      // Parse dữ liệu từ ESP32
+      const receivedTime = data.Time || new Date().toISOString();
+      const receivedTemp = Number(parseFloat(data.Temperature ?? 0));
+      const receivedHum = Number(parseFloat(data.Humidity ?? 0));
+      const receivedSensors = readSensorValues(data);
+      const receivedConcentrations = readConcentrations(data);
+      
+      // Cập nhật giá trị global
+      TemperatureValue = receivedTemp;
+      HumidityValue = receivedHum;
+      SensorValues = receivedSensors;
+      [EtOH1Value, EtOH2Value, EtOH3Value, EtOH4Value] = receivedSensors;
+      Time = receivedTime;
+      
+      // Gửi dữ liệu đến tất cả frontend clients qua WebSocket (mỗi mẫu một message, giữ nguyên độ phân giải biểu đồ)
+      const fullStatus = {
+        type: "status-all",
+        data: {
+          Temperature: TemperatureValue,
+          Humidity: HumidityValue,
+          EtOH1: EtOH1Value,
+          EtOH2: EtOH2Value,
+          EtOH3: EtOH3Value,
+          EtOH4: EtOH4Value,
+          Sensors: SensorValues,
+          Concentrations: receivedConcentrations
+        }
+      };
+      
+      // ESP32 đang stream qua WebSocket thì frontend đã nhận mẫu này, không gửi lặp lại
+      if (!isStreamActive()) {
+        clients.forEach((clientType, client) => {
+          if (client.readyState === WebSocket.OPEN && clientType === 'frontend') {
+            client.send(JSON.stringify(fullStatus));
+          }
+        });
+      }
+      
+      // Lưu vào database nếu cần
+      const DataRealTime = {
+        ID: "Data",
+        Time: Time,
         Temperature: TemperatureValue,
         Humidity: HumidityValue,
         EtOH1: EtOH1Value,
         EtOH2: EtOH2Value,
         EtOH3: EtOH3Value,
-        EtOH4: EtOH4Value
-      }
-    };
+        EtOH4: EtOH4Value,
+        Sensors: SensorValues,
+        Concentrations: receivedConcentrations
+      };
+      saveRealTimeData(JSON.stringify(DataRealTime));
+    });
+    
+    console.log(`✅ Sent ${samples.length} sample(s) to dashboard, last: Temperature=${TemperatureValue}, Humidity=${HumidityValue}, EtOH=[${SensorValues.join(', ')}]`);
     
+    res.json({ success: true, message: 'Data received and sent to dashboard', samples: samples.length });
+  } catch (error) {
+    console.error('❌ Error processing ESP32 data:', error);
+    res.status(500).json({ success: false, message: error.message });
+  }
+});
+
+// ========== HTTP POST ENDPOINT FOR ESP32 EVENTS ==========
+// Mỗi event hơi thở/phơi nhiễm do ESP32 phát hiện là một record đặc trưng (baseline, peak, rise time,
+// time-to-peak, area, recovery slope của từng kênh), gửi vài giây sau khi thổi.
+// Giữ EVENT_HISTORY_MAX event gần nhất trong RAM và đẩy ngay lên frontend (type "event").
+const EVENT_HISTORY_MAX = 200;
+const eventHistory = [];
+
+app.post('/api/esp32/event', express.json({ limit: '64kb' }), (req, res) => {
+  try {
+    const event = req.body;
+    if (event === null || typeof event !== 'object' || !Number.isInteger(event.event) || !Array.isArray(event.channels)) {
+      return res.status(400).json({ success: false, message: 'Expected an event object with "event" and "channels"' });
+    }
+
+    const record = {
+      event: event.event,
+      Time: csvTimeUsToIso(event.Time_us) || new Date().toISOString(),
+      durationMs: Number(event.duration_ms ?? 0),
+      frames: Number(event.frames ?? 0),
+      mask: Number(event.mask ?? 0),
+      truncated: Boolean(event.truncated),
+      ip: event.ip || null,
+      // Kết quả bộ phân loại trên ESP32 (MODEL.ENM), null khi thiết bị chưa có model
+      classification: (event.class && typeof event.class === 'object') ? {
+        label: String(event.class.label ?? 'unknown'),
+        index: Number(event.class.index ?? -1),
+        confidence: Number(event.class.confidence ?? 0),
+        known: Boolean(event.class.known)
+      } : null,
+      channels: event.channels.map((channel) => ({
+        baseline: Number(channel.baseline ?? 0),
+        peak: Number(channel.peak ?? 0),
+        onsetMs: Number(channel.onset_ms ?? -1),
+        riseMs: Number(channel.rise_ms ?? 0),
+        timeToPeakMs: Number(channel.ttp_ms ?? 0),
+        area: Number(channel.area ?? 0),
+        slope: Number(channel.slope ?? 0)
+      }))
+    };
+    eventHistory.push(record);
+    if (eventHistory.length > EVENT_HISTORY_MAX) {
+      eventHistory.shift();
+    }
+
     clients.forEach((clientType, client) => {
       if (client.readyState === WebSocket.OPEN && clientType === 'frontend') {
-        client.send(JSON.stringify(fullStatus));
+        client.send(JSON.stringify({ type: 'event', data: record }));
       }
     });
-    
-    console.log(`✅ Sent data to dashboard: ${JSON.stringify(fullStatus.data, null, 2)}`);
-    
-    // Lưu vào database nếu cần
-    const DataRealTime = {
-      ID: "Data",
-      Time: Time,
-      Temperature: TemperatureValue,
-      Humidity: HumidityValue,
-      EtOH1: EtOH1Value,
-      EtOH2: EtOH2Value,
-      EtOH3: EtOH3Value,
-      EtOH4: EtOH4Value
-    };
-    saveRealTimeData(JSON.stringify(DataRealTime));
-    
-    res.json({ success: true, message: 'Data received and sent to dashboard' });
+
+    const classText = record.classification ? `, ${record.classification.label} (${record.classification.confidence}%)` : '';
+    console.log(`🌬️  Event #${record.event} from ESP32: ${record.durationMs} ms, peaks [${record.channels.map((c) => c.peak).join(', ')}]${classText}${record.truncated ? ' (truncated)' : ''}`);
+    res.json({ success: true, message: 'Event received', event: record.event });
   } catch (error) {
-    console.error('❌ Error processing ESP32 data:', error);
+    console.error('❌ Error processing ESP32 event:', error);
     res.status(500).json({ success: false, message: error.message });
   }
 });
 
+// Các event gần nhất (mới nhất cuối), ?limit=N
+app.get('/api/esp32/events', (req, res) => {
+  const limit = Math.max(1, Math.min(EVENT_HISTORY_MAX, parseInt(req.query.limit, 10) || EVENT_HISTORY_MAX));
+  res.json({ success: true, events: eventHistory.slice(-limit) });
+});
+
 // ========== PROXY ENDPOINTS FOR ESP32 SAMPLING CONTROL ==========
 // Proxy endpoint để forward request đến ESP32
 app.post('/api/esp32/start-sampling', async (req, res) => {
@@ -868,6 +1012,113 @@ const esp32IPs = new Map();
 // Store ESP32 IP from HTTP POST requests (ESP32 không dùng WebSocket, chỉ dùng HTTP POST)
 let esp32HTTPIP = null;
 
+// ========== WEBSOCKET STREAM FROM ESP32 ==========
+// ESP32 (CONFIG_DASHBOARD_WEBSOCKET_ENABLED) giữ một kết nối WebSocket và đẩy mỗi mẫu dưới dạng
+// binary frame 16 + 3 x số kênh byte (xem dataSensor_encodeStreamFrame trong Electronic-Nose), nhiều frame có thể
+// nối liền trong một message. Stream chỉ phục vụ hiển thị realtime: frame được chuyển thẳng tới
+// frontend, việc lưu database vẫn do HTTP POST /api/esp32/data đảm nhận.
+// Frame 0xE2 mang gain của từng kênh (auto gain): giá trị được quy về dải ±2.048 V như CSV/API của ESP32.
+// Frame 0xE1 (firmware cũ, 16 + 2 x số kênh byte) không có gain, giá trị là code thô.
+const STREAM_FRAME_TYPE_RAW = 0xE1;
+const STREAM_FRAME_TYPE = 0xE2;
+const STREAM_FRAME_HEADER_SIZE = 16;
+// Full scale (mV) theo ads111x_gain_t, gain 6..7 cùng là ±0.256 V
+const STREAM_GAIN_FULL_SCALE_MV = [6144, 4096, 2048, 1024, 512, 256, 256, 256];
+const STREAM_REFERENCE_FULL_SCALE_MV = 2048;
+const STREAM_ACTIVE_TIMEOUT_MS = 5000;
+const HEARTBEAT_INTERVAL_MS = 30000;
+let lastStreamFrameAt = 0;
+
+function isStreamActive() {
+  return Date.now() - lastStreamFrameAt < STREAM_ACTIVE_TIMEOUT_MS;
+}
+
+function decodeStreamFrames(buffer) {
+  const frames = [];
+  let offset = 0;
+  while (offset + STREAM_FRAME_HEADER_SIZE <= buffer.length) {
+    const type = buffer.readUInt8(offset);
+    if (type !== STREAM_FRAME_TYPE && type !== STREAM_FRAME_TYPE_RAW) {
+      break;
+    }
+    const hasGain = type === STREAM_FRAME_TYPE;
+    const channelCount = buffer.readUInt8(offset + 1);
+    const frameSize = STREAM_FRAME_HEADER_SIZE + (hasGain ? 3 : 2) * channelCount;
+    if (channelCount > SENSOR_CHANNEL_MAX || offset + frameSize > buffer.length) {
+      break;
+    }
+    const adc = [];
+    for (let i = 0; i < channelCount; i++) {
+      const code = buffer.readInt16LE(offset + STREAM_FRAME_HEADER_SIZE + 2 * i);
+      if (!hasGain) {
+        adc.push(code);
+        continue;
+      }
+      const gain = buffer.readUInt8(offset + STREAM_FRAME_HEADER_SIZE + 2 * channelCount + i) & 0x07;
+      const value = code * STREAM_GAIN_FULL_SCALE_MV[gain] / STREAM_REFERENCE_FULL_SCALE_MV;
+      adc.push(Math.round(value * 100) / 100);
+    }
+    frames.push({
+      timeStamp: buffer.readUInt32LE(offset + 2),
+      Time: new Date(buffer.readUInt32LE(offset + 6) * 1000 + buffer.readUInt16LE(offset + 10)).toISOString(),
+      Temperature: buffer.readInt16LE(offset + 12) / 100,
+      Humidity: buffer.readUInt16LE(offset + 14) / 100,
+      ADC_Value: adc,
+    });
+    offset += frameSize;
+  }
+  return frames;
+}
+
+function handleStreamFrames(buffer) {
+  const frames = decodeStreamFrames(buffer);
+  if (frames.length === 0) {
+    console.warn(`⚠️  Ignoring malformed stream message (${buffer.length} bytes)`);
+    return;
+  }
+  lastStreamFrameAt = Date.now();
+
+  frames.forEach((frame) => {
+    Time = frame.Time;
+    TemperatureValue = frame.Temperature;
+    HumidityValue = frame.Humidity;
+    SensorValues = frame.ADC_Value;
+    [EtOH1Value = 0, EtOH2Value = 0, EtOH3Value = 0, EtOH4Value = 0] = frame.ADC_Value;
+
+    const fullStatus = JSON.stringify({
+      type: "status-all",
+      data: {
+        Temperature: TemperatureValue,
+        Humidity: HumidityValue,
+        EtOH1: EtOH1Value,
+        EtOH2: EtOH2Value,
+        EtOH3: EtOH3Value,
+        EtOH4: EtOH4Value,
+        Sensors: SensorValues
+      }
+    });
+    clients.forEach((clientType, client) => {
+      if (client.readyState === WebSocket.OPEN && clientType === 'frontend') {
+        client.send(fullStatus);
+      }
+    });
+  });
+}
+
+// Heartbeat: đóng các kết nối không trả lời ping (ESP32 mất điện/WiFi không gửi close frame)
+const heartbeatTimer = setInterval(() => {
+  wss.clients.forEach((ws) => {
+    if (ws.isAlive === false) {
+      console.warn(`💔 WebSocket client not responding, terminating: Type=${clients.get(ws)}, IP=${esp32IPs.get(ws) || 'unknown'}`);
+      ws.terminate();
+      return;
+    }
+    ws.isAlive = false;
+    ws.ping();
+  });
+}, HEARTBEAT_INTERVAL_MS);
+wss.on('close', () => clearInterval(heartbeatTimer));
+
 const port = 3000;
 
 // Get local IP address for logging
@@ -887,7 +1138,7 @@ for (const interfaceName in networkInterfaces) {
 }
 
 // Listen on all network interfaces (0.0.0.0) to accept connections from ESP32
-app.listen(port, '0.0.0.0', () => {
+const httpServer = app.listen(port, '0.0.0.0', () => {
   console.log(`🚀 Server is running at http://localhost:${port}`);
   console.log(`🌐 Server is accessible at http://${localIP}:${port}`);
   console.log(`📁 CSV data folder: ${CSV_DATA_FOLDER}`);
@@ -901,6 +1152,11 @@ app.listen(port, '0.0.0.0', () => {
   console.log(`\n💡 Configure ESP32 to use: http://${localIP}:${port}`);
 });
 
+// ESP32 giữ một kết nối keep-alive và gửi batch mỗi vài giây: timeout mặc định của Node (5 s)
+// sẽ đóng socket giữa hai batch và bắt ESP32 bắt tay TCP lại
+httpServer.keepAliveTimeout = 65000;
+httpServer.headersTimeout = 66000;
+
 wss.on('connection', (ws) => {
   // Get client IP address from socket
   let clientIP = 'unknown';
@@ -915,7 +1171,19 @@ wss.on('connection', (ws) => {
   }
   console.log(`New client connected from IP: ${clientIP}`);
 
-  ws.on('message', async (message) => {
+  ws.isAlive = true;
+  ws.on('pong', () => { ws.isAlive = true; });
+
+  ws.on('message', async (message, isBinary) => {
+    ws.isAlive = true;
+    if (isBinary) {
+      if (ws.clientType === 'esp32') {
+        handleStreamFrames(message);
+      } else {
+        console.warn(`⚠️  Binary message from unregistered client ${clientIP} ignored`);
+      }
+      return;
+    }
     try {
       const data = JSON.parse(message);
       console.log('Received:', data);
@@ -90,7 +90,8 @@ const Real_Data = new mongoose.Schema({
   EtOH1: Number,
   EtOH2: Number,
   EtOH3: Number,
-  EtOH4: Number
+  EtOH4: Number,
+  Sensors: [Number] // Tất cả kênh cảm biến (tới 16), EtOH1..4 giữ cho dữ liệu cũ
 });
 
 
@@ -109,7 +110,8 @@ async function saveRealTimeData(jsonString) {
       EtOH1: parsed.EtOH1,
       EtOH2: parsed.EtOH2,
       EtOH3: parsed.EtOH3,
-      EtOH4: parsed.EtOH4
+      EtOH4: parsed.EtOH4,
+      Sensors: parsed.Sensors
     });
 
     console.log("✅ Dữ liệu đã được cập nhật vào database:", parsed);